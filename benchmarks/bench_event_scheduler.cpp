@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+#include "../src/event_scheduler.hpp"
+#include "../src/timer_wheel.hpp"
+#include <random>
+#include <string>
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+ScheduledEvent event_at(Clock::time_point start, int64_t i) {
+    ScheduledEvent event;
+    event.item = {"/media/videos/show_" + std::to_string(i) + ".mp4", PriorityClass::Normal, DEFAULT_SUBMITTER};
+    event.start = start;
+    return event;
+}
+
+// Random expiries spread over a week of 10 ms ticks, so every level of the wheel is used
+std::vector<uint64_t> random_expiries(int64_t count) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<uint64_t> ticks(1, 7ull * 24 * 3600 * 100);
+    std::vector<uint64_t> expiries(count);
+    for (auto& expiry : expiries) {
+        expiry = ticks(rng);
+    }
+    return expiries;
+}
+
+void BM_TimerWheelSchedule(benchmark::State& state) {
+    auto expiries = random_expiries(state.range(0));
+    for (auto _ : state) {
+        TimerWheel wheel;
+        for (size_t i = 0; i < expiries.size(); ++i) {
+            wheel.schedule(i, expiries[i]);
+        }
+        benchmark::DoNotOptimize(wheel.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TimerWheelSchedule)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// Per-tick overhead of the scheduler loop with 100k events pending far in the future
+void BM_TimerWheelIdleTick(benchmark::State& state) {
+    auto expiries = random_expiries(state.range(0));
+    TimerWheel wheel;
+    for (size_t i = 0; i < expiries.size(); ++i) {
+        wheel.schedule(i, expiries[i] + 1'000'000);
+    }
+    std::vector<uint64_t> expired;
+    uint64_t tick = 0;
+    for (auto _ : state) {
+        wheel.advance(++tick, expired);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerWheelIdleTick)->Arg(100000);
+
+// Drain a week of 100k events, including every cascade
+void BM_TimerWheelDrain(benchmark::State& state) {
+    auto expiries = random_expiries(state.range(0));
+    std::vector<uint64_t> expired;
+    expired.reserve(expiries.size());
+    for (auto _ : state) {
+        state.PauseTiming();
+        TimerWheel wheel;
+        for (size_t i = 0; i < expiries.size(); ++i) {
+            wheel.schedule(i, expiries[i]);
+        }
+        expired.clear();
+        state.ResumeTiming();
+        wheel.advance(7ull * 24 * 3600 * 100, expired);
+        benchmark::DoNotOptimize(expired.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TimerWheelDrain)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// EventScheduler::schedule with 100k future events already pending
+void BM_EventSchedulerSchedule(benchmark::State& state) {
+    auto now = Clock::now();
+    EventScheduler scheduler({}, {}, now);
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        scheduler.schedule(event_at(now + std::chrono::seconds(60 + i), i));
+    }
+    int64_t i = 0;
+    for (auto _ : state) {
+        auto id = scheduler.schedule(event_at(now + std::chrono::hours(2), i++));
+        scheduler.cancel(id);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EventSchedulerSchedule)->Arg(100000);
+
+// Timer precision on the real background thread: how late events are seen as due,
+// with 100k other events pending. Reports the mean and worst lateness.
+void BM_EventSchedulerFireLateness(benchmark::State& state) {
+    EventScheduler scheduler({}, {std::chrono::milliseconds(1)});
+    auto now = Clock::now();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        scheduler.schedule(event_at(now + std::chrono::hours(1) + std::chrono::seconds(i), i));
+    }
+    scheduler.start();
+    double total_ms = 0.0;
+    double worst_ms = 0.0;
+    ScheduledEvent event;
+    for (auto _ : state) {
+        auto start = Clock::now() + std::chrono::milliseconds(5);
+        scheduler.schedule(event_at(start, -1));
+        while (!scheduler.take_due(event)) {
+            std::this_thread::yield();
+        }
+        double lateness = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        total_ms += lateness;
+        worst_ms = std::max(worst_ms, lateness);
+    }
+    scheduler.stop();
+    state.counters["late_mean_ms"] = total_ms / static_cast<double>(state.iterations());
+    state.counters["late_max_ms"] = worst_ms;
+}
+BENCHMARK(BM_EventSchedulerFireLateness)->Arg(100000)->Iterations(50)->Unit(benchmark::kMillisecond);
+
+} // namespace
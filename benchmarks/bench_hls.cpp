@@ -0,0 +1,129 @@
+#include <benchmark/benchmark.h>
+#include "../src/hls.hpp"
+#include <cstdint>
+#include <string>
+
+// What a local HLS viewer costs the server per request: the playlist and the newest
+// segment, handed out by reference from the published window, against copying the segment
+// into each response. Readers run alongside the ingest thread cutting new segments.
+
+namespace {
+
+constexpr int64_t FRAME_TICKS = 3000;
+
+std::string packet(int pid, bool unit_start, bool random_access, const std::string& payload) {
+    std::string p(188, '\xff');
+    p[0] = 0x47;
+    p[1] = static_cast<char>((unit_start ? 0x40 : 0) | (pid >> 8));
+    p[2] = static_cast<char>(pid & 0xff);
+    size_t adaptation = 188 - 4 - payload.size();
+    p[3] = 0x30;
+    p[4] = static_cast<char>(adaptation - 1);
+    p[5] = static_cast<char>(random_access ? 0x40 : 0x00);
+    p.replace(4 + adaptation, payload.size(), payload);
+    return p;
+}
+
+std::string tables() {
+    std::string pat = {0x00, 0x00, '\xb0', 0x0d, 0x00, 0x01, '\xc1', 0x00, 0x00, 0x00, 0x01, '\xf0', 0x00, 0, 0, 0, 0};
+    std::string pmt = {0x00, 0x02, '\xb0', 0x12, 0x00, 0x01, '\xc1', 0x00, 0x00, '\xe1', 0x00, '\xf0', 0x00,
+                       0x1b, '\xe1', 0x00, '\xf0', 0x00, 0, 0, 0, 0};
+    return packet(0, true, false, pat) + packet(0x1000, true, false, pmt);
+}
+
+// One frame of video at 30 fps with a keyframe every 2 s, plus the bulk of a 4 Mbit/s
+// stream as non-video packets
+std::string frame(int64_t index) {
+    int64_t pts = 126000 + index * FRAME_TICKS;
+    std::string pes = {0x00, 0x00, 0x01, '\xe0', 0x00, 0x00, '\x80', '\x80', 0x05};
+    pes += static_cast<char>(0x21 | ((pts >> 29) & 0x0e));
+    pes += static_cast<char>((pts >> 22) & 0xff);
+    pes += static_cast<char>(0x01 | ((pts >> 14) & 0xfe));
+    pes += static_cast<char>((pts >> 7) & 0xff);
+    pes += static_cast<char>(0x01 | ((pts << 1) & 0xfe));
+    std::string ts = index % 30 == 0 ? tables() : std::string();
+    ts += packet(0x100, true, index % 60 == 0, pes);
+    for (int i = 0; i < 88; ++i) {
+        ts += packet(0x101, i == 0, false, std::string(180, '\x22'));
+    }
+    return ts;
+}
+
+// A live output with a full window; only the thread that owns it writes
+struct LiveHls {
+    HlsOutput output{[] {
+        HlsOptions options;
+        options.part_target = std::chrono::milliseconds(500);
+        return options;
+    }()};
+    int64_t frames = 0;
+
+    LiveHls() {
+        while (frames < 60 * 30) {
+            output.write(frame(frames++));
+        }
+    }
+};
+
+LiveHls& live() {
+    static LiveHls instance;
+    return instance;
+}
+
+}  // namespace
+
+// Playlist and newest segment by reference, as the /hls routes serve them
+static void BM_HlsReadShared(benchmark::State& state) {
+    LiveHls& hls = live();
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        auto window = hls.output.window();
+        std::shared_ptr<const std::string> playlist = window->playlist;
+        std::shared_ptr<const std::string> segment = window->find(window->next_sequence - 1)->data;
+        benchmark::DoNotOptimize(playlist);
+        benchmark::DoNotOptimize(segment);
+        bytes += static_cast<int64_t>(playlist->size() + segment->size());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_HlsReadShared)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
+
+// Baseline: every response gets its own copy of the segment
+static void BM_HlsReadCopy(benchmark::State& state) {
+    LiveHls& hls = live();
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        auto window = hls.output.window();
+        std::string playlist = *window->playlist;
+        std::string segment = *window->find(window->next_sequence - 1)->data;
+        benchmark::DoNotOptimize(playlist.data());
+        benchmark::DoNotOptimize(segment.data());
+        bytes += static_cast<int64_t>(playlist.size() + segment.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_HlsReadCopy)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
+
+// Thread 0 is the ingest thread, one frame per iteration; the others poll the playlist
+static void BM_HlsReadWhileCutting(benchmark::State& state) {
+    static LiveHls* hls = nullptr;
+    if (state.thread_index() == 0) {
+        hls = new LiveHls();
+    }
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            hls->output.write(frame(hls->frames++));
+        } else {
+            auto window = hls->output.window();
+            benchmark::DoNotOptimize(window->playlist);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        delete hls;
+        hls = nullptr;
+    }
+}
+BENCHMARK(BM_HlsReadWhileCutting)->Threads(2)->Threads(16)->Threads(64)->UseRealTime();
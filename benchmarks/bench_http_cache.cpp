@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include "../src/http_cache.hpp"
+#include "../src/json_response.hpp"
+#include "../src/media_queue.hpp"
+#include <string>
+
+// What one dashboard poll of GET /queue costs while the queue is idle: a full render (the
+// old behaviour), a 304 for a client that sends the current ETag, and a cached gzip body
+// for a client without one.
+
+namespace {
+
+std::shared_ptr<const QueueSnapshot> queue_of(int64_t count) {
+    ThreadSafeMediaQueue queue;
+    std::vector<QueueItem> items;
+    for (int64_t i = 0; i < count; ++i) {
+        items.push_back({"/media/videos/clip_" + std::to_string(i) + ".mp4", PriorityClass::Normal, DEFAULT_SUBMITTER});
+    }
+    std::vector<bool> accepted;
+    queue.push_batch(items, accepted);
+    return queue.snapshot();  // Outlives the queue
+}
+
+std::string render_queue(const QueueSnapshot& snapshot) {
+    return write_json_response(queue_page(snapshot, 0, snapshot.items.size()));
+}
+
+}  // namespace
+
+// Baseline: every poll serializes the whole queue
+static void BM_QueuePollRender(benchmark::State& state) {
+    auto snapshot = queue_of(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(render_queue(*snapshot));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueuePollRender)->Arg(10)->Arg(100)->Arg(1000);
+
+// If-None-Match holds the current revision: no serialization at all
+static void BM_QueuePollNotModified(benchmark::State& state) {
+    auto snapshot = queue_of(state.range(0));
+    std::string if_none_match = snapshot_etag(snapshot->revision);
+    for (auto _ : state) {
+        std::string etag = snapshot_etag(snapshot->revision);
+        benchmark::DoNotOptimize(etag_matches(if_none_match, etag));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueuePollNotModified)->Arg(10)->Arg(100)->Arg(1000);
+
+// No ETag, gzip accepted: the compressed body is reused until the revision changes
+static void BM_QueuePollCachedGzip(benchmark::State& state) {
+    auto snapshot = queue_of(state.range(0));
+    ResponseCache cache;
+    auto render = [&] { return render_queue(*snapshot); };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.get("queue 0 all", snapshot->revision, ContentEncoding::Gzip, render));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = static_cast<double>(
+        cache.get("queue 0 all", snapshot->revision, ContentEncoding::Gzip, render).data->size());
+    state.counters["identity_bytes"] = static_cast<double>(render().size());
+}
+BENCHMARK(BM_QueuePollCachedGzip)->Arg(10)->Arg(100)->Arg(1000);
+
+// The first poll after a change: render and compress
+static void BM_QueuePollRenderGzip(benchmark::State& state) {
+    auto snapshot = queue_of(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(compress(render_queue(*snapshot), ContentEncoding::Gzip));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueuePollRenderGzip)->Arg(10)->Arg(100)->Arg(1000);
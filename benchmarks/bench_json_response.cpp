@@ -0,0 +1,136 @@
+#include <benchmark/benchmark.h>
+#include "../src/json_response.hpp"
+#include "../src/media_queue.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Count heap allocations so each benchmark can report allocations per response. This
+// replaces the global operator new for the whole benchmark binary; the count is a relaxed
+// atomic increment and does not change what the other benchmarks measure. Every
+// replaceable form that can hand out this memory is replaced together with its matching
+// delete, so std::free only ever sees blocks that came from std::malloc below; the aligned
+// forms are left to the library, which pairs them itself.
+namespace {
+std::atomic<size_t> g_allocations{0};
+
+void* counted_malloc(size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+// Out of line: once inlined into a caller, std::free on a pointer from operator new trips
+// -Wmismatched-new-delete, which cannot see that this operator new is std::malloc underneath
+[[gnu::noinline]] void release_block(void* p) noexcept {
+    std::free(p);
+}
+}
+
+void* operator new(size_t size) {
+    if (void* p = counted_malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return counted_malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return counted_malloc(size);
+}
+
+void operator delete(void* p) noexcept {
+    release_block(p);
+}
+
+void operator delete[](void* p) noexcept {
+    release_block(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    release_block(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    release_block(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    release_block(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    release_block(p);
+}
+
+namespace {
+
+std::shared_ptr<const QueueSnapshot> queue_of(int64_t count) {
+    ThreadSafeMediaQueue queue;
+    std::vector<QueueItem> items;
+    for (int64_t i = 0; i < count; ++i) {
+        items.push_back({"/media/videos/clip_" + std::to_string(i) + ".mp4", PriorityClass::Normal, DEFAULT_SUBMITTER});
+    }
+    std::vector<bool> accepted;
+    queue.push_batch(items, accepted);
+    return queue.snapshot();  // Outlives the queue
+}
+
+// Baseline: the GET /queue body as it was built before, by string concatenation
+std::string concat_queue_response(const QueueSnapshot& snapshot) {
+    const auto& items = snapshot.items;
+    size_t begin = 0;
+    size_t end = items.size();
+    std::string json_response = "{\"queue\":[";
+    for (size_t i = begin; i < end; ++i) {
+        json_response += "\"" + items[i].source + "\"";
+        if (i < end - 1) json_response += ",";
+    }
+    json_response += "],\"size\":" + std::to_string(items.size());
+    json_response += ",\"offset\":" + std::to_string(begin);
+    json_response += ",\"version\":" + std::to_string(snapshot.version) + "}";
+    return json_response;
+}
+
+void report(benchmark::State& state, size_t allocations, size_t bytes) {
+    state.counters["allocs_per_response"] =
+        benchmark::Counter(static_cast<double>(allocations) / static_cast<double>(state.iterations()));
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(bytes) * state.iterations());
+}
+
+// Both variants end with the copy into the HTTP response body (res.set_content)
+void BM_QueueResponseConcat(benchmark::State& state) {
+    auto snapshot = queue_of(state.range(0));
+    size_t bytes = 0;
+    size_t before = g_allocations.load();
+    for (auto _ : state) {
+        std::string body = concat_queue_response(*snapshot);
+        bytes = body.size();
+        benchmark::DoNotOptimize(body.data());
+    }
+    report(state, g_allocations.load() - before, bytes);
+}
+BENCHMARK(BM_QueueResponseConcat)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+void BM_QueueResponseGlaze(benchmark::State& state) {
+    auto snapshot = queue_of(state.range(0));
+    size_t bytes = 0;
+    size_t before = g_allocations.load();
+    for (auto _ : state) {
+        std::string body = write_json_response(queue_page(*snapshot, 0, snapshot->items.size()));
+        bytes = body.size();
+        benchmark::DoNotOptimize(body.data());
+    }
+    report(state, g_allocations.load() - before, bytes);
+}
+BENCHMARK(BM_QueueResponseGlaze)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,150 @@
+#include <benchmark/benchmark.h>
+#include "../src/logger.hpp"
+#include "../src/media_info.hpp"
+#include "../src/media_queue.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream>
+#include <map>
+#include <string>
+
+// The /queue/add handler's work with its old and new logging: the old handler printed the
+// request line, every parameter and header and the body with std::endl (one write(2) and
+// one stdout lock per line); the new one hands one or two records to the async logger.
+// stdout is pointed at /dev/null while these run, so the numbers exclude terminal cost.
+
+namespace {
+
+// Short lineup, so the snapshot rebuild does not hide the logging cost
+constexpr size_t MAX_QUEUED = 16;
+
+const std::string ITEM = "https://www.youtube.com/watch?v=dQw4w9WgXcQ";
+const std::string SUBMITTER = "agent";
+
+struct FakeRequest {
+    std::string method = "POST";
+    std::string path = "/queue/add";
+    std::multimap<std::string, std::string> params{{"url", ITEM}, {"token", "secret"}};
+    std::multimap<std::string, std::string> headers{
+        {"Host", "localhost:8080"},           {"User-Agent", "curl/8.5.0"},
+        {"Accept", "*/*"},                    {"Authorization", "Bearer secret"},
+        {"X-Submitter", SUBMITTER},           {"Content-Length", "0"},
+        {"REMOTE_ADDR", "127.0.0.1"},         {"REMOTE_PORT", "53412"},
+    };
+    std::string body;
+};
+
+const FakeRequest REQUEST;
+
+int saved_stdout = -1;
+
+void silence_stdout(const benchmark::State&) {
+    std::cout.flush();
+    saved_stdout = dup(1);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, 1);
+    close(null_fd);
+}
+
+void restore_stdout(const benchmark::State&) {
+    std::cout.flush();
+    dup2(saved_stdout, 1);
+    close(saved_stdout);
+}
+
+ThreadSafeMediaQueue& shared_queue() {
+    static ThreadSafeMediaQueue queue;
+    return queue;
+}
+
+// Everything the handler does besides logging
+void handle(const std::string& item) {
+    std::string error;
+    benchmark::DoNotOptimize(validate_media_source(item, error));
+    auto& queue = shared_queue();
+    queue.push(item, SUBMITTER);
+    if (queue.size() > MAX_QUEUED) {
+        queue.clear();
+    }
+}
+
+Logger& bench_logger() {
+    static Logger logger([] {
+        Logger::Options options;
+        options.fd = open("/dev/null", O_WRONLY);
+        options.capacity = 1 << 16;
+        return options;
+    }());
+    return logger;
+}
+
+}  // namespace
+
+static void BM_QueueAddSyncCout(benchmark::State& state) {
+    const auto& req = REQUEST;
+    for (auto _ : state) {
+        std::cout << "🔍 DEBUG: POST /queue/add request received" << std::endl;
+        std::cout << "   Method: " << req.method << std::endl;
+        std::cout << "   Path: " << req.path << std::endl;
+        std::cout << "   Query params count: " << req.params.size() << std::endl;
+        for (const auto& param : req.params) {
+            std::cout << "   Query param: " << param.first << " = " << param.second << std::endl;
+        }
+        std::cout << "   Headers count: " << req.headers.size() << std::endl;
+        for (const auto& header : req.headers) {
+            std::cout << "   Header: " << header.first << " = " << header.second << std::endl;
+        }
+        std::cout << "   Body: " << req.body << std::endl;
+        std::cout << "   ✅ Authentication passed" << std::endl;
+        std::cout << "   ✅ Found parameter: " << ITEM << std::endl;
+        std::cout << "   ✅ Validation passed" << std::endl;
+        handle(ITEM);
+        std::cout << "   ✅ Item added to queue: " << ITEM << " (submitter " << SUBMITTER << ")" << std::endl;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueueAddSyncCout)->Setup(silence_stdout)->Teardown(restore_stdout)->Threads(1)->Threads(4)->UseRealTime();
+
+// Default level: the debug record is filtered, the "added" record is queued
+static void BM_QueueAddAsyncLog(benchmark::State& state) {
+    auto& logger = bench_logger();
+    logger.set_level(LogLevel::Info);
+    uint64_t dropped_before = logger.dropped();
+    const auto& req = REQUEST;
+    for (auto _ : state) {
+        logger.log(LogLevel::Debug, LogCategory::Http, "POST /queue/add",
+                   {{"params", req.params.size()}, {"headers", req.headers.size()}, {"body_bytes", req.body.size()}});
+        handle(ITEM);
+        logger.log(LogLevel::Info, LogCategory::Http, "✅ Item added to queue", {{"item", ITEM}, {"submitter", SUBMITTER}});
+    }
+    logger.flush();
+    state.SetItemsProcessed(state.iterations());
+    // Non-zero only when the producers outrun the writer (the ring is sized for bursts)
+    state.counters["dropped"] = static_cast<double>(logger.dropped() - dropped_before);
+}
+BENCHMARK(BM_QueueAddAsyncLog)->Threads(1)->Threads(4)->UseRealTime();
+
+// MYCHANNEL_LOG_LEVEL=debug: both records are queued
+static void BM_QueueAddAsyncLogDebug(benchmark::State& state) {
+    auto& logger = bench_logger();
+    logger.set_level(LogLevel::Debug);
+    const auto& req = REQUEST;
+    for (auto _ : state) {
+        logger.log(LogLevel::Debug, LogCategory::Http, "POST /queue/add",
+                   {{"params", req.params.size()}, {"headers", req.headers.size()}, {"body_bytes", req.body.size()}});
+        handle(ITEM);
+        logger.log(LogLevel::Info, LogCategory::Http, "✅ Item added to queue", {{"item", ITEM}, {"submitter", SUBMITTER}});
+    }
+    logger.flush();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueueAddAsyncLogDebug)->Threads(1)->Threads(4)->UseRealTime();
+
+// Handler work alone, for reference
+static void BM_QueueAddNoLog(benchmark::State& state) {
+    for (auto _ : state) {
+        handle(ITEM);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueueAddNoLog)->Threads(1)->Threads(4)->UseRealTime();
@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+#include "../src/mcp_server.hpp"
+#include "../src/http_server.hpp"
+#include "../src/media_queue.hpp"
+#include <string>
+#include <vector>
+
+// A typical agent turn: queue N items, then read the stream status. Sent one request per
+// POST it costs N + 1 round trips, auth checks and envelope parses; as a JSON-RPC batch it
+// costs one. The time below is server-side only, so the network round trips saved
+// (reported as the round_trips counter) come on top of it.
+
+namespace {
+
+std::string add_call(int64_t id) {
+    return R"({"jsonrpc":"2.0","id":)" + std::to_string(id) +
+           R"(,"method":"tools/call","params":{"name":"add_video_to_queue","arguments":{"source":"videos/clip_)" +
+           std::to_string(id) + R"(.mp4","submitter":"agent"}}})";
+}
+
+const std::string STATUS_CALL =
+    R"({"jsonrpc":"2.0","id":"status","method":"tools/call","params":{"name":"get_stream_status","arguments":{}}})";
+
+void BM_AgentTurnSingleRequests(benchmark::State& state) {
+    ThreadSafeMediaQueue queue;
+    HttpServer http_server(queue);
+    MCPServer mcp_server(http_server);
+    std::vector<std::string> requests;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        requests.push_back(add_call(i));
+    }
+    requests.push_back(STATUS_CALL);
+
+    for (auto _ : state) {
+        for (const auto& request : requests) {
+            benchmark::DoNotOptimize(mcp_server.handle_jsonrpc(request, true));
+        }
+        state.PauseTiming();
+        queue.clear();
+        state.ResumeTiming();
+    }
+    state.counters["round_trips"] = static_cast<double>(requests.size());
+}
+BENCHMARK(BM_AgentTurnSingleRequests)->Arg(10)->Arg(50);
+
+void BM_AgentTurnBatch(benchmark::State& state) {
+    ThreadSafeMediaQueue queue;
+    HttpServer http_server(queue);
+    MCPServer mcp_server(http_server);
+    std::string batch = "[";
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        batch += add_call(i) + ",";
+    }
+    batch += STATUS_CALL + "]";
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mcp_server.handle_jsonrpc(batch, true));
+        state.PauseTiming();
+        queue.clear();
+        state.ResumeTiming();
+    }
+    state.counters["round_trips"] = 1;
+}
+BENCHMARK(BM_AgentTurnBatch)->Arg(10)->Arg(50);
+
+// Read-only members between writes fan out; here every member is a read
+void BM_BatchOfReads(benchmark::State& state) {
+    ThreadSafeMediaQueue queue;
+    HttpServer http_server(queue);
+    MCPServer mcp_server(http_server);
+    std::string batch = "[";
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        batch += (i ? "," : "") + std::string(R"({"jsonrpc":"2.0","id":)") + std::to_string(i) +
+                 R"(,"method":"tools/call","params":{"name":"get_streaming_queue","arguments":{}}})";
+    }
+    batch += "]";
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mcp_server.handle_jsonrpc(batch, true));
+    }
+}
+BENCHMARK(BM_BatchOfReads)->Arg(8)->Arg(64);
+
+} // namespace
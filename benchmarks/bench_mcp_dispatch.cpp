@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+#include "../src/mcp_tools.hpp"
+#include <map>
+#include <string>
+
+// Argument handling for a tools/call request, without the tool itself: the generic-value
+// path (parse, dump the arguments, re-parse into a string map) against the typed registry
+// path (read the envelope, read the arguments into the tool's struct).
+
+namespace {
+
+const std::string REQUEST =
+    R"({"jsonrpc":"2.0","method":"tools/call","id":"bench-1","params":{"name":"schedule_video","arguments":{"source":"videos/news_at_nine.mp4","at":"2026-10-18T21:00:00Z","join":"hard_cut","title":"News at Nine","every":86400,"submitter":"newsroom"}}})";
+
+void BM_DispatchGenericValue(benchmark::State& state) {
+    for (auto _ : state) {
+        glz::json_t request;
+        if (glz::read_json(request, REQUEST)) {
+            state.SkipWithError("parse failed");
+            break;
+        }
+        const auto& params = request["params"].get_object();
+        std::string name = params.at("name").get_string();
+        std::string arguments = params.at("arguments").dump().value_or("{}");
+
+        // What extract_mcp_params did in every handler
+        glz::json_t parsed;
+        (void)glz::read_json(parsed, arguments);
+        std::map<std::string, std::string> values;
+        for (const auto& [key, value] : parsed.get_object()) {
+            if (value.is_string()) {
+                values[key] = value.get_string();
+            } else if (value.is_number()) {
+                values[key] = std::to_string(value.get_number());
+            }
+        }
+        benchmark::DoNotOptimize(name);
+        benchmark::DoNotOptimize(values);
+    }
+}
+BENCHMARK(BM_DispatchGenericValue);
+
+void BM_DispatchTypedRegistry(benchmark::State& state) {
+    for (auto _ : state) {
+        MCPRequest request;
+        if (glz::read<MCP_READ_OPTS>(request, REQUEST)) {
+            state.SkipWithError("parse failed");
+            break;
+        }
+        ScheduleVideoTool::Args args{};
+        (void)glz::read<MCP_READ_OPTS>(args, request.params.arguments.str);
+        benchmark::DoNotOptimize(request.params.name);
+        benchmark::DoNotOptimize(args);
+    }
+}
+BENCHMARK(BM_DispatchTypedRegistry);
+
+} // namespace
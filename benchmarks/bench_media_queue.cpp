@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include "../src/media_queue.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+
+namespace {
+
+void fill_queue(ThreadSafeMediaQueue& queue, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        queue.push("videos/item_" + std::to_string(i) + ".mp4");
+    }
+}
+
+// Playout rotation (pop + push_back) while N reader threads hammer the queue
+// the way /queue, get_streaming_queue and get_stream_status do.
+void BM_PlayoutRotateUnderReadLoad(benchmark::State& state) {
+    ThreadSafeMediaQueue queue;
+    fill_queue(queue, static_cast<size_t>(state.range(0)));
+    const int readers = static_cast<int>(state.range(1));
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> reads{0};
+    std::vector<std::thread> reader_threads;
+    for (int r = 0; r < readers; ++r) {
+        reader_threads.emplace_back([&queue, &running, &reads]() {
+            while (running.load(std::memory_order_relaxed)) {
+                auto snapshot = queue.snapshot();
+                benchmark::DoNotOptimize(snapshot->items.size());
+                benchmark::DoNotOptimize(queue.size());
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    std::string item;
+    for (auto _ : state) {
+        queue.pop(item);
+        queue.push_back(item);
+    }
+
+    running.store(false);
+    for (auto& t : reader_threads) {
+        t.join();
+    }
+    state.counters["reads"] = benchmark::Counter(static_cast<double>(reads.load()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_PlayoutRotateUnderReadLoad)
+    ->ArgsProduct({{100, 1000}, {0, 1, 4, 16}})
+    ->UseRealTime();
+
+// Cost of a paginated read against a large queue
+void BM_PaginatedRead(benchmark::State& state) {
+    ThreadSafeMediaQueue queue;
+    fill_queue(queue, 10000);
+    for (auto _ : state) {
+        auto page = queue.get_items(5000, static_cast<size_t>(state.range(0)));
+        benchmark::DoNotOptimize(page.data());
+    }
+}
+BENCHMARK(BM_PaginatedRead)->Arg(10)->Arg(100)->Arg(1000);
+
+// Size/version accessors used by status endpoints
+void BM_SizeAndVersion(benchmark::State& state) {
+    ThreadSafeMediaQueue queue;
+    fill_queue(queue, 10000);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(queue.size());
+        benchmark::DoNotOptimize(queue.version());
+    }
+}
+BENCHMARK(BM_SizeAndVersion);
+
+} // namespace
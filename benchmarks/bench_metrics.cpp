@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include "../src/metrics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Baseline: one counter shared by every thread, as a single atomic
+std::atomic<uint64_t> g_shared_counter{0};
+
+// Baseline: a histogram behind a mutex
+struct LockedHistogram {
+    std::mutex mutex;
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(latency_buckets().size() + 1);
+    std::vector<double> bounds = latency_buckets();
+    double sum = 0.0;
+
+    void observe(double value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++buckets[std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin()];
+        sum += value;
+    }
+};
+
+}  // namespace
+
+static void BM_CounterAdd(benchmark::State& state) {
+    static Counter counter;
+    for (auto _ : state) {
+        counter.add();
+    }
+}
+BENCHMARK(BM_CounterAdd)->ThreadRange(1, 8);
+
+static void BM_SharedAtomicAdd(benchmark::State& state) {
+    for (auto _ : state) {
+        g_shared_counter.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+BENCHMARK(BM_SharedAtomicAdd)->ThreadRange(1, 8);
+
+static void BM_HistogramObserve(benchmark::State& state) {
+    static Histogram histogram(latency_buckets());
+    double value = 0.0003 * (state.thread_index() + 1);
+    for (auto _ : state) {
+        histogram.observe(value);
+    }
+}
+BENCHMARK(BM_HistogramObserve)->ThreadRange(1, 8);
+
+static void BM_LockedHistogramObserve(benchmark::State& state) {
+    static LockedHistogram histogram;
+    double value = 0.0003 * (state.thread_index() + 1);
+    for (auto _ : state) {
+        histogram.observe(value);
+    }
+}
+BENCHMARK(BM_LockedHistogramObserve)->ThreadRange(1, 8);
+
+// A scrape of a registry about the size of the real one
+static void BM_RenderRegistry(benchmark::State& state) {
+    MetricsRegistry registry;
+    for (int i = 0; i < 20; ++i) {
+        registry.histogram("bench_request_seconds", "Bench", latency_buckets(), label("route", std::to_string(i)))
+            .observe(0.001);
+        registry.counter("bench_total", "Bench", label("n", std::to_string(i))).add(i);
+    }
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        registry.render(out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * out.size()));
+}
+BENCHMARK(BM_RenderRegistry);
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+#include "../src/playlist_import.hpp"
+#include "../src/media_info.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+constexpr int PLAYLIST_SIZE = 1000;
+
+// A lineup of real local files so validation pays the same stat() cost as in production
+const std::vector<std::string>& lineup() {
+    static const std::vector<std::string> sources = []() {
+        auto dir = std::filesystem::temp_directory_path() / ("mychannel_bench_playlist_" + std::to_string(::getpid()));
+        std::filesystem::create_directories(dir);
+        std::vector<std::string> paths;
+        for (int i = 0; i < PLAYLIST_SIZE; ++i) {
+            auto path = dir / ("clip_" + std::to_string(i) + ".mp4");
+            std::ofstream(path) << "media";
+            paths.push_back(path.string());
+        }
+        return paths;
+    }();
+    return sources;
+}
+
+// Baseline: what 1000 /queue/add calls do, one validation and one queue commit per item
+void BM_ImportItemByItem(benchmark::State& state) {
+    const auto& sources = lineup();
+    for (auto _ : state) {
+        ThreadSafeMediaQueue queue;
+        for (const auto& source : sources) {
+            std::string error;
+            if (validate_media_source(source, error)) {
+                queue.push(source);
+            }
+        }
+        benchmark::DoNotOptimize(queue.size());
+    }
+    state.SetItemsProcessed(state.iterations() * PLAYLIST_SIZE);
+}
+BENCHMARK(BM_ImportItemByItem)->Unit(benchmark::kMillisecond);
+
+// Bulk import with N validation workers and a single commit
+void BM_ImportBulk(benchmark::State& state) {
+    const auto& sources = lineup();
+    PlaylistImportOptions options;
+    options.max_parallel = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        ThreadSafeMediaQueue queue;
+        auto result = import_sources(queue, sources, options);
+        benchmark::DoNotOptimize(result.queued);
+    }
+    state.SetItemsProcessed(state.iterations() * PLAYLIST_SIZE);
+}
+BENCHMARK(BM_ImportBulk)->Arg(1)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Parsing cost of a 1000-entry M3U body
+void BM_ParseM3U(benchmark::State& state) {
+    std::string body = "#EXTM3U\n";
+    for (const auto& source : lineup()) {
+        body += "#EXTINF:60,Clip\n" + source + "\n";
+    }
+    PlaylistImportOptions options;
+    std::vector<std::string> sources;
+    std::string error;
+    for (auto _ : state) {
+        parse_playlist(body, options, sources, error);
+        benchmark::DoNotOptimize(sources.data());
+    }
+}
+BENCHMARK(BM_ParseM3U)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+#include "../src/queue_journal.hpp"
+#include "../src/media_queue.hpp"
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+std::string bench_dir(const std::string& name) {
+    auto dir = std::filesystem::temp_directory_path() / ("mychannel_bench_" + name + "_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(dir);
+    return dir.string();
+}
+
+// Latency of a journaled enqueue as seen by the caller (buffer only, fsync happens in the background)
+void BM_JournaledPush(benchmark::State& state) {
+    auto dir = bench_dir("push");
+    {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir);
+        journal.open(queue);
+        size_t i = 0;
+        for (auto _ : state) {
+            queue.push("videos/item_" + std::to_string(i++) + ".mp4");
+            if (queue.size() > 1000) {
+                state.PauseTiming();
+                queue.clear();
+                state.ResumeTiming();
+            }
+        }
+        journal.sync();
+    }
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_JournaledPush);
+
+// Time until a mutation is durable, including the group-commit window and fsync
+void BM_JournalSyncLatency(benchmark::State& state) {
+    auto dir = bench_dir("sync");
+    {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir);
+        journal.open(queue);
+        for (auto _ : state) {
+            queue.push("videos/item.mp4");
+            journal.sync();
+            state.PauseTiming();
+            if (queue.size() > 1000) queue.clear();
+            state.ResumeTiming();
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_JournalSyncLatency)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Startup recovery of N entries, either from a compacted snapshot (arg 1 = 1)
+// or by replaying one journal record per entry (arg 1 = 0)
+void BM_Recovery(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    const bool from_snapshot = state.range(1) != 0;
+    QueueJournalOptions options;
+    options.compact_after_records = from_snapshot ? 1 : count * 10;
+    auto dir = bench_dir("recovery");
+    {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir, options);
+        journal.open(queue);
+        if (from_snapshot) {
+            std::vector<QueueItem> items;
+            for (size_t i = 0; i < count; ++i) {
+                items.push_back({"https://www.youtube.com/watch?v=item" + std::to_string(i), PriorityClass::Normal});
+            }
+            queue.restore(std::move(items), 0);
+            queue.push("videos/last.mp4");  // Triggers compaction of the restored lineup
+        } else {
+            // Feed records straight into the journal to avoid rebuilding queue snapshots N times
+            for (size_t i = 0; i < count; ++i) {
+                journal.append(QueueOp::PushBack, "https://www.youtube.com/watch?v=item" + std::to_string(i), i + 1);
+            }
+        }
+        journal.sync();
+    }
+
+    for (auto _ : state) {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir, options);
+        auto stats = journal.open(queue);
+        benchmark::DoNotOptimize(stats.items);
+    }
+    std::filesystem::remove_all(dir);
+}
+BENCHMARK(BM_Recovery)->ArgsProduct({{10000, 100000}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+} // namespace
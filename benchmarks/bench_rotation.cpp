@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+#include "../src/media_queue.hpp"
+#include "../src/fair_queue.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+QueueItem clip(int64_t i) {
+    return {"/media/videos/clip_" + std::to_string(i) + ".mp4", PriorityClass::Normal, DEFAULT_SUBMITTER};
+}
+
+// Baseline: the old playout step, pop and re-append under two lock acquisitions
+void BM_QueuePopPushBack(benchmark::State& state) {
+    ThreadSafeMediaQueue queue;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        queue.push_back(clip(i));
+    }
+    QueueItem item;
+    for (auto _ : state) {
+        queue.pop(item);
+        queue.push_back(QueueItem{item.source, PriorityClass::Normal, item.submitter});
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueuePopPushBack)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// One lock, one version and one journal record; the rotation stays in place and the
+// published snapshot shares the playlist instead of copying it
+void BM_QueueAdvance(benchmark::State& state) {
+    ThreadSafeMediaQueue queue;
+    std::vector<QueueItem> items;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        items.push_back(clip(i));
+    }
+    std::vector<bool> accepted;
+    queue.push_batch(items, accepted);  // One snapshot for the whole playlist
+    QueueItem item;
+    for (auto _ : state) {
+        queue.advance(item);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueueAdvance)->Arg(100)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Cost of the rotation step alone, without snapshot publication, per mode and playlist size
+void BM_RotationAdvance(benchmark::State& state) {
+    FairQueue rotation;
+    rotation.seed(1);
+    rotation.set_mode(static_cast<RotationMode>(state.range(1)));
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        rotation.push_back(clip(i));
+    }
+    QueueItem item;
+    rotation.advance(item);  // Build shuffle/alias tables outside the timed loop
+    for (auto _ : state) {
+        rotation.advance(item);
+        benchmark::DoNotOptimize(item.source.data());
+    }
+    state.SetLabel(rotation_mode_name(rotation.mode()));
+}
+BENCHMARK(BM_RotationAdvance)
+    ->ArgsProduct({{100, 10000, 1000000},
+                   {static_cast<int64_t>(RotationMode::Loop), static_cast<int64_t>(RotationMode::Shuffle),
+                    static_cast<int64_t>(RotationMode::WeightedRandom)}});
+
+// The same step done the old way: pop, copy and push back
+void BM_RotationPopPushBack(benchmark::State& state) {
+    FairQueue rotation;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        rotation.push_back(clip(i));
+    }
+    QueueItem item;
+    for (auto _ : state) {
+        rotation.pop(item);
+        rotation.push_back(item);
+        benchmark::DoNotOptimize(item.source.data());
+    }
+}
+BENCHMARK(BM_RotationPopPushBack)->Arg(100)->Arg(10000)->Arg(1000000);
+
+} // namespace
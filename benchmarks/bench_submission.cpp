@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+#include "../src/media_queue.hpp"
+#include "../src/mpsc_queue.hpp"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Keep the lineup short so the O(n) snapshot rebuild doesn't dominate the submission cost
+constexpr size_t MAX_QUEUED = 256;
+
+const std::string SOURCE = "/media/videos/clip.mp4";
+
+// Baseline: the original submission path, one mutex around a std::deque
+void BM_SubmitMutexDeque(benchmark::State& state) {
+    static std::mutex mutex;
+    static std::deque<std::string> queue;
+    for (auto _ : state) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(SOURCE);
+        if (queue.size() > MAX_QUEUED) {
+            queue.clear();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SubmitMutexDeque)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
+
+// Raw cost of the lock-free buffer, drained by one consumer per batch
+void BM_SubmitMpscRaw(benchmark::State& state) {
+    static MpscQueue<std::string> queue;
+    static std::mutex consumer;
+    for (auto _ : state) {
+        queue.push(SOURCE);
+        if (state.thread_index() == 0 && consumer.try_lock()) {
+            std::string item;
+            while (queue.pop(item)) {
+            }
+            consumer.unlock();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SubmitMpscRaw)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
+
+ThreadSafeMediaQueue& shared_queue() {
+    static ThreadSafeMediaQueue queue;
+    return queue;
+}
+
+// The queue's locked path: every submission takes mutex_ and publishes its own version
+void BM_SubmitQueueLocked(benchmark::State& state) {
+    auto& queue = shared_queue();
+    std::vector<QueueItem> item{{SOURCE, PriorityClass::Normal, DEFAULT_SUBMITTER}};
+    std::vector<bool> accepted;
+    for (auto _ : state) {
+        queue.push_batch(item, accepted);
+        if (queue.size() > MAX_QUEUED) {
+            queue.clear();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SubmitQueueLocked)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
+
+// push(): lock-free submit, drained in batches by whoever holds the lock
+void BM_SubmitQueueBuffered(benchmark::State& state) {
+    auto& queue = shared_queue();
+    for (auto _ : state) {
+        queue.push(SOURCE);
+        if (queue.size() > MAX_QUEUED) {
+            queue.clear();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SubmitQueueBuffered)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
+
+} // namespace
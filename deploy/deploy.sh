@@ -39,12 +39,7 @@ fi
 
 log "🚀 Starting MyChannel deployment..."
 
-# Stop the service if it's running
-if systemctl is-active --quiet $SERVICE_NAME; then
-    log "🛑 Stopping $SERVICE_NAME service..."
-    systemctl stop $SERVICE_NAME
-fi
-
+# The running service keeps streaming while the new version builds; it hands over at the end
 # Create deploy user if it doesn't exist
 if ! id "$BUILD_USER" &>/dev/null; then
     log "👤 Creating $BUILD_USER user..."
@@ -110,10 +105,16 @@ fi
 
 # Deploy new version
 log "📦 Deploying new version..."
-mkdir -p $DEPLOY_DIR
-cp -r $TEMP_DIR/result/* $DEPLOY_DIR/
+mkdir -p $DEPLOY_DIR/bin
+for entry in $TEMP_DIR/result/*; do
+    [ "$(basename $entry)" = "bin" ] || cp -r $entry $DEPLOY_DIR/
+done
+# Replace the binary by rename: the running one keeps its file, and the successor it
+# starts for the handoff finds the new one under the same name
+cp $TEMP_DIR/result/bin/mychannel $DEPLOY_DIR/bin/mychannel.new
+chmod +x $DEPLOY_DIR/bin/mychannel.new
+mv -f $DEPLOY_DIR/bin/mychannel.new $DEPLOY_DIR/bin/mychannel
 chown -R root:root $DEPLOY_DIR
-chmod +x $DEPLOY_DIR/bin/mychannel
 
 # Copy videos directory if it exists
 if [ -d "$TEMP_DIR/videos" ]; then
@@ -135,6 +136,9 @@ Type=simple
 User=root
 WorkingDirectory=$DEPLOY_DIR
 ExecStart=$DEPLOY_DIR/bin/mychannel
+# Reload hands the stream over to a new process started from the deployed binary
+ExecReload=/bin/kill -USR2 \$MAINPID
+NotifyAccess=all
 Restart=always
 RestartSec=10
 Environment=PATH=/usr/bin:/bin
@@ -151,9 +155,33 @@ EOF
     systemctl enable $SERVICE_NAME
 fi
 
-# Start the service
-log "🚀 Starting $SERVICE_NAME service..."
-systemctl start $SERVICE_NAME
+# Hand over to the new version without dropping the stream, or start it
+if systemctl is-active --quiet $SERVICE_NAME && grep -q '^ExecReload=' $SERVICE_FILE; then
+    OLD_PID=$(systemctl show -p MainPID --value $SERVICE_NAME)
+    log "🤝 Handing $SERVICE_NAME over to the new version (PID $OLD_PID)..."
+    systemctl reload $SERVICE_NAME
+    HANDED_OVER=false
+    for i in $(seq 1 150); do
+        NEW_PID=$(systemctl show -p MainPID --value $SERVICE_NAME)
+        if [ "$NEW_PID" != "$OLD_PID" ] && [ "$NEW_PID" != "0" ] && ! kill -0 $OLD_PID 2>/dev/null; then
+            HANDED_OVER=true
+            break
+        fi
+        sleep 1
+    done
+    if [ "$HANDED_OVER" = true ]; then
+        success "Handed over to PID $NEW_PID"
+    else
+        warning "Handoff did not complete, restarting (the stream drops)"
+        systemctl restart $SERVICE_NAME
+    fi
+elif systemctl is-active --quiet $SERVICE_NAME; then
+    warning "$SERVICE_FILE has no ExecReload, restarting (the stream drops)"
+    systemctl restart $SERVICE_NAME
+else
+    log "🚀 Starting $SERVICE_NAME service..."
+    systemctl start $SERVICE_NAME
+fi
 
 # Wait a moment and check if it's running
 sleep 2
@@ -29,6 +29,7 @@
             pkgs.httplib
             pkgs.glaze
             pkgs.gtest
+            pkgs.gbenchmark
           ];
           
           configurePhase = ''
@@ -54,6 +55,7 @@
             pkgs.httplib
             pkgs.glaze
             pkgs.gtest
+            pkgs.gbenchmark
           ];
           shellHook = ''
             # Only set these if they're not already defined
@@ -0,0 +1,351 @@
+#include "event_scheduler.hpp"
+#include "runtime.hpp"
+#include "priority_scheduler.hpp"
+#include "json_response.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+
+constexpr const char* JOIN_POLICY_NAMES[] = {"hard_cut", "wait", "trim_filler"};
+
+std::string escape_xml(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            case '\'': out += "&apos;"; break;
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+std::tm to_utc(std::chrono::system_clock::time_point time) {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    std::tm utc{};
+    gmtime_r(&seconds, &utc);
+    return utc;
+}
+
+// XMLTV timestamps: "20260101120000 +0000"
+std::string format_xmltv_time(std::chrono::system_clock::time_point time) {
+    std::tm utc = to_utc(time);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S +0000", &utc);
+    return buffer;
+}
+
+std::chrono::system_clock::time_point stop_time(const ScheduledEvent& event) {
+    return event.start + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                             std::chrono::duration<double>(event.duration));
+}
+
+} // namespace
+
+const char* join_policy_name(JoinPolicy policy) {
+    return JOIN_POLICY_NAMES[static_cast<size_t>(policy)];
+}
+
+std::optional<JoinPolicy> parse_join_policy(const std::string& name) {
+    for (size_t i = 0; i < std::size(JOIN_POLICY_NAMES); ++i) {
+        if (name == JOIN_POLICY_NAMES[i]) {
+            return static_cast<JoinPolicy>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::chrono::system_clock::time_point> parse_schedule_time(const std::string& text) {
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    if (text.find_first_not_of("0123456789") == std::string::npos) {
+        try {
+            return std::chrono::system_clock::time_point(std::chrono::seconds(std::stoll(text)));
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+    std::tm utc{};
+    char zone = 0;
+    int consumed = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d%c%n", &utc.tm_year, &utc.tm_mon, &utc.tm_mday,
+                    &utc.tm_hour, &utc.tm_min, &utc.tm_sec, &zone, &consumed) != 7 ||
+        zone != 'Z' || static_cast<size_t>(consumed) != text.size()) {
+        return std::nullopt;
+    }
+    if (utc.tm_mon < 1 || utc.tm_mon > 12 || utc.tm_mday < 1 || utc.tm_mday > 31 || utc.tm_hour > 23 ||
+        utc.tm_min > 59 || utc.tm_sec > 60) {
+        return std::nullopt;
+    }
+    utc.tm_year -= 1900;
+    utc.tm_mon -= 1;
+    std::time_t seconds = timegm(&utc);
+    if (seconds < 0) {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::from_time_t(seconds);
+}
+
+std::string format_schedule_time(std::chrono::system_clock::time_point time) {
+    std::tm utc = to_utc(time);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buffer;
+}
+
+EventScheduler::EventScheduler(PlayoutControl control, EventSchedulerOptions options, Clock::time_point now)
+    : control_(std::move(control)), options_(options), wheel_(0) {
+    if (options_.tick.count() <= 0) {
+        options_.tick = std::chrono::milliseconds(1);
+    }
+    wheel_ = TimerWheel(tick_of(now));
+}
+
+EventScheduler::~EventScheduler() {
+    stop();
+}
+
+uint64_t EventScheduler::tick_of(Clock::time_point time) const {
+    auto since_epoch = time.time_since_epoch().count();
+    if (since_epoch <= 0) {
+        return 0;
+    }
+    auto tick = static_cast<uint64_t>(std::chrono::duration_cast<Clock::duration>(options_.tick).count());
+    return (static_cast<uint64_t>(since_epoch) + tick - 1) / tick;
+}
+
+EventScheduler::Clock::time_point EventScheduler::time_of(uint64_t tick) const {
+    return Clock::time_point(std::chrono::duration_cast<Clock::duration>(options_.tick * static_cast<int64_t>(tick)));
+}
+
+void EventScheduler::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) {
+        return;
+    }
+    stopping_ = false;
+    thread_ = std::thread([this] {
+        enter_thread_role(ThreadRole::Playout, "scheduler");
+        run();
+    });
+}
+
+void EventScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void EventScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        // Sleep until the wheel's next possible expiry, re-checking at least once a second
+        auto deadline = Clock::now() + std::chrono::seconds(1);
+        if (auto wakeup = wheel_.next_wakeup()) {
+            deadline = std::min(deadline, time_of(*wakeup));
+        }
+        wake_cv_.wait_until(lock, deadline);
+        if (stopping_) {
+            break;
+        }
+        lock.unlock();
+        poll(Clock::now());
+        lock.lock();
+    }
+}
+
+uint64_t EventScheduler::schedule(ScheduledEvent event) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        event.id = id;
+        wheel_.schedule(id, tick_of(event.start));
+        events_[id] = std::move(event);
+    }
+    wake_cv_.notify_all();  // The new event may be due before the thread's current deadline
+    return id;
+}
+
+bool EventScheduler::cancel(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wheel_.cancel(id);
+    return events_.erase(id) > 0;
+}
+
+bool EventScheduler::set_duration(uint64_t id, double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = events_.find(id);
+    if (it == events_.end()) {
+        return false;
+    }
+    it->second.duration = seconds;
+    return true;
+}
+
+size_t EventScheduler::poll(Clock::time_point now) {
+    std::vector<ScheduledEvent> fired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t tick = tick_of(now);
+        // tick_of rounds up; only advance over ticks that have fully started
+        if (time_of(tick) > now && tick > 0) {
+            --tick;
+        }
+        if (tick <= wheel_.now()) {
+            return 0;
+        }
+        std::vector<uint64_t> expired;
+        wheel_.advance(tick, expired);
+        for (uint64_t id : expired) {
+            auto it = events_.find(id);
+            if (it == events_.end()) {
+                continue;
+            }
+            ScheduledEvent event = it->second;
+            double lateness_ms = std::chrono::duration<double, std::milli>(now - event.start).count();
+            stats_.last_lateness_ms = lateness_ms;
+            stats_.max_lateness_ms = std::max(stats_.max_lateness_ms, lateness_ms);
+            ++stats_.fired;
+
+            if (event.repeat.count() > 0) {
+                // Re-arm from the scheduled start, skipping occurrences missed while we were behind
+                auto& next = it->second;
+                do {
+                    next.start += event.repeat;
+                } while (next.start <= now);
+                wheel_.schedule(id, tick_of(next.start));
+            } else {
+                events_.erase(it);
+            }
+            due_.push_back(event);
+            fired.push_back(std::move(event));
+        }
+    }
+    // Playout callbacks run outside the lock; they may kill the encoder
+    for (const auto& event : fired) {
+        join(event);
+    }
+    return fired.size();
+}
+
+void EventScheduler::join(const ScheduledEvent& event) {
+    if (!control_.cut) {
+        return;
+    }
+    switch (event.join) {
+        case JoinPolicy::HardCut:
+            control_.cut();
+            break;
+        case JoinPolicy::TrimFiller:
+            // Rotation and fallback content is filler; priority content plays out
+            if (!control_.on_air_priority || control_.on_air_priority() == PriorityClass::Normal) {
+                control_.cut();
+            }
+            break;
+        case JoinPolicy::WaitForEnd:
+            break;
+    }
+}
+
+bool EventScheduler::take_due(ScheduledEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (due_.empty()) {
+        return false;
+    }
+    event = std::move(due_.front());
+    due_.pop_front();
+    return true;
+}
+
+bool EventScheduler::has_due() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !due_.empty();
+}
+
+std::vector<ScheduledEvent> EventScheduler::listing(Clock::time_point from, Clock::time_point until) const {
+    std::vector<ScheduledEvent> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [id, event] : events_) {
+            ScheduledEvent occurrence = event;
+            if (occurrence.repeat.count() > 0 && occurrence.start < from) {
+                auto missed = (from - occurrence.start) / occurrence.repeat;
+                occurrence.start += occurrence.repeat * missed;
+            }
+            while (occurrence.start < until) {
+                if (occurrence.start >= from || stop_time(occurrence) > from) {
+                    entries.push_back(occurrence);
+                }
+                if (occurrence.repeat.count() <= 0) {
+                    break;
+                }
+                occurrence.start += occurrence.repeat;
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const ScheduledEvent& a, const ScheduledEvent& b) {
+        return a.start != b.start ? a.start < b.start : a.id < b.id;
+    });
+    return entries;
+}
+
+std::string EventScheduler::epg_json(Clock::time_point from) const {
+    auto entries = listing(from, from + options_.epg_horizon);
+    EpgResponse response{{}, format_schedule_time(from)};
+    response.events.reserve(entries.size());
+    for (const auto& event : entries) {
+        EpgEventView view{event.id, event.title, event.item.source, priority_class_name(event.item.priority),
+                          format_schedule_time(event.start)};
+        if (event.duration > 0.0) {
+            view.stop = format_schedule_time(stop_time(event));
+        }
+        view.duration = event.duration;
+        view.join = join_policy_name(event.join);
+        view.repeat = event.repeat.count();
+        response.events.push_back(std::move(view));
+    }
+    return write_json_response(response);
+}
+
+std::string EventScheduler::epg_xmltv(Clock::time_point from, const std::string& channel_id,
+                                      const std::string& channel_name) const {
+    auto entries = listing(from, from + options_.epg_horizon);
+    std::string id = escape_xml(channel_id);
+    std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    xml += "<!DOCTYPE tv SYSTEM \"xmltv.dtd\">\n";
+    xml += "<tv generator-info-name=\"mychannel\">\n";
+    xml += "  <channel id=\"" + id + "\">\n";
+    xml += "    <display-name>" + escape_xml(channel_name) + "</display-name>\n";
+    xml += "  </channel>\n";
+    for (const auto& event : entries) {
+        xml += "  <programme start=\"" + format_xmltv_time(event.start) + "\"";
+        if (event.duration > 0.0) {
+            xml += " stop=\"" + format_xmltv_time(stop_time(event)) + "\"";
+        }
+        xml += " channel=\"" + id + "\">\n";
+        xml += "    <title>" + escape_xml(event.title.empty() ? event.item.source : event.title) + "</title>\n";
+        xml += "  </programme>\n";
+    }
+    xml += "</tv>\n";
+    return xml;
+}
+
+EventSchedulerStats EventScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EventSchedulerStats stats = stats_;
+    stats.pending = events_.size();
+    return stats;
+}
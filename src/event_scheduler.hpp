@@ -0,0 +1,115 @@
+#pragma once
+#include "queue_item.hpp"
+#include "timer_wheel.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+// What happens to the item on air when a scheduled event starts
+enum class JoinPolicy : uint8_t {
+    HardCut = 0,     // Cut whatever is on air at the scheduled time
+    WaitForEnd = 1,  // Start when the item on air finishes
+    TrimFiller = 2,  // Cut rotation/fallback content, wait for priority content to finish
+};
+
+const char* join_policy_name(JoinPolicy policy);
+std::optional<JoinPolicy> parse_join_policy(const std::string& name);
+
+// Wall-clock times for the schedule API: unix seconds or UTC ISO 8601 ("2026-01-01T12:00:00Z")
+std::optional<std::chrono::system_clock::time_point> parse_schedule_time(const std::string& text);
+std::string format_schedule_time(std::chrono::system_clock::time_point time);
+
+struct ScheduledEvent {
+    uint64_t id = 0;
+    std::string title;
+    QueueItem item;  // Played directly, never enters the rotation
+    std::chrono::system_clock::time_point start;
+    double duration = 0.0;              // Seconds for the EPG stop time; 0 when unknown
+    JoinPolicy join = JoinPolicy::WaitForEnd;
+    std::chrono::seconds repeat{0};     // Re-arm this long after each start; 0 for a one-off
+};
+
+// Hooks into the playout loop; main.cpp wires them to g_stream_process
+struct PlayoutControl {
+    std::function<PriorityClass()> on_air_priority;
+    std::function<void()> cut;  // End the item on air now
+};
+
+struct EventSchedulerOptions {
+    std::chrono::milliseconds tick{10};  // Timer resolution; events fire up to one tick late
+    std::chrono::hours epg_horizon{48};  // How far repeating events are expanded in EPG exports
+};
+
+struct EventSchedulerStats {
+    size_t pending = 0;
+    uint64_t fired = 0;
+    double last_lateness_ms = 0.0;  // Fire time minus scheduled start
+    double max_lateness_ms = 0.0;
+};
+
+// Wall-clock schedule alongside ThreadSafeMediaQueue. Events sit in a TimerWheel; when one
+// is due it is handed to the playout loop through take_due() and the item on air is cut
+// according to the event's JoinPolicy. poll() does the firing: start() runs it on a
+// background thread, tests call it directly with their own clock.
+class EventScheduler {
+public:
+    using Clock = std::chrono::system_clock;
+
+    explicit EventScheduler(PlayoutControl control = {}, EventSchedulerOptions options = {},
+                            Clock::time_point now = Clock::now());
+    ~EventScheduler();
+
+    EventScheduler(const EventScheduler&) = delete;
+    EventScheduler& operator=(const EventScheduler&) = delete;
+
+    void start();
+    void stop();
+
+    uint64_t schedule(ScheduledEvent event);  // Returns the event id; past starts fire at the next tick
+    bool cancel(uint64_t id);
+    // Fills in the duration of an event scheduled without one, once it has been probed;
+    // false when the event has fired (one-offs) or was cancelled meanwhile
+    bool set_duration(uint64_t id, double seconds);
+
+    // Fire every event due at `now`; returns how many fired
+    size_t poll(Clock::time_point now);
+
+    // Playout side: the next started event, oldest first
+    bool take_due(ScheduledEvent& event);
+    bool has_due() const;
+
+    // Events (with repeats expanded) starting in [from, until), sorted by start
+    std::vector<ScheduledEvent> listing(Clock::time_point from, Clock::time_point until) const;
+    std::string epg_json(Clock::time_point from) const;
+    std::string epg_xmltv(Clock::time_point from, const std::string& channel_id = "mychannel",
+                          const std::string& channel_name = "MyChannel") const;
+
+    EventSchedulerStats stats() const;
+
+private:
+    PlayoutControl control_;
+    EventSchedulerOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    TimerWheel wheel_;
+    std::unordered_map<uint64_t, ScheduledEvent> events_;
+    std::deque<ScheduledEvent> due_;
+    uint64_t next_id_ = 1;
+    bool stopping_ = false;
+    std::thread thread_;
+    EventSchedulerStats stats_;
+
+    uint64_t tick_of(Clock::time_point time) const;  // Rounded up, so events never fire early
+    Clock::time_point time_of(uint64_t tick) const;
+    void run();
+    void join(const ScheduledEvent& event);
+};
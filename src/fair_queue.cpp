@@ -0,0 +1,472 @@
+#include "fair_queue.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+
+namespace {
+
+// Every flow must earn some credit per round, otherwise pop() could spin forever
+constexpr double MIN_WEIGHT = 0.01;
+
+constexpr const char* ROTATION_MODE_NAMES[] = {"loop", "once", "shuffle", "weighted_random"};
+
+} // namespace
+
+const char* rotation_mode_name(RotationMode mode) {
+    return ROTATION_MODE_NAMES[static_cast<size_t>(mode)];
+}
+
+std::optional<RotationMode> parse_rotation_mode(const std::string& name) {
+    for (size_t i = 0; i < std::size(ROTATION_MODE_NAMES); ++i) {
+        if (name == ROTATION_MODE_NAMES[i]) {
+            return static_cast<RotationMode>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+const QueueItem& LineupPart::at(size_t k) const {
+    if (k < pinned.size()) {
+        return pinned[k];
+    }
+    size_t i = (start + k - pinned.size()) % count;
+    return (*items)[begin + (order ? (*order)[i] : i)];
+}
+
+void append_round_robin(const std::vector<LineupPart>& parts, std::vector<QueueItem>& out) {
+    size_t remaining = 0;
+    for (const auto& part : parts) {
+        remaining += part.size();
+    }
+    std::vector<size_t> next(parts.size(), 0);
+    while (remaining > 0) {
+        for (size_t i = 0; i < parts.size(); ++i) {
+            for (size_t n = 0; n < parts[i].share && next[i] < parts[i].size(); ++n, --remaining) {
+                out.push_back(parts[i].at(next[i]++));
+            }
+        }
+    }
+}
+
+FairQueue::FairQueue(double quantum_seconds) : quantum_seconds_(quantum_seconds), rng_(std::random_device{}()) {}
+
+FairQueue::Flow& FairQueue::activate(const std::string& submitter, bool at_front) {
+    auto& flow = flows_[submitter];
+    if (!flow.active) {
+        flow.active = true;
+        flow.deficit = 0.0;
+        if (at_front) {
+            active_.push_front(submitter);
+        } else {
+            active_.push_back(submitter);
+        }
+    } else if (at_front && active_.front() != submitter) {
+        active_.erase(std::find(active_.begin(), active_.end(), submitter));
+        active_.push_front(submitter);
+    }
+    return flow;
+}
+
+void FairQueue::deactivate(const std::string& submitter, Flow& flow) {
+    flow.active = false;
+    flow.deficit = 0.0;
+    flow.cursor = 0;
+    flow.tables_stale = true;
+    flow.published.reset();
+    flow.published_order.reset();
+    active_.erase(std::find(active_.begin(), active_.end(), submitter));
+}
+
+FairQueue::Flow* FairQueue::next_flow() {
+    while (!active_.empty()) {
+        auto& flow = flows_[active_.front()];
+        if (flow.deficit > 0.0) {
+            flow.deficit -= quantum_seconds_;
+            return &flow;
+        }
+
+        // Out of credit for this round: replenish by weight and pass the turn on
+        flow.deficit += quantum_seconds_ * policy(active_.front()).weight;
+        active_.push_back(active_.front());
+        active_.pop_front();
+    }
+    return nullptr;
+}
+
+void FairQueue::reshuffle(Flow& flow) {
+    size_t last = flow.cursor > 0 && flow.cursor <= flow.order.size() ? flow.order[flow.cursor - 1] : SIZE_MAX;
+    flow.order.resize(flow.items.size());
+    std::iota(flow.order.begin(), flow.order.end(), 0u);
+    std::shuffle(flow.order.begin(), flow.order.end(), rng_);
+    // Don't open a pass with the item that closed the previous one
+    if (flow.order.size() > 1 && flow.order.front() == last) {
+        std::uniform_int_distribution<size_t> pick(1, flow.order.size() - 1);
+        std::swap(flow.order.front(), flow.order[pick(rng_)]);
+    }
+    flow.cursor = 0;
+    flow.tables_stale = false;
+    flow.published_order.reset();
+}
+
+void FairQueue::rebuild_alias(Flow& flow) {
+    // Vose's alias method: O(n) build, O(1) weighted pick
+    size_t n = flow.items.size();
+    double total = 0.0;
+    for (const auto& item : flow.items) {
+        total += item.weight;
+    }
+    flow.alias_prob.assign(n, 1.0);
+    flow.alias.assign(n, 0);
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; ++i) {
+        scaled[i] = total > 0.0 ? flow.items[i].weight * static_cast<double>(n) / total : 1.0;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty()) {
+        uint32_t lo = small.back();
+        uint32_t hi = large.back();
+        small.pop_back();
+        flow.alias_prob[lo] = scaled[lo];
+        flow.alias[lo] = hi;
+        scaled[hi] -= 1.0 - scaled[lo];
+        if (scaled[hi] < 1.0) {
+            large.pop_back();
+            small.push_back(hi);
+        }
+    }
+    flow.tables_stale = false;
+}
+
+size_t FairQueue::next_index(Flow& flow) {
+    switch (mode_) {
+        case RotationMode::Shuffle:
+            if (flow.tables_stale || flow.order.size() != flow.items.size() || flow.cursor >= flow.order.size()) {
+                reshuffle(flow);
+            }
+            return flow.order[flow.cursor];
+        case RotationMode::WeightedRandom: {
+            if (flow.tables_stale || flow.alias.size() != flow.items.size()) {
+                rebuild_alias(flow);
+            }
+            std::uniform_int_distribution<size_t> column(0, flow.items.size() - 1);
+            size_t i = column(rng_);
+            return std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < flow.alias_prob[i] ? i : flow.alias[i];
+        }
+        case RotationMode::Loop:
+        case RotationMode::Once:
+            break;
+    }
+    return 0;
+}
+
+void FairQueue::wrap(Flow& flow) {
+    if (flow.items.empty()) {
+        flow.items.swap(flow.played);  // Same play order, so the published copy still holds
+    }
+}
+
+void FairQueue::insert_played(Flow& flow, QueueItem item) {
+    flow.published.reset();
+    if (mode_ == RotationMode::Loop || mode_ == RotationMode::Once) {
+        // Last of the played part: it comes round again after everything else
+        flow.played.push_back(std::move(item));
+        wrap(flow);
+        return;
+    }
+    flow.items.push_back(std::move(item));
+    if (mode_ == RotationMode::Shuffle && !flow.tables_stale && flow.order.size() + 1 == flow.items.size()) {
+        // Count it as played in this pass: swap it into the played prefix
+        flow.order.push_back(static_cast<uint32_t>(flow.items.size() - 1));
+        std::swap(flow.order.back(), flow.order[flow.cursor]);
+        ++flow.cursor;
+        flow.published_order.reset();
+    } else {
+        flow.tables_stale = true;
+    }
+}
+
+void FairQueue::take(const std::string& submitter, Flow& flow, bool keep, QueueItem& item) {
+    if (!flow.pinned.empty()) {
+        if (keep) {
+            item = flow.pinned.front();
+            insert_played(flow, std::move(flow.pinned.front()));
+        } else {
+            item = std::move(flow.pinned.front());
+            --size_;
+        }
+        flow.pinned.pop_front();
+    } else {
+        size_t index = next_index(flow);
+        if (keep) {
+            item = flow.items[index];
+            if (mode_ == RotationMode::Shuffle) {
+                ++flow.cursor;
+            } else if (mode_ != RotationMode::WeightedRandom) {
+                // Moves from the rest of the pass to the played part; the play order is unchanged
+                flow.played.push_back(std::move(flow.items.front()));
+                flow.items.pop_front();
+                wrap(flow);
+            }
+        } else {
+            item = std::move(flow.items[index]);
+            flow.items.erase(flow.items.begin() + static_cast<std::ptrdiff_t>(index));
+            if (index == 0 && flow.played.empty()) {
+                ++flow.published_begin;  // Off the front of the published copy
+            } else {
+                flow.published.reset();
+            }
+            if (mode_ == RotationMode::Shuffle && !flow.tables_stale) {
+                // Keep the pass: drop the entry and renumber the items behind it
+                flow.order.erase(flow.order.begin() + static_cast<std::ptrdiff_t>(flow.cursor));
+                for (auto& entry : flow.order) {
+                    entry -= entry > index ? 1 : 0;
+                }
+                flow.published_order.reset();
+            } else if (mode_ == RotationMode::WeightedRandom) {
+                flow.tables_stale = true;
+            } else {
+                wrap(flow);
+            }
+            --size_;
+        }
+    }
+    if (flow.size() == 0) {
+        deactivate(submitter, flow);
+    }
+}
+
+void FairQueue::push_back(QueueItem item) {
+    auto& flow = activate(item.submitter, false);
+    flow.items.push_back(std::move(item));
+    flow.published.reset();
+    ++size_;
+    if (mode_ == RotationMode::Shuffle && !flow.tables_stale && flow.order.size() + 1 == flow.items.size()) {
+        // Land somewhere in the unplayed rest of the current pass
+        flow.order.push_back(static_cast<uint32_t>(flow.items.size() - 1));
+        std::uniform_int_distribution<size_t> slot(std::min(flow.cursor, flow.order.size() - 1), flow.order.size() - 1);
+        std::swap(flow.order.back(), flow.order[slot(rng_)]);
+        flow.published_order.reset();
+    } else if (mode_ != RotationMode::Shuffle) {
+        flow.tables_stale = true;
+    }
+}
+
+void FairQueue::push_front(QueueItem item) {
+    auto& flow = activate(item.submitter, true);
+    flow.pinned.push_front(std::move(item));
+    ++size_;
+}
+
+void FairQueue::push_played(QueueItem item) {
+    auto& flow = activate(item.submitter, false);
+    insert_played(flow, std::move(item));
+    ++size_;
+}
+
+bool FairQueue::remove_played(const QueueItem& item) {
+    auto it = flows_.find(item.submitter);
+    if (it == flows_.end()) {
+        return false;
+    }
+    Flow& flow = it->second;
+    // Newest match first: the played part ends with the last item handed out, and after a
+    // wrap that item closes the new pass instead
+    auto drop = [&item](std::deque<QueueItem>& part) {
+        auto match = std::find_if(part.rbegin(), part.rend(),
+                                  [&item](const QueueItem& entry) { return entry.source == item.source; });
+        if (match == part.rend()) {
+            return false;
+        }
+        part.erase(std::next(match).base());
+        return true;
+    };
+    if (!drop(flow.played) && !drop(flow.items)) {
+        return false;
+    }
+    flow.tables_stale = true;
+    flow.published.reset();
+    flow.published_order.reset();
+    wrap(flow);
+    --size_;
+    if (flow.size() == 0) {
+        deactivate(item.submitter, flow);
+    }
+    return true;
+}
+
+bool FairQueue::pop(QueueItem& item) {
+    Flow* flow = next_flow();
+    if (!flow) {
+        return false;
+    }
+    take(active_.front(), *flow, false, item);
+    return true;
+}
+
+bool FairQueue::advance(QueueItem& item) {
+    Flow* flow = next_flow();
+    if (!flow) {
+        return false;
+    }
+    take(active_.front(), *flow, mode_ != RotationMode::Once, item);
+    return true;
+}
+
+bool FairQueue::pop_from(const std::string& submitter, QueueItem& item) {
+    return advance_from(submitter, false, item);
+}
+
+bool FairQueue::advance_from(const std::string& submitter, bool keep, QueueItem& item) {
+    auto it = flows_.find(submitter);
+    if (it == flows_.end() || it->second.size() == 0) {
+        return false;
+    }
+    take(submitter, it->second, keep, item);
+    return true;
+}
+
+void FairQueue::record_airtime(const std::string& submitter, double seconds) {
+    auto& flow = flows_[submitter];
+    flow.airtime += seconds;
+    if (flow.active) {
+        flow.deficit -= seconds - quantum_seconds_;  // Replace the nominal charge taken at pop()
+    }
+}
+
+void FairQueue::clear() {
+    for (auto& [name, flow] : flows_) {
+        flow.pinned.clear();
+        flow.items.clear();
+        flow.played.clear();
+        flow.order.clear();
+        flow.cursor = 0;
+        flow.tables_stale = true;
+        flow.published.reset();
+        flow.published_order.reset();
+        flow.active = false;
+        flow.deficit = 0.0;
+    }
+    active_.clear();
+    size_ = 0;
+}
+
+void FairQueue::set_mode(RotationMode mode) {
+    if (mode == mode_) {
+        return;
+    }
+    // Lay each playlist out in its projected order so the new mode starts from the cursor
+    for (auto& [name, flow] : flows_) {
+        std::vector<size_t> order;
+        rotation_order(flow, order);
+        std::deque<QueueItem> items;
+        for (size_t index : order) {
+            size_t played = flow.played.size();
+            items.push_back(std::move(index < played ? flow.played[index] : flow.items[index - played]));
+        }
+        flow.items = std::move(items);
+        flow.played.clear();
+        flow.order.clear();
+        flow.cursor = 0;
+        flow.tables_stale = true;
+        flow.published.reset();
+        flow.published_order.reset();
+    }
+    mode_ = mode;
+}
+
+void FairQueue::set_policy(const std::string& submitter, SubmitterPolicy policy) {
+    policy.weight = std::max(policy.weight, MIN_WEIGHT);
+    policies_[submitter] = policy;
+}
+
+void FairQueue::set_default_policy(SubmitterPolicy policy) {
+    policy.weight = std::max(policy.weight, MIN_WEIGHT);
+    default_policy_ = policy;
+}
+
+SubmitterPolicy FairQueue::policy(const std::string& submitter) const {
+    auto it = policies_.find(submitter);
+    return it != policies_.end() ? it->second : default_policy_;
+}
+
+bool FairQueue::has_quotas() const {
+    return default_policy_.quota > 0 ||
+           std::any_of(policies_.begin(), policies_.end(), [](const auto& entry) { return entry.second.quota > 0; });
+}
+
+void FairQueue::rotation_order(const Flow& flow, std::vector<size_t>& out) const {
+    size_t n = flow.playlist_size();
+    if (mode_ == RotationMode::Shuffle && !flow.tables_stale && flow.order.size() == n) {
+        // Rest of this pass, then the played part (the next pass is not drawn yet)
+        for (size_t k = 0; k < n; ++k) {
+            out.push_back(flow.order[(flow.cursor + k) % n]);
+        }
+        return;
+    }
+    size_t start = mode_ == RotationMode::Loop || mode_ == RotationMode::Once ? flow.played.size() : 0;
+    for (size_t k = 0; k < n; ++k) {
+        out.push_back((start + k) % n);
+    }
+}
+
+void FairQueue::append_in_order(std::vector<QueueItem>& out) const {
+    std::vector<LineupPart> parts;
+    freeze(parts);
+    append_round_robin(parts, out);
+}
+
+void FairQueue::freeze(std::vector<LineupPart>& out) const {
+    out.reserve(out.size() + active_.size());
+    for (const auto& name : active_) {
+        const auto& flow = flows_.at(name);
+        if (!flow.published) {
+            auto playlist = std::make_shared<std::vector<QueueItem>>();
+            playlist->reserve(flow.playlist_size());
+            playlist->insert(playlist->end(), flow.played.begin(), flow.played.end());
+            playlist->insert(playlist->end(), flow.items.begin(), flow.items.end());
+            flow.published = std::move(playlist);
+            flow.published_begin = 0;
+        }
+
+        LineupPart part;
+        part.items = flow.published;
+        part.begin = flow.published_begin;
+        part.count = flow.playlist_size();
+        part.pinned.assign(flow.pinned.begin(), flow.pinned.end());
+        part.share = std::max<size_t>(1, static_cast<size_t>(std::lround(policy(name).weight)));
+        if (mode_ == RotationMode::Shuffle && !flow.tables_stale && flow.order.size() == part.count) {
+            // Rest of this pass, then the played part (the next pass is not drawn yet)
+            if (!flow.published_order) {
+                flow.published_order = std::make_shared<const std::vector<uint32_t>>(flow.order);
+            }
+            part.order = flow.published_order;
+            part.start = flow.cursor;
+        } else if (mode_ == RotationMode::Loop || mode_ == RotationMode::Once) {
+            part.start = flow.played.size();
+        }
+        out.push_back(std::move(part));
+    }
+}
+
+std::vector<SubmitterStats> FairQueue::stats() const {
+    std::vector<SubmitterStats> result;
+    for (const auto& [name, flow] : flows_) {
+        auto p = policy(name);
+        size_t position = 0;
+        if (mode_ == RotationMode::Shuffle) {
+            position = std::min(flow.cursor, flow.items.size());
+        } else if (mode_ != RotationMode::WeightedRandom) {
+            position = flow.played.size();
+        }
+        result.push_back({name, p.weight, p.quota, flow.size(), flow.deficit, flow.airtime, position});
+    }
+    for (const auto& [name, p] : policies_) {
+        if (!flows_.contains(name)) {
+            result.push_back({name, p.weight, p.quota, 0, 0.0, 0.0, 0});
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+    return result;
+}
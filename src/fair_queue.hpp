@@ -0,0 +1,149 @@
+#pragma once
+#include "queue_item.hpp"
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <random>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+
+// How the normal rotation moves on after an item has played
+enum class RotationMode : uint8_t {
+    Loop = 0,            // Play each submitter's items in order, then start over
+    Once = 1,            // Played items leave the queue
+    Shuffle = 2,         // New random order every pass, each item once per pass
+    WeightedRandom = 3,  // Independent picks, proportional to QueueItem::weight
+};
+
+const char* rotation_mode_name(RotationMode mode);
+std::optional<RotationMode> parse_rotation_mode(const std::string& name);
+
+// Per-submitter share of the rotation; quota 0 means unlimited queued items
+struct SubmitterPolicy {
+    double weight = 1.0;
+    size_t quota = 0;
+};
+
+struct SubmitterStats {
+    std::string name;
+    double weight = 1.0;
+    size_t quota = 0;
+    size_t queued = 0;     // Items in the rotation
+    double deficit = 0.0;  // Airtime credit left in the current round, in seconds
+    double airtime = 0.0;  // Total seconds played
+    size_t position = 0;   // Rotation cursor: items already played in the current pass
+};
+
+// One priority lane or one submitter's share of the rotation, frozen for a snapshot.
+// The entries are shared with the scheduler until that lane or playlist changes other
+// than at its front, so publishing after a rotation step or a pop copies no items.
+struct LineupPart {
+    std::shared_ptr<const std::vector<QueueItem>> items;  // Entries [begin, begin + count)
+    size_t begin = 0;
+    size_t count = 0;
+    size_t start = 0;  // Play order starts at this entry and wraps round
+    std::shared_ptr<const std::vector<uint32_t>> order;  // Shuffle pass over the entries, if any
+    std::vector<QueueItem> pinned;  // Played before the entries
+    size_t share = 1;               // Items per round-robin round
+
+    size_t size() const { return pinned.size() + count; }
+    const QueueItem& at(size_t k) const;  // k-th item in play order
+};
+
+// Round-robin rounds over the parts, each giving up to its share per round
+void append_round_robin(const std::vector<LineupPart>& parts, std::vector<QueueItem>& out);
+
+// Deficit round robin over per-submitter playlists. Credit is airtime in seconds:
+// each visit grants quantum * weight, each play charges a nominal quantum, and
+// record_airtime() corrects the charge once the real playback time is known.
+// In Loop and Once modes a playlist is split into the rest of the current pass and
+// the items already played, so advance() and requeueing a played item are O(1);
+// Shuffle and WeightedRandom leave the playlist in place and pick from it.
+// Not thread-safe; owned by PriorityScheduler.
+class FairQueue {
+private:
+    struct Flow {
+        std::deque<QueueItem> pinned;  // push_front(): plays before the rotation resumes
+        std::deque<QueueItem> items;   // The playlist (Loop/Once: the rest of the current pass)
+        std::deque<QueueItem> played;  // Loop/Once: played this pass, in play order; empty otherwise
+        size_t cursor = 0;             // Shuffle: next index into order
+        std::vector<uint32_t> order;   // Shuffle: permutation of items for the current pass
+        std::vector<double> alias_prob;  // WeightedRandom: Vose alias table over items
+        std::vector<uint32_t> alias;
+        bool tables_stale = true;      // order/alias no longer match items
+        double deficit = 0.0;
+        double airtime = 0.0;
+        bool active = false;
+
+        // Last frozen copy of played + items and of order; null once they change
+        mutable std::shared_ptr<const std::vector<QueueItem>> published;
+        mutable size_t published_begin = 0;  // Entries taken off its front since
+        mutable std::shared_ptr<const std::vector<uint32_t>> published_order;
+
+        size_t playlist_size() const { return played.size() + items.size(); }
+        size_t size() const { return pinned.size() + playlist_size(); }
+    };
+
+    std::unordered_map<std::string, Flow> flows_;
+    std::deque<std::string> active_;  // Round-robin order of submitters with queued items
+    std::unordered_map<std::string, SubmitterPolicy> policies_;
+    SubmitterPolicy default_policy_;
+    double quantum_seconds_;
+    size_t size_ = 0;
+    RotationMode mode_ = RotationMode::Loop;
+    std::mt19937_64 rng_;
+
+    Flow& activate(const std::string& submitter, bool at_front);
+    void deactivate(const std::string& submitter, Flow& flow);
+    Flow* next_flow();  // DRR turn: the flow that plays next, already charged
+    size_t next_index(Flow& flow);
+    void reshuffle(Flow& flow);
+    void rebuild_alias(Flow& flow);
+    // Take the next item of a flow; keep leaves it in the playlist behind the cursor
+    void take(const std::string& submitter, Flow& flow, bool keep, QueueItem& item);
+    void insert_played(Flow& flow, QueueItem item);
+    void wrap(Flow& flow);  // Loop/Once: start the next pass once the current one is used up
+    void rotation_order(const Flow& flow, std::vector<size_t>& out) const;  // Indices into played + items
+
+public:
+    explicit FairQueue(double quantum_seconds = 60.0);
+
+    void push_back(QueueItem item);
+    void push_front(QueueItem item);
+    // Remove the next item, whatever the mode
+    bool pop(QueueItem& item);
+    // Return the next item to play and move the cursor past it; in Once mode the item is removed
+    bool advance(QueueItem& item);
+    // Pop the head of one submitter's sub-queue without fairness accounting (journal replay)
+    bool pop_from(const std::string& submitter, QueueItem& item);
+    // Replay an advance of one submitter without fairness accounting
+    bool advance_from(const std::string& submitter, bool keep, QueueItem& item);
+    // Add an item that has just played (e.g. from a priority lane) so it comes round again last
+    void push_played(QueueItem item);
+    // Drop the most recently played entry with the item's submitter and source from the rotation
+    bool remove_played(const QueueItem& item);
+    void record_airtime(const std::string& submitter, double seconds);
+    void clear();
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void set_mode(RotationMode mode);
+    RotationMode mode() const { return mode_; }
+    void seed(uint64_t seed) { rng_.seed(seed); }
+
+    void set_policy(const std::string& submitter, SubmitterPolicy policy);
+    void set_default_policy(SubmitterPolicy policy);
+    SubmitterPolicy policy(const std::string& submitter) const;
+    const SubmitterPolicy& default_policy() const { return default_policy_; }
+    bool has_quotas() const;  // Some submitter, or the default policy, has a quota
+
+    // Projected play order: weighted round-robin rounds starting at the current turn,
+    // each submitter's playlist starting at its cursor
+    void append_in_order(std::vector<QueueItem>& out) const;
+    // The same order as one part per active submitter, sharing unchanged playlists
+    void freeze(std::vector<LineupPart>& out) const;
+    std::vector<SubmitterStats> stats() const;
+};
@@ -0,0 +1,460 @@
+#include "handoff.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "queue_journal.hpp"
+#include "runtime.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+constexpr uint8_t HANDOFF_VERSION = 2;  // 1 sent the elapsed seconds instead of the start time
+constexpr size_t MAX_FDS = 4;
+constexpr size_t MAX_MESSAGE = 256 * 1024;
+constexpr const char* HANDOFF_FD_ENV = "MYCHANNEL_HANDOFF_FD";
+constexpr std::chrono::seconds STATE_TIMEOUT{60};  // The old server sends at its next playout tick
+constexpr std::chrono::seconds EXIT_TIMEOUT{30};   // Its shutdown after the ack
+
+template <class T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <class T>
+bool get(std::string_view in, size_t& pos, T& value) {
+    if (in.size() - pos < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, in.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+bool get_bytes(std::string_view in, size_t& pos, size_t len, std::string& value) {
+    if (in.size() - pos < len) {
+        return false;
+    }
+    value.assign(in.data() + pos, len);
+    pos += len;
+    return true;
+}
+
+Counter& handoffs(const char* result) {
+    return metrics_registry().counter("mychannel_handoffs_total", "Restarts handed over to a successor process",
+                                      label("result", result));
+}
+
+bool send_message(int socket, const sockaddr_un* to, socklen_t to_len, std::string_view payload,
+                  const std::vector<int>& fds) {
+    if (fds.size() > MAX_FDS) {
+        return false;
+    }
+    iovec iov{const_cast<char*>(payload.data()), payload.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS)] = {};
+    msghdr message{};
+    message.msg_name = const_cast<sockaddr_un*>(to);
+    message.msg_namelen = to ? to_len : 0;
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    if (!fds.empty()) {
+        message.msg_control = control;
+        message.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+    }
+    ssize_t sent;
+    while ((sent = sendmsg(socket, &message, MSG_NOSIGNAL)) < 0 && errno == EINTR) {
+    }
+    return sent == static_cast<ssize_t>(payload.size());
+}
+
+// Waits for the peer to close its end; false on timeout
+bool wait_for_eof(int socket, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        pollfd ready{socket, POLLIN, 0};
+        int result = poll(&ready, 1, static_cast<int>(std::max<int64_t>(left.count(), 0)));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        char byte;
+        if (recv(socket, &byte, 1, 0) <= 0) {
+            return true;  // Anything else sent now is noise
+        }
+    }
+}
+
+void close_fds(const std::vector<int>& fds) {
+    for (int fd : fds) {
+        close(fd);
+    }
+}
+
+}  // namespace
+
+std::chrono::steady_clock::time_point HandoffState::started_at() const {
+    return std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(started_at_ns)));
+}
+
+double HandoffState::elapsed_seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at()).count();
+}
+
+std::string encode_handoff(const HandoffState& state) {
+    std::string out;
+    put(out, HANDOFF_VERSION);
+    std::string item = QueueJournal::encode_item(state.item);
+    put(out, static_cast<uint32_t>(item.size()));
+    out.append(item);
+    put(out, static_cast<uint8_t>(state.origin.size()));
+    out.append(state.origin, 0, UINT8_MAX);
+    put(out, state.duration);
+    put(out, state.started_at_ns);
+    put(out, static_cast<uint8_t>(state.encoder ? 1 : 0));
+    if (state.encoder) {
+        put(out, static_cast<int32_t>(state.encoder->process.pid));
+        put(out, static_cast<uint32_t>(state.encoder->pending.size()));
+        out.append(state.encoder->pending);
+    }
+    return out;
+}
+
+bool decode_handoff(std::string_view payload, HandoffState& state) {
+    size_t pos = 0;
+    uint8_t version = 0;
+    uint32_t item_len = 0;
+    uint8_t origin_len = 0;
+    uint8_t has_encoder = 0;
+    std::string item;
+    HandoffState decoded;
+    if (!get(payload, pos, version) || (version != HANDOFF_VERSION && version != 1) || !get(payload, pos, item_len) ||
+        !get_bytes(payload, pos, item_len, item) || !QueueJournal::decode_item(item, decoded.item) ||
+        !get(payload, pos, origin_len) || !get_bytes(payload, pos, origin_len, decoded.origin) ||
+        !get(payload, pos, decoded.duration)) {
+        return false;
+    }
+    if (version == 1) {
+        // From a server deployed before the start time was sent: elapsed as of sending
+        double elapsed_seconds = 0.0;
+        if (!get(payload, pos, elapsed_seconds)) {
+            return false;
+        }
+        auto started_at = std::chrono::steady_clock::now() -
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double>(elapsed_seconds));
+        decoded.started_at_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(started_at.time_since_epoch()).count();
+    } else if (!get(payload, pos, decoded.started_at_ns)) {
+        return false;
+    }
+    if (!get(payload, pos, has_encoder)) {
+        return false;
+    }
+    if (has_encoder) {
+        int32_t pid = 0;
+        uint32_t pending_len = 0;
+        EncoderHandle encoder;
+        if (!get(payload, pos, pid) || pid <= 0 || !get(payload, pos, pending_len) ||
+            !get_bytes(payload, pos, pending_len, encoder.pending)) {
+            return false;
+        }
+        encoder.process.pid = pid;
+        decoded.encoder = std::move(encoder);
+    }
+    if (pos != payload.size()) {
+        return false;
+    }
+    state = std::move(decoded);
+    return true;
+}
+
+bool send_with_fds(int socket, std::string_view payload, const std::vector<int>& fds) {
+    return send_message(socket, nullptr, 0, payload, fds);
+}
+
+bool receive_with_fds(int socket, std::string& payload, std::vector<int>& fds, std::chrono::milliseconds timeout) {
+    fds.clear();
+    pollfd ready{socket, POLLIN, 0};
+    int polled;
+    while ((polled = poll(&ready, 1, static_cast<int>(timeout.count()))) < 0 && errno == EINTR) {
+    }
+    if (polled <= 0) {
+        return false;
+    }
+    payload.resize(MAX_MESSAGE);
+    iovec iov{payload.data(), payload.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t received;
+    while ((received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR) {
+    }
+    for (cmsghdr* header = received >= 0 ? CMSG_FIRSTHDR(&message) : nullptr; header;
+         header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int* data = reinterpret_cast<const int*>(CMSG_DATA(header));
+            fds.insert(fds.end(), data, data + count);
+        }
+    }
+    if (received <= 0 || (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+        close_fds(fds);
+        fds.clear();
+        return false;
+    }
+    payload.resize(static_cast<size_t>(received));
+    return true;
+}
+
+bool notify_main_pid() {
+    const char* path = std::getenv("NOTIFY_SOCKET");
+    sockaddr_un addr{};
+    size_t len = path ? std::strlen(path) : 0;
+    if (len == 0 || len >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path, len);
+    if (addr.sun_path[0] == '@') {
+        addr.sun_path[0] = '\0';  // Abstract namespace
+    }
+    auto addr_len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + len);
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    // BARRIER=1 carries a pipe that systemd closes once it has handled everything before it,
+    // so the old process cannot exit while systemd still thinks it is the main process
+    int barrier[2] = {-1, -1};
+    bool sent = send_message(fd, &addr, addr_len, "MAINPID=" + std::to_string(getpid()), {}) &&
+                pipe2(barrier, O_CLOEXEC) == 0 && send_message(fd, &addr, addr_len, "BARRIER=1", {barrier[1]});
+    close(fd);
+    if (barrier[1] >= 0) {
+        close(barrier[1]);
+    }
+    if (barrier[0] >= 0) {
+        pollfd hangup{barrier[0], 0, 0};  // POLLHUP is always reported
+        sent = sent && poll(&hangup, 1, 5000) > 0;
+        close(barrier[0]);
+    }
+    return sent;
+}
+
+void block_handoff_signal() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+
+Handoff::Handoff(std::vector<std::string> args, HandoffOptions options) : args_(std::move(args)), options_(options) {
+    std::error_code ec;
+    executable_ = std::filesystem::read_symlink("/proc/self/exe", ec).string();
+}
+
+Handoff::~Handoff() {
+    if (watcher_.joinable()) {
+        stopping_.store(true);
+        pthread_kill(watcher_.native_handle(), SIGUSR2);
+        watcher_.join();
+    }
+    // After a completed handoff this EOF is the successor's signal that the journal and the
+    // ports are free: main destroys the Handoff after everything else
+    if (socket_ >= 0) {
+        close(socket_);
+    }
+}
+
+void Handoff::watch_signal() {
+    watcher_ = std::thread([this] {
+        enter_thread_role(ThreadRole::Background, "handoff");
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGUSR2);
+        for (int signal = 0; sigwait(&set, &signal) == 0 && !stopping_.load();) {
+            if (requested_.load()) {
+                log_warn(LogCategory::Main, "⚠️ Handoff already in progress");
+            } else {
+                begin();
+            }
+        }
+    });
+}
+
+bool Handoff::begin() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) != 0) {
+        log_error(LogCategory::Main, "❌ Handoff failed", {{"error", std::strerror(errno)}});
+        handoffs("failed").add();
+        return false;
+    }
+    // Everything the child needs is prepared before fork, as in spawn_with_policy
+    std::vector<std::string> env;
+    for (char** entry = environ; *entry; ++entry) {
+        if (!std::string_view(*entry).starts_with(std::string(HANDOFF_FD_ENV) + "=")) {
+            env.emplace_back(*entry);
+        }
+    }
+    env.push_back(std::string(HANDOFF_FD_ENV) + "=" + std::to_string(fds[1]));
+    std::vector<char*> envp;
+    for (auto& entry : env) {
+        envp.push_back(entry.data());
+    }
+    envp.push_back(nullptr);
+    std::vector<char*> argv{executable_.data()};
+    for (auto& arg : args_) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : process_cpu_set()) {
+        CPU_SET(cpu, &cpus);
+    }
+    sigset_t no_signals;
+    sigemptyset(&no_signals);
+
+    log_info(LogCategory::Main, "🤝 Starting successor for handoff", {{"executable", executable_}});
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Not the pinned CPUs or the blocked signals of the thread that forked
+        sigprocmask(SIG_SETMASK, &no_signals, nullptr);
+        if (CPU_COUNT(&cpus) > 0) {
+            sched_setaffinity(0, sizeof(cpus), &cpus);
+        }
+        fcntl(fds[1], F_SETFD, 0);
+        execve(executable_.c_str(), argv.data(), envp.data());
+        _exit(127);
+    }
+    close(fds[1]);
+    socket_ = fds[0];
+    if (pid < 0) {
+        abandon("cannot start the successor");
+        return false;
+    }
+    successor_ = pid;
+
+    std::string message;
+    std::vector<int> received;
+    if (!receive_with_fds(socket_, message, received, options_.ready_timeout) || message != "ready") {
+        close_fds(received);
+        abandon("successor did not get ready");
+        return false;
+    }
+    log_info(LogCategory::Main, "🤝 Successor ready, handing over at the next playout tick", {{"pid", pid}});
+    requested_.store(true);
+    return true;
+}
+
+bool Handoff::complete(const HandoffState& state) {
+    std::vector<int> fds;
+    if (state.encoder) {
+        fds.push_back(state.encoder->process.stdout_fd);
+        if (state.encoder->process.pidfd >= 0) {
+            fds.push_back(state.encoder->process.pidfd);
+        }
+    }
+    std::string message;
+    std::vector<int> received;
+    if (!send_with_fds(socket_, encode_handoff(state), fds)) {
+        abandon("cannot send the state");
+        return false;
+    }
+    if (!receive_with_fds(socket_, message, received, options_.ack_timeout) || message != "ack") {
+        close_fds(received);
+        abandon("successor did not take over");
+        return false;
+    }
+    handoffs("completed").add();
+    log_info(LogCategory::Main, "🤝 Handed over to successor",
+             {{"pid", successor_}, {"item", state.item.source}, {"elapsed_seconds", state.elapsed_seconds()},
+              {"encoder_pid", state.encoder ? state.encoder->process.pid : 0}});
+    return true;
+}
+
+void Handoff::abandon(const char* reason) {
+    log_error(LogCategory::Main, "❌ Handoff failed, staying on air", {{"error", reason}, {"pid", successor_}});
+    handoffs("failed").add();
+    if (successor_ > 0) {
+        kill(successor_, SIGKILL);
+        waitpid(successor_, nullptr, 0);
+        successor_ = -1;
+    }
+    if (socket_ >= 0) {
+        close(socket_);
+        socket_ = -1;
+    }
+    requested_.store(false);
+}
+
+std::optional<HandoffState> receive_handoff() {
+    const char* fd_env = std::getenv(HANDOFF_FD_ENV);
+    if (!fd_env) {
+        return std::nullopt;
+    }
+    int socket = std::atoi(fd_env);
+    unsetenv(HANDOFF_FD_ENV);
+    fcntl(socket, F_SETFD, FD_CLOEXEC);
+    pid_t predecessor = getppid();
+    log_info(LogCategory::Main, "🤝 Taking over from the running server", {{"pid", predecessor}});
+
+    HandoffState state;
+    std::string payload;
+    std::vector<int> fds;
+    if (!send_with_fds(socket, "ready", {}) || !receive_with_fds(socket, payload, fds, STATE_TIMEOUT) ||
+        !decode_handoff(payload, state) || fds.size() > (state.encoder ? 2u : 0u) ||
+        (state.encoder && fds.empty())) {
+        close_fds(fds);
+        close(socket);
+        throw std::runtime_error("The running server did not hand over");
+    }
+    if (state.encoder) {
+        state.encoder->process.stdout_fd = fds[0];
+        state.encoder->process.pidfd = fds.size() > 1 ? fds[1] : -1;
+        state.encoder->adopted = true;
+    }
+    bool systemd = notify_main_pid();
+    if (!send_with_fds(socket, "ack", {})) {
+        close_fds(fds);
+        close(socket);
+        throw std::runtime_error("The running server went away during the handoff");
+    }
+    if (!wait_for_eof(socket, EXIT_TIMEOUT)) {
+        // It has let go of the encoder; whatever holds it up must not hold up the channel
+        log_warn(LogCategory::Main, "⚠️ Previous server is slow to exit, killing it", {{"pid", predecessor}});
+        kill(predecessor, SIGKILL);
+        wait_for_eof(socket, EXIT_TIMEOUT);
+    }
+    close(socket);
+    log_info(LogCategory::Main, "🤝 Took over",
+             {{"item", state.item.source}, {"elapsed_seconds", state.elapsed_seconds()},
+              {"encoder_pid", state.encoder ? state.encoder->process.pid : 0}, {"systemd", systemd}});
+    return state;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "media_queue.hpp"
+#include "streaming.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+// Zero-downtime restarts. On SIGUSR2 the running server starts its own executable again
+// (normally a freshly deployed binary) with one end of a Unix socket. Once the successor is
+// up, the playout loop releases the encoder on air without stopping it and sends the item,
+// its position and the encoder's descriptors (SCM_RIGHTS) to the successor, which
+// supervises it from there. The queue travels through the journal: the successor opens it
+// only after the old process has exited.
+//
+//   successor                      old server
+//   ready           ---------->
+//                   <----------    state + progress pipe + pidfd
+//   MAINPID=self (systemd)
+//   ack             ---------->
+//                                  stops HTTP, closes the journal, exits
+//   EOF, opens journal, serves
+
+// What the successor resumes
+struct HandoffState {
+    QueueItem item;
+    std::string origin;  // "queue", "scheduled" or "fallback"
+    double duration = 0.0;
+    // When the item's timeline started, in steady_clock (CLOCK_MONOTONIC) nanoseconds. The
+    // clock is system-wide, so the successor's own startup counts as airtime too.
+    int64_t started_at_ns = 0;
+    std::optional<EncoderHandle> encoder;  // Empty between items
+
+    std::chrono::steady_clock::time_point started_at() const;
+    double elapsed_seconds() const;  // Up to now
+};
+
+// Wire format of the state; the encoder's descriptors travel beside it
+std::string encode_handoff(const HandoffState& state);
+bool decode_handoff(std::string_view payload, HandoffState& state);
+
+// One message and up to four descriptors over a SOCK_SEQPACKET socket
+bool send_with_fds(int socket, std::string_view payload, const std::vector<int>& fds);
+// False on timeout, error or EOF; received descriptors are close-on-exec
+bool receive_with_fds(int socket, std::string& payload, std::vector<int>& fds, std::chrono::milliseconds timeout);
+
+// Tells systemd (NOTIFY_SOCKET, needs NotifyAccess=all) that this process is now the
+// service's main process, and waits until it has taken note. False without systemd.
+bool notify_main_pid();
+
+// SIGUSR2 must be blocked in every thread for the watcher to receive it: call first thing
+// in main, before any thread starts
+void block_handoff_signal();
+
+struct HandoffOptions {
+    std::chrono::milliseconds ready_timeout{120000};  // Successor startup
+    std::chrono::milliseconds ack_timeout{10000};
+};
+
+// The old server's side
+class Handoff {
+public:
+    // Remembers the executable path now: a deploy replaces the file under the same name.
+    // Closing the socket on destruction lets the successor go on, so the owner destroys
+    // it last.
+    explicit Handoff(std::vector<std::string> args = {}, HandoffOptions options = HandoffOptions());
+    ~Handoff();
+
+    Handoff(const Handoff&) = delete;
+    Handoff& operator=(const Handoff&) = delete;
+
+    // Starts the "handoff" thread, which calls begin() on each SIGUSR2
+    void watch_signal();
+
+    // Starts the successor and waits until it is ready for the state. False (and the
+    // successor is stopped) when it exits or does not get ready in time.
+    bool begin();
+    // A successor is waiting: the playout loop should release the encoder and complete()
+    bool requested() const { return requested_.load(); }
+    // Sends the state and waits for the successor to take over; true means this process
+    // should now exit without stopping the encoder. On false the successor is stopped and
+    // the caller keeps the encoder.
+    bool complete(const HandoffState& state);
+
+    const std::string& executable() const { return executable_; }
+    pid_t successor() const { return successor_; }
+
+private:
+    void abandon(const char* reason);
+
+    std::string executable_;
+    std::vector<std::string> args_;
+    HandoffOptions options_;
+    pid_t successor_ = -1;
+    int socket_ = -1;
+    std::atomic<bool> requested_{false};
+    std::atomic<bool> stopping_{false};
+    std::thread watcher_;
+};
+
+// The successor's side: when started by Handoff (MYCHANNEL_HANDOFF_FD), takes over from the
+// old process and returns once that has exited. Nothing for a normal start. Throws
+// runtime_error when the old process goes away without handing over; starting anyway
+// could leave two servers writing the same journal.
+std::optional<HandoffState> receive_handoff();
@@ -0,0 +1,434 @@
+#include "hls.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "runtime.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t TS_PACKET = 188;
+constexpr uint8_t TS_SYNC = 0x47;
+constexpr int64_t PTS_HZ = 90000;
+constexpr int64_t PTS_MASK = (int64_t{1} << 33) - 1;
+constexpr int64_t MAX_PTS_STEP = 5 * PTS_HZ;  // A larger jump between frames is a new encoder run
+constexpr size_t PARTS_LISTED_SEGMENTS = 2;   // Complete segments whose parts stay in the playlist
+
+// Stream types of the video elementary stream in a PMT: MPEG-2, H.264, HEVC
+constexpr uint8_t VIDEO_STREAM_TYPES[] = {0x02, 0x1b, 0x24};
+
+Counter& hls_segments() {
+    static Counter& counter =
+        metrics_registry().counter("mychannel_hls_segments_total", "HLS segments cut from the encoder output");
+    return counter;
+}
+
+// a - b across the 33-bit wrap; negative when a is earlier
+int64_t pts_delta(int64_t a, int64_t b) {
+    int64_t delta = (a - b) & PTS_MASK;
+    return delta > PTS_MASK / 2 ? delta - PTS_MASK - 1 : delta;
+}
+
+double pts_seconds(int64_t ticks) {
+    return static_cast<double>(ticks) / PTS_HZ;
+}
+
+void append_fixed(std::string& out, double value, int precision = 3) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision);
+    out.append(buffer, result.ptr);
+}
+
+// Start of a PSI section in a packet payload (after the pointer field)
+const uint8_t* psi_section(const uint8_t* payload, size_t size, size_t& section_size) {
+    if (size < 1 || size_t{payload[0]} + 1 >= size) {
+        return nullptr;
+    }
+    section_size = size - 1 - payload[0];
+    return payload + 1 + payload[0];
+}
+
+bool env_number(const char* name, size_t& value) {
+    const char* text = std::getenv(name);
+    if (!text) {
+        return false;
+    }
+    std::string_view view(text);
+    size_t parsed = 0;
+    auto result = std::from_chars(view.data(), view.data() + view.size(), parsed);
+    if (result.ec != std::errc{} || result.ptr != view.data() + view.size()) {
+        log_warn(LogCategory::Stream, "⚠️ Ignoring invalid HLS setting", {{"name", name}, {"value", view}});
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+}  // namespace
+
+HlsOptions HlsOptions::from_env() {
+    HlsOptions options;
+    size_t value = 0;
+    if (env_number("MYCHANNEL_HLS_SEGMENTS", value) && value >= 3) {
+        options.playlist_segments = value;
+        options.kept_segments = std::max(options.kept_segments, value * 2);
+    }
+    if (env_number("MYCHANNEL_HLS_PART_MS", value)) {
+        options.part_target = std::chrono::milliseconds(value);
+    }
+    return options;
+}
+
+const HlsSegment* HlsWindow::find(uint64_t sequence) const {
+    if (segments.empty() || sequence < segments.front()->sequence) {
+        return open && open->sequence == sequence ? open.get() : nullptr;
+    }
+    size_t index = sequence - segments.front()->sequence;
+    if (index < segments.size()) {
+        return segments[index].get();
+    }
+    return open && open->sequence == sequence ? open.get() : nullptr;
+}
+
+bool HlsWindow::has(uint64_t sequence, std::optional<size_t> part) const {
+    const HlsSegment* segment = find(sequence);
+    if (!segment) {
+        return false;
+    }
+    return part ? *part < segment->parts.size() : segment->data != nullptr;
+}
+
+HlsOutput::HlsOutput(HlsOptions options)
+    : options_(options), window_(std::make_shared<const HlsWindow>()) {}
+
+void HlsOutput::write(std::string_view ts) {
+    size_t pos = 0;
+    if (!carry_.empty()) {
+        size_t take = std::min(TS_PACKET - carry_.size(), ts.size());
+        carry_.append(ts.substr(0, take));
+        pos = take;
+        if (carry_.size() < TS_PACKET) {
+            return;
+        }
+        packet(reinterpret_cast<const uint8_t*>(carry_.data()));
+        carry_.clear();
+    }
+    while (pos < ts.size()) {
+        // Out of sync (a reader that took over mid-packet): a sync byte counts once the
+        // packet after it starts with one too
+        if (static_cast<uint8_t>(ts[pos]) != TS_SYNC ||
+            (!synced_ && pos + TS_PACKET < ts.size() && static_cast<uint8_t>(ts[pos + TS_PACKET]) != TS_SYNC)) {
+            synced_ = false;
+            pos = ts.find(static_cast<char>(TS_SYNC), pos + 1);
+            continue;
+        }
+        synced_ = true;
+        if (ts.size() - pos < TS_PACKET) {
+            carry_.assign(ts.substr(pos));
+            break;
+        }
+        packet(reinterpret_cast<const uint8_t*>(ts.data() + pos));
+        pos += TS_PACKET;
+    }
+}
+
+void HlsOutput::packet(const uint8_t* p) {
+    int pid = ((p[1] & 0x1f) << 8) | p[2];
+    bool unit_start = p[1] & 0x40;
+    int adaptation = (p[3] >> 4) & 0x3;
+    size_t offset = 4;
+    bool random_access = false;
+    if (adaptation & 0x2) {
+        size_t length = p[4];
+        random_access = length > 0 && (p[5] & 0x40);
+        offset = 5 + length;
+    }
+    size_t payload_size = (adaptation & 0x1) && offset < TS_PACKET ? TS_PACKET - offset : 0;
+    const uint8_t* payload = p + offset;
+    std::string_view raw(reinterpret_cast<const char*>(p), TS_PACKET);
+
+    if (pid == 0) {
+        if (unit_start) {
+            parse_pat(payload, payload_size);
+        }
+        pat_packet_.assign(raw);
+    } else if (pid == pmt_pid_) {
+        if (unit_start) {
+            parse_pmt(payload, payload_size);
+        }
+        pmt_packet_.assign(raw);
+    } else if (pid == video_pid_ && unit_start && payload_size >= 14 && payload[0] == 0 && payload[1] == 0 &&
+               payload[2] == 1 && (payload[7] & 0x80)) {
+        // A video PES with a PTS: the only place segments and parts are cut
+        const uint8_t* t = payload + 9;
+        int64_t pts = (int64_t{t[0] & 0x0e} << 29) | (int64_t{t[1]} << 22) | (int64_t{t[2] & 0xfe} << 14) |
+                      (int64_t{t[3]} << 7) | (t[4] >> 1);
+        int64_t step = last_pts_ < 0 ? 0 : pts_delta(pts, last_pts_);
+        if (step < 0 || step > MAX_PTS_STEP) {
+            if (in_segment_) {
+                close_segment(last_pts_ + frame_interval_);
+                in_segment_ = false;
+                publish();
+            }
+            pending_discontinuity_ = true;
+        } else if (step > 0) {
+            frame_interval_ = step;
+        }
+        last_pts_ = pts;
+
+        if (!in_segment_) {
+            if (!random_access) {
+                return;  // Segments start with a keyframe
+            }
+            start_segment(pts, std::exchange(pending_discontinuity_, false));
+            if (options_.part_target.count() > 0) {
+                publish();  // Advertise the open segment's first part
+            }
+        } else if (random_access && pts_delta(pts, segment_start_pts_) >= std::llround(options_.target_seconds * PTS_HZ)) {
+            close_segment(pts);
+            start_segment(pts, false);
+            publish();
+        } else if (options_.part_target.count() > 0 &&
+                   pts_delta(pts, part_start_pts_) >= options_.part_target.count() * PTS_HZ / 1000) {
+            close_part(pts);
+            part_start_pts_ = pts;
+            part_independent_ = random_access;
+            publish();
+        }
+    }
+    if (in_segment_) {
+        part_data_.append(raw);
+    }
+}
+
+void HlsOutput::parse_pat(const uint8_t* payload, size_t size) {
+    size_t section_size = 0;
+    const uint8_t* s = psi_section(payload, size, section_size);
+    if (!s || section_size < 12 || s[0] != 0x00) {
+        return;
+    }
+    size_t end = std::min<size_t>(3 + (((s[1] & 0x0f) << 8) | s[2]), section_size) - 4;  // Without the CRC
+    for (size_t i = 8; i + 4 <= end; i += 4) {
+        int program = (s[i] << 8) | s[i + 1];
+        if (program != 0) {  // 0 points at the network PID
+            pmt_pid_ = ((s[i + 2] & 0x1f) << 8) | s[i + 3];
+            return;
+        }
+    }
+}
+
+void HlsOutput::parse_pmt(const uint8_t* payload, size_t size) {
+    size_t section_size = 0;
+    const uint8_t* s = psi_section(payload, size, section_size);
+    if (!s || section_size < 16 || s[0] != 0x02) {
+        return;
+    }
+    size_t end = std::min<size_t>(3 + (((s[1] & 0x0f) << 8) | s[2]), section_size) - 4;
+    size_t program_info = ((s[10] & 0x0f) << 8) | s[11];
+    for (size_t i = 12 + program_info; i + 5 <= end; i += 5 + (((s[i + 3] & 0x0f) << 8) | s[i + 4])) {
+        if (std::find(std::begin(VIDEO_STREAM_TYPES), std::end(VIDEO_STREAM_TYPES), s[i]) != std::end(VIDEO_STREAM_TYPES)) {
+            video_pid_ = ((s[i + 1] & 0x1f) << 8) | s[i + 2];
+            return;
+        }
+    }
+}
+
+void HlsOutput::start_segment(int64_t pts, bool discontinuity) {
+    current_ = HlsSegment{};
+    current_.sequence = next_sequence_;
+    current_.discontinuity = discontinuity;
+    segment_start_pts_ = pts;
+    part_start_pts_ = pts;
+    part_independent_ = true;
+    // The tables first, so a player can start decoding at any segment
+    part_data_.assign(pat_packet_);
+    part_data_.append(pmt_packet_);
+    in_segment_ = true;
+}
+
+void HlsOutput::close_part(int64_t end_pts) {
+    if (part_data_.empty()) {
+        return;
+    }
+    current_.parts.push_back({std::make_shared<const std::string>(std::move(part_data_)),
+                              pts_seconds(pts_delta(end_pts, part_start_pts_)), part_independent_});
+    part_data_.clear();
+}
+
+void HlsOutput::close_segment(int64_t end_pts) {
+    if (options_.part_target.count() > 0) {
+        close_part(end_pts);
+        std::string data;
+        size_t size = 0;
+        for (const auto& part : current_.parts) {
+            size += part.data->size();
+        }
+        data.reserve(size);
+        for (const auto& part : current_.parts) {
+            data.append(*part.data);
+        }
+        current_.data = std::make_shared<const std::string>(std::move(data));
+    } else {
+        current_.data = std::make_shared<const std::string>(std::move(part_data_));
+        part_data_.clear();
+    }
+    current_.duration = pts_seconds(pts_delta(end_pts, segment_start_pts_));
+    target_duration_ = std::max(target_duration_, current_.duration);
+    segments_.push_back(std::make_shared<const HlsSegment>(std::move(current_)));
+    current_ = HlsSegment{};
+    ++next_sequence_;
+    while (segments_.size() > std::max(options_.kept_segments, options_.playlist_segments)) {
+        discontinuities_dropped_ += segments_.front()->discontinuity;
+        segments_.erase(segments_.begin());
+    }
+    hls_segments().add();
+}
+
+void HlsOutput::publish() {
+    auto window = std::make_shared<HlsWindow>();
+    window->next_sequence = next_sequence_;
+    window->discontinuity_sequence = discontinuities_dropped_;
+    window->segments = segments_;
+    if (options_.part_target.count() > 0 && in_segment_) {
+        window->open = std::make_shared<const HlsSegment>(current_);
+    }
+    if (!segments_.empty()) {
+        window->playlist = std::make_shared<const std::string>(render_playlist(*window));
+    }
+    std::atomic_store_explicit(&window_, std::shared_ptr<const HlsWindow>(std::move(window)), std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);  // A waiter between its check and its wait sees this
+    }
+    published_.notify_all();
+}
+
+std::shared_ptr<const HlsWindow> HlsOutput::window() const {
+    return std::atomic_load_explicit(&window_, std::memory_order_acquire);
+}
+
+std::shared_ptr<const HlsWindow> HlsOutput::wait_for(uint64_t sequence, std::optional<size_t> part,
+                                                     std::chrono::milliseconds timeout) const {
+    auto current = window();
+    if (current->has(sequence, part)) {
+        return current;
+    }
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    published_.wait_for(lock, timeout, [&] {
+        current = window();
+        return current->has(sequence, part);
+    });
+    return current;
+}
+
+std::string HlsOutput::render_playlist(const HlsWindow& window) const {
+    bool low_latency = options_.part_target.count() > 0;
+    double part_target = static_cast<double>(options_.part_target.count()) / 1000.0;
+    const auto& segments = window.segments;
+    size_t first = segments.size() > options_.playlist_segments ? segments.size() - options_.playlist_segments : 0;
+    uint64_t discontinuity_sequence = window.discontinuity_sequence;
+    for (size_t i = 0; i < first; ++i) {
+        discontinuity_sequence += segments[i]->discontinuity;
+    }
+
+    std::string out = "#EXTM3U\n#EXT-X-VERSION:6\n#EXT-X-TARGETDURATION:";
+    out += std::to_string(static_cast<int>(std::ceil(std::max(target_duration_, options_.target_seconds))));
+    out += '\n';
+    if (low_latency) {
+        out += "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=";
+        append_fixed(out, part_target * 3);
+        out += "\n#EXT-X-PART-INF:PART-TARGET=";
+        append_fixed(out, part_target);
+        out += '\n';
+    }
+    out += "#EXT-X-MEDIA-SEQUENCE:" + std::to_string(segments[first]->sequence) + '\n';
+    out += "#EXT-X-DISCONTINUITY-SEQUENCE:" + std::to_string(discontinuity_sequence) + '\n';
+
+    auto append_parts = [&out](const HlsSegment& segment) {
+        for (size_t i = 0; i < segment.parts.size(); ++i) {
+            out += "#EXT-X-PART:DURATION=";
+            append_fixed(out, segment.parts[i].duration);
+            out += ",URI=\"part/" + std::to_string(segment.sequence) + '.' + std::to_string(i) + ".ts\"";
+            out += segment.parts[i].independent ? ",INDEPENDENT=YES\n" : "\n";
+        }
+    };
+    for (size_t i = first; i < segments.size(); ++i) {
+        const HlsSegment& segment = *segments[i];
+        if (segment.discontinuity) {
+            out += "#EXT-X-DISCONTINUITY\n";
+        }
+        if (low_latency && segments.size() - i <= PARTS_LISTED_SEGMENTS) {
+            append_parts(segment);
+        }
+        out += "#EXTINF:";
+        append_fixed(out, segment.duration);
+        out += ",\nseg/" + std::to_string(segment.sequence) + ".ts\n";
+    }
+    if (low_latency) {
+        size_t next_part = 0;
+        if (window.open) {
+            if (window.open->discontinuity) {
+                out += "#EXT-X-DISCONTINUITY\n";
+            }
+            append_parts(*window.open);
+            next_part = window.open->parts.size();
+        }
+        out += "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"part/" + std::to_string(window.next_sequence) + '.' +
+               std::to_string(next_part) + ".ts\"\n";
+    }
+    return out;
+}
+
+HlsIngest::HlsIngest(std::string path, HlsOutput& output) : path_(std::move(path)), output_(output) {
+    if (mkfifo(path_.c_str(), 0600) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Cannot create " + path_ + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    if (stat(path_.c_str(), &info) != 0 || !S_ISFIFO(info.st_mode)) {
+        throw std::runtime_error(path_ + " exists and is not a FIFO");
+    }
+    fd_ = open(path_.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open " + path_ + ": " + std::strerror(errno));
+    }
+    // About a second of the encoder's output: room while a handoff moves the reader
+    fcntl(fd_, F_SETPIPE_SZ, 1 << 20);
+}
+
+HlsIngest::~HlsIngest() {
+    stopping_.store(true);
+    if (reader_.joinable()) {
+        reader_.join();
+    }
+    close(fd_);
+}
+
+void HlsIngest::start() {
+    reader_ = std::thread([this] {
+        enter_thread_role(ThreadRole::Playout, "hls-ingest");
+        run();
+    });
+}
+
+void HlsIngest::run() {
+    std::string buffer(64 * 1024, '\0');
+    while (!stopping_.load()) {
+        pollfd readable{fd_, POLLIN, 0};
+        if (poll(&readable, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t n = read(fd_, buffer.data(), buffer.size());
+        if (n > 0) {
+            output_.write(std::string_view(buffer.data(), static_cast<size_t>(n)));
+        }
+    }
+}
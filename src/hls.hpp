@@ -0,0 +1,137 @@
+#pragma once
+#include "streaming_config.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Local HLS output. Besides (or instead of) RTMP, the encoder writes MPEG-TS into a FIFO;
+// the server cuts it into segments at keyframes, and optionally into LL-HLS partial
+// segments, and keeps the last few in memory for the HTTP server to serve as they are.
+
+struct HlsOptions {
+    size_t playlist_segments = 6;  // Listed in the playlist
+    size_t kept_segments = 12;     // Held in memory, so readers behind the window still get theirs
+    double target_seconds = StreamingConfig::SEGMENT_SECONDS;  // Segments end at the first keyframe after this
+    std::chrono::milliseconds part_target{0};  // LL-HLS partial segments; 0 turns them off
+
+    // MYCHANNEL_HLS_SEGMENTS and MYCHANNEL_HLS_PART_MS; invalid values keep the default
+    static HlsOptions from_env();
+};
+
+struct HlsPart {
+    std::shared_ptr<const std::string> data;
+    double duration = 0.0;
+    bool independent = false;  // Starts with a keyframe
+};
+
+struct HlsSegment {
+    uint64_t sequence = 0;
+    double duration = 0.0;
+    bool discontinuity = false;  // Timestamps restarted: the next item's encoder
+    std::shared_ptr<const std::string> data;  // Null while the segment is still being written
+    std::vector<HlsPart> parts;  // With part_target only
+};
+
+// What readers see, published as a whole after every part and segment
+struct HlsWindow {
+    uint64_t next_sequence = 0;  // Sequence of the segment being written
+    uint64_t discontinuity_sequence = 0;  // Discontinuities before the first kept segment
+    std::vector<std::shared_ptr<const HlsSegment>> segments;  // Complete, oldest first
+    std::shared_ptr<const HlsSegment> open;  // Parts of the segment being written; null without parts
+    std::shared_ptr<const std::string> playlist;  // Null until the first segment is complete
+
+    const HlsSegment* find(uint64_t sequence) const;
+    // True once the segment (or the given part of it) can be served
+    bool has(uint64_t sequence, std::optional<size_t> part) const;
+};
+
+class HlsOutput {
+public:
+    explicit HlsOutput(HlsOptions options = HlsOptions());
+
+    HlsOutput(const HlsOutput&) = delete;
+    HlsOutput& operator=(const HlsOutput&) = delete;
+
+    // Encoder output in any chunking, from one thread. Nothing is kept before the first
+    // keyframe. A timestamp jump ends the segment and marks a discontinuity.
+    void write(std::string_view ts);
+
+    // Lock-free for readers
+    std::shared_ptr<const HlsWindow> window() const;
+    // Waits until the segment, or the part of it, is published (LL-HLS blocking reloads
+    // and preload hints); whatever is published when the timeout passes
+    std::shared_ptr<const HlsWindow> wait_for(uint64_t sequence, std::optional<size_t> part,
+                                              std::chrono::milliseconds timeout) const;
+
+    const HlsOptions& options() const { return options_; }
+
+private:
+    void packet(const uint8_t* p);
+    void parse_pat(const uint8_t* payload, size_t size);
+    void parse_pmt(const uint8_t* payload, size_t size);
+    void start_segment(int64_t pts, bool discontinuity);
+    void close_part(int64_t end_pts);
+    void close_segment(int64_t end_pts);
+    void publish();
+    std::string render_playlist(const HlsWindow& window) const;
+
+    const HlsOptions options_;
+
+    // Ingest state, owned by the writing thread
+    std::string carry_;  // Bytes of an incomplete packet
+    bool synced_ = false;
+    int pmt_pid_ = -1;
+    int video_pid_ = -1;
+    std::string pat_packet_;
+    std::string pmt_packet_;
+    bool in_segment_ = false;
+    bool pending_discontinuity_ = false;
+    int64_t segment_start_pts_ = 0;
+    int64_t part_start_pts_ = 0;
+    int64_t last_pts_ = -1;
+    int64_t frame_interval_ = 3000;  // 90 kHz ticks; refined from the stream
+    bool part_independent_ = false;
+    std::string part_data_;
+    HlsSegment current_;
+    std::vector<std::shared_ptr<const HlsSegment>> segments_;
+    uint64_t next_sequence_ = 0;
+    uint64_t discontinuities_dropped_ = 0;  // Discontinuities of segments no longer kept
+    double target_duration_ = 0.0;  // Largest segment so far; EXT-X-TARGETDURATION never shrinks
+
+    std::shared_ptr<const HlsWindow> window_;  // atomic_load / atomic_store
+    mutable std::mutex wait_mutex_;
+    mutable std::condition_variable published_;
+};
+
+// Reads the encoder's MPEG-TS from a FIFO into an HlsOutput on a "hls-ingest" thread. The
+// FIFO is opened read-write, so it never reports end of file between items and the encoder
+// never blocks opening it. Opening it early keeps a reader on it across a handoff.
+class HlsIngest {
+public:
+    // Creates the FIFO when it does not exist; throws runtime_error when it cannot
+    HlsIngest(std::string path, HlsOutput& output);
+    ~HlsIngest();
+
+    HlsIngest(const HlsIngest&) = delete;
+    HlsIngest& operator=(const HlsIngest&) = delete;
+
+    void start();
+    const std::string& path() const { return path_; }
+
+private:
+    void run();
+
+    std::string path_;
+    HlsOutput& output_;
+    int fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::thread reader_;
+};
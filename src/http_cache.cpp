@@ -0,0 +1,201 @@
+#include "http_cache.hpp"
+#include <zlib.h>
+#include <charconv>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+// The quoted part of an entity tag, without a W/ prefix
+std::string_view opaque_tag(std::string_view etag) {
+    if (etag.starts_with("W/")) {
+        etag.remove_prefix(2);
+    }
+    return etag;
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+}  // namespace
+
+const char* content_encoding_name(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::Gzip: return "gzip";
+        case ContentEncoding::Deflate: return "deflate";
+        case ContentEncoding::Identity: break;
+    }
+    return "";
+}
+
+ContentEncoding negotiate_encoding(std::string_view accept_encoding) {
+    bool gzip = false;
+    bool deflate = false;
+    while (!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view entry = accept_encoding.substr(0, comma);
+        accept_encoding = comma == std::string_view::npos ? std::string_view{} : accept_encoding.substr(comma + 1);
+
+        size_t semicolon = entry.find(';');
+        std::string_view coding = entry.substr(0, semicolon);
+        while (!coding.empty() && is_space(coding.front())) coding.remove_prefix(1);
+        while (!coding.empty() && is_space(coding.back())) coding.remove_suffix(1);
+
+        // q=0 means "not acceptable"; any other weight is taken as acceptable
+        bool refused = false;
+        if (semicolon != std::string_view::npos) {
+            std::string_view params = entry.substr(semicolon + 1);
+            size_t q = params.find("q=");
+            if (q != std::string_view::npos) {
+                std::string_view weight = params.substr(q + 2);
+                while (!weight.empty() && is_space(weight.back())) weight.remove_suffix(1);
+                refused = weight.find_first_not_of("0.") == std::string_view::npos;
+            }
+        }
+        if (refused) {
+            continue;
+        }
+        if (coding == "gzip" || coding == "x-gzip" || coding == "*") {
+            gzip = true;
+        } else if (coding == "deflate") {
+            deflate = true;
+        }
+    }
+    return gzip ? ContentEncoding::Gzip : deflate ? ContentEncoding::Deflate : ContentEncoding::Identity;
+}
+
+std::string compress(std::string_view data, ContentEncoding encoding) {
+    if (encoding == ContentEncoding::Identity) {
+        return std::string(data);
+    }
+    z_stream stream{};
+    int window_bits = encoding == ContentEncoding::Gzip ? 15 + 16 : 15;  // +16 writes a gzip wrapper
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+    std::string out(deflateBound(&stream, data.size()) + 32, '\0');  // Bound excludes the gzip wrapper
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error("deflate failed");
+    }
+    return out;
+}
+
+std::string snapshot_etag(uint64_t revision) {
+    static const std::string boot = [] {
+        auto now = std::chrono::system_clock::now().time_since_epoch().count();
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<uint64_t>(now), 36);
+        return std::string(buffer, result.ptr);
+    }();
+    std::string etag = "W/\"" + boot + '.';
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), revision);
+    etag.append(buffer, result.ptr);
+    etag += '"';
+    return etag;
+}
+
+bool etag_matches(std::string_view if_none_match, std::string_view etag) {
+    std::string_view wanted = opaque_tag(etag);
+    size_t i = 0;
+    while (i < if_none_match.size()) {
+        char c = if_none_match[i];
+        if (is_space(c) || c == ',') {
+            ++i;
+            continue;
+        }
+        if (c == '*') {
+            return true;
+        }
+        size_t start = i;
+        if (if_none_match.substr(i).starts_with("W/")) {
+            i += 2;
+        }
+        if (i >= if_none_match.size() || if_none_match[i] != '"') {
+            return false;  // Malformed; treat as no match so the full response is sent
+        }
+        size_t close = if_none_match.find('"', i + 1);
+        if (close == std::string_view::npos) {
+            return false;
+        }
+        if (opaque_tag(if_none_match.substr(start, close + 1 - start)) == wanted) {
+            return true;
+        }
+        i = close + 1;
+    }
+    return false;
+}
+
+std::shared_ptr<const std::string>& ResponseCache::slot(Entry& entry, ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::Gzip: return entry.gzip;
+        case ContentEncoding::Deflate: return entry.deflate;
+        case ContentEncoding::Identity: break;
+    }
+    return entry.identity;
+}
+
+ResponseCache::Body ResponseCache::get(const std::string& key, uint64_t revision, ContentEncoding encoding,
+                                       const std::function<std::string()>& render) {
+    std::shared_ptr<const std::string> identity;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end() && it->second.revision == revision) {
+            Entry& entry = it->second;
+            if (auto& cached = slot(entry, encoding)) {
+                ++hits_;
+                return {cached, encoding};
+            }
+            if (entry.identity && entry.identity->size() < MIN_COMPRESS_BYTES) {
+                ++hits_;
+                return {entry.identity, ContentEncoding::Identity};
+            }
+            identity = entry.identity;  // Only the compressed form is missing
+        }
+    }
+
+    if (!identity) {
+        identity = std::make_shared<const std::string>(render());
+    }
+    Body body{identity, ContentEncoding::Identity};
+    if (encoding != ContentEncoding::Identity && identity->size() >= MIN_COMPRESS_BYTES) {
+        body = {std::make_shared<const std::string>(compress(*identity, encoding)), encoding};
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++misses_;
+    if (!entries_.contains(key) && entries_.size() >= max_keys_) {
+        entries_.clear();  // Paging parameters are client chosen; start over rather than grow
+    }
+    Entry& entry = entries_[key];
+    if (entry.revision > revision) {
+        return body;  // A newer revision was stored while this one rendered
+    }
+    if (entry.revision < revision) {
+        entry = Entry{revision};
+    }
+    entry.identity = identity;
+    if (body.encoding != ContentEncoding::Identity) {
+        slot(entry, body.encoding) = body.data;
+    }
+    return body;
+}
+
+uint64_t ResponseCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+uint64_t ResponseCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
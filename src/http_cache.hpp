@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Conditional GET and response compression for the read endpoints that are built from a
+// queue snapshot (/queue, /queue/position, /status). Every published snapshot has a
+// revision; it is the ETag of everything rendered from it, so a poll that already has the
+// current revision is answered 304 without serializing anything, and a body rendered
+// (and compressed) for a revision is reused until the next one is published.
+
+enum class ContentEncoding { Identity, Gzip, Deflate };
+
+inline constexpr size_t MIN_COMPRESS_BYTES = 1024;  // Smaller bodies are sent as they are
+
+const char* content_encoding_name(ContentEncoding encoding);  // "gzip", "deflate"; "" for identity
+
+// Best encoding the client accepts per its Accept-Encoding header; gzip before deflate
+ContentEncoding negotiate_encoding(std::string_view accept_encoding);
+
+// gzip or zlib ("deflate" in HTTP) at the default level; identity returns data unchanged
+std::string compress(std::string_view data, ContentEncoding encoding);
+
+// W/"<boot>.<revision>". The boot part changes on restart, so a client holding a tag
+// from a previous process never gets a 304 for different contents.
+std::string snapshot_etag(uint64_t revision);
+
+// If-None-Match check with weak comparison (RFC 9110 13.1.2); handles lists and "*"
+bool etag_matches(std::string_view if_none_match, std::string_view etag);
+
+// Rendered bodies keyed by route and parameters, each valid for one snapshot revision.
+// Thread safe; renders and compresses outside the lock, so a slow render never blocks
+// hits on other keys.
+class ResponseCache {
+public:
+    struct Body {
+        std::shared_ptr<const std::string> data;
+        ContentEncoding encoding = ContentEncoding::Identity;  // What data is actually in
+    };
+
+    explicit ResponseCache(size_t max_keys = 64) : max_keys_(max_keys) {}
+
+    // render() produces the identity body on a miss. Bodies under MIN_COMPRESS_BYTES are
+    // returned uncompressed whatever encoding was asked for.
+    Body get(const std::string& key, uint64_t revision, ContentEncoding encoding,
+             const std::function<std::string()>& render);
+
+    uint64_t hits() const;
+    uint64_t misses() const;  // Renders and compressions
+
+private:
+    struct Entry {
+        uint64_t revision = 0;
+        std::shared_ptr<const std::string> identity;
+        std::shared_ptr<const std::string> gzip;
+        std::shared_ptr<const std::string> deflate;
+    };
+    std::shared_ptr<const std::string>& slot(Entry& entry, ContentEncoding encoding);
+
+    const size_t max_keys_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
@@ -1,21 +1,383 @@
 #include "http_server.hpp"
 #include "streaming.hpp"
-#include <iostream>
+#include "media_info.hpp"
+#include "playlist_import.hpp"
+#include "json_response.hpp"
+#include "http_cache.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "rate_limiter.hpp"
+#include "runtime.hpp"
+#include "utils.hpp"
+#include <functional>
 #include <future>
 #include <cstdlib>
-#include <filesystem>
 #include <string>
+#include <algorithm>
+#include <charconv>
+#include <thread>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+template <class T>
+void send_json(httplib::Response& res, const T& body, int status = 200) {
+    res.status = status;
+    res.set_content(write_json_response(body), "application/json");
+}
 
-HttpServer::HttpServer(ThreadSafeMediaQueue& queue) : media_queue_(queue) {
+void send_error(httplib::Response& res, int status, std::string_view message) {
+    send_json(res, ErrorResponse{.message = message}, status);
+}
+
+// Conditional GET for a body rendered from one queue snapshot: 304 when the client already
+// has this revision, otherwise the body cached for it, compressed when the client accepts it
+void send_snapshot_json(const httplib::Request& req, httplib::Response& res, ResponseCache& cache,
+                        const std::string& key, uint64_t revision, const std::function<std::string()>& render) {
+    std::string etag = snapshot_etag(revision);
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", "no-cache");  // Revalidate every time; a 304 is cheap
+    res.set_header("Vary", "Accept-Encoding");
+    if (etag_matches(req.get_header_value("If-None-Match"), etag)) {
+        res.status = 304;
+        return;
+    }
+    auto body = cache.get(key, revision, negotiate_encoding(req.get_header_value("Accept-Encoding")), render);
+    if (body.encoding != ContentEncoding::Identity) {
+        res.set_header("Content-Encoding", content_encoding_name(body.encoding));
+    }
+    res.status = 200;
+    res.set_content(*body.data, "application/json");
+}
+
+// Set by the pre-routing handler and read by the logger, which run on the same worker thread
+thread_local std::chrono::steady_clock::time_point request_started;
+thread_local AdmissionGate* held_admission = nullptr;  // In-flight slot taken for the current request
+
+void release_admission() {
+    if (held_admission) {
+        held_admission->leave();
+        held_admission = nullptr;
+    }
+}
+
+// Class a request is charged to; none for preflights and scrapes
+std::optional<RateClass> rate_class(const httplib::Request& req) {
+    if (req.method == "OPTIONS" || req.path == "/metrics") {
+        return std::nullopt;
+    }
+    if (req.method == "GET") {
+        return RateClass::Read;
+    }
+    if (req.path == "/queue/priority") {
+        return RateClass::Priority;
+    }
+    if (req.path == "/" || req.path == "/mcp/call") {
+        return RateClass::Mcp;
+    }
+    return RateClass::Write;
+}
+
+Counter& rate_limited(RateClass cls) {
+    static const auto counters = [] {
+        std::array<Counter*, RATE_CLASS_COUNT> counters{};
+        for (size_t i = 0; i < RATE_CLASS_COUNT; ++i) {
+            counters[i] = &metrics_registry().counter("mychannel_http_rate_limited_total",
+                                                      "Requests answered 429 by the per-client rate limit, by class",
+                                                      label("class", rate_class_name(static_cast<RateClass>(i))));
+        }
+        return counters;
+    }();
+    return *counters[static_cast<size_t>(cls)];
+}
+
+Counter& admission_rejected() {
+    static Counter& counter = metrics_registry().counter(
+        "mychannel_http_admission_rejected_total", "Requests answered 429 because the in-flight limit was reached");
+    return counter;
+}
+
+void send_too_many_requests(httplib::Response& res, std::chrono::nanoseconds retry_after, std::string_view message) {
+    auto seconds = std::max<int64_t>(1, std::chrono::ceil<std::chrono::seconds>(retry_after).count());
+    res.set_header("Retry-After", std::to_string(seconds));
+    send_error(res, 429, message);
+}
+
+constexpr size_t MAX_ROUTE_SERIES = 64;
+
+// Latency histogram of the request's route. 404s share one series so scans cannot add
+// labels; each worker caches what it has resolved, so a known route is recorded without a lock.
+Histogram& route_latency(const httplib::Request& req, int status) {
+    std::string route = status == 404 ? "unmatched" : req.method == "OPTIONS" ? "OPTIONS" : req.method + " " + req.path;
+    if (req.path.starts_with("/hls/seg/")) {
+        route = req.method + " /hls/seg";  // One series for every segment
+    } else if (req.path.starts_with("/hls/part/")) {
+        route = req.method + " /hls/part";
+    }
+    thread_local std::unordered_map<std::string, Histogram*> cache;
+    if (auto it = cache.find(route); it != cache.end()) {
+        return *it->second;
+    }
+
+    static std::mutex routes_mutex;
+    static std::unordered_set<std::string> routes;
+    std::string series = route;
+    {
+        std::lock_guard<std::mutex> lock(routes_mutex);
+        if (!routes.contains(route) && routes.size() >= MAX_ROUTE_SERIES) {
+            series = "other";
+        } else {
+            routes.insert(route);
+        }
+    }
+    Histogram& histogram = metrics_registry().histogram(
+        "mychannel_http_request_duration_seconds", "HTTP request handling time by route", latency_buckets(),
+        label("route", series));
+    cache.emplace(std::move(route), &histogram);
+    return histogram;
+}
+
+// Totals over every connection queue, for /metrics
+std::atomic<int64_t> active_connections{0};
+std::atomic<int64_t> waiting_connections{0};
+
+Counter& rejected_connections() {
+    static Counter& counter = []() -> Counter& {
+        auto& registry = metrics_registry();
+        registry.gauge_callback("mychannel_http_active_connections", "Connections being served by an HTTP worker",
+                                [] { return static_cast<double>(active_connections.load(std::memory_order_relaxed)); });
+        registry.gauge_callback("mychannel_http_waiting_connections", "Accepted connections waiting for an HTTP worker",
+                                [] { return static_cast<double>(waiting_connections.load(std::memory_order_relaxed)); });
+        return registry.counter("mychannel_http_rejected_connections_total",
+                                "Connections closed at once because max_connections were open");
+    }();
+    return counter;
+}
+
+Counter& hls_served_bytes() {
+    static Counter& counter =
+        metrics_registry().counter("mychannel_hls_served_bytes_total", "HLS segment and part bytes served");
+    return counter;
+}
+
+// A segment or part straight from the buffer the segmenter filled: httplib writes from
+// it, nothing is copied into the response
+void send_shared(httplib::Response& res, std::shared_ptr<const std::string> body, const char* content_type) {
+    size_t size = body->size();
+    hls_served_bytes().add(size);
+    res.set_header("Cache-Control", "max-age=60");  // Never changes once published
+    res.set_content_provider(size, content_type,
+                             [body = std::move(body)](size_t offset, size_t length, httplib::DataSink& sink) {
+                                 return sink.write(body->data() + offset, length);
+                             });
+}
+
+template <class T>
+bool parse_number(std::string_view text, T& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc{} && result.ptr == text.data() + text.size();
+}
+
+// Longest a blocking playlist reload or preload hint waits: three part or segment targets
+std::chrono::milliseconds hls_block_timeout(const HlsOptions& options) {
+    auto target = options.part_target.count() > 0
+                      ? options.part_target
+                      : std::chrono::milliseconds(static_cast<int64_t>(options.target_seconds * 1000));
+    return target * 3;
+}
+
+// Positive integer setting from the environment; anything else is reported and ignored
+bool env_count(const char* name, size_t& value) {
+    const char* text = std::getenv(name);
+    if (!text) {
+        return false;
+    }
+    std::string_view view(text);
+    size_t parsed = 0;
+    auto result = std::from_chars(view.data(), view.data() + view.size(), parsed);
+    if (result.ec != std::errc{} || result.ptr != view.data() + view.size() || parsed == 0) {
+        log_warn(LogCategory::Http, "⚠️ Ignoring invalid HTTP setting", {{"name", name}, {"value", view}});
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+} // namespace
+
+HttpConnectionQueue::HttpConnectionQueue(size_t workers, size_t max_waiting)
+    : limit_(workers + std::max<size_t>(max_waiting, 1)),
+      workers_(std::make_unique<ToolExecutor>(workers, limit_, ThreadRole::Http, "http")) {
+    rejected_connections();  // Registers the connection metrics
+}
+
+bool HttpConnectionQueue::enqueue(std::function<void()> fn) {
+    // Counted here rather than by the executor, whose bound only covers jobs no worker has
+    // picked up yet: a burst would otherwise be refused before the workers wake
+    if (!workers_) {
+        return false;  // Shut down
+    }
+    if (open_.fetch_add(1, std::memory_order_acq_rel) >= limit_) {
+        open_.fetch_sub(1, std::memory_order_acq_rel);
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        rejected_connections().add();
+        return false;
+    }
+    waiting_.fetch_add(1, std::memory_order_relaxed);
+    waiting_connections.fetch_add(1, std::memory_order_relaxed);
+    bool queued = workers_->submit([this, fn = std::move(fn)] {
+        waiting_.fetch_sub(1, std::memory_order_relaxed);
+        waiting_connections.fetch_sub(1, std::memory_order_relaxed);
+        active_.fetch_add(1, std::memory_order_relaxed);
+        active_connections.fetch_add(1, std::memory_order_relaxed);
+        fn();
+        active_.fetch_sub(1, std::memory_order_relaxed);
+        active_connections.fetch_sub(1, std::memory_order_relaxed);
+        open_.fetch_sub(1, std::memory_order_acq_rel);
+    });
+    if (!queued) {
+        waiting_.fetch_sub(1, std::memory_order_relaxed);
+        waiting_connections.fetch_sub(1, std::memory_order_relaxed);
+        open_.fetch_sub(1, std::memory_order_acq_rel);
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        rejected_connections().add();
+    }
+    return queued;
+}
+
+void HttpConnectionQueue::shutdown() {
+    workers_.reset();
+}
+
+HttpServer::Options HttpServer::Options::from_env() {
+    Options options;
+    size_t value = 0;
+    env_count("MYCHANNEL_HTTP_THREADS", options.worker_threads);
+    env_count("MYCHANNEL_HTTP_MAX_CONNECTIONS", options.max_connections);
+    env_count("MYCHANNEL_HTTP_KEEPALIVE_REQUESTS", options.keep_alive_max_requests);
+    if (env_count("MYCHANNEL_HTTP_KEEPALIVE_TIMEOUT", value)) {
+        options.keep_alive_timeout = std::chrono::seconds(value);
+    }
+    if (env_count("MYCHANNEL_HTTP_READ_TIMEOUT_MS", value)) {
+        options.read_timeout = std::chrono::milliseconds(value);
+    }
+    if (env_count("MYCHANNEL_HTTP_WRITE_TIMEOUT_MS", value)) {
+        options.write_timeout = std::chrono::milliseconds(value);
+    }
+    env_count("MYCHANNEL_HTTP_MAX_PAYLOAD", options.max_payload_bytes);
+    env_count("MYCHANNEL_HTTP_MAX_INFLIGHT", options.max_inflight_requests);
+    env_count("MYCHANNEL_HTTP_MAX_INFLIGHT_MCP", options.max_inflight_mcp);
+    if (const char* validation = std::getenv("MYCHANNEL_VALIDATION")) {
+        options.validate_on_add = std::string_view(validation) != "off";
+    }
+    env_count("MYCHANNEL_VALIDATION_WORKERS", options.validation.workers);
+    env_count("MYCHANNEL_VALIDATION_MAX_PENDING", options.validation.max_pending);
+    if (const char* import_dir = std::getenv("MYCHANNEL_IMPORT_DIR")) {
+        options.import_dir = import_dir;
+    }
+    if (const char* limits = std::getenv("MYCHANNEL_RATE_LIMITS")) {
+        if (!parse_rate_limits(limits, options.rate_limits)) {
+            log_warn(LogCategory::Http, "⚠️ Ignoring invalid rate limit entries", {{"value", limits}});
+        }
+    }
+    return options;
+}
+
+size_t HttpServer::Options::inflight_limit() const {
+    return max_inflight_requests > 0 ? max_inflight_requests : std::max<size_t>(1, workers() / 2);
+}
+
+size_t HttpServer::Options::mcp_inflight_limit() const {
+    return max_inflight_mcp > 0 ? max_inflight_mcp : std::max<size_t>(1, workers() / 4);
+}
+
+size_t HttpServer::Options::workers() const {
+    if (worker_threads > 0) {
+        return worker_threads;
+    }
+    unsigned hardware = std::thread::hardware_concurrency();
+    return std::max<size_t>(8, hardware > 0 ? hardware - 1 : 0);
+}
+
+HttpServer::HttpServer(ThreadSafeMediaQueue& queue, EventScheduler* event_scheduler)
+    : HttpServer(queue, event_scheduler, Options{}) {}
+
+HttpServer::HttpServer(ThreadSafeMediaQueue& queue, EventScheduler* event_scheduler, Options options)
+    : media_queue_(queue), event_scheduler_(event_scheduler), options_(options),
+      rate_limiter_(options_.rate_limits), admission_(options_.inflight_limit(), options_.mcp_inflight_limit()) {
     // Read authentication token from environment variable
     const char* token_env = std::getenv("MYCHANNEL_AUTH_TOKEN");
     if (token_env) {
         auth_token_ = token_env;
-        std::cout << "🔐 Authentication enabled with token" << std::endl;
+        log_info(LogCategory::Http, "🔐 Authentication enabled with token");
     } else {
-        std::cout << "⚠️ No MYCHANNEL_AUTH_TOKEN set - authentication disabled" << std::endl;
+        log_warn(LogCategory::Http, "⚠️ No MYCHANNEL_AUTH_TOKEN set - authentication disabled");
+    }
+    if (options_.validate_on_add) {
+        // Rotation and play-next submissions wait for a probe; interrupting classes cut in at once
+        validation_ = std::make_unique<ValidationJobs>(options_.validation, [this](const QueueItem& item) {
+            bool queued = item.priority == PriorityClass::Normal
+                              ? media_queue_.push(item.source, item.submitter, item.weight)
+                              : media_queue_.enqueue(item.source, item.priority, item.submitter).has_value();
+            if (!queued) {
+                return "Queue quota exceeded for submitter " + item.submitter;
+            }
+            return std::string();
+        });
     }
     setup_routes();
+    apply_options();
+}
+
+void HttpServer::apply_options() {
+    size_t workers = options_.workers();
+    size_t max_waiting = options_.max_connections > workers ? options_.max_connections - workers : 1;
+    server_.new_task_queue = [workers, max_waiting] { return new HttpConnectionQueue(workers, max_waiting); };
+    server_.set_keep_alive_max_count(options_.keep_alive_max_requests);
+    server_.set_keep_alive_timeout(options_.keep_alive_timeout.count());
+    auto read_ms = options_.read_timeout.count();
+    auto write_ms = options_.write_timeout.count();
+    server_.set_read_timeout(read_ms / 1000, (read_ms % 1000) * 1000);
+    server_.set_write_timeout(write_ms / 1000, (write_ms % 1000) * 1000);
+    server_.set_payload_max_length(options_.max_payload_bytes);
+    server_.set_tcp_nodelay(options_.tcp_nodelay);
+}
+
+bool HttpServer::admit(const httplib::Request& req, httplib::Response& res) {
+    auto cls = rate_class(req);
+    if (!cls) {
+        return true;
+    }
+    // Buckets are per credential and address, so a client cannot get a fresh one by
+    // sending made-up tokens
+    std::string client = (is_authenticated(req) && !auth_token_.empty() ? auth_token_ : std::string()) + '@' +
+                         req.remote_addr;
+    auto decision = rate_limiter_.admit(client, *cls);
+    if (!decision.admitted) {
+        rate_limited(*cls).add();
+        send_too_many_requests(res, decision.retry_after,
+                               std::string("Rate limit exceeded for ") + rate_class_name(*cls) + " requests");
+        return false;
+    }
+    AdmissionGate* gate = admission_.gate(*cls);
+    if (!gate) {
+        return true;
+    }
+    if (!gate->try_enter()) {
+        admission_rejected().add();
+        send_too_many_requests(res, std::chrono::seconds(1), "Server busy, retry later");
+        return false;
+    }
+    held_admission = gate;
+    return true;
 }
 
 bool HttpServer::is_authenticated(const httplib::Request& req) const {
@@ -44,57 +406,58 @@ bool HttpServer::is_authenticated(const httplib::Request& req) const {
     return false;
 }
 
-bool HttpServer::is_valid_media_item(const std::string& item, std::string& error_message) const {
-    // If it's a URL (starts with http:// or https://), assume it's valid
-    // The streaming component will handle URL validation
-    if (item.starts_with("http://") || item.starts_with("https://")) {
-        return true;
-    }
-    
-    // For local files, check if they exist
-    std::filesystem::path file_path(item);
-    
-    // Convert relative paths to absolute paths based on working directory
-    if (file_path.is_relative()) {
-        file_path = std::filesystem::current_path() / file_path;
+bool HttpServer::get_submitter(const httplib::Request& req, std::string& submitter) const {
+    submitter = req.get_header_value("X-Submitter");
+    if (submitter.empty() && req.has_param("submitter")) {
+        submitter = req.get_param_value("submitter");
     }
-    
-    if (!std::filesystem::exists(file_path)) {
-        error_message = "File does not exist: " + file_path.string();
-        return false;
-    }
-    
-    if (!std::filesystem::is_regular_file(file_path)) {
-        error_message = "Path is not a regular file: " + file_path.string();
-        return false;
+    if (submitter.empty()) {
+        submitter = DEFAULT_SUBMITTER;
     }
-    
-    // Check if file is readable
-    std::error_code ec;
-    auto perms = std::filesystem::status(file_path, ec).permissions();
-    if (ec) {
-        error_message = "Cannot check file permissions: " + ec.message();
-        return false;
+    return submitter.size() <= MAX_SUBMITTER_LENGTH;
+}
+
+uint64_t HttpServer::schedule_event(ScheduledEvent event) {
+    if (event.duration == 0.0) {
+        // For the EPG stop time; 0 while unknown
+        event.duration = cached_media_duration(event.item.source).value_or(0.0);
     }
-    
-    // Basic check for read permissions
-    if ((perms & std::filesystem::perms::owner_read) == std::filesystem::perms::none &&
-        (perms & std::filesystem::perms::group_read) == std::filesystem::perms::none &&
-        (perms & std::filesystem::perms::others_read) == std::filesystem::perms::none) {
-        error_message = "File is not readable: " + file_path.string();
-        return false;
+    std::string source = event.item.source;
+    bool unknown = event.duration == 0.0;
+    uint64_t id = event_scheduler_->schedule(std::move(event));
+    if (unknown && validation_) {
+        validation_->probe_async(std::move(source), [this, id](std::optional<MediaProbe> media) {
+            if (media && media->duration > 0) {
+                event_scheduler_->set_duration(id, media->duration);
+            }
+        });
     }
-    
-    return true;
+    return id;
+}
+
+bool HttpServer::is_valid_media_item(const std::string& item, std::string& error_message) const {
+    return validate_media_source(item, error_message);
 }
 
 void HttpServer::setup_routes() {
-    // CORS headers for all responses
-    server_.set_pre_routing_handler([](const httplib::Request& req, httplib::Response& res) {
+    // CORS headers for all responses, then rate limits and admission control before any handler work
+    server_.set_pre_routing_handler([this](const httplib::Request& req, httplib::Response& res) {
+        release_admission();  // In case the previous request on this worker never reached the logger
+        request_started = std::chrono::steady_clock::now();
         res.set_header("Access-Control-Allow-Origin", "*");
         res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-        res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
-        return httplib::Server::HandlerResponse::Unhandled;
+        res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization, If-None-Match");
+        res.set_header("Access-Control-Expose-Headers", "ETag, Retry-After");
+        return admit(req, res) ? httplib::Server::HandlerResponse::Unhandled : httplib::Server::HandlerResponse::Handled;
+    });
+
+    server_.set_logger([](const httplib::Request& req, const httplib::Response& res) {
+        release_admission();
+        if (request_started == std::chrono::steady_clock::time_point{}) {
+            return;  // Rejected before routing (malformed request)
+        }
+        route_latency(req, res.status).observe(std::chrono::steady_clock::now() - request_started);
+        request_started = {};
     });
 
     // Handle OPTIONS requests for CORS preflight
@@ -103,136 +466,592 @@ void HttpServer::setup_routes() {
     });
 
     // GET /queue - Get current queue status
-    server_.Get("/queue", [this](const httplib::Request&, httplib::Response& res) {
-        std::cout << "🔍 DEBUG: GET /queue request received" << std::endl;
-        auto items = media_queue_.get_all_items();
-        std::string json_response = "{\"queue\":[";
-        for (size_t i = 0; i < items.size(); ++i) {
-            json_response += "\"" + items[i] + "\"";
-            if (i < items.size() - 1) json_response += ",";
+    // Optional ?offset=<n>&limit=<n> for paginated reads; ETag / If-None-Match per snapshot revision
+    server_.Get("/queue", [this](const httplib::Request& req, httplib::Response& res) {
+        // Work from an immutable snapshot so readers never block the playout loop
+        auto snapshot = media_queue_.snapshot();
+
+        size_t offset = 0;
+        size_t limit = snapshot->items.size();
+        try {
+            if (req.has_param("offset")) offset = std::stoul(req.get_param_value("offset"));
+            if (req.has_param("limit")) limit = std::stoul(req.get_param_value("limit"));
+        } catch (const std::exception&) {
+            send_error(res, 400, "Invalid offset or limit");
+            return;
         }
-        json_response += "],\"size\":" + std::to_string(items.size()) + "}";
-        std::cout << "🔍 DEBUG: Returning queue with " << items.size() << " items" << std::endl;
-        res.set_content(json_response, "application/json");
+        std::string key = "queue " + std::to_string(offset) + " " + (req.has_param("limit") ? std::to_string(limit) : "all");
+        send_snapshot_json(req, res, response_cache_, key, snapshot->revision, [&] {
+            auto page = queue_page(*snapshot, offset, limit);
+            log_debug(LogCategory::Http, "Rendering queue page", {{"items", page.queue.size()}, {"size", page.size}});
+            return write_json_response(page);
+        });
+    });
+
+    // GET /queue/changes?since=<version> - Version-stamped deltas after the client's version
+    // Optional &timeout_ms=<n> long-polls until something changes (capped at 30 s)
+    server_.Get("/queue/changes", [this](const httplib::Request& req, httplib::Response& res) {
+        uint64_t since = 0;
+        long long timeout_ms = 0;
+        try {
+            if (req.has_param("since")) since = std::stoull(req.get_param_value("since"));
+            if (req.has_param("timeout_ms")) timeout_ms = std::stoll(req.get_param_value("timeout_ms"));
+        } catch (const std::exception&) {
+            send_error(res, 400, "Invalid since or timeout_ms");
+            return;
+        }
+        timeout_ms = std::clamp(timeout_ms, 0LL, 30000LL);
+
+        auto changes = timeout_ms > 0
+            ? media_queue_.wait_for_changes(since, std::chrono::milliseconds(timeout_ms))
+            : media_queue_.changes_since(since);
+
+        send_json(res, queue_changes_response(changes));
     });
 
     // POST /queue/add - Add item to queue
     server_.Post("/queue/add", [this](const httplib::Request& req, httplib::Response& res) {
-        std::cout << "🔍 DEBUG: POST /queue/add request received" << std::endl;
-        std::cout << "   Method: " << req.method << std::endl;
-        std::cout << "   Path: " << req.path << std::endl;
-        std::cout << "   Query params count: " << req.params.size() << std::endl;
-        for (const auto& param : req.params) {
-            std::cout << "   Query param: " << param.first << " = " << param.second << std::endl;
-        }
-        std::cout << "   Headers count: " << req.headers.size() << std::endl;
-        for (const auto& header : req.headers) {
-            std::cout << "   Header: " << header.first << " = " << header.second << std::endl;
-        }
-        std::cout << "   Body: " << req.body << std::endl;
-        
+        // Headers and tokens stay out of the log; the query names the item
+        log_debug(LogCategory::Http, "POST /queue/add",
+                  {{"params", req.params.size()}, {"headers", req.headers.size()}, {"body_bytes", req.body.size()}});
+
         if (!is_authenticated(req)) {
-            std::cout << "   ❌ Authentication failed" << std::endl;
-            res.status = 401;
-            res.set_content("{\"status\":\"error\",\"message\":\"Authentication required\"}", "application/json");
+            log_warn(LogCategory::Http, "❌ Authentication failed", {{"route", "/queue/add"}});
+            send_error(res, 401, "Authentication required");
+            return;
+        }
+
+        std::string submitter;
+        if (!get_submitter(req, submitter)) {
+            send_error(res, 400, "Submitter name too long");
             return;
         }
-        std::cout << "   ✅ Authentication passed" << std::endl;
         
         if (req.has_param("url") || req.has_param("path")) {
             std::string item = req.has_param("url") ? req.get_param_value("url") : req.get_param_value("path");
-            std::cout << "   ✅ Found parameter: " << item << std::endl;
-            
+
             // Validate the media item before adding to queue
             std::string validation_error;
             if (!is_valid_media_item(item, validation_error)) {
-                std::cout << "   ❌ Validation failed: " << validation_error << std::endl;
-                res.status = 400;
-                res.set_content("{\"status\":\"error\",\"message\":\"" + validation_error + "\"}", "application/json");
+                log_info(LogCategory::Http, "❌ Validation failed", {{"item", item}, {"error", validation_error}});
+                send_error(res, 400, validation_error);
+                return;
+            }
+
+            // Relative play frequency in weighted_random rotation
+            double weight = 1.0;
+            try {
+                if (req.has_param("weight")) weight = std::stod(req.get_param_value("weight"));
+            } catch (const std::exception&) {
+                weight = 0.0;
+            }
+            if (!(weight > 0.0) || weight > 1000.0) {
+                send_error(res, 400, "weight must be between 0 and 1000");
                 return;
             }
-            std::cout << "   ✅ Validation passed" << std::endl;
             
-            media_queue_.push(item);
-            std::cout << "   ✅ Item added to queue: " << item << std::endl;
-            res.set_content("{\"status\":\"success\",\"message\":\"Item added to queue\",\"item\":\"" + item + "\"}", "application/json");
+            if (validation_) {
+                auto job_id = validation_->submit({item, PriorityClass::Normal, submitter, weight});
+                if (!job_id) {
+                    res.set_header("Retry-After", "5");
+                    send_error(res, 503, "Too many items waiting for validation, retry later");
+                    return;
+                }
+                std::string status_url = "/queue/jobs?id=" + *job_id;
+                log_info(LogCategory::Http, "⏳ Item accepted for validation",
+                         {{"item", item}, {"submitter", submitter}, {"job", *job_id}});
+                res.set_header("Location", status_url);
+                send_json(res, QueueAddAcceptedResponse{.message = "Item accepted, queued once validated", .item = item,
+                                                        .job_id = *job_id, .status_url = status_url}, 202);
+                return;
+            }
+            if (!media_queue_.push(item, submitter, weight)) {
+                log_info(LogCategory::Http, "❌ Quota exceeded", {{"submitter", submitter}});
+                send_error(res, 429, "Queue quota exceeded for submitter " + submitter);
+                return;
+            }
+            log_info(LogCategory::Http, "✅ Item added to queue", {{"item", item}, {"submitter", submitter}});
+            send_json(res, QueueAddResponse{.message = "Item added to queue", .item = item});
         } else {
-            std::cout << "   ❌ No url or path parameter found" << std::endl;
-            res.status = 400;
-            res.set_content("{\"status\":\"error\",\"message\":\"Missing url or path parameter\"}", "application/json");
+            send_error(res, 400, "Missing url or path parameter");
         }
     });
 
-    // POST /queue/priority - Add high-priority item to front of queue and interrupt current stream
+    // GET /queue/jobs?id=<id> - Validation job of a /queue/add submission; without id the
+    // pending and most recent jobs (no auth required)
+    server_.Get("/queue/jobs", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!validation_) {
+            send_error(res, 404, "Validation is disabled");
+            return;
+        }
+        if (req.has_param("id")) {
+            auto job = validation_->find(req.get_param_value("id"));
+            if (!job) {
+                send_error(res, 404, "No validation job with that id");
+                return;
+            }
+            send_json(res, validation_job_view(*job));
+            return;
+        }
+        size_t limit = 50;
+        try {
+            if (req.has_param("limit")) limit = std::stoul(req.get_param_value("limit"));
+        } catch (const std::exception&) {
+            send_error(res, 400, "Invalid limit");
+            return;
+        }
+        auto jobs = validation_->recent(limit);
+        ValidationJobsResponse response{{}, validation_->pending()};
+        response.jobs.reserve(jobs.size());
+        for (const auto& job : jobs) {
+            response.jobs.push_back(validation_job_view(job));
+        }
+        send_json(res, response);
+    });
+
+    // POST /queue/import - Bulk import a playlist in one queue commit
+    // Body: JSON array or M3U/M3U8 text; or ?url=<youtube playlist>; or ?path=<playlist file>
+    // Optional ?format=auto|json|m3u|youtube, ?probe=true, ?parallel=<n>
+    server_.Post("/queue/import", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!is_authenticated(req)) {
+            send_error(res, 401, "Authentication required");
+            return;
+        }
+
+        PlaylistImportOptions options;
+        if (!get_submitter(req, options.submitter)) {
+            send_error(res, 400, "Submitter name too long");
+            return;
+        }
+        if (req.has_param("format")) {
+            auto format = parse_playlist_format(req.get_param_value("format"));
+            if (!format) {
+                send_error(res, 400, "Invalid format, expected auto, json, m3u or youtube");
+                return;
+            }
+            options.format = *format;
+        }
+        options.probe = req.has_param("probe") && req.get_param_value("probe") == "true";
+        if (req.has_param("parallel")) {
+            try {
+                options.max_parallel = std::clamp<size_t>(std::stoul(req.get_param_value("parallel")), 1, 32);
+            } catch (const std::exception&) {
+                send_error(res, 400, "Invalid parallel");
+                return;
+            }
+        }
+
+        std::string content = req.body;
+        if (req.has_param("url")) {
+            content = req.get_param_value("url");
+        } else if (req.has_param("path")) {
+            // Only files under the import directory: the response echoes every line read
+            if (options_.import_dir.empty()) {
+                send_error(res, 403, "Importing playlist files is disabled (MYCHANNEL_IMPORT_DIR is not set)");
+                return;
+            }
+            auto playlist_path = resolve_import_path(options_.import_dir, req.get_param_value("path"));
+            if (!playlist_path) {
+                send_error(res, 403, "Playlist path is outside the import directory");
+                return;
+            }
+            std::ifstream file(*playlist_path);
+            if (!file) {
+                send_error(res, 400, "Cannot read playlist file: " + req.get_param_value("path"));
+                return;
+            }
+            std::ostringstream buffer;
+            buffer << file.rdbuf();
+            content = buffer.str();
+            options.base_dir = playlist_path->parent_path().string();
+        }
+
+        auto result = import_playlist(media_queue_, content, options);
+        if (!result.ok) {
+            send_error(res, 400, result.error);
+            return;
+        }
+        log_info(LogCategory::Http, "📥 Imported playlist",
+                 {{"queued", result.queued}, {"items", result.items.size()}, {"elapsed_ms", result.elapsed_ms},
+                  {"submitter", options.submitter}});
+
+        auto response = import_response(result);
+        response.status = "success";
+        send_json(res, response);
+    });
+
+    // POST /queue/priority - Add high-priority item and cut the current stream per its class policy
+    // Optional ?class=next|interrupt|breaking (default: interrupt)
     server_.Post("/queue/priority", [this](const httplib::Request& req, httplib::Response& res) {
         if (!is_authenticated(req)) {
-            res.status = 401;
-            res.set_content("{\"status\":\"error\",\"message\":\"Authentication required\"}", "application/json");
+            send_error(res, 401, "Authentication required");
+            return;
+        }
+
+        std::string submitter;
+        if (!get_submitter(req, submitter)) {
+            send_error(res, 400, "Submitter name too long");
             return;
         }
         
         if (req.has_param("url") || req.has_param("path")) {
             std::string item = req.has_param("url") ? req.get_param_value("url") : req.get_param_value("path");
+
+            auto priority = PriorityClass::Interrupt;
+            if (req.has_param("class")) {
+                auto parsed = parse_priority_class(req.get_param_value("class"));
+                if (!parsed || *parsed == PriorityClass::Normal) {
+                    send_error(res, 400, "Invalid class, expected next, interrupt or breaking");
+                    return;
+                }
+                priority = *parsed;
+            }
             
             // Validate the media item before adding to queue
             std::string validation_error;
             if (!is_valid_media_item(item, validation_error)) {
-                res.status = 400;
-                res.set_content("{\"status\":\"error\",\"message\":\"" + validation_error + "\"}", "application/json");
+                send_error(res, 400, validation_error);
                 return;
             }
             
-            // Add to front of queue
-            media_queue_.push_front(item);
-            
-            // Request termination of current stream
-            g_stream_process->request_termination();
-            g_stream_process->kill_current_process();
+            // FIFO within the class lane, then cut the item on air if the policy says so
+            auto policy = media_queue_.enqueue(item, priority, submitter);
+            if (!policy) {
+                send_error(res, 429, "Queue quota exceeded for submitter " + submitter);
+                return;
+            }
+            bool interrupted = g_stream_process->preempt(priority, *policy);
             
-            res.set_content("{\"status\":\"success\",\"message\":\"High-priority item added and current stream interrupted\",\"item\":\"" + item + "\"}", "application/json");
+            std::string message = interrupted ? "High-priority item added and current stream interrupted"
+                                              : "High-priority item queued to play next";
+            send_json(res, QueuePriorityResponse{.message = message, .item = item, .priority = priority_class_name(priority),
+                                                 .policy = interrupt_policy_name(*policy)});
         } else {
-            res.status = 400;
-            res.set_content("{\"status\":\"error\",\"message\":\"Missing url or path parameter\"}", "application/json");
+            send_error(res, 400, "Missing url or path parameter");
         }
     });
 
     // POST /queue/clear - Clear the queue
     server_.Post("/queue/clear", [this](const httplib::Request& req, httplib::Response& res) {
         if (!is_authenticated(req)) {
-            res.status = 401;
-            res.set_content("{\"status\":\"error\",\"message\":\"Authentication required\"}", "application/json");
+            send_error(res, 401, "Authentication required");
             return;
         }
         
         media_queue_.clear();
-        res.set_content("{\"status\":\"success\",\"message\":\"Queue cleared\"}", "application/json");
+        send_json(res, MessageResponse{.message = "Queue cleared"});
+    });
+
+    // GET /queue/position - What is on air, what plays next and where each submitter's cursor is
+    server_.Get("/queue/position", [this](const httplib::Request& req, httplib::Response& res) {
+        auto snapshot = media_queue_.snapshot();
+        send_snapshot_json(req, res, response_cache_, "position", snapshot->revision, [&] {
+            QueuePositionResponse response{.mode = rotation_mode_name(snapshot->rotation_mode),
+                                           .version = snapshot->version};
+            if (snapshot->now_playing) {
+                response.now_playing = queue_item_view(*snapshot->now_playing);
+            }
+            if (const auto* next = snapshot->up_next()) {
+                response.up_next = queue_item_view(*next);
+            }
+            response.submitters.reserve(snapshot->submitters.size());
+            for (const auto& stats : snapshot->submitters) {
+                response.submitters.push_back({stats.name, stats.position, stats.queued});
+            }
+            return write_json_response(response);
+        });
+    });
+
+    // POST /queue/mode?mode=loop|once|shuffle|weighted_random - Change how the rotation advances
+    server_.Post("/queue/mode", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!is_authenticated(req)) {
+            send_error(res, 401, "Authentication required");
+            return;
+        }
+        auto mode = parse_rotation_mode(req.get_param_value("mode"));
+        if (!mode) {
+            send_error(res, 400, "mode must be loop, once, shuffle or weighted_random");
+            return;
+        }
+        media_queue_.set_rotation_mode(*mode);
+        send_json(res, RotationModeResponse{.mode = rotation_mode_name(*mode)});
+    });
+
+    // POST /schedule?url=<url>|path=<path>&at=<unix seconds|YYYY-MM-DDTHH:MM:SSZ> - Start an item at a wall-clock time
+    // Optional: join=hard_cut|wait|trim_filler (default wait), title=, duration=<seconds>, every=<seconds>,
+    // class=normal|next|interrupt|breaking (the class it is reported on air as)
+    server_.Post("/schedule", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!is_authenticated(req)) {
+            send_error(res, 401, "Authentication required");
+            return;
+        }
+        if (!event_scheduler_) {
+            send_error(res, 503, "Scheduling is not available");
+            return;
+        }
+
+        std::string submitter;
+        if (!get_submitter(req, submitter)) {
+            send_error(res, 400, "Submitter name too long");
+            return;
+        }
+        if (!req.has_param("url") && !req.has_param("path")) {
+            send_error(res, 400, "Missing url or path parameter");
+            return;
+        }
+
+        ScheduledEvent event;
+        event.item.source = req.has_param("url") ? req.get_param_value("url") : req.get_param_value("path");
+        event.item.submitter = submitter;
+        event.title = req.get_param_value("title");
+
+        auto start = parse_schedule_time(req.get_param_value("at"));
+        if (!start) {
+            send_error(res, 400, "at must be unix seconds or YYYY-MM-DDTHH:MM:SSZ");
+            return;
+        }
+        event.start = *start;
+
+        if (req.has_param("join")) {
+            auto join = parse_join_policy(req.get_param_value("join"));
+            if (!join) {
+                send_error(res, 400, "join must be hard_cut, wait or trim_filler");
+                return;
+            }
+            event.join = *join;
+        }
+        if (req.has_param("class")) {
+            auto priority = parse_priority_class(req.get_param_value("class"));
+            if (!priority) {
+                send_error(res, 400, "Invalid class, expected normal, next, interrupt or breaking");
+                return;
+            }
+            event.item.priority = *priority;
+        }
+
+        try {
+            if (req.has_param("duration")) event.duration = std::stod(req.get_param_value("duration"));
+            if (req.has_param("every")) event.repeat = std::chrono::seconds(std::stoll(req.get_param_value("every")));
+        } catch (const std::exception&) {
+            event.duration = -1.0;
+        }
+        if (event.duration < 0.0 || event.repeat.count() < 0 ||
+            (event.repeat.count() > 0 && event.repeat < std::chrono::seconds(60))) {
+            send_error(res, 400, "duration must be >= 0 and every at least 60 seconds");
+            return;
+        }
+
+        std::string validation_error;
+        if (!is_valid_media_item(event.item.source, validation_error)) {
+            send_error(res, 400, validation_error);
+            return;
+        }
+        auto id = schedule_event(event);
+        log_info(LogCategory::Http, "🗓️ Scheduled event",
+                 {{"item", event.item.source}, {"at", format_schedule_time(event.start)},
+                  {"join", join_policy_name(event.join)}, {"id", id}});
+        send_json(res, ScheduledResponse{"success", id, format_schedule_time(event.start), join_policy_name(event.join)});
+    });
+
+    // POST /schedule/cancel?id=<id> - Remove a scheduled event (all future repeats)
+    server_.Post("/schedule/cancel", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!is_authenticated(req)) {
+            send_error(res, 401, "Authentication required");
+            return;
+        }
+        if (!event_scheduler_) {
+            send_error(res, 503, "Scheduling is not available");
+            return;
+        }
+        uint64_t id = 0;
+        try {
+            id = std::stoull(req.get_param_value("id"));
+        } catch (const std::exception&) {
+        }
+        if (!event_scheduler_->cancel(id)) {
+            send_error(res, 404, "No scheduled event with that id");
+            return;
+        }
+        send_json(res, ScheduledResponse{.status = "success", .id = id});
+    });
+
+    // GET /schedule - EPG as JSON; GET /schedule/xmltv - the same as XMLTV (no auth required)
+    server_.Get("/schedule", [this](const httplib::Request&, httplib::Response& res) {
+        if (!event_scheduler_) {
+            send_error(res, 503, "Scheduling is not available");
+            return;
+        }
+        res.set_content(event_scheduler_->epg_json(std::chrono::system_clock::now()), "application/json");
+    });
+
+    server_.Get("/schedule/xmltv", [this](const httplib::Request&, httplib::Response& res) {
+        if (!event_scheduler_) {
+            send_error(res, 503, "Scheduling is not available");
+            return;
+        }
+        res.set_content(event_scheduler_->epg_xmltv(std::chrono::system_clock::now()), "application/xml");
+    });
+
+    // GET /metrics - Prometheus text exposition format; reads atomics and the published snapshot only
+    server_.Get("/metrics", [this](const httplib::Request&, httplib::Response& res) {
+        std::string body;
+        metrics_registry().render(body);
+        auto snapshot = media_queue_.snapshot();
+        render_sample(body, "mychannel_queue_depth", "gauge", "Items in the queue",
+                      static_cast<double>(snapshot->items.size()));
+        render_sample(body, "mychannel_queue_version", "gauge", "Version of the queue contents",
+                      static_cast<double>(snapshot->version));
+        render_sample(body, "mychannel_queue_rejected_submissions_total", "counter",
+                      "Submissions refused by a submitter quota", static_cast<double>(media_queue_.rejected_submissions()));
+        res.set_content(body, "text/plain; version=0.0.4; charset=utf-8");
+    });
+
+    // GET /hls/live.m3u8 - Playlist of the local HLS output (no auth required). LL-HLS
+    // clients block with ?_HLS_msn=<n>&_HLS_part=<m> until that segment or part exists.
+    server_.Get("/hls/live.m3u8", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!hls_) {
+            send_error(res, 404, "HLS output is off (MYCHANNEL_HLS)");
+            return;
+        }
+        auto window = hls_->window();
+        if (req.has_param("_HLS_msn")) {
+            uint64_t msn = 0;
+            std::optional<size_t> part;
+            size_t index = 0;
+            bool valid = parse_number(req.get_param_value("_HLS_msn"), msn);
+            if (valid && req.has_param("_HLS_part")) {
+                valid = parse_number(req.get_param_value("_HLS_part"), index);
+                part = index;
+            }
+            if (!valid) {
+                send_error(res, 400, "Invalid _HLS_msn or _HLS_part");
+                return;
+            }
+            if (msn > window->next_sequence + 2) {
+                send_error(res, 400, "_HLS_msn is too far ahead");
+                return;
+            }
+            window = hls_->wait_for(msn, part, hls_block_timeout(hls_->options()));
+            if (!window->has(msn, part)) {
+                send_error(res, 503, "Segment not ready");
+                return;
+            }
+        }
+        if (!window->playlist) {
+            send_error(res, 404, "No segment yet");
+            return;
+        }
+        res.set_header("Cache-Control", "no-cache");
+        res.set_content(*window->playlist, "application/vnd.apple.mpegurl");
+    });
+
+    server_.Get(R"(/hls/seg/(\d+)\.ts)", [this](const httplib::Request& req, httplib::Response& res) {
+        const HlsSegment* segment = nullptr;
+        auto window = hls_ ? hls_->window() : nullptr;
+        uint64_t sequence = 0;
+        if (window && parse_number(req.matches[1].str(), sequence)) {
+            segment = window->find(sequence);
+        }
+        if (!segment || !segment->data) {
+            send_error(res, 404, "No such segment");
+            return;
+        }
+        send_shared(res, segment->data, "video/mp2t");
+    });
+
+    // Parts of the segment being written; a preload hint's part is waited for
+    server_.Get(R"(/hls/part/(\d+)\.(\d+)\.ts)", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!hls_) {
+            send_error(res, 404, "HLS output is off (MYCHANNEL_HLS)");
+            return;
+        }
+        uint64_t sequence = 0;
+        size_t index = 0;
+        if (!parse_number(req.matches[1].str(), sequence) || !parse_number(req.matches[2].str(), index)) {
+            send_error(res, 404, "No such part");
+            return;
+        }
+        auto window = hls_->window();
+        if (sequence >= window->next_sequence && sequence <= window->next_sequence + 1) {
+            window = hls_->wait_for(sequence, index, hls_block_timeout(hls_->options()));
+        }
+        const HlsSegment* segment = window->find(sequence);
+        if (!segment || index >= segment->parts.size()) {
+            send_error(res, 404, "No such part");
+            return;
+        }
+        send_shared(res, segment->parts[index].data, "video/mp2t");
     });
 
     // GET /status - Get server status
-    server_.Get("/status", [](const httplib::Request&, httplib::Response& res) {
-        res.set_content("{\"status\":\"running\",\"server\":\"mychannel\",\"fallback_video\":\"videos/News_Intro.mp4\"}", "application/json");
+    server_.Get("/status", [this](const httplib::Request& req, httplib::Response& res) {
+        auto snapshot = media_queue_.snapshot();
+        send_snapshot_json(req, res, response_cache_, "status", snapshot->revision, [&] {
+            return write_json_response(ServerStatusResponse{.fallback_video = "videos/News_Intro.mp4",
+                                                            .rotation_mode = rotation_mode_name(snapshot->rotation_mode),
+                                                            .submitters = submitter_status_views(*snapshot)});
+        });
     });
 }
 
+HttpServer::~HttpServer() {
+    stop();
+    if (listener_.joinable()) {
+        listener_.join();
+    }
+}
+
 std::future<void> HttpServer::start_async(const std::string& host, int port) {
-    return std::async(std::launch::async, [this, host, port]() {
-        std::cout << "Starting HTTP server on http://" << host << ":" << port << std::endl;
+    if (listener_.joinable()) {
+        throw std::runtime_error("HTTP server already started");
+    }
+    auto task = std::make_shared<std::packaged_task<void()>>([this, host, port]() {
+        log_info(LogCategory::Http, "Starting HTTP server",
+                 {{"host", host}, {"port", port}, {"workers", options_.workers()},
+                  {"max_inflight", admission_.shared().limit()},
+                  {"max_inflight_mcp", admission_.mcp().limit()},
+                  {"max_connections", options_.max_connections},
+                  {"keep_alive_requests", options_.keep_alive_max_requests},
+                  {"keep_alive_timeout_s", options_.keep_alive_timeout.count()}});
         if (!auth_token_.empty()) {
-            std::cout << "🔐 Authentication is ENABLED - token required for write operations" << std::endl;
+            log_info(LogCategory::Http, "🔐 Authentication is ENABLED - token required for write operations");
         } else {
-            std::cout << "⚠️ Authentication is DISABLED - set MYCHANNEL_AUTH_TOKEN to enable" << std::endl;
-        }
-        std::cout << "Available endpoints:" << std::endl;
-        std::cout << "  GET  /status - Server status (no auth required)" << std::endl;
-        std::cout << "  GET  /queue - Get current queue (no auth required)" << std::endl;
-        std::cout << "  POST /queue/add?url=<url>&token=<token> - Add URL to queue" << std::endl;
-        std::cout << "  POST /queue/add?path=<path>&token=<token> - Add local file to queue" << std::endl;
-        std::cout << "  POST /queue/priority?url=<url>&token=<token> - Add high-priority URL (interrupts current stream)" << std::endl;
-        std::cout << "  POST /queue/priority?path=<path>&token=<token> - Add high-priority file (interrupts current stream)" << std::endl;
-        std::cout << "  POST /queue/clear?token=<token> - Clear the queue" << std::endl;
-        std::cout << "Alternative: Use Authorization: Bearer <token> header instead of token parameter" << std::endl;
+            log_warn(LogCategory::Http, "⚠️ Authentication is DISABLED - set MYCHANNEL_AUTH_TOKEN to enable");
+        }
+        static constexpr std::pair<std::string_view, std::string_view> endpoints[] = {
+            {"GET /status", "Server status (no auth required)"},
+            {"GET /metrics", "Prometheus metrics (no auth required)"},
+            {"GET /queue", "Get current queue (no auth required)"},
+            {"GET /queue?offset=<n>&limit=<n>", "Get a page of the queue (no auth required)"},
+            {"GET /queue/changes?since=<version>&timeout_ms=<n>", "Long-poll queue deltas (no auth required)"},
+            {"POST /queue/add?url=<url>&token=<token>", "Add URL to queue"},
+            {"POST /queue/add?path=<path>&token=<token>", "Add local file to queue"},
+            {"GET /queue/jobs?id=<id>", "Validation status of an added item (no auth required)"},
+            {"POST /queue/import?token=<token>", "Bulk import a JSON/M3U playlist body (or ?url=<youtube playlist>, ?path=<file under MYCHANNEL_IMPORT_DIR>)"},
+            {"POST /queue/priority?url=<url>&token=<token>", "Add high-priority URL (interrupts current stream)"},
+            {"POST /queue/priority?path=<path>&token=<token>", "Add high-priority file (interrupts current stream)"},
+            {"POST /queue/priority?...&class=next|interrupt|breaking", "Priority class (default: interrupt)"},
+            {"POST /queue/clear?token=<token>", "Clear the queue"},
+            {"GET /queue/position", "Now playing, up next and rotation cursors (no auth required)"},
+            {"POST /queue/mode?mode=loop|once|shuffle|weighted_random&token=<token>", "Set the rotation mode"},
+            {"POST /schedule?url=<url>&at=<time>&join=hard_cut|wait|trim_filler&token=<token>", "Start an item at a wall-clock time"},
+            {"POST /schedule/cancel?id=<id>&token=<token>", "Cancel a scheduled event"},
+            {"GET /schedule", "Programme guide as JSON (no auth required)"},
+            {"GET /schedule/xmltv", "Programme guide as XMLTV (no auth required)"},
+            {"GET /hls/live.m3u8", "Local HLS playlist when MYCHANNEL_HLS is on (no auth required)"},
+        };
+        for (const auto& [route, description] : endpoints) {
+            log_info(LogCategory::Http, "Endpoint", {{"route", route}, {"description", description}});
+        }
+        log_info(LogCategory::Http, "Alternative: Use Authorization: Bearer <token> header instead of token parameter");
         server_.listen(host, port);
     });
+    auto stopped = task->get_future();
+    listener_ = std::thread([task] {
+        enter_thread_role(ThreadRole::Http, "http-listen");
+        (*task)();
+    });
+    return stopped;
 }
 
 void HttpServer::stop() {
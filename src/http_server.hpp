@@ -1,25 +1,117 @@
 #pragma once
 #include "media_queue.hpp"
+#include "event_scheduler.hpp"
+#include "hls.hpp"
+#include "http_cache.hpp"
+#include "rate_limiter.hpp"
+#include "tool_executor.hpp"
+#include "validation_jobs.hpp"
 #include <httplib.h>
+#include <atomic>
+#include <chrono>
 #include <future>
+#include <memory>
+#include <thread>
 #include <string>
 
+// httplib hands every accepted connection to its task queue, and one worker then serves it
+// for its whole keep-alive session. Bounding the queue bounds open connections: past the
+// limit enqueue() refuses and httplib closes the socket at once instead of letting
+// connections pile up behind busy workers.
+class HttpConnectionQueue : public httplib::TaskQueue {
+public:
+    HttpConnectionQueue(size_t workers, size_t max_waiting);
+
+    bool enqueue(std::function<void()> fn) override;
+    void shutdown() override;  // Serves what is queued, then joins the workers
+
+    size_t open() const { return open_.load(std::memory_order_relaxed); }  // Active plus waiting
+    size_t active() const { return active_.load(std::memory_order_relaxed); }
+    size_t waiting() const { return waiting_.load(std::memory_order_relaxed); }
+    uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    const size_t limit_;  // Workers plus waiting connections
+    std::atomic<size_t> open_{0};
+    std::unique_ptr<ToolExecutor> workers_;
+    std::atomic<size_t> active_{0};
+    std::atomic<size_t> waiting_{0};
+    std::atomic<uint64_t> rejected_{0};
+};
+
 class HttpServer {
 public:
+    // Worker pool, connection limits and timeouts of the REST/MCP port
+    struct Options {
+        size_t worker_threads = 0;       // 0: max(8, hardware threads - 1), as httplib picks
+        size_t max_connections = 1024;   // Served plus waiting for a worker; at least workers + 1
+        size_t keep_alive_max_requests = 100;  // Requests per connection before it is closed
+        std::chrono::seconds keep_alive_timeout{5};  // Idle time before a kept-alive connection is closed
+        std::chrono::milliseconds read_timeout{5000};
+        std::chrono::milliseconds write_timeout{5000};
+        size_t max_payload_bytes = 16 * 1024 * 1024;  // Request bodies; playlist imports are the largest
+        bool tcp_nodelay = true;  // Headers and body go out in separate writes
+        RateLimits rate_limits = default_rate_limits();  // Per client and request class
+        size_t max_inflight_requests = 0;  // Write and priority requests at once; 0: half the workers
+        size_t max_inflight_mcp = 0;  // MCP requests at once, bounded apart; 0: a quarter of the workers
+        bool validate_on_add = true;  // Probe /queue/add items before queueing them and answer 202
+        std::string import_dir;  // Where /queue/import?path= may read playlist files; empty: nowhere
+        ValidationJobs::Options validation;
+
+        // MYCHANNEL_HTTP_THREADS, _MAX_CONNECTIONS, _KEEPALIVE_REQUESTS, _KEEPALIVE_TIMEOUT (s),
+        // _READ_TIMEOUT_MS, _WRITE_TIMEOUT_MS, _MAX_PAYLOAD (bytes), _MAX_INFLIGHT, _MAX_INFLIGHT_MCP,
+        // MYCHANNEL_RATE_LIMITS, MYCHANNEL_VALIDATION (off), MYCHANNEL_VALIDATION_WORKERS and
+        // _MAX_PENDING, MYCHANNEL_IMPORT_DIR; invalid values keep the default
+        static Options from_env();
+        size_t workers() const;  // worker_threads with the default resolved
+        size_t inflight_limit() const;  // max_inflight_requests with the default resolved
+        size_t mcp_inflight_limit() const;  // max_inflight_mcp with the default resolved
+    };
+
     httplib::Server server_;
     ThreadSafeMediaQueue& media_queue_;
+    EventScheduler* event_scheduler_;  // Optional; the /schedule routes answer 503 without it
     
     // Helper method to validate authentication
     bool is_authenticated(const httplib::Request& req) const;
     
     // Helper method to validate media items (files/URLs)
     bool is_valid_media_item(const std::string& item, std::string& error_message) const;
+
+    // Helper method to read the fair-share submitter (X-Submitter header or submitter param)
+    bool get_submitter(const httplib::Request& req, std::string& submitter) const;
+
+    // Adds an event to the schedule without probing on the caller's thread: an unknown
+    // duration comes from the probe cache, or is probed on the validation workers and
+    // filled in afterwards (it stays unknown with validation off)
+    uint64_t schedule_event(ScheduledEvent event);
     
-    explicit HttpServer(ThreadSafeMediaQueue& queue);
+    explicit HttpServer(ThreadSafeMediaQueue& queue, EventScheduler* event_scheduler = nullptr);
+    HttpServer(ThreadSafeMediaQueue& queue, EventScheduler* event_scheduler, Options options);
+    ~HttpServer();  // Stops listening and joins the listener
     void setup_routes();
+    // Listens on a named thread of its own; the future is ready once the server has stopped
     std::future<void> start_async(const std::string& host = "0.0.0.0", int port = 8080);
     void stop();
 
+    // Deep validation of queued submissions; null when validate_on_add is off
+    ValidationJobs* validation_jobs() { return validation_.get(); }
+
+    // Local HLS output served under /hls/; set before start_async. The /hls routes answer
+    // 404 without it.
+    void set_hls_output(HlsOutput* hls) { hls_ = hls; }
+
 private:
+    void apply_options();
+    // Charges the request to its client's bucket and the in-flight limit; false after answering 429
+    bool admit(const httplib::Request& req, httplib::Response& res);
+
+    Options options_;
+    RateLimiter rate_limiter_;
+    AdmissionGates admission_;
     std::string auth_token_;
+    ResponseCache response_cache_;  // Bodies of /queue, /queue/position and /status per snapshot revision
+    std::unique_ptr<ValidationJobs> validation_;
+    HlsOutput* hls_ = nullptr;
+    std::thread listener_;
 };
@@ -0,0 +1,68 @@
+#include "json_response.hpp"
+#include "event_scheduler.hpp"
+#include <algorithm>
+
+QueueItemView queue_item_view(const QueueItem& item) {
+    return {item.source, item.submitter, priority_class_name(item.priority)};
+}
+
+QueuePageResponse queue_page(const QueueSnapshot& snapshot, size_t offset, size_t limit) {
+    const auto& items = snapshot.items;
+    size_t begin = std::min(offset, items.size());
+    size_t end = begin + std::min(limit, items.size() - begin);
+    QueuePageResponse page{{}, items.size(), begin, snapshot.version};
+    page.queue.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        page.queue.push_back(items[i].source);
+    }
+    return page;
+}
+
+std::vector<SubmitterStatusView> submitter_status_views(const QueueSnapshot& snapshot) {
+    std::vector<SubmitterStatusView> views;
+    views.reserve(snapshot.submitters.size());
+    for (const auto& stats : snapshot.submitters) {
+        views.push_back({stats.name, stats.weight, stats.quota, stats.queued, stats.airtime});
+    }
+    return views;
+}
+
+QueueChangesResponse queue_changes_response(const QueueChanges& changes) {
+    QueueChangesResponse response{changes.version, changes.resync, {}};
+    response.changes.reserve(changes.deltas.size());
+    for (const auto& delta : changes.deltas) {
+        QueueChangeView change{delta.version, queue_op_name(delta.op)};
+        if (delta.op != QueueOp::Clear) {
+            change.source = delta.item.source;
+            change.priority = priority_class_name(delta.item.priority);
+            change.submitter = delta.item.submitter;
+        }
+        response.changes.push_back(change);
+    }
+    return response;
+}
+
+ImportResponse import_response(const PlaylistImportResult& result) {
+    ImportResponse response{std::nullopt, result.queued, result.items.size() - result.queued, result.version, {}};
+    response.items.reserve(result.items.size());
+    for (const auto& item : result.items) {
+        ImportItemView view{item.source, item.queued ? "queued" : "rejected"};
+        if (!item.error.empty()) view.error = item.error;
+        if (item.duration > 0.0) view.duration = item.duration;
+        response.items.push_back(view);
+    }
+    return response;
+}
+
+ValidationJobView validation_job_view(const ValidationJob& job) {
+    ValidationJobView view{job.id, validation_state_name(job.state), job.item.source,
+                           priority_class_name(job.item.priority), job.item.submitter};
+    if (!job.error.empty()) view.error = job.error;
+    if (job.media) {
+        view.media = MediaProbeView{job.media->duration, job.media->video_codec, job.media->width, job.media->height};
+        if (!job.media->audio_codec.empty()) view.media->audio_codec = job.media->audio_codec;
+    }
+    view.submitted_at = format_schedule_time(job.submitted_at);
+    if (job.finished_at) view.finished_at = format_schedule_time(*job.finished_at);
+    return view;
+}
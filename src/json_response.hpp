@@ -0,0 +1,391 @@
+#pragma once
+#include "media_queue.hpp"
+#include "playlist_import.hpp"
+#include "validation_jobs.hpp"
+#include <glaze/glaze.hpp>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Serialize a response struct with glaze reflection into a per-thread buffer that keeps
+// its capacity between requests, so a steady-state response costs no growth reallocations.
+// The reference is valid until the next write_json_response() on the same thread; never
+// pass a view into it back in (copy it, or hand it straight to the HTTP response).
+template <class T>
+const std::string& write_json_response(const T& value) {
+    thread_local std::string buffer;
+    if (glz::write_json(value, buffer)) {
+        buffer = R"({"status":"error","message":"Failed to serialize response"})";
+    }
+    return buffer;
+}
+
+// Field order is the JSON key order. Strings borrowed from a snapshot are string_views;
+// empty optionals are left out of the output.
+
+struct ErrorResponse {
+    std::string_view status = "error";
+    std::string_view message;
+};
+
+struct MessageResponse {
+    std::string_view status = "success";
+    std::string_view message;
+};
+
+// MCP tool results: {"status":"success","result":...}
+template <class T>
+struct ToolResult {
+    std::string_view status = "success";
+    T result;
+};
+
+// An item as reported by the API; "class" is a keyword, hence the glz::meta below
+struct QueueItemView {
+    std::string_view source;
+    std::string_view submitter;
+    std::string_view priority;
+};
+
+// GET /queue
+struct QueuePageResponse {
+    std::vector<std::string_view> queue;
+    size_t size = 0;
+    size_t offset = 0;
+    uint64_t version = 0;
+};
+
+// GET /queue/changes
+struct QueueChangeView {
+    uint64_t version = 0;
+    std::string_view op;
+    std::optional<std::string_view> source;  // Empty for clear
+    std::optional<std::string_view> priority;
+    std::optional<std::string_view> submitter;
+};
+
+struct QueueChangesResponse {
+    uint64_t version = 0;
+    bool resync = false;
+    std::vector<QueueChangeView> changes;
+};
+
+// POST /queue/add
+struct QueueAddResponse {
+    std::string_view status = "success";
+    std::string_view message;
+    std::string_view item;
+};
+
+// GET /queue/jobs, the validation push event and the add_video_to_queue tool
+struct MediaProbeView {
+    double duration = 0.0;
+    std::string_view video_codec;
+    int width = 0;
+    int height = 0;
+    std::optional<std::string_view> audio_codec;
+};
+
+struct ValidationJobView {
+    std::string_view id;
+    std::string_view state;
+    std::string_view item;
+    std::string_view priority;
+    std::string_view submitter;
+    std::optional<std::string_view> error;
+    std::optional<MediaProbeView> media;
+    std::string submitted_at;
+    std::optional<std::string> finished_at;
+};
+
+struct ValidationJobsResponse {
+    std::vector<ValidationJobView> jobs;
+    size_t pending = 0;
+};
+
+// POST /queue/add while validation is on: 202 with the job to poll
+struct QueueAddAcceptedResponse {
+    std::string_view status = "accepted";
+    std::string_view message;
+    std::string_view item;
+    std::string_view job_id;
+    std::string status_url;
+};
+
+// POST / with a probe that outlasts the inline wait: 202 with the call to poll
+struct MCPCallPendingResponse {
+    std::string_view status = "pending";
+    std::string_view message;
+    std::string_view call_id;
+    std::string status_url;
+};
+
+// POST /queue/priority
+struct QueuePriorityResponse {
+    std::string_view status = "success";
+    std::string_view message;
+    std::string_view item;
+    std::string_view priority;
+    std::string_view policy;
+};
+
+// POST /queue/import and the import_playlist tool
+struct ImportItemView {
+    std::string_view source;
+    std::string_view status;
+    std::optional<std::string_view> error;
+    std::optional<double> duration;
+};
+
+struct ImportResponse {
+    std::optional<std::string_view> status;  // Set on HTTP, the MCP envelope carries its own
+    size_t queued = 0;
+    size_t rejected = 0;
+    uint64_t version = 0;
+    std::vector<ImportItemView> items;
+};
+
+// GET /queue/position
+struct SubmitterPositionView {
+    std::string_view name;
+    size_t position = 0;
+    size_t queued = 0;
+};
+
+struct QueuePositionResponse {
+    std::string_view mode;
+    std::optional<QueueItemView> now_playing;
+    std::optional<QueueItemView> up_next;
+    std::vector<SubmitterPositionView> submitters;
+    uint64_t version = 0;
+};
+
+// POST /queue/mode
+struct RotationModeResponse {
+    std::string_view status = "success";
+    std::string_view mode;
+};
+
+// GET /status and the get_stream_status tool
+struct SubmitterStatusView {
+    std::string_view name;
+    double weight = 1.0;
+    size_t quota = 0;
+    size_t queued = 0;
+    double airtime_seconds = 0.0;
+};
+
+struct ServerStatusResponse {
+    std::string_view status = "running";
+    std::string_view server = "mychannel";
+    std::string_view fallback_video;
+    std::string_view rotation_mode;
+    std::vector<SubmitterStatusView> submitters;
+};
+
+// POST /schedule, POST /schedule/cancel and the schedule_video tool
+struct ScheduledResponse {
+    std::optional<std::string_view> status;
+    uint64_t id = 0;
+    std::optional<std::string> start;
+    std::optional<std::string_view> join;
+};
+
+// GET /schedule and the get_schedule tool
+struct EpgEventView {
+    uint64_t id = 0;
+    std::string_view title;
+    std::string_view source;
+    std::string_view priority;
+    std::string start;
+    std::optional<std::string> stop;
+    double duration = 0.0;
+    std::string_view join;
+    int64_t repeat = 0;
+};
+
+struct EpgResponse {
+    std::vector<EpgEventView> events;
+    std::string from;
+};
+
+// MCP tool results
+struct QueueListingResult {
+    std::vector<std::string_view> queue;
+    size_t size = 0;
+    uint64_t version = 0;
+    bool is_streaming = false;
+};
+
+struct ClassCountsView {
+    size_t normal = 0;
+    size_t next = 0;
+    size_t interrupt = 0;
+    size_t breaking = 0;
+};
+
+struct StreamStatusResult {
+    bool is_streaming = false;
+    size_t queue_size = 0;
+    uint64_t queue_version = 0;
+    std::string_view on_air_priority;
+    ClassCountsView queue_by_class;
+    std::vector<SubmitterStatusView> submitters;
+    std::string_view rotation_mode;
+    std::optional<std::string_view> now_playing;
+    std::optional<std::string_view> up_next;
+    std::string_view fallback_video;
+    std::string_view server_status = "running";
+};
+
+struct DurationResult {
+    double duration = 0.0;
+    std::string_view source;
+};
+
+struct SourceValidationResult {
+    bool is_valid = false;
+    std::string_view source_type;
+    std::string_view source;
+};
+
+// MCP tool discovery and JSON-RPC 2.0 envelopes. Ids are the request's raw JSON id, echoed
+// back unchanged so batch clients can match responses; null when the request had none.
+struct ToolView {
+    std::string_view name;
+    std::string_view description;
+    glz::raw_json_view inputSchema;
+};
+
+struct ToolsResponse {
+    std::vector<ToolView> tools;
+};
+
+struct RpcErrorView {
+    int code = 0;
+    std::string_view message;
+};
+
+struct RpcErrorResponse {
+    std::string_view jsonrpc = "2.0";
+    glz::raw_json_view id{"null"};
+    RpcErrorView error;
+};
+
+struct ServerInfoView {
+    std::string_view name = "mychannel";
+    std::string_view version = "1.0.0";
+};
+
+struct InitializeResult {
+    std::string_view protocolVersion = "2024-11-05";
+    glz::raw_json_view capabilities{R"({"tools":{},"resources":{},"prompts":{},"logging":{}})"};
+    ServerInfoView serverInfo;
+};
+
+// tools/call: the tool's {"status":...,"result":...} object is embedded as the text content
+struct ToolContentView {
+    std::string_view type = "text";
+    glz::raw_json_view text;
+};
+
+struct ToolCallResult {
+    std::vector<ToolContentView> content;
+};
+
+// notifications/progress for a tool call that carried params._meta.progressToken
+struct ProgressParams {
+    glz::raw_json_view progressToken;
+    double progress = 0.0;
+    std::optional<double> total;
+    std::optional<std::string_view> message;
+};
+
+struct ProgressNotification {
+    std::string_view jsonrpc = "2.0";
+    std::string_view method = "notifications/progress";
+    ProgressParams params;
+};
+
+// Push channel events (GET /events on the push port). An item_started/item_ended event
+// says where the item came from: queue, scheduled or fallback.
+struct ItemEventView {
+    std::string_view source;
+    std::string_view submitter;
+    std::string_view priority;
+    std::string_view origin;
+    std::optional<double> duration;        // item_started
+    std::optional<double> played_seconds;  // item_ended
+    std::optional<bool> interrupted;       // item_ended
+    std::optional<std::string_view> error;  // item_skipped
+};
+
+struct InterruptEventView {
+    std::string_view source;
+    std::string_view reason;
+};
+
+struct EncoderTelemetryView {
+    uint64_t frame = 0;
+    double fps = 0.0;
+    double bitrate_kbps = 0.0;
+    double speed = 0.0;
+    double out_time_seconds = 0.0;
+    uint64_t total_size = 0;
+    uint64_t dropped_frames = 0;
+    uint64_t duplicated_frames = 0;
+};
+
+template <class T>
+struct RpcResponse {
+    std::string_view jsonrpc = "2.0";
+    glz::raw_json_view id{"null"};
+    T result;
+};
+
+// Views over queue state; strings are borrowed from the arguments
+QueueItemView queue_item_view(const QueueItem& item);
+QueuePageResponse queue_page(const QueueSnapshot& snapshot, size_t offset, size_t limit);  // Clamped to the size
+std::vector<SubmitterStatusView> submitter_status_views(const QueueSnapshot& snapshot);
+QueueChangesResponse queue_changes_response(const QueueChanges& changes);
+ImportResponse import_response(const PlaylistImportResult& result);
+ValidationJobView validation_job_view(const ValidationJob& job);  // Borrows from job
+
+template <>
+struct glz::meta<QueueItemView> {
+    using T = QueueItemView;
+    static constexpr auto value = glz::object("source", &T::source, "submitter", &T::submitter, "class", &T::priority);
+};
+
+template <>
+struct glz::meta<ItemEventView> {
+    using T = ItemEventView;
+    static constexpr auto value = glz::object("source", &T::source, "submitter", &T::submitter, "class", &T::priority,
+                                              "origin", &T::origin, "duration", &T::duration,
+                                              "played_seconds", &T::played_seconds, "interrupted", &T::interrupted,
+                                              "error", &T::error);
+};
+
+template <>
+struct glz::meta<QueueChangeView> {
+    using T = QueueChangeView;
+    static constexpr auto value = glz::object("version", &T::version, "op", &T::op, "source", &T::source,
+                                              "class", &T::priority, "submitter", &T::submitter);
+};
+
+template <>
+struct glz::meta<QueuePriorityResponse> {
+    using T = QueuePriorityResponse;
+    static constexpr auto value = glz::object("status", &T::status, "message", &T::message, "item", &T::item,
+                                              "class", &T::priority, "policy", &T::policy);
+};
+
+template <>
+struct glz::meta<EpgEventView> {
+    using T = EpgEventView;
+    static constexpr auto value = glz::object("id", &T::id, "title", &T::title, "source", &T::source,
+                                              "class", &T::priority, "start", &T::start, "stop", &T::stop,
+                                              "duration", &T::duration, "join", &T::join, "repeat", &T::repeat);
+};
@@ -0,0 +1,446 @@
+#include "logger.hpp"
+#include "runtime.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <optional>
+
+namespace {
+
+constexpr size_t MAX_BATCH_RECORDS = 256;
+constexpr size_t MAX_BATCH_BYTES = 64 * 1024;
+
+constexpr const char* LEVEL_NAMES[] = {"debug", "info", "warn", "error"};
+constexpr const char* LEVEL_LABELS[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+constexpr const char* CATEGORY_NAMES[] = {"main", "http", "queue", "playout", "progress", "stream", "probe", "push"};
+static_assert(std::size(CATEGORY_NAMES) == LOG_CATEGORY_COUNT);
+
+constexpr size_t DATA_BYTES = sizeof(LogRecord::data);
+
+// Longest prefix of text that fits in room without splitting a UTF-8 sequence
+size_t fit(std::string_view text, size_t room) {
+    if (text.size() <= room) {
+        return text.size();
+    }
+    size_t cut = room;
+    while (cut > 0 && (static_cast<unsigned char>(text[cut]) & 0xC0) == 0x80) {
+        --cut;
+    }
+    return cut;
+}
+
+void put_u16(char* out, size_t value) {
+    out[0] = static_cast<char>(value & 0xFF);
+    out[1] = static_cast<char>(value >> 8);
+}
+
+size_t get_u16(const char* in) {
+    return static_cast<unsigned char>(in[0]) | (static_cast<size_t>(static_cast<unsigned char>(in[1])) << 8);
+}
+
+std::string_view render_value(const LogField& field, char* buffer, size_t size) {
+    if (field.kind == LogField::Kind::String) {
+        return field.text;
+    }
+    if (field.kind == LogField::Kind::Bool) {
+        return field.boolean ? "true" : "false";
+    }
+    std::to_chars_result result;
+    if (field.is_real) {
+        result = std::to_chars(buffer, buffer + size, field.real);
+    } else if (field.is_unsigned) {
+        result = std::to_chars(buffer, buffer + size, field.unsigned_integer);
+    } else {
+        result = std::to_chars(buffer, buffer + size, field.integer);
+    }
+    return {buffer, static_cast<size_t>(result.ptr - buffer)};
+}
+
+void encode(LogRecord& record, std::string_view message, std::initializer_list<LogField> fields) {
+    size_t used = fit(message, DATA_BYTES);
+    std::memcpy(record.data, message.data(), used);
+    record.message_size = static_cast<uint16_t>(used);
+    record.truncated = used < message.size();
+
+    for (const auto& field : fields) {
+        std::string_view key = field.key.substr(0, fit(field.key, 64));
+        size_t header = 1 + 1 + key.size() + 2;
+        if (used + header >= DATA_BYTES) {
+            record.truncated = true;
+            break;
+        }
+        char number[32];
+        std::string_view value = render_value(field, number, sizeof(number));
+        size_t value_size = fit(value, DATA_BYTES - used - header);
+        record.truncated |= value_size < value.size();
+
+        char* out = record.data + used;
+        out[0] = static_cast<char>(field.kind);
+        out[1] = static_cast<char>(key.size());
+        std::memcpy(out + 2, key.data(), key.size());
+        put_u16(out + 2 + key.size(), value_size);
+        std::memcpy(out + header, value.data(), value_size);
+        used += header + value_size;
+    }
+    record.size = static_cast<uint16_t>(used);
+}
+
+void append_json_string(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    constexpr char hex[] = "0123456789abcdef";
+                    out += "\\u00";
+                    out += hex[(c >> 4) & 0xF];
+                    out += hex[c & 0xF];
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+// logfmt style: bare when it is one token, otherwise quoted
+void append_text_value(std::string& out, std::string_view text) {
+    bool bare = !text.empty() && std::none_of(text.begin(), text.end(), [](char c) {
+        return c == ' ' || c == '"' || c == '=' || static_cast<unsigned char>(c) < 0x20;
+    });
+    if (bare) {
+        out += text;
+        return;
+    }
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: out += c;
+        }
+    }
+    out += '"';
+}
+
+// 2026-10-18T09:30:00.125Z; the writer formats records in time order, so the date part
+// is only rebuilt when the second changes
+void append_timestamp(std::string& out, int64_t time_ns) {
+    thread_local int64_t cached_second = -1;
+    thread_local char prefix[24];
+    int64_t second = time_ns / 1000000000;
+    if (second != cached_second) {
+        std::time_t seconds = static_cast<std::time_t>(second);
+        std::tm utc{};
+        gmtime_r(&seconds, &utc);
+        std::strftime(prefix, sizeof(prefix), "%Y-%m-%dT%H:%M:%S", &utc);
+        cached_second = second;
+    }
+    int millis = static_cast<int>((time_ns / 1000000) % 1000);
+    out += prefix;
+    out += '.';
+    out += static_cast<char>('0' + millis / 100);
+    out += static_cast<char>('0' + millis / 10 % 10);
+    out += static_cast<char>('0' + millis % 10);
+    out += 'Z';
+}
+
+std::optional<LogLevel> parse_level(std::string_view text) {
+    for (size_t i = 0; i < std::size(LEVEL_NAMES); ++i) {
+        if (text == LEVEL_NAMES[i]) {
+            return static_cast<LogLevel>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+const char* log_level_name(LogLevel level) {
+    return LEVEL_NAMES[static_cast<size_t>(level)];
+}
+
+const char* log_category_name(LogCategory category) {
+    return CATEGORY_NAMES[static_cast<size_t>(category)];
+}
+
+Logger::Logger() : Logger(Options{}) {}
+
+Logger::Logger(Options options)
+    : options_(options),
+      level_(options.level),
+      mask_(std::bit_ceil(std::max<size_t>(options.capacity, 2)) - 1),
+      cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+    for (uint64_t i = 0; i <= mask_; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer_ = std::thread([this] {
+        enter_thread_role(ThreadRole::Background, "log-writer");
+        run();
+    });
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_.store(true, std::memory_order_release);
+    }
+    wake_.notify_one();
+    writer_.join();
+}
+
+bool Logger::log(LogLevel level, LogCategory category, std::string_view message,
+                 std::initializer_list<LogField> fields) {
+    if (!enabled(level)) {
+        return false;
+    }
+    size_t index = static_cast<size_t>(category);
+    uint32_t every = options_.sample_every[index];
+    if (every > 1 && level < LogLevel::Warn &&
+        sample_counters_[index].fetch_add(1, std::memory_order_relaxed) % every != 0) {
+        sampled_out_.add();
+        return false;
+    }
+
+    // Bounded MPMC ring (Vyukov): a slot is free for position pos when its sequence equals pos
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &cells_[pos & mask_];
+        uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<int64_t>(sequence - pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped_.add();  // The writer is a full ring behind
+            return false;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    LogRecord& record = cell->record;
+    record.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch()).count();
+    record.level = level;
+    record.category = category;
+    encode(record, message, fields);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool Logger::flush(std::chrono::milliseconds timeout) {
+    uint64_t target = enqueue_pos_.load(std::memory_order_acquire);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (written_pos_.load(std::memory_order_acquire) < target) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            wake_requested_ = true;
+        }
+        wake_.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void Logger::encode(LogRecord& record, std::string_view message, std::initializer_list<LogField> fields) {
+    ::encode(record, message, fields);
+}
+
+void Logger::format(const LogRecord& record, LogFormat format, std::string& out) {
+    std::string_view message(record.data, record.message_size);
+    bool json = format == LogFormat::Json;
+    if (json) {
+        out += "{\"ts\":\"";
+        append_timestamp(out, record.time_ns);
+        out += "\",\"level\":\"";
+        out += log_level_name(record.level);
+        out += "\",\"category\":\"";
+        out += log_category_name(record.category);
+        out += "\",\"msg\":";
+        append_json_string(out, message);
+    } else {
+        append_timestamp(out, record.time_ns);
+        out += ' ';
+        out += LEVEL_LABELS[static_cast<size_t>(record.level)];
+        out += " [";
+        out += log_category_name(record.category);
+        out += "] ";
+        out += message;
+    }
+
+    const char* in = record.data + record.message_size;
+    const char* end = record.data + record.size;
+    while (in < end) {
+        auto kind = static_cast<LogField::Kind>(in[0]);
+        size_t key_size = static_cast<unsigned char>(in[1]);
+        std::string_view key(in + 2, key_size);
+        size_t value_size = get_u16(in + 2 + key_size);
+        std::string_view value(in + 4 + key_size, value_size);
+        in += 4 + key_size + value_size;
+
+        if (json) {
+            out += ',';
+            append_json_string(out, key);
+            out += ':';
+            if (kind == LogField::Kind::String) {
+                append_json_string(out, value);
+            } else if (value == "inf" || value == "-inf" || value == "nan" || value == "-nan") {
+                out += "null";  // Not representable in JSON
+            } else {
+                out += value;
+            }
+        } else {
+            out += ' ';
+            out += key;
+            out += '=';
+            append_text_value(out, value);
+        }
+    }
+
+    if (json) {
+        out += record.truncated ? ",\"truncated\":true}\n" : "}\n";
+    } else {
+        out += record.truncated ? " (truncated)\n" : "\n";
+    }
+}
+
+size_t Logger::drain(std::string& batch) {
+    size_t count = 0;
+    while (count < MAX_BATCH_RECORDS && batch.size() < MAX_BATCH_BYTES) {
+        Cell& cell = cells_[dequeue_pos_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+            break;  // Empty, or the producer of this slot is still filling it
+        }
+        format(cell.record, options_.format, batch);
+        cell.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+        ++count;
+    }
+    return count;
+}
+
+void Logger::write_batch(const std::string& batch) {
+    size_t offset = 0;
+    while (offset < batch.size()) {
+        ssize_t n = ::write(options_.fd, batch.data() + offset, batch.size() - offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;  // Nowhere to report it; the batch is lost
+        }
+        offset += static_cast<size_t>(n);
+    }
+}
+
+void Logger::run() {
+    std::string batch;
+    batch.reserve(MAX_BATCH_BYTES + LOG_RECORD_BYTES * 4);
+    for (;;) {
+        bool stopping = stopping_.load(std::memory_order_acquire);
+        size_t count = drain(batch);
+        if (count > 0) {
+            write_batch(batch);
+            batch.clear();
+            written_records_.add(count);
+            written_pos_.store(dequeue_pos_, std::memory_order_release);
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+        // Producers never signal; the writer polls, and only stop() and flush() wake it early
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait_for(lock, options_.idle_interval,
+                       [this] { return wake_requested_ || stopping_.load(std::memory_order_acquire); });
+        wake_requested_ = false;
+    }
+}
+
+std::array<uint32_t, LOG_CATEGORY_COUNT> parse_log_sampling(std::string_view spec) {
+    std::array<uint32_t, LOG_CATEGORY_COUNT> every{};
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        std::string_view entry = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view{} : spec.substr(comma + 1);
+
+        size_t equals = entry.find('=');
+        if (equals == std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = entry.substr(0, equals);
+        std::string_view count = entry.substr(equals + 1);
+        uint32_t n = 0;
+        auto result = std::from_chars(count.data(), count.data() + count.size(), n);
+        if (result.ec != std::errc{} || result.ptr != count.data() + count.size() || n == 0) {
+            continue;
+        }
+        for (size_t i = 0; i < LOG_CATEGORY_COUNT; ++i) {
+            if (name == CATEGORY_NAMES[i]) {
+                every[i] = n;
+            }
+        }
+    }
+    return every;
+}
+
+Logger& logger() {
+    static Logger* instance = [] {
+        Logger::Options options;
+        // One progress line in ten: the playout loop ticks once a second
+        options.sample_every[static_cast<size_t>(LogCategory::Progress)] = 10;
+
+        const char* level_env = std::getenv("MYCHANNEL_LOG_LEVEL");
+        std::optional<LogLevel> level = level_env ? parse_level(level_env) : std::nullopt;
+        if (level) {
+            options.level = *level;
+        }
+        const char* format_env = std::getenv("MYCHANNEL_LOG_FORMAT");
+        if (format_env && std::string_view(format_env) == "json") {
+            options.format = LogFormat::Json;
+        }
+        if (const char* sample_env = std::getenv("MYCHANNEL_LOG_SAMPLE")) {
+            auto every = parse_log_sampling(sample_env);
+            for (size_t i = 0; i < LOG_CATEGORY_COUNT; ++i) {
+                if (every[i] != 0) {
+                    options.sample_every[i] = every[i];
+                }
+            }
+        }
+
+        // Leaked so that threads still logging during static destruction stay safe
+        auto* created = new Logger(options);
+        std::atexit([] { logger().flush(); });
+        metrics_registry().counter_callback("mychannel_log_dropped_records_total",
+                                            "Log records dropped because the log ring was full",
+                                            [created] { return static_cast<double>(created->dropped()); });
+        metrics_registry().counter_callback("mychannel_log_sampled_records_total",
+                                            "Log records skipped by per-category sampling",
+                                            [created] { return static_cast<double>(created->sampled_out()); });
+        if (level_env && !level) {
+            created->log(LogLevel::Warn, LogCategory::Main, "Ignoring invalid MYCHANNEL_LOG_LEVEL",
+                         {{"value", level_env}});
+        }
+        return created;
+    }();
+    return *instance;
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "metrics.hpp"
+
+// Asynchronous structured logging. A call does no formatting and no I/O: it copies the
+// message and its fields into a fixed-size record of a bounded lock-free ring, and a
+// background writer turns batches of records into text or JSON lines with one write(2)
+// per batch. When the ring is full the record is counted as dropped instead of making
+// the caller wait.
+
+enum class LogLevel : uint8_t { Debug, Info, Warn, Error };
+
+enum class LogCategory : uint8_t {
+    Main,      // Startup and configuration
+    Http,      // REST API
+    Queue,     // Queue persistence
+    Playout,   // Items starting and ending
+    Progress,  // Periodic playback progress; sampled by default
+    Stream,    // Encoder processes
+    Probe,     // ffprobe / yt-dlp
+    Push,      // Push event channel
+    Count
+};
+
+inline constexpr size_t LOG_CATEGORY_COUNT = static_cast<size_t>(LogCategory::Count);
+
+const char* log_level_name(LogLevel level);           // "debug", "info", ...
+const char* log_category_name(LogCategory category);  // "http", "playout", ...
+
+enum class LogFormat : uint8_t { Text, Json };
+
+// A key and its value, copied into the record at the call, so temporaries are fine
+struct LogField {
+    enum class Kind : uint8_t { String, Number, Bool };
+
+    LogField(std::string_view key, std::string_view value) : key(key), kind(Kind::String), text(value) {}
+    LogField(std::string_view key, const char* value) : LogField(key, std::string_view(value)) {}
+    LogField(std::string_view key, const std::string& value) : LogField(key, std::string_view(value)) {}
+    LogField(std::string_view key, bool value) : key(key), kind(Kind::Bool), boolean(value) {}
+    template <std::integral T>
+        requires(!std::same_as<T, bool> && !std::same_as<T, char>)
+    LogField(std::string_view key, T value) : key(key), kind(Kind::Number) {
+        if constexpr (std::is_signed_v<T>) {
+            integer = value;
+        } else {
+            unsigned_integer = value;
+            is_unsigned = true;
+        }
+    }
+    LogField(std::string_view key, double value) : key(key), kind(Kind::Number), real(value), is_real(true) {}
+
+    std::string_view key;
+    Kind kind;
+    std::string_view text;
+    int64_t integer = 0;
+    uint64_t unsigned_integer = 0;
+    double real = 0.0;
+    bool boolean = false;
+    bool is_unsigned = false;
+    bool is_real = false;
+};
+
+inline constexpr size_t LOG_RECORD_BYTES = 512;  // Longer messages and fields are cut short
+
+// One ring slot: fields are stored as [kind][key length][key][value length][value], numbers
+// already rendered as text
+struct LogRecord {
+    int64_t time_ns = 0;  // system_clock since the epoch
+    LogLevel level = LogLevel::Info;
+    LogCategory category = LogCategory::Main;
+    bool truncated = false;
+    uint16_t message_size = 0;
+    uint16_t size = 0;  // Bytes of data used, message first
+    char data[LOG_RECORD_BYTES - 16];
+};
+
+class Logger {
+public:
+    struct Options {
+        LogLevel level = LogLevel::Info;
+        LogFormat format = LogFormat::Text;
+        int fd = 1;             // Not closed by the logger
+        size_t capacity = 2048;  // Records; rounded up to a power of two
+        std::chrono::milliseconds idle_interval{5};  // Writer sleep when the ring is empty
+        // Keep one in N Debug/Info records of a category; warnings and errors are never sampled
+        std::array<uint32_t, LOG_CATEGORY_COUNT> sample_every{};
+    };
+
+    Logger();
+    explicit Logger(Options options);
+    ~Logger();  // Writes what is queued, then stops the writer
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    bool enabled(LogLevel level) const { return level >= level_.load(std::memory_order_relaxed); }
+    void set_level(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return level_.load(std::memory_order_relaxed); }
+
+    // Never blocks; false when the record was filtered, sampled out or dropped
+    bool log(LogLevel level, LogCategory category, std::string_view message,
+             std::initializer_list<LogField> fields = {});
+
+    // Waits (up to the timeout) until every record logged before the call has been written
+    bool flush(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+
+    uint64_t written() const { return written_records_.value(); }
+    uint64_t dropped() const { return dropped_.value(); }     // Ring full
+    uint64_t sampled_out() const { return sampled_out_.value(); }
+
+    // Fills record's message and fields as log() does; format() appends it as one line
+    static void encode(LogRecord& record, std::string_view message, std::initializer_list<LogField> fields);
+    static void format(const LogRecord& record, LogFormat format, std::string& out);
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> sequence;
+        LogRecord record;
+    };
+
+    void run();
+    size_t drain(std::string& batch);  // Formats ready records; returns how many
+    void write_batch(const std::string& batch);
+
+    const Options options_;
+    std::atomic<LogLevel> level_;
+    const uint64_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+    alignas(64) uint64_t dequeue_pos_ = 0;  // Writer thread only
+    std::atomic<uint64_t> written_pos_{0};  // Records formatted and handed to write(2)
+
+    std::array<std::atomic<uint32_t>, LOG_CATEGORY_COUNT> sample_counters_{};
+    Counter written_records_;
+    Counter dropped_;
+    Counter sampled_out_;
+
+    std::mutex wake_mutex_;  // Writer sleeps only; producers never take it
+    std::condition_variable wake_;
+    bool wake_requested_ = false;  // By flush(), under wake_mutex_
+    std::atomic<bool> stopping_{false};
+    std::thread writer_;
+};
+
+// Parses "playout=10,stream=5"; unknown categories and bad counts are ignored
+std::array<uint32_t, LOG_CATEGORY_COUNT> parse_log_sampling(std::string_view spec);
+
+// Process-wide logger, configured from MYCHANNEL_LOG_LEVEL (debug|info|warn|error),
+// MYCHANNEL_LOG_FORMAT (text|json) and MYCHANNEL_LOG_SAMPLE. Never destroyed; queued
+// records are flushed at exit.
+Logger& logger();
+
+inline void log_debug(LogCategory category, std::string_view message, std::initializer_list<LogField> fields = {}) {
+    logger().log(LogLevel::Debug, category, message, fields);
+}
+inline void log_info(LogCategory category, std::string_view message, std::initializer_list<LogField> fields = {}) {
+    logger().log(LogLevel::Info, category, message, fields);
+}
+inline void log_warn(LogCategory category, std::string_view message, std::initializer_list<LogField> fields = {}) {
+    logger().log(LogLevel::Warn, category, message, fields);
+}
+inline void log_error(LogCategory category, std::string_view message, std::initializer_list<LogField> fields = {}) {
+    logger().log(LogLevel::Error, category, message, fields);
+}
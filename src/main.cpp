@@ -1,88 +1,475 @@
-#include <iostream>
 #include <string>
 #include <chrono>
 #include <thread>
 #include <cstdlib>
 #include <future>
+#include <memory>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <atomic>
+#include <utility>
+#include <vector>
 #include "media_queue.hpp"
+#include "queue_journal.hpp"
+#include "event_scheduler.hpp"
 #include "media_info.hpp"
 #include "streaming.hpp"
 #include "http_server.hpp"
 #include "mcp_server.hpp"
+#include "push_server.hpp"
+#include "json_response.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "runtime.hpp"
+#include "handoff.hpp"
+#include "hls.hpp"
+#include "tool_executor.hpp"
 #include "utils.hpp"
+#include <sstream>
+
+// Apply MYCHANNEL_INTERRUPT_POLICIES, e.g. "next=end_of_item,interrupt=segment,breaking=immediate"
+static void configure_interrupt_policies(ThreadSafeMediaQueue& queue, const char* spec) {
+    std::stringstream ss(spec);
+    std::string entry;
+    while (std::getline(ss, entry, ',')) {
+        auto eq = entry.find('=');
+        auto priority = parse_priority_class(entry.substr(0, eq));
+        auto policy = eq == std::string::npos ? std::nullopt : parse_interrupt_policy(entry.substr(eq + 1));
+        if (!priority || !policy) {
+            log_warn(LogCategory::Main, "⚠️ Ignoring invalid interrupt policy entry", {{"entry", entry}});
+            continue;
+        }
+        queue.set_interrupt_policy(*priority, *policy);
+    }
+    for (size_t i = 1; i < PRIORITY_CLASS_COUNT; ++i) {
+        auto priority = static_cast<PriorityClass>(i);
+        log_info(LogCategory::Main, "🚦 Priority class",
+                 {{"class", priority_class_name(priority)}, {"policy", interrupt_policy_name(queue.interrupt_policy(priority))}});
+    }
+}
+
+// Apply MYCHANNEL_SUBMITTER_WEIGHTS / MYCHANNEL_SUBMITTER_QUOTAS, e.g. "editorial=3,agent=1".
+// The name "*" sets the default for submitters that are not listed.
+static void configure_submitters(ThreadSafeMediaQueue& queue, const char* weights, const char* quotas) {
+    std::map<std::string, SubmitterPolicy> policies;
+    auto parse = [&](const char* spec, auto&& apply) {
+        std::stringstream ss(spec ? spec : "");
+        std::string entry;
+        while (std::getline(ss, entry, ',')) {
+            auto eq = entry.find('=');
+            try {
+                if (eq == std::string::npos || eq == 0) {
+                    throw std::invalid_argument(entry);
+                }
+                apply(policies[entry.substr(0, eq)], entry.substr(eq + 1));
+            } catch (const std::exception&) {
+                log_warn(LogCategory::Main, "⚠️ Ignoring invalid submitter entry", {{"entry", entry}});
+            }
+        }
+    };
+    parse(weights, [](SubmitterPolicy& policy, const std::string& value) { policy.weight = std::stod(value); });
+    parse(quotas, [](SubmitterPolicy& policy, const std::string& value) { policy.quota = std::stoul(value); });
+
+    for (const auto& [name, policy] : policies) {
+        if (name == "*") {
+            queue.set_default_submitter_policy(policy);
+        } else {
+            queue.set_submitter_policy(name, policy);
+        }
+        log_info(LogCategory::Main, "⚖️ Submitter policy",
+                 {{"submitter", name}, {"weight", policy.weight},
+                  {"quota", policy.quota ? std::to_string(policy.quota) : "unlimited"}});
+    }
+}
 
 int main() {
+    // SIGUSR2 hands the channel over to a freshly started successor (see handoff.hpp)
+    block_handoff_signal();
+    Handoff handoff;
+
+    // Threads started from here on name and place themselves by their own role
+    enter_thread_role(ThreadRole::Playout, "playout");
+    if (const char* cpus_env = std::getenv("MYCHANNEL_THREAD_CPUS")) {
+        RoleCpus cpus{};
+        if (!parse_role_cpus(cpus_env, cpus)) {
+            log_warn(LogCategory::Main, "⚠️ Ignoring invalid thread CPU entries", {{"value", cpus_env}});
+        }
+        for (size_t i = 0; i < THREAD_ROLE_COUNT; ++i) {
+            auto role = static_cast<ThreadRole>(i);
+            if (!role_cpus(role).empty()) {
+                log_info(LogCategory::Main, "📌 Thread CPUs",
+                         {{"role", thread_role_name(role)}, {"cpus", format_cpu_set(role_cpus(role))}});
+            }
+        }
+    }
+    // Before the first item: a CPU cap also moves the server into a cgroup of its own
+    g_stream_process->set_encoder_policy(encoder_policy_from_env());
+
+    const char* state_dir_env = std::getenv("MYCHANNEL_STATE_DIR");
+    std::string state_dir = state_dir_env ? state_dir_env : "state";
+
+    // Local HLS output: MYCHANNEL_HLS=on next to RTMP, only without it. The FIFO is opened
+    // before a handoff, so the encoder on air never loses its reader.
+    const char* hls_env = std::getenv("MYCHANNEL_HLS");
+    std::string hls_mode = hls_env ? hls_env : "off";
+    if (hls_mode != "off" && hls_mode != "on" && hls_mode != "only") {
+        log_warn(LogCategory::Main, "⚠️ Ignoring invalid HLS mode", {{"value", hls_mode}});
+        hls_mode = "off";
+    }
+    std::unique_ptr<HlsOutput> hls;
+    std::unique_ptr<HlsIngest> hls_ingest;
+    if (hls_mode != "off") {
+        try {
+            std::filesystem::create_directories(state_dir);
+            hls = std::make_unique<HlsOutput>(HlsOptions::from_env());
+            hls_ingest = std::make_unique<HlsIngest>(state_dir + "/hls.fifo", *hls);
+            g_stream_process->set_hls_fifo(hls_ingest->path());
+            log_info(LogCategory::Main, "📺 Local HLS output on /hls/live.m3u8",
+                     {{"mode", hls_mode}, {"fifo", hls_ingest->path()},
+                      {"part_ms", static_cast<int64_t>(hls->options().part_target.count())}});
+        } catch (const std::exception& e) {
+            log_error(LogCategory::Main, "⚠️ HLS output disabled", {{"error", e.what()}});
+            hls_ingest.reset();
+            hls.reset();
+            if (hls_mode == "only") {
+                return 1;
+            }
+        }
+    }
+
     const char* rtmp_url_env = std::getenv("YOUTUBE_RTMP_URL");
     const char* stream_key_env = std::getenv("YOUTUBE_STREAM_KEY");
 
-    if (!rtmp_url_env || !stream_key_env) {
-        std::cerr << "Error: YOUTUBE_RTMP_URL or YOUTUBE_STREAM_KEY environment variables are not set." << std::endl;
+    if (hls_mode != "only" && (!rtmp_url_env || !stream_key_env)) {
+        log_error(LogCategory::Main, "Error: YOUTUBE_RTMP_URL or YOUTUBE_STREAM_KEY environment variables are not set.");
         return 1;
     }
 
-    std::string rtmp_url = rtmp_url_env;
-    std::string stream_key = stream_key_env;
+    // HLS only: no RTMP output
+    std::string rtmp_url = hls_mode != "only" ? rtmp_url_env : "";
+    std::string stream_key = hls_mode != "only" ? stream_key_env : "";
+
+    // Started by a running server for a handoff: wait until it has let go of the journal,
+    // the ports and the encoder on air
+    std::optional<HandoffState> inherited;
+    try {
+        inherited = receive_handoff();
+    } catch (const std::exception& e) {
+        log_error(LogCategory::Main, "❌ Handoff failed", {{"error", e.what()}});
+        return 1;
+    }
+    if (hls_ingest) {
+        hls_ingest->start();  // The previous process has stopped reading
+    }
 
     // Initialize media queue with default items
     ThreadSafeMediaQueue media_queue;
     // media_queue.push("https://www.youtube.com/watch?v=gCNeDWCI0vo");
 
+    // Restore the persisted lineup and journal every mutation from here on
+    // The probe cache loads on the cache workers while the journal replays here
+    const std::string probe_cache_path = state_dir + "/probe.cache";
+    ToolExecutor cache_workers(std::clamp<size_t>(process_cpu_set().size(), 1, 4), 1024, ThreadRole::Background, "cache");
+    auto probe_cache_loaded = std::make_shared<std::promise<size_t>>();
+    auto probe_cache_entries = probe_cache_loaded->get_future();
+    if (!cache_workers.submit([probe_cache_loaded, &probe_cache_path] {
+            probe_cache_loaded->set_value(load_probe_cache(probe_cache_path));
+        })) {
+        probe_cache_loaded->set_value(load_probe_cache(probe_cache_path));
+    }
+    std::unique_ptr<QueueJournal> queue_journal;
+    try {
+        queue_journal = std::make_unique<QueueJournal>(state_dir);
+        auto recovery = queue_journal->open(media_queue);
+        log_info(LogCategory::Queue, "💾 Restored queue",
+                 {{"items", recovery.items}, {"state_dir", state_dir}, {"snapshot_items", recovery.snapshot_items},
+                  {"journal_records", recovery.replayed_records}, {"elapsed_ms", recovery.elapsed_ms}});
+    } catch (const std::exception& e) {
+        log_error(LogCategory::Queue, "⚠️ Queue persistence disabled", {{"error", e.what()}});
+        queue_journal.reset();
+    }
+    log_info(LogCategory::Probe, "💾 Restored probe cache", {{"entries", probe_cache_entries.get()}});
+
+    // Queued files are checked against it in the background (a stat() each) and the ones
+    // that changed are probed again before they come up
+    {
+        std::vector<std::string> sources;
+        for (const auto& item : media_queue.snapshot()->items) {
+            sources.push_back(item.source);
+        }
+        warm_probe_cache(std::move(sources), cache_workers);
+    }
+
+    if (const char* policies_env = std::getenv("MYCHANNEL_INTERRUPT_POLICIES")) {
+        configure_interrupt_policies(media_queue, policies_env);
+    }
+    if (const char* cooldown_env = std::getenv("MYCHANNEL_INTERRUPT_COOLDOWN_MS")) {
+        char* end = nullptr;
+        long cooldown_ms = std::strtol(cooldown_env, &end, 10);
+        if (end != cooldown_env && *end == '\0' && cooldown_ms >= 0) {
+            g_stream_process->set_interrupt_cooldown(std::chrono::milliseconds(cooldown_ms));
+        } else {
+            log_warn(LogCategory::Main, "⚠️ Ignoring invalid interrupt cooldown", {{"value", cooldown_env}});
+        }
+    }
+    log_info(LogCategory::Main, "⏳ Interrupt cooldown",
+             {{"ms", static_cast<int64_t>(g_stream_process->interrupt_cooldown().count())}});
+    configure_submitters(media_queue, std::getenv("MYCHANNEL_SUBMITTER_WEIGHTS"),
+                         std::getenv("MYCHANNEL_SUBMITTER_QUOTAS"));
+    if (const char* mode_env = std::getenv("MYCHANNEL_ROTATION_MODE")) {
+        if (auto mode = parse_rotation_mode(mode_env)) {
+            media_queue.set_rotation_mode(*mode);
+        } else {
+            log_warn(LogCategory::Main, "⚠️ Ignoring invalid rotation mode", {{"mode", mode_env}});
+        }
+    }
+    log_info(LogCategory::Main, "🔁 Rotation mode", {{"mode", rotation_mode_name(media_queue.rotation_mode())}});
+
+    // Wall-clock events start at their scheduled time, cutting the item on air per their join policy
+    EventScheduler event_scheduler({
+        [] { return g_stream_process->on_air_priority(); },
+        [] {
+            log_info(LogCategory::Playout, "🗓️ Cutting the current stream for a scheduled event");
+            g_stream_process->request_termination();
+            g_stream_process->kill_current_process();
+        },
+    });
+    event_scheduler.start();
+
     // Start HTTP server with MCP support
-    HttpServer http_server(media_queue);
+    HttpServer http_server(media_queue, &event_scheduler, HttpServer::Options::from_env());
     MCPServer mcp_server(http_server);
-    auto server_future = http_server.start_async();
+    http_server.set_hls_output(hls.get());
+
+    // Push channel for dashboards (GET /events); MYCHANNEL_PUSH_PORT=0 turns it off
+    PushServer push_server;
+    auto& metrics = channel_metrics();
+    metrics_registry().gauge_callback("mychannel_push_subscribers", "Connected push event subscribers",
+                                      [&push_server] { return static_cast<double>(push_server.subscribers()); });
+    metrics_registry().counter_callback("mychannel_push_dropped_events_total", "Push events coalesced or dropped for slow subscribers",
+                                      [&push_server] { return static_cast<double>(push_server.dropped()); });
+    // Time to first frame of a cold start, from the process's own start; a handoff resumes
+    // a stream that never stopped
+    auto& first_frame_seconds = metrics_registry().gauge(
+        "mychannel_startup_first_frame_seconds", "Seconds from process start to the first encoded frame on a cold start");
+    std::atomic<bool> awaiting_first_frame{!inherited};
+    g_stream_process->set_telemetry_listener([&push_server, &metrics, &first_frame_seconds,
+                                              &awaiting_first_frame](const EncoderTelemetry& t) {
+        if (t.frame > 0 && awaiting_first_frame.exchange(false)) {
+            if (auto uptime = process_uptime_seconds()) {
+                first_frame_seconds.set(*uptime);
+                log_info(LogCategory::Main, "⏱️ First frame on air", {{"seconds_since_start", *uptime}});
+            }
+        }
+        metrics.encoder_speed.set(t.speed);
+        metrics.encoder_fps.set(t.fps);
+        metrics.encoder_bitrate_kbps.set(t.bitrate_kbps);
+        EncoderTelemetryView view{t.frame, t.fps, t.bitrate_kbps, t.speed, t.out_time_seconds,
+                                  t.total_size, t.dropped_frames, t.duplicated_frames};
+        push_server.publish("telemetry", write_json_response(view), true);
+    });
+    if (auto* validation = http_server.validation_jobs()) {
+        validation->set_listener([&push_server](const ValidationJob& job) {
+            push_server.publish("validation", write_json_response(validation_job_view(job)));
+        });
+    }
+
+    // The first item goes on air before the ports open: HTTP, push events and the handoff
+    // signal start right after its encoder, once
+    std::future<void> server_future;
+    auto start_control_plane = [&, started = false]() mutable {
+        if (std::exchange(started, true)) {
+            return;
+        }
+        const char* push_port_env = std::getenv("MYCHANNEL_PUSH_PORT");
+        int push_port = push_port_env ? std::atoi(push_port_env) : 8081;
+        if (push_port > 0) {
+            try {
+                push_server.start("0.0.0.0", push_port);
+                push_server.watch_queue(media_queue);
+                log_info(LogCategory::Push, "📡 Push events on /events", {{"port", push_port}});
+            } catch (const std::exception& e) {
+                log_error(LogCategory::Push, "⚠️ Push channel disabled", {{"error", e.what()}});
+            }
+        }
+        server_future = http_server.start_async();  // Once the validation listener is in place
+        handoff.watch_signal();
+    };
 
     std::future<void> current_push_future;
+    std::optional<std::chrono::steady_clock::time_point> previous_ended_at;
+    const std::string fallback_video = "videos/News_Intro.mp4";
 
     // Main streaming loop
-    for (;;) {
-        std::string current_video_path;
+    for (bool handed_off = false; !handed_off;) {
+        QueueItem current_item;
         bool is_fallback = false;
-        
-        if (!media_queue.pop(current_video_path)) {
+        bool is_scheduled = false;
+
+        // Reset before picking the item so a cut requested while it is being prepared still lands
+        g_stream_process->reset();
+
+        if (handoff.requested() && handoff.complete({})) {
+            break;  // Between items: the successor starts the next one
+        }
+
+        // The item the previous server process had on air plays on from where it was
+        std::optional<HandoffState> resumed;
+        if (inherited && inherited->encoder) {
+            resumed = std::move(inherited);
+            current_item = resumed->item;
+            is_fallback = resumed->origin == "fallback";
+            is_scheduled = resumed->origin == "scheduled";
+        }
+        inherited.reset();
+
+        // Scheduled events that have started take precedence over the queue
+        ScheduledEvent due_event;
+        if (resumed) {
+            log_info(LogCategory::Playout, "🤝 Resuming item on air",
+                     {{"item", current_item.source}, {"elapsed_seconds", resumed->elapsed_seconds()}});
+        } else if (event_scheduler.take_due(due_event)) {
+            current_item = due_event.item;
+            is_scheduled = true;
+            log_info(LogCategory::Playout, "🗓️ Starting scheduled event",
+                     {{"title", due_event.title.empty() ? current_item.source : due_event.title},
+                      {"scheduled_for", format_schedule_time(due_event.start)}});
+        } else if (!media_queue.advance(current_item)) {  // The rotation keeps the item (unless the mode is "once")
             // Queue is empty, use fallback video
-            current_video_path = "videos/News_Intro.mp4";
+            current_item.source = fallback_video;
             is_fallback = true;
-            std::cout << "Queue is empty, playing fallback video: " << current_video_path << std::endl;
-        } else {
-            // Add item back to end of queue for continuous loop
-            media_queue.push_back(current_video_path);
+            log_info(LogCategory::Playout, "Queue is empty, playing fallback video", {{"item", current_item.source}});
         }
+        const std::string& current_video_path = current_item.source;
 
-        // Get media duration
-        double duration;
-        if (is_youtube_url(current_video_path)) {
-            std::cout << "Getting duration for YouTube video: " << current_video_path << std::endl;
-            duration = get_youtube_duration(current_video_path);
+        // Streams and duration, from the probe cache unless the source changed
+        double duration = 0.0;
+        std::string unplayable;
+        if (resumed) {
+            duration = resumed->duration;
         } else {
-            duration = get_media_duration(current_video_path);
+            try {
+                MediaProbe media = probe_media(current_video_path);
+                duration = media.duration;
+                unplayable = check_playable(media);
+            } catch (const std::exception& e) {
+                unplayable = e.what();
+            }
         }
-        
-        std::cout << "Media duration for " << current_video_path << ": " << duration << " seconds" << std::endl;
-        
-        if (is_fallback) {
-            std::cout << "📺 [FALLBACK] No queue items - streaming default content" << std::endl;
-        } else {
-            std::cout << "🎬 [QUEUE] Streaming queued content" << std::endl;
+
+        const char* origin = is_fallback ? "fallback" : is_scheduled ? "scheduled" : "queue";
+        auto item_event = [&](ItemEventView view) {
+            view.source = current_item.source;
+            view.submitter = current_item.submitter;
+            view.priority = priority_class_name(current_item.priority);
+            view.origin = origin;
+            return write_json_response(view);
+        };
+
+        // Added items were probed when they were added, but a file can vanish or a URL expire
+        // while waiting, and priority and restored items were never probed: skip anything that
+        // would not pass validation rather than start the encoder on it. The item leaves the
+        // rotation, so a queue of nothing but dead items empties and the fallback plays on
+        // until something new is queued.
+        if (!unplayable.empty() && !is_fallback && !is_scheduled && !resumed) {
+            log_warn(LogCategory::Playout, "⏭️ Skipping unplayable item",
+                     {{"item", current_video_path}, {"submitter", current_item.submitter}, {"error", unplayable}});
+            push_server.publish("item_skipped", item_event({.error = unplayable}));
+            media_queue.remove_played(current_item);
+            continue;
         }
 
+        log_info(LogCategory::Playout, "🎬 Streaming item",
+                 {{"item", current_video_path}, {"origin", origin}, {"class", priority_class_name(current_item.priority)},
+                  {"submitter", current_item.submitter}, {"duration", duration}});
+        push_server.publish("item_started", item_event({.duration = duration}));
+
         // Start async streaming
-        g_stream_process->reset(); // Reset termination flag
-        current_push_future = push_to_youtube_async(current_video_path, rtmp_url, stream_key);
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        g_stream_process->set_on_air_priority(current_item.priority);
+        auto started_at = std::chrono::steady_clock::now();
+        if (previous_ended_at) {
+            metrics.transition_gap.observe(started_at - *previous_ended_at);
+        }
+        int first_second = 0;
+        if (resumed) {
+            // Where the encoder is now, handover and this process's startup included
+            started_at = resumed->started_at();
+            first_second = static_cast<int>(resumed->elapsed_seconds());
+            current_push_future = supervise_encoder_async(std::move(*resumed->encoder), current_video_path);
+            start_control_plane();
+        } else {
+            current_push_future = push_to_youtube_async(current_video_path, rtmp_url, stream_key);
+            start_control_plane();
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
 
         // Simulate playback timing with interruption checking
-        for (int j = 0; j < static_cast<int>(duration); ++j) {
+        bool interrupted = false;
+        auto record_interrupt_latency = [&] {
+            if (auto requested = g_stream_process->interrupt_requested_at()) {
+                metrics.interrupt_latency.observe(std::chrono::steady_clock::now() - *requested);
+            }
+        };
+        for (int j = first_second; j < static_cast<int>(duration); ++j) {
+            // A successor is ready: release the encoder to it without stopping it
+            if (handoff.requested()) {
+                g_stream_process->request_detach();
+                current_push_future.wait();
+                HandoffState state{current_item, origin, duration,
+                                   std::chrono::duration_cast<std::chrono::nanoseconds>(started_at.time_since_epoch()).count(),
+                                   g_stream_process->take_detached()};
+                if (handoff.complete(state)) {
+                    handed_off = true;
+                    break;
+                }
+                if (state.encoder) {
+                    current_push_future = supervise_encoder_async(std::move(*state.encoder), current_video_path);
+                }
+            }
+
             // Check if stream should be interrupted
             if (g_stream_process->should_terminate()) {
-                std::cout << "🔄 Stream interrupted for high-priority content" << std::endl;
+                log_info(LogCategory::Playout, "🔄 Stream interrupted for high-priority content", {{"item", current_video_path}});
+                push_server.publish("interrupt", write_json_response(InterruptEventView{current_video_path, "immediate"}));
+                record_interrupt_latency();
+                interrupted = true;
+                break;
+            }
+
+            // Segment-policy interrupts land on the next forced keyframe, by the encoder's output clock
+            if (g_stream_process->segment_boundary_reached()) {
+                log_info(LogCategory::Playout, "🔄 Cutting at segment boundary for high-priority content", {{"item", current_video_path}});
+                push_server.publish("interrupt", write_json_response(InterruptEventView{current_video_path, "segment"}));
+                record_interrupt_latency();
+                g_stream_process->request_termination();
+                g_stream_process->kill_current_process();
+                interrupted = true;
                 break;
             }
             
-            std::cout << "Playing " << current_video_path << " - " << (j + 1) << " of " << static_cast<int>(duration) << " seconds" << std::endl;
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            log_info(LogCategory::Progress, "Playing",
+                     {{"item", current_video_path}, {"second", j + 1}, {"of", static_cast<int>(duration)}});
+            if (is_fallback) {
+                // Fallback only fills dead air: hand over as soon as the first item is queued or an event starts
+                if (media_queue.wait_until_nonempty(std::chrono::seconds(1)) || event_scheduler.has_due()) {
+                    log_info(LogCategory::Playout, "🔄 Content is ready, ending fallback video");
+                    g_stream_process->request_termination();
+                    g_stream_process->kill_current_process();
+                    interrupted = true;
+                    break;
+                }
+            } else {
+                g_stream_process->wait_for_segment_boundary(std::chrono::seconds(1));  // Wakes for a due cut
+            }
         }
         
+        if (handed_off) {
+            break;  // The item plays on in the successor
+        }
+
         // Check for interruption before handling fractional duration
         if (!g_stream_process->should_terminate()) {
             // Handle fractional duration
@@ -91,14 +478,23 @@ int main() {
             }
         }
         
-        std::cout << "Finished playing " << current_video_path << std::endl;
+        double played_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at).count();
+        log_info(LogCategory::Playout, "Finished playing",
+                 {{"item", current_video_path}, {"played_seconds", played_seconds}, {"interrupted", interrupted}});
+        push_server.publish("item_ended", item_event({.played_seconds = played_seconds, .interrupted = interrupted}));
+
+        // Charge the real airtime (including cut-short items) to the submitter's fair share;
+        // scheduled events are outside the rotation
+        if (!is_fallback && !is_scheduled) {
+            media_queue.record_airtime(current_item.submitter, played_seconds);
+        }
         
         // Wait for the streaming future to complete before continuing
         if (current_push_future.valid()) {
             current_push_future.wait();
         }
-        
-        std::cout << "----------------------------------------" << std::endl;
+        previous_ended_at = std::chrono::steady_clock::now();
+        cache_workers.submit([&probe_cache_path] { save_probe_cache(probe_cache_path); });
     }
 
     return 0;
@@ -2,119 +2,145 @@
 #include "utils.hpp"
 #include "media_info.hpp"
 #include "streaming.hpp"
+#include "playlist_import.hpp"
+#include "json_response.hpp"
 #include <iostream>
-#include <sstream>
+#include <chrono>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+#include <utility>
 #include <glaze/glaze.hpp>
 
-MCPServer::MCPServer(HttpServer& server) : http_server_(server) {
-    // Initialize available MCP tools with simpler JSON schemas
-    tools_ = {
-        {
-            "add_video_to_queue",
-            "Add a video (YouTube URL or local file path) to the streaming queue",
-            "{\"type\":\"object\",\"properties\":{\"source\":{\"type\":\"string\"},\"position\":{\"type\":\"string\"}},\"required\":[\"source\"]}"
-        },
-        {
-            "add_priority_video", 
-            "Add high-priority video that interrupts current stream immediately",
-            "{\"type\":\"object\",\"properties\":{\"source\":{\"type\":\"string\"},\"reason\":{\"type\":\"string\"}},\"required\":[\"source\"]}"
-        },
-        {
-            "get_streaming_queue",
-            "Get current streaming queue status and contents", 
-            "{\"type\":\"object\",\"properties\":{}}"
-        },
-        {
-            "clear_streaming_queue",
-            "Clear the entire streaming queue",
-            "{\"type\":\"object\",\"properties\":{}}"
-        },
-        {
-            "get_stream_status",
-            "Get current streaming status and progress information",
-            "{\"type\":\"object\",\"properties\":{}}"
-        },
-        {
-            "interrupt_current_stream", 
-            "Immediately interrupt the current stream",
-            "{\"type\":\"object\",\"properties\":{\"reason\":{\"type\":\"string\"}},\"required\":[]}"
-        },
-        {
-            "get_video_duration",
-            "Get duration of a video file or YouTube URL",
-            "{\"type\":\"object\",\"properties\":{\"source\":{\"type\":\"string\"}},\"required\":[\"source\"]}"
-        },
-        {
-            "validate_video_source",
-            "Check if video source is accessible and valid",
-            "{\"type\":\"object\",\"properties\":{\"source\":{\"type\":\"string\"}},\"required\":[\"source\"]}"
-        }
-    };
+namespace {
+
+// Fair-share submitter for MCP clients that do not name one
+constexpr const char* MCP_SUBMITTER = "mcp";
+
+// Larger batches are rejected whole; runs of read-only members use at most this many threads
+constexpr size_t MAX_BATCH_SIZE = 100;
+constexpr size_t BATCH_PARALLELISM = 8;
+
+std::string submitter_or_default(const std::string& submitter) {
+    return submitter.empty() ? std::string(MCP_SUBMITTER) : submitter;
+}
+
+// Probe executor: at most this many probes run at once and this many wait; beyond that
+// calls are refused as busy
+constexpr size_t PROBE_WORKERS = 4;
+constexpr size_t PROBE_QUEUE = 32;
+// How long POST / holds its HTTP worker for a probe before answering with a status URL
+constexpr auto PROBE_INLINE_WAIT = std::chrono::seconds(1);
+// How long past its deadline a probe may run before its call is answered as timed out
+constexpr auto PROBE_GRACE = std::chrono::seconds(5);
+// How long a finished call stays at its status URL, and how many calls are kept
+constexpr auto POLLED_CALL_RETENTION = std::chrono::minutes(5);
+constexpr size_t MAX_POLLED_CALLS = 256;
+
+template <class Tool>
+constexpr std::optional<std::chrono::seconds> tool_timeout() {
+    if constexpr (Tool::access == MCPToolAccess::Probe) {
+        return Tool::timeout;
+    } else {
+        return std::nullopt;
+    }
+}
+
+bool accepts_event_stream(const httplib::Request& req) {
+    return req.get_header_value("Accept").find("text/event-stream") != std::string::npos;
+}
+
+void append_sse(std::string& stream, std::string_view data) {
+    stream += "event: message\ndata: ";
+    stream += data;
+    stream += "\n\n";
+}
+
+bool is_batch(std::string_view body) {
+    auto start = body.find_first_not_of(" \t\r\n");
+    return start != std::string_view::npos && body[start] == '[';
+}
+
+} // namespace
+
+MCPServer::MCPServer(HttpServer& server)
+    : http_server_(server), pending_calls_(MAX_POLLED_CALLS, POLLED_CALL_RETENTION) {
+    // Build the dispatch table and the tool discovery payload from the registry once
+    std::vector<ToolView> views;
+    std::apply([&]<class... Tool>(Tool...) {
+        (tools_.push_back({std::string(Tool::name), std::string(Tool::description), std::string(Tool::input_schema)}), ...);
+        (views.push_back({Tool::name, Tool::description, {Tool::input_schema}}), ...);
+        (tool_table_.emplace(Tool::name, ToolEntry{&MCPServer::call_tool<Tool>, Tool::access, tool_timeout<Tool>()}), ...);
+    }, MCPTools{});
+    tools_json_ = write_json_response(ToolsResponse{std::move(views)});
+    executor_ = std::make_unique<ToolExecutor>(PROBE_WORKERS, PROBE_QUEUE, ThreadRole::Background, "probe");
     
     setup_mcp_routes();
 }
 
+MCPServer::~MCPServer() {
+    // Queued and running probes abort at once, so joining the executor is quick
+    std::lock_guard<std::mutex> lock(running_mutex_);
+    for (auto& [key, task] : running_) {
+        task->cancel();
+    }
+}
+
 void MCPServer::setup_mcp_routes() {
-    // MCP JSON-RPC 2.0 endpoint
+    // MCP JSON-RPC 2.0 endpoint: one request or a batch array per POST
     http_server_.server_.Post("/", [this](const httplib::Request& req, httplib::Response& res) {
-        res.set_header("Content-Type", "application/json");
-        
         try {
-            // Parse JSON-RPC request with Glaze
-            glz::json_t json_request;
-            auto parse_error = glz::read_json(json_request, req.body);
-            
-            if (parse_error) {
-                std::string error_response = create_mcp_error_response("null", -32700, "Parse error");
-                res.set_content(error_response, "application/json");
-                return;
-            }
-            
-            // Extract method and id from JSON
-            std::string method;
-            std::string id;
-            
-            if (json_request.contains("method") && json_request["method"].is_string()) {
-                method = json_request["method"].get_string();
-            }
-            
-            if (json_request.contains("id")) {
-                if (json_request["id"].is_string()) {
-                    id = json_request["id"].get_string();
-                } else if (json_request["id"].is_number()) {
-                    id = std::to_string(json_request["id"].get_number());
+            bool authenticated = http_server_.is_authenticated(req);
+            std::optional<std::string> response;
+            if (is_batch(req.body)) {
+                response = handle_rpc_batch(req.body, authenticated);
+            } else {
+                MCPRequest request;
+                if (glz::read<MCP_READ_OPTS>(request, req.body)) {
+                    res.set_content(create_mcp_error_response("null", -32700, "Parse error"), "application/json");
+                    return;
                 }
-            }
-            
-            std::string response;
-            
-            if (method == "initialize") {
-                response = handle_mcp_initialize(id);
-            } else if (method == "tools/list") {
-                response = handle_mcp_tools_list(id);
-            } else if (method == "tools/call") {
-                if (!http_server_.is_authenticated(req)) {
-                    response = create_mcp_error_response(id, -32001, "Authentication required");
-                } else {
-                    response = handle_mcp_tool_call(id, json_request);
+                // Probes go to the executor rather than tying up this thread running ffprobe/yt-dlp
+                if (authenticated && request.method == "tools/call") {
+                    auto tool = tool_table_.find(request.params.name);
+                    if (tool != tool_table_.end() && tool->second.access == MCPToolAccess::Probe) {
+                        respond_async(request, tool->second, req, res);
+                        return;
+                    }
                 }
-            } else {
-                response = create_mcp_error_response(id, -32601, "Method not found");
+                response = handle_rpc_request(request, authenticated);
             }
-            
-            res.set_content(response, "application/json");
-        } catch (const std::exception& e) {
-            std::string error_response = create_mcp_error_response("null", -32700, "Parse error");
-            res.set_content(error_response, "application/json");
+            if (!response) {
+                res.status = 202;  // Only notifications, nothing to answer
+                return;
+            }
+            res.set_content(*response, "application/json");
+        } catch (const std::exception&) {
+            res.set_content(create_mcp_error_response("null", -32603, "Internal error"), "application/json");
+        }
+    });
+
+    // GET /mcp/calls?id=<id> - Response of a probe call answered with 202: 202 again while it
+    // runs, then the JSON-RPC response
+    http_server_.server_.Get("/mcp/calls", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!http_server_.is_authenticated(req)) {
+            res.status = 401;
+            res.set_content(create_error_response("Authentication required"), "application/json");
+            return;
+        }
+        if (!req.has_param("id")) {
+            res.status = 400;
+            res.set_content(create_error_response("Missing id parameter"), "application/json");
+            return;
         }
+        respond_pending(req.get_param_value("id"), res);
     });
 
     // Legacy endpoints for backward compatibility
     // MCP endpoint for tool discovery
     http_server_.server_.Get("/mcp/tools", [this](const httplib::Request&, httplib::Response& res) {
-        std::string json_response = get_tools_schema();
-        res.set_content(json_response, "application/json");
+        res.set_content(get_tools_schema(), "application/json");
     });
     
     // MCP endpoint for tool execution
@@ -125,314 +151,667 @@ void MCPServer::setup_mcp_routes() {
             return;
         }
         
-        // Parse the main request body with Glaze
-        auto main_json = parse_json(req.body);
-        std::string tool_name;
-        
-        if (main_json.contains("tool") && main_json["tool"].is_string()) {
-            tool_name = main_json["tool"].get_string();
-        }
-        
-        // For parameters, we need to extract the params object from the JSON
-        // This is a simplified approach - extract parameters from the main JSON
+        MCPLegacyCall call;
         std::string result;
-        
-        // Route to appropriate tool handler - pass the original body for param extraction
-        if (tool_name == "add_video_to_queue") {
-            result = handle_add_video_to_queue(req.body);
-        } else if (tool_name == "add_priority_video") {
-            result = handle_add_priority_video(req.body);
-        } else if (tool_name == "get_streaming_queue") {
-            result = handle_get_streaming_queue(req.body);
-        } else if (tool_name == "clear_streaming_queue") {
-            result = handle_clear_streaming_queue(req.body);
-        } else if (tool_name == "get_stream_status") {
-            result = handle_get_stream_status(req.body);
-        } else if (tool_name == "interrupt_current_stream") {
-            result = handle_interrupt_current_stream(req.body);
-        } else if (tool_name == "get_video_duration") {
-            result = handle_get_video_duration(req.body);
-        } else if (tool_name == "validate_video_source") {
-            result = handle_validate_video_source(req.body);
+        if (glz::read<MCP_READ_OPTS>(call, req.body)) {
+            result = create_error_response("Invalid JSON");
         } else {
-            result = create_error_response("Unknown tool: " + tool_name);
+            try {
+                auto tool_result = run_tool(call.tool, call.params.str);
+                result = tool_result ? std::move(*tool_result) : create_error_response("Unknown tool: " + call.tool);
+            } catch (const std::invalid_argument& e) {
+                result = create_error_response(e.what());
+            }
         }
         
         res.set_content(result, "application/json");
     });
 }
 
-std::string MCPServer::get_tools_schema() const {
-    std::ostringstream oss;
-    oss << "{\"tools\":[";
-    for (size_t i = 0; i < tools_.size(); ++i) {
-        oss << "{\"name\":\"" << tools_[i].name << "\",";
-        oss << "\"description\":\"" << tools_[i].description << "\",";
-        oss << "\"inputSchema\":" << tools_[i].input_schema << "}";
-        if (i < tools_.size() - 1) oss << ",";
+const std::string& MCPServer::get_tools_schema() const {
+    return tools_json_;
+}
+
+template <class Tool>
+std::string MCPServer::call_tool(const std::string& arguments, ToolTask& task) {
+    typename Tool::Args args{};
+    if (auto ec = glz::read<MCP_READ_OPTS>(args, arguments)) {
+        throw std::invalid_argument("Invalid arguments for " + std::string(Tool::name) + ": " +
+                                    glz::format_error(ec, arguments));
+    }
+    if constexpr (Tool::access == MCPToolAccess::Probe) {
+        return handle(args, task);
+    } else {
+        return handle(args);
+    }
+}
+
+std::optional<std::string> MCPServer::run_tool(std::string_view name, const std::string& arguments, ToolTask* task) {
+    auto it = tool_table_.find(name);
+    if (it == tool_table_.end()) {
+        return std::nullopt;
+    }
+    static const std::string no_arguments = "{}";
+    const auto& args = arguments.empty() ? no_arguments : arguments;
+    if (task) {
+        return (this->*it->second.call)(args, *task);
+    }
+    ToolTask inline_task(it->second.timeout);
+    return (this->*it->second.call)(args, inline_task);
+}
+
+void MCPServer::respond_async(const MCPRequest& request, const ToolEntry& tool, const httplib::Request& req,
+                              httplib::Response& res) {
+    const std::string& id = request.id.str;  // Empty for a notification
+    std::string progress_token = request.params._meta ? request.params._meta->progressToken.str : std::string();
+    auto task = std::make_shared<ToolTask>(tool.timeout, std::move(progress_token));
+
+    std::string key;
+    {
+        std::lock_guard<std::mutex> lock(running_mutex_);
+        key = id.empty() ? "#" + std::to_string(next_anonymous_task_++) : id;
+        running_[key] = task;
+    }
+    std::string id_json = id.empty() ? std::string("null") : id;
+    bool queued = executor_->submit([this, task, key, id_json, name = request.params.name,
+                                     arguments = request.params.arguments.str] {
+        if (!task->cancelled()) {
+            task->finish(tool_call_response(id_json, name, arguments, task.get()));
+        } else {
+            task->finish({});
+        }
+        forget_task(key, task);
+    });
+    if (!queued) {
+        forget_task(key, task);
+        res.status = 503;
+        res.set_content(create_mcp_error_response(id_json, -32000, "Server busy: too many probes in flight, retry later"),
+                        "application/json");
+        return;
+    }
+    if (id.empty()) {
+        res.status = 202;  // Notification: runs in the background, nothing to answer
+        return;
+    }
+
+    // Grace past the deadline: the worker normally answers first, with a timeout error
+    auto give_up = *task->deadline() + PROBE_GRACE;
+    auto inline_until = std::min(ToolTask::Clock::now() + PROBE_INLINE_WAIT, give_up);
+    std::vector<std::string> events;
+    std::string response;
+    auto state = ToolTask::Wait::Idle;
+    while ((state = task->wait(events, response, inline_until)) != ToolTask::Wait::Done &&
+           ToolTask::Clock::now() < inline_until) {
+    }
+
+    if (state != ToolTask::Wait::Done) {
+        // Still probing: release this worker and let the client fetch the response later
+        std::string call_id = pending_calls_.add(
+            task, give_up, [this, id_json](const ToolTask& done, std::string finished) {
+                return final_call_response(done, id_json, std::move(finished));
+            });
+        std::string status_url = "/mcp/calls?id=" + call_id;
+        res.set_header("Location", status_url);
+        res.set_header("Retry-After", "1");
+        res.status = 202;
+        res.set_content(write_json_response(MCPCallPendingResponse{
+                            .message = "Probe still running, fetch the response from status_url",
+                            .call_id = call_id, .status_url = status_url}),
+                        "application/json");
+        return;
+    }
+    if (accepts_event_stream(req)) {
+        std::string stream;
+        for (const auto& event : events) {
+            append_sse(stream, event);
+        }
+        append_sse(stream, final_call_response(*task, id_json, std::move(response)));
+        res.set_header("Cache-Control", "no-cache");
+        res.set_content(stream, "text/event-stream");
+        return;
+    }
+    res.set_content(final_call_response(*task, id_json, std::move(response)), "application/json");
+}
+
+std::string MCPServer::final_call_response(const ToolTask& task, std::string_view id_json, std::string response) {
+    if (task.cancelled()) {
+        return create_mcp_error_response(id_json, -32800, "Request cancelled");
+    }
+    if (response.empty()) {
+        return create_mcp_error_response(id_json, -32002, "Request timed out");
+    }
+    return response;
+}
+
+void MCPServer::respond_pending(const std::string& call_id, httplib::Response& res) {
+    std::string response;
+    switch (pending_calls_.poll(call_id, response)) {
+    case PendingCalls::State::Unknown:
+        res.status = 404;
+        res.set_content(create_error_response("No call with that id (or it expired)"), "application/json");
+        return;
+    case PendingCalls::State::Running: {
+        std::string status_url = "/mcp/calls?id=" + call_id;
+        res.set_header("Retry-After", "1");
+        res.status = 202;
+        res.set_content(write_json_response(MCPCallPendingResponse{
+                            .message = "Probe still running", .call_id = call_id, .status_url = status_url}),
+                        "application/json");
+        return;
+    }
+    case PendingCalls::State::Finished:
+        res.set_content(response, "application/json");
+        return;
+    }
+}
+
+void MCPServer::cancel_request(const std::string& id) {
+    std::lock_guard<std::mutex> lock(running_mutex_);
+    auto it = running_.find(id);
+    if (it != running_.end()) {
+        it->second->cancel();
+    }
+}
+
+void MCPServer::forget_task(const std::string& key, const std::shared_ptr<ToolTask>& task) {
+    std::lock_guard<std::mutex> lock(running_mutex_);
+    auto it = running_.find(key);
+    if (it != running_.end() && it->second == task) {
+        running_.erase(it);
     }
-    oss << "]}";
-    return oss.str();
 }
 
 // Tool implementations using existing functionality
-std::string MCPServer::handle_add_video_to_queue(const std::string& full_request) {
-    auto parsed = extract_mcp_params(full_request);
-    auto source = parsed["source"];
-    auto position = parsed["position"];
+std::string MCPServer::handle(const AddVideoToQueueTool::Args& args) {
+    const auto& source = args.source;
+    auto submitter = submitter_or_default(args.submitter);
     
     if (source.empty()) {
         return create_error_response("Missing required parameter: source");
     }
+    if (submitter.size() > MAX_SUBMITTER_LENGTH) {
+        return create_error_response("Submitter name too long");
+    }
     
+    // "Play next" lane: FIFO among other play-next items, never cuts the stream
+    auto priority = args.position == "front" ? PriorityClass::Next : PriorityClass::Normal;
+    if (auto* validation = http_server_.validation_jobs()) {
+        std::string error;
+        if (!validate_media_source(source, error)) {
+            return create_error_response(error);
+        }
+        auto id = validation->submit({source, priority, submitter});
+        if (!id) {
+            return create_error_response("Too many videos waiting for validation, retry later");
+        }
+        auto job = validation->find(*id);
+        if (!job) {
+            return create_success_response("Video accepted for validation: " + *id);
+        }
+        return create_success_response(validation_job_view(*job));
+    }
+
     try {
-        if (position == "front") {
-            http_server_.media_queue_.push_front(source);
+        bool accepted = false;
+        if (priority == PriorityClass::Next) {
+            accepted = http_server_.media_queue_.enqueue(source, PriorityClass::Next, submitter).has_value();
         } else {
-            http_server_.media_queue_.push(source);
+            accepted = http_server_.media_queue_.push(source, submitter);
+        }
+        if (!accepted) {
+            return create_error_response("Queue quota exceeded for submitter " + submitter);
         }
-        return create_success_response("\"Video added to queue: " + source + "\"");
+        return create_success_response("Video added to queue: " + source);
     } catch (const std::exception& e) {
         return create_error_response("Failed to add video: " + std::string(e.what()));
     }
 }
 
-std::string MCPServer::handle_add_priority_video(const std::string& full_request) {
-    auto parsed = extract_mcp_params(full_request);
-    auto source = parsed["source"];
-    auto reason = parsed["reason"];
+std::string MCPServer::handle(const AddPriorityVideoTool::Args& args) {
+    const auto& source = args.source;
+    auto submitter = submitter_or_default(args.submitter);
     
     if (source.empty()) {
         return create_error_response("Missing required parameter: source");
     }
+    if (submitter.size() > MAX_SUBMITTER_LENGTH) {
+        return create_error_response("Submitter name too long");
+    }
+
+    auto priority = PriorityClass::Interrupt;
+    if (!args.priority.empty()) {
+        auto requested = parse_priority_class(args.priority);
+        if (!requested || *requested == PriorityClass::Normal) {
+            return create_error_response("Invalid priority, expected next, interrupt or breaking");
+        }
+        priority = *requested;
+    }
     
     try {
-        // Add to front of queue
-        http_server_.media_queue_.push_front(source);
-        
-        // Interrupt current stream
-        g_stream_process->request_termination();
-        g_stream_process->kill_current_process();
+        // Queue in the class lane and cut the current stream if its policy says so
+        auto policy = http_server_.media_queue_.enqueue(source, priority, submitter);
+        if (!policy) {
+            return create_error_response("Queue quota exceeded for submitter " + submitter);
+        }
+        bool interrupted = g_stream_process->preempt(priority, *policy);
         
-        std::string msg = "\"Priority video added and current stream interrupted: " + source;
-        if (!reason.empty()) {
-            msg += " (Reason: " + reason + ")";
+        std::string msg = interrupted ? "Priority video added and current stream interrupted: " + source
+                                      : "Priority video queued to play next: " + source;
+        msg += " [" + std::string(priority_class_name(priority)) + ", " + interrupt_policy_name(*policy) + "]";
+        if (!args.reason.empty()) {
+            msg += " (Reason: " + args.reason + ")";
         }
-        msg += "\"";
         return create_success_response(msg);
     } catch (const std::exception& e) {
         return create_error_response("Failed to add priority video: " + std::string(e.what()));
     }
 }
 
-std::string MCPServer::handle_get_streaming_queue(const std::string&) {
+std::string MCPServer::handle(const GetStreamingQueueTool::Args&) {
     try {
-        auto items = http_server_.media_queue_.get_all_items();
-        std::ostringstream oss;
-        oss << "{\"queue\":[";
-        for (size_t i = 0; i < items.size(); ++i) {
-            oss << "\"" << items[i] << "\"";
-            if (i < items.size() - 1) oss << ",";
-        }
-        oss << "],\"size\":" << items.size();
-        oss << ",\"is_streaming\":" << (!g_stream_process->should_terminate() ? "true" : "false");
-        oss << "}";
-        return create_success_response(oss.str());
+        auto snapshot = http_server_.media_queue_.snapshot();
+        auto page = queue_page(*snapshot, 0, snapshot->items.size());
+        return create_success_response(QueueListingResult{std::move(page.queue), page.size, page.version,
+                                                          !g_stream_process->should_terminate()});
     } catch (const std::exception& e) {
         return create_error_response("Failed to get queue: " + std::string(e.what()));
     }
 }
 
-std::string MCPServer::handle_clear_streaming_queue(const std::string&) {
+std::string MCPServer::handle(const ClearStreamingQueueTool::Args&) {
     try {
         http_server_.media_queue_.clear();
-        return create_success_response("\"Queue cleared successfully\"");
+        return create_success_response("Queue cleared successfully");
     } catch (const std::exception& e) {
         return create_error_response("Failed to clear queue: " + std::string(e.what()));
     }
 }
 
-std::string MCPServer::handle_get_stream_status(const std::string&) {
+std::string MCPServer::handle(const GetStreamStatusTool::Args&) {
     try {
-        auto items = http_server_.media_queue_.get_all_items();
-        bool is_streaming = !g_stream_process->should_terminate();
-        
-        std::ostringstream oss;
-        oss << "{\"is_streaming\":" << (is_streaming ? "true" : "false");
-        oss << ",\"queue_size\":" << items.size();
-        oss << ",\"fallback_video\":\"videos/News_Intro.mp4\"";
-        oss << ",\"server_status\":\"running\"";
-        oss << "}";
-        return create_success_response(oss.str());
+        auto snapshot = http_server_.media_queue_.snapshot();
+        const auto& counts = snapshot->class_counts;
+        StreamStatusResult status{
+            .is_streaming = !g_stream_process->should_terminate(),
+            .queue_size = snapshot->items.size(),
+            .queue_version = snapshot->version,
+            .on_air_priority = priority_class_name(g_stream_process->on_air_priority()),
+            .queue_by_class = {counts[0], counts[1], counts[2], counts[3]},
+            .submitters = submitter_status_views(*snapshot),
+            .rotation_mode = rotation_mode_name(snapshot->rotation_mode),
+            .fallback_video = "videos/News_Intro.mp4",
+        };
+        if (snapshot->now_playing) {
+            status.now_playing = snapshot->now_playing->source;
+        }
+        if (const auto* next = snapshot->up_next()) {
+            status.up_next = next->source;
+        }
+        return create_success_response(status);
     } catch (const std::exception& e) {
         return create_error_response("Failed to get status: " + std::string(e.what()));
     }
 }
 
-std::string MCPServer::handle_interrupt_current_stream(const std::string& full_request) {
-    auto parsed = extract_mcp_params(full_request);
-    auto reason = parsed["reason"];
-    
+std::string MCPServer::handle(const InterruptCurrentStreamTool::Args& args) {
     try {
-        g_stream_process->request_termination();
-        g_stream_process->kill_current_process();
-        
-        std::string msg = "\"Current stream interrupted";
-        if (!reason.empty()) {
-            msg += " (Reason: " + reason + ")";
+        if (!g_stream_process->interrupt()) {
+            return create_error_response("Interrupt cooldown running: the stream was cut less than " +
+                                         std::to_string(g_stream_process->interrupt_cooldown().count()) +
+                                         " ms ago, retry later");
+        }
+
+        std::string msg = "Current stream interrupted";
+        if (!args.reason.empty()) {
+            msg += " (Reason: " + args.reason + ")";
         }
-        msg += "\"";
         return create_success_response(msg);
     } catch (const std::exception& e) {
         return create_error_response("Failed to interrupt stream: " + std::string(e.what()));
     }
 }
 
-std::string MCPServer::handle_get_video_duration(const std::string& full_request) {
-    auto parsed = extract_mcp_params(full_request);
-    auto source = parsed["source"];
+std::string MCPServer::handle(const GetVideoDurationTool::Args& args, ToolTask& task) {
+    const auto& source = args.source;
     
     if (source.empty()) {
         return create_error_response("Missing required parameter: source");
     }
     
     try {
+        task.progress(0, 1, "Probing " + source);
         double duration;
         if (is_youtube_url(source)) {
-            duration = get_youtube_duration(source);
+            duration = get_youtube_duration(source, task.exec_limits());
         } else {
-            duration = get_media_duration(source);
+            duration = get_media_duration(source, task.exec_limits());
         }
+        task.progress(1, 1, "Probe finished");
         
-        std::ostringstream oss;
-        oss << "{\"duration\":" << duration << ",\"source\":\"" << source << "\"}";
-        return create_success_response(oss.str());
+        return create_success_response(DurationResult{duration, source});
     } catch (const std::exception& e) {
         return create_error_response("Failed to get duration: " + std::string(e.what()));
     }
 }
 
-std::string MCPServer::handle_validate_video_source(const std::string& full_request) {
-    auto parsed = extract_mcp_params(full_request);
-    auto source = parsed["source"];
+std::string MCPServer::handle(const ValidateVideoSourceTool::Args& args, ToolTask& task) {
+    const auto& source = args.source;
     
     if (source.empty()) {
         return create_error_response("Missing required parameter: source");
     }
     
     try {
+        task.progress(0, 1, "Probing " + source);
         bool is_valid = false;
         std::string source_type;
         
         if (is_youtube_url(source)) {
             source_type = "youtube";
             // Try to get duration as validation
-            double duration = get_youtube_duration(source);
+            double duration = get_youtube_duration(source, task.exec_limits());
             is_valid = (duration > 0);
         } else {
             source_type = "local_file";
             // Try to get duration as validation  
-            double duration = get_media_duration(source);
+            double duration = get_media_duration(source, task.exec_limits());
             is_valid = (duration > 0);
         }
+        task.progress(1, 1, "Probe finished");
         
-        std::ostringstream oss;
-        oss << "{\"is_valid\":" << (is_valid ? "true" : "false");
-        oss << ",\"source_type\":\"" << source_type << "\"";
-        oss << ",\"source\":\"" << source << "\"}";
-        return create_success_response(oss.str());
+        return create_success_response(SourceValidationResult{is_valid, source_type, source});
     } catch (const std::exception& e) {
         return create_error_response("Failed to validate source: " + std::string(e.what()));
     }
 }
 
+std::string MCPServer::handle(const ImportPlaylistTool::Args& args) {
+    const auto& playlist = args.playlist;
+
+    if (playlist.empty()) {
+        return create_error_response("Missing required parameter: playlist");
+    }
+
+    PlaylistImportOptions options;
+    options.submitter = submitter_or_default(args.submitter);
+    if (options.submitter.size() > MAX_SUBMITTER_LENGTH) {
+        return create_error_response("Submitter name too long");
+    }
+    if (!args.format.empty()) {
+        auto format = parse_playlist_format(args.format);
+        if (!format) {
+            return create_error_response("Invalid format, expected auto, json, m3u or youtube");
+        }
+        options.format = *format;
+    }
+    options.probe = args.probe;
+
+    try {
+        auto result = import_playlist(http_server_.media_queue_, playlist, options);
+        if (!result.ok) {
+            return create_error_response("Failed to import playlist: " + result.error);
+        }
+
+        return create_success_response(import_response(result));
+    } catch (const std::exception& e) {
+        return create_error_response("Failed to import playlist: " + std::string(e.what()));
+    }
+}
+
+std::string MCPServer::handle(const ScheduleVideoTool::Args& args) {
+    if (!http_server_.event_scheduler_) {
+        return create_error_response("Scheduling is not available");
+    }
+
+    ScheduledEvent event;
+    event.item.source = args.source;
+    event.item.submitter = submitter_or_default(args.submitter);
+    event.title = args.title;
+    if (event.item.source.empty()) {
+        return create_error_response("Missing required parameter: source");
+    }
+    if (event.item.submitter.size() > MAX_SUBMITTER_LENGTH) {
+        return create_error_response("Submitter name too long");
+    }
+    auto start = parse_schedule_time(args.at);
+    if (!start) {
+        return create_error_response("at must be unix seconds or YYYY-MM-DDTHH:MM:SSZ");
+    }
+    event.start = *start;
+    if (!args.join.empty()) {
+        auto join = parse_join_policy(args.join);
+        if (!join) {
+            return create_error_response("join must be hard_cut, wait or trim_filler");
+        }
+        event.join = *join;
+    }
+    if (args.every) {
+        event.repeat = std::chrono::seconds(*args.every);
+        if (event.repeat < std::chrono::seconds(60)) {
+            return create_error_response("every must be at least 60 seconds");
+        }
+    }
+
+    std::string validation_error;
+    if (!validate_media_source(event.item.source, validation_error)) {
+        return create_error_response(validation_error);
+    }
+    auto id = http_server_.schedule_event(event);
+    return create_success_response(
+        ScheduledResponse{std::nullopt, id, format_schedule_time(event.start), join_policy_name(event.join)});
+}
+
+std::string MCPServer::handle(const GetScheduleTool::Args&) {
+    if (!http_server_.event_scheduler_) {
+        return create_error_response("Scheduling is not available");
+    }
+    auto epg = http_server_.event_scheduler_->epg_json(std::chrono::system_clock::now());
+    return create_success_response(glz::raw_json_view{epg});
+}
+
 // MCP JSON-RPC 2.0 protocol implementations
-std::string MCPServer::handle_mcp_initialize(const std::string& id) {
-    return R"({"jsonrpc":"2.0","id":")" + id + R"(","result":{"protocolVersion":"2024-11-05","capabilities":{"tools":{},"resources":{},"prompts":{},"logging":{}},"serverInfo":{"name":"mychannel","version":"1.0.0"}}})";
+std::string MCPServer::handle_mcp_initialize(std::string_view id) {
+    return write_json_response(RpcResponse<InitializeResult>{.id = {id}});
 }
 
-std::string MCPServer::handle_mcp_tools_list(const std::string& id) {
-    std::ostringstream oss;
-    oss << R"({"jsonrpc":"2.0","id":")" << id << R"(","result":{"tools":[)";
-    
-    for (size_t i = 0; i < tools_.size(); ++i) {
-        oss << R"({"name":")" << tools_[i].name << R"(",)";
-        oss << R"("description":")" << tools_[i].description << R"(",)";
-        oss << R"("inputSchema":)" << tools_[i].input_schema << "}";
-        if (i < tools_.size() - 1) oss << ",";
+std::string MCPServer::handle_mcp_tools_list(std::string_view id) {
+    return write_json_response(RpcResponse<glz::raw_json_view>{.id = {id}, .result = {tools_json_}});
+}
+
+std::optional<std::string> MCPServer::handle_jsonrpc(const std::string& body, bool authenticated) {
+    if (is_batch(body)) {
+        return handle_rpc_batch(body, authenticated);
     }
-    
-    oss << "]}}";
-    return oss.str();
+    // Parse the JSON-RPC envelope once; tool arguments stay raw until dispatch
+    MCPRequest request;
+    if (glz::read<MCP_READ_OPTS>(request, body)) {
+        return create_mcp_error_response("null", -32700, "Parse error");
+    }
+    return handle_rpc_request(request, authenticated);
 }
 
-std::string MCPServer::handle_mcp_tool_call(const std::string& id, const glz::json_t& request) {
-    try {
-        // Extract tool name and arguments from MCP request
-        std::string tool_name;
-        std::string params_json;
-        
-        // Navigate to params.name
-        if (request.contains("params") && request["params"].is_object()) {
-            const auto& params = request["params"].get_object();
-            
-            if (params.contains("name") && params.at("name").is_string()) {
-                tool_name = params.at("name").get_string();
+std::optional<std::string> MCPServer::handle_rpc_request(const MCPRequest& request, bool authenticated) {
+    bool notification = request.id.str.empty();
+    std::string_view id = notification ? std::string_view("null") : std::string_view(request.id.str);
+
+    if (request.method == "notifications/cancelled") {
+        if (authenticated) {
+            cancel_request(request.params.requestId.str);
+        }
+        return std::nullopt;
+    }
+    if (request.method == "tools/call") {
+        // A tool called as a notification still runs; only its response is dropped
+        auto response = authenticated ? tool_call_response(id, request.params.name, request.params.arguments.str)
+                                      : create_mcp_error_response(id, -32001, "Authentication required");
+        if (notification) {
+            return std::nullopt;
+        }
+        return response;
+    }
+    if (notification) {
+        return std::nullopt;  // notifications/initialized and the like; nothing else has side effects
+    }
+    if (request.method == "initialize") {
+        return handle_mcp_initialize(id);
+    }
+    if (request.method == "tools/list") {
+        return handle_mcp_tools_list(id);
+    }
+    return create_mcp_error_response(id, -32601, "Method not found");
+}
+
+MCPToolAccess MCPServer::access_of(const MCPRequest& request) const {
+    if (request.method != "tools/call") {
+        return MCPToolAccess::Read;
+    }
+    auto it = tool_table_.find(request.params.name);
+    return it == tool_table_.end() ? MCPToolAccess::Read : it->second.access;  // Unknown tools only produce an error
+}
+
+std::optional<std::string> MCPServer::handle_rpc_batch(const std::string& body, bool authenticated) {
+    // Common case: every member is a well-formed request, read in one pass
+    std::vector<MCPRequest> requests;
+    std::vector<std::optional<std::string>> responses;
+    std::vector<char> valid;
+    if (!glz::read<MCP_READ_OPTS>(requests, body)) {
+        valid.assign(requests.size(), 1);
+    } else {
+        // Otherwise take the members apart so each bad one gets its own error
+        std::vector<glz::raw_json> members;
+        if (glz::read<MCP_READ_OPTS>(members, body)) {
+            return create_mcp_error_response("null", -32700, "Parse error");
+        }
+        requests.assign(members.size(), {});
+        valid.assign(members.size(), 0);
+        for (size_t i = 0; i < members.size(); ++i) {
+            valid[i] = !glz::read<MCP_READ_OPTS>(requests[i], members[i].str);
+        }
+    }
+    size_t count = requests.size();
+    if (count == 0) {
+        return create_mcp_error_response("null", -32600, "Invalid Request: empty batch");
+    }
+    if (count > MAX_BATCH_SIZE) {
+        return create_mcp_error_response(
+            "null", -32600, "Invalid Request: batch larger than " + std::to_string(MAX_BATCH_SIZE));
+    }
+    responses.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (!valid[i]) {
+            responses[i] = create_mcp_error_response("null", -32600, "Invalid Request");
+        }
+    }
+
+    // Members run in batch order. Writes act as barriers: a read sees every write before it
+    // and none after it, and writes never reorder. A run of consecutive non-writes is spread
+    // over a bounded pool when it has at least two probes; cheap reads are not worth a thread.
+    for (size_t begin = 0; begin < count;) {
+        if (!valid[begin]) {
+            ++begin;
+            continue;
+        }
+        if (access_of(requests[begin]) == MCPToolAccess::Write) {
+            responses[begin] = handle_rpc_request(requests[begin], authenticated);
+            ++begin;
+            continue;
+        }
+        size_t end = begin;
+        size_t probes = 0;
+        for (; end < count; ++end) {
+            if (!valid[end]) {
+                continue;
             }
-            
-            if (params.contains("arguments") && params.at("arguments").is_object()) {
-                // Convert arguments object back to JSON string for tool handlers
-                auto arguments_dump = params.at("arguments").dump();
-                if (arguments_dump) {
-                    params_json = *arguments_dump;
+            auto access = access_of(requests[end]);
+            if (access == MCPToolAccess::Write) {
+                break;
+            }
+            probes += access == MCPToolAccess::Probe;
+        }
+
+        std::atomic<size_t> next{begin};
+        auto worker = [&]() {
+            for (size_t i = next.fetch_add(1); i < end; i = next.fetch_add(1)) {
+                if (valid[i]) {
+                    responses[i] = handle_rpc_request(requests[i], authenticated);
                 }
             }
+        };
+        size_t workers = probes >= 2 ? std::min(BATCH_PARALLELISM, end - begin) : 1;
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (size_t i = 1; i < workers; ++i) {
+            threads.emplace_back(worker);
         }
-        
-        if (tool_name.empty()) {
-            return create_mcp_error_response(id, -32602, "Invalid params: missing tool name");
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
         }
-        
-        std::string result;
-        
-        // Route to appropriate tool handler
-        if (tool_name == "add_video_to_queue") {
-            result = handle_add_video_to_queue(params_json);
-        } else if (tool_name == "add_priority_video") {
-            result = handle_add_priority_video(params_json);
-        } else if (tool_name == "get_streaming_queue") {
-            result = handle_get_streaming_queue(params_json);
-        } else if (tool_name == "clear_streaming_queue") {
-            result = handle_clear_streaming_queue(params_json);
-        } else if (tool_name == "get_stream_status") {
-            result = handle_get_stream_status(params_json);
-        } else if (tool_name == "interrupt_current_stream") {
-            result = handle_interrupt_current_stream(params_json);
-        } else if (tool_name == "get_video_duration") {
-            result = handle_get_video_duration(params_json);
-        } else if (tool_name == "validate_video_source") {
-            result = handle_validate_video_source(params_json);
-        } else {
-            return create_mcp_error_response(id, -32601, "Tool not found: " + tool_name);
+        begin = end;
+    }
+
+    // Responses in request order; notifications leave no entry
+    std::vector<glz::raw_json_view> out;
+    out.reserve(count);
+    for (const auto& response : responses) {
+        if (response) {
+            out.push_back({*response});
         }
-        
-        return R"({"jsonrpc":"2.0","id":")" + id + R"(","result":{"content":[{"type":"text","text":)" + result + "}]}}";
+    }
+    if (out.empty()) {
+        return std::nullopt;
+    }
+    return write_json_response(out);
+}
+
+std::string MCPServer::handle_mcp_tool_call(const std::string& id, const glz::json_t& request) {
+    // Generic-value entry point kept for callers that already hold a parsed document; the
+    // JSON-RPC route reads the envelope directly and skips this re-serialization
+    std::string tool_name;
+    std::string arguments;
+    if (request.contains("params") && request["params"].is_object()) {
+        const auto& params = request["params"].get_object();
+        if (params.contains("name") && params.at("name").is_string()) {
+            tool_name = params.at("name").get_string();
+        }
+        if (params.contains("arguments") && params.at("arguments").is_object()) {
+            auto arguments_dump = params.at("arguments").dump();
+            if (arguments_dump) {
+                arguments = *arguments_dump;
+            }
+        }
+    }
+    std::string id_json;
+    (void)glz::write_json(id, id_json);
+    return tool_call_response(id_json, tool_name, arguments);
+}
+
+std::string MCPServer::tool_call_response(std::string_view id, std::string_view name, const std::string& arguments,
+                                          ToolTask* task) {
+    if (name.empty()) {
+        return create_mcp_error_response(id, -32602, "Invalid params: missing tool name");
+    }
+    try {
+        auto result = run_tool(name, arguments, task);
+        if (!result) {
+            return create_mcp_error_response(id, -32601, "Tool not found: " + std::string(name));
+        }
+        ToolCallResult call{{ToolContentView{.text = {*result}}}};
+        return write_json_response(RpcResponse<ToolCallResult>{.id = {id}, .result = std::move(call)});
+    } catch (const std::invalid_argument& e) {
+        return create_mcp_error_response(id, -32602, e.what());
     } catch (const std::exception& e) {
         return create_mcp_error_response(id, -32602, "Invalid params: " + std::string(e.what()));
     }
 }
 
-std::string MCPServer::create_mcp_error_response(const std::string& id, int code, const std::string& message) {
-    return R"({"jsonrpc":"2.0","id":")" + id + R"(","error":{"code":)" + std::to_string(code) + R"(,"message":")" + message + R"("}})";
+std::string MCPServer::create_mcp_error_response(std::string_view id, int code, std::string_view message) {
+    return write_json_response(RpcErrorResponse{.id = {id}, .error = {code, message}});
 }
 
 // Helper methods
 std::string MCPServer::create_error_response(const std::string& error_msg) {
-    return "{\"status\":\"error\",\"message\":\"" + error_msg + "\"}";
-}
-
-std::string MCPServer::create_success_response(const std::string& result) {
-    return "{\"status\":\"success\",\"result\":" + result + "}";
+    return write_json_response(ErrorResponse{.message = error_msg});
 }
 
 glz::json_t MCPServer::parse_json(const std::string& json) {
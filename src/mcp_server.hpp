@@ -1,8 +1,17 @@
 #pragma once
 #include "http_server.hpp"
+#include "json_response.hpp"
+#include "mcp_tools.hpp"
+#include "tool_executor.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <optional>
+#include <unordered_map>
 #include <glaze/glaze.hpp>
 
 // MCP Tool definition structure
@@ -17,34 +26,93 @@ class MCPServer {
 private:
     HttpServer& http_server_;
     std::vector<MCPTool> tools_;
-    
-    // Tool implementations
-    std::string handle_add_video_to_queue(const std::string& params);
-    std::string handle_add_priority_video(const std::string& params);
-    std::string handle_get_streaming_queue(const std::string& params);
-    std::string handle_clear_streaming_queue(const std::string& params);
-    std::string handle_get_stream_status(const std::string& params);
-    std::string handle_interrupt_current_stream(const std::string& params);
-    std::string handle_get_video_duration(const std::string& params);
-    std::string handle_validate_video_source(const std::string& params);
+    // tools/list and /mcp/tools payload, serialized once at startup
+    std::string tools_json_;
+
+    // Name -> thunk that reads the typed arguments and runs the handler
+    using ToolThunk = std::string (MCPServer::*)(const std::string& arguments, ToolTask& task);
+    struct ToolEntry {
+        ToolThunk call;
+        MCPToolAccess access;
+        std::optional<std::chrono::seconds> timeout;  // Probes only
+    };
+    std::unordered_map<std::string_view, ToolEntry> tool_table_;
+
+    // Probe calls in flight, by raw request id ("#<n>" for notifications), for
+    // notifications/cancelled and shutdown
+    std::mutex running_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<ToolTask>> running_;
+    uint64_t next_anonymous_task_ = 0;
+    // Probe calls answered with 202 and a status URL (GET /mcp/calls?id=)
+    PendingCalls pending_calls_;
+    // Declared last so it is joined first, while everything its jobs use is still alive
+    std::unique_ptr<ToolExecutor> executor_;
+
+    template <class Tool>
+    std::string call_tool(const std::string& arguments, ToolTask& task);
+    // Runs a registered tool; nullopt when the name is unknown, throws std::invalid_argument
+    // when the arguments do not match the tool's argument struct. Without a task, one is made
+    // here so the tool's timeout still applies.
+    std::optional<std::string> run_tool(std::string_view name, const std::string& arguments, ToolTask* task = nullptr);
+    std::string tool_call_response(std::string_view id, std::string_view name, const std::string& arguments,
+                                   ToolTask* task = nullptr);
+    // tools/call of a Probe tool from POST /: queue it on the executor and wait briefly. A
+    // probe that finishes in time is answered as SSE (progress, then the response) or plain
+    // JSON; a slower one gets 202 and a status URL, so no HTTP worker waits out the probe.
+    void respond_async(const MCPRequest& request, const ToolEntry& tool, const httplib::Request& req,
+                       httplib::Response& res);
+    std::string final_call_response(const ToolTask& task, std::string_view id_json, std::string response);
+    void respond_pending(const std::string& call_id, httplib::Response& res);
+    void cancel_request(const std::string& id);
+    void forget_task(const std::string& key, const std::shared_ptr<ToolTask>& task);
+    // One JSON-RPC request; nullopt for notifications, which get no response
+    std::optional<std::string> handle_rpc_request(const MCPRequest& request, bool authenticated);
+    std::optional<std::string> handle_rpc_batch(const std::string& body, bool authenticated);
+    // Write for tool calls that change state, Read for everything else that is not a Probe
+    MCPToolAccess access_of(const MCPRequest& request) const;
+
+    // Tool implementations, one per MCPTools entry
+    std::string handle(const AddVideoToQueueTool::Args& args);
+    std::string handle(const AddPriorityVideoTool::Args& args);
+    std::string handle(const GetStreamingQueueTool::Args& args);
+    std::string handle(const ClearStreamingQueueTool::Args& args);
+    std::string handle(const GetStreamStatusTool::Args& args);
+    std::string handle(const InterruptCurrentStreamTool::Args& args);
+    std::string handle(const GetVideoDurationTool::Args& args, ToolTask& task);
+    std::string handle(const ValidateVideoSourceTool::Args& args, ToolTask& task);
+    std::string handle(const ImportPlaylistTool::Args& args);
+    std::string handle(const ScheduleVideoTool::Args& args);
+    std::string handle(const GetScheduleTool::Args& args);
     
     // Helper methods
     std::string create_error_response(const std::string& error_msg);
-    std::string create_success_response(const std::string& result);
+    // {"status":"success","result":<result>} serialized with glaze; strings become JSON strings
+    template <class T>
+        requires(!std::is_convertible_v<const T&, std::string_view>)
+    std::string create_success_response(const T& result) {
+        return write_json_response(ToolResult<T>{.result = result});
+    }
+    std::string create_success_response(std::string_view message) {
+        return write_json_response(ToolResult<std::string_view>{.result = message});
+    }
     
-    // MCP JSON-RPC 2.0 protocol methods
-    std::string handle_mcp_initialize(const std::string& id);
-    std::string handle_mcp_tools_list(const std::string& id);
-    std::string create_mcp_error_response(const std::string& id, int code, const std::string& message);
+    // MCP JSON-RPC 2.0 protocol methods; ids are raw JSON
+    std::string handle_mcp_initialize(std::string_view id);
+    std::string handle_mcp_tools_list(std::string_view id);
+    std::string create_mcp_error_response(std::string_view id, int code, std::string_view message);
 
 public:
     explicit MCPServer(HttpServer& server);
+    ~MCPServer();  // Cancels probes in flight
     void setup_mcp_routes();
     std::vector<MCPTool> get_available_tools() const;
-    std::string get_tools_schema() const;
+    const std::string& get_tools_schema() const;
+    // Body of a POST / request: a single JSON-RPC 2.0 request or a batch array. Returns
+    // nullopt when there is nothing to send back (only notifications).
+    std::optional<std::string> handle_jsonrpc(const std::string& body, bool authenticated);
     
     // Public methods for testing
     glz::json_t parse_json(const std::string& json);
     std::map<std::string, std::string> extract_mcp_params(const std::string& json);
-    std::string handle_mcp_tool_call(const std::string& id, const glz::json_t& request);
+    std::string handle_mcp_tool_call(const std::string& id, const glz::json_t& request);  // id is echoed as a string
 };
@@ -0,0 +1,183 @@
+#pragma once
+#include <glaze/glaze.hpp>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+// Compile-time MCP tool registry. Each tool declares its name, description, JSON schema
+// and a typed argument struct; arguments are read by glaze straight into that struct, so
+// a call costs one parse. Empty strings mean "not given", as the handlers expect.
+// MCPServer implements handle() for every entry of MCPTools.
+
+// Unknown argument keys are ignored so older clients that send extras keep working
+inline constexpr glz::opts MCP_READ_OPTS{.error_on_unknown_keys = false};
+
+// What a tool touches, for running JSON-RPC batch members side by side
+enum class MCPToolAccess {
+    Write,  // Changes queue, schedule or stream state; runs alone, in batch order
+    Read,   // Reads published state only
+    Probe,  // Read-only but runs ffprobe/yt-dlp: runs on the tool executor under a timeout
+};
+
+struct AddVideoToQueueTool {
+    static constexpr std::string_view name = "add_video_to_queue";
+    static constexpr MCPToolAccess access = MCPToolAccess::Write;
+    static constexpr std::string_view description =
+        "Add a video (YouTube URL or local file path) to the streaming queue. Unless validation is disabled "
+        "the video is probed first and queued once found playable; the result is the validation job";
+    static constexpr std::string_view input_schema =
+        R"({"type":"object","properties":{"source":{"type":"string"},"position":{"type":"string"},"submitter":{"type":"string"}},"required":["source"]})";
+    struct Args {
+        std::string source;
+        std::string position;
+        std::string submitter;
+    };
+};
+
+struct AddPriorityVideoTool {
+    static constexpr std::string_view name = "add_priority_video";
+    static constexpr MCPToolAccess access = MCPToolAccess::Write;
+    static constexpr std::string_view description =
+        "Add high-priority video; priority is next, interrupt (default) or breaking and decides whether the current stream is cut";
+    static constexpr std::string_view input_schema =
+        R"({"type":"object","properties":{"source":{"type":"string"},"reason":{"type":"string"},"priority":{"type":"string","enum":["next","interrupt","breaking"]},"submitter":{"type":"string"}},"required":["source"]})";
+    struct Args {
+        std::string source;
+        std::string reason;
+        std::string priority;
+        std::string submitter;
+    };
+};
+
+struct GetStreamingQueueTool {
+    static constexpr std::string_view name = "get_streaming_queue";
+    static constexpr MCPToolAccess access = MCPToolAccess::Read;
+    static constexpr std::string_view description = "Get current streaming queue status and contents";
+    static constexpr std::string_view input_schema = R"({"type":"object","properties":{}})";
+    struct Args {};
+};
+
+struct ClearStreamingQueueTool {
+    static constexpr std::string_view name = "clear_streaming_queue";
+    static constexpr MCPToolAccess access = MCPToolAccess::Write;
+    static constexpr std::string_view description = "Clear the entire streaming queue";
+    static constexpr std::string_view input_schema = R"({"type":"object","properties":{}})";
+    struct Args {};
+};
+
+struct GetStreamStatusTool {
+    static constexpr std::string_view name = "get_stream_status";
+    static constexpr MCPToolAccess access = MCPToolAccess::Read;
+    static constexpr std::string_view description = "Get current streaming status and progress information";
+    static constexpr std::string_view input_schema = R"({"type":"object","properties":{}})";
+    struct Args {};
+};
+
+struct InterruptCurrentStreamTool {
+    static constexpr std::string_view name = "interrupt_current_stream";
+    static constexpr MCPToolAccess access = MCPToolAccess::Write;
+    static constexpr std::string_view description = "Immediately interrupt the current stream";
+    static constexpr std::string_view input_schema =
+        R"({"type":"object","properties":{"reason":{"type":"string"}},"required":[]})";
+    struct Args {
+        std::string reason;
+    };
+};
+
+struct GetVideoDurationTool {
+    static constexpr std::string_view name = "get_video_duration";
+    static constexpr MCPToolAccess access = MCPToolAccess::Probe;
+    static constexpr std::chrono::seconds timeout{30};  // yt-dlp on a cold cache is slow
+    static constexpr std::string_view description = "Get duration of a video file or YouTube URL";
+    static constexpr std::string_view input_schema =
+        R"({"type":"object","properties":{"source":{"type":"string"}},"required":["source"]})";
+    struct Args {
+        std::string source;
+    };
+};
+
+struct ValidateVideoSourceTool {
+    static constexpr std::string_view name = "validate_video_source";
+    static constexpr MCPToolAccess access = MCPToolAccess::Probe;
+    static constexpr std::chrono::seconds timeout{30};
+    static constexpr std::string_view description = "Check if video source is accessible and valid";
+    static constexpr std::string_view input_schema =
+        R"({"type":"object","properties":{"source":{"type":"string"}},"required":["source"]})";
+    struct Args {
+        std::string source;
+    };
+};
+
+struct ImportPlaylistTool {
+    static constexpr std::string_view name = "import_playlist";
+    static constexpr MCPToolAccess access = MCPToolAccess::Write;
+    static constexpr std::string_view description =
+        "Bulk add a playlist (JSON array of sources, M3U/M3U8 text, or YouTube playlist URL) in one queue commit, with per-item results";
+    static constexpr std::string_view input_schema =
+        R"({"type":"object","properties":{"playlist":{"type":"string"},"format":{"type":"string","enum":["auto","json","m3u","youtube"]},"probe":{"type":"boolean"},"submitter":{"type":"string"}},"required":["playlist"]})";
+    struct Args {
+        std::string playlist;
+        std::string format;
+        bool probe = false;
+        std::string submitter;
+    };
+};
+
+struct ScheduleVideoTool {
+    static constexpr std::string_view name = "schedule_video";
+    static constexpr MCPToolAccess access = MCPToolAccess::Write;
+    static constexpr std::string_view description =
+        "Start a video at a wall-clock time (unix seconds or YYYY-MM-DDTHH:MM:SSZ); join decides what happens to the item on air";
+    static constexpr std::string_view input_schema =
+        R"({"type":"object","properties":{"source":{"type":"string"},"at":{"type":"string"},"join":{"type":"string","enum":["hard_cut","wait","trim_filler"]},"title":{"type":"string"},"every":{"type":"integer","minimum":60},"submitter":{"type":"string"}},"required":["source","at"]})";
+    struct Args {
+        std::string source;
+        std::string at;
+        std::string join;
+        std::string title;
+        std::optional<int64_t> every;  // Repeat interval in seconds
+        std::string submitter;
+    };
+};
+
+struct GetScheduleTool {
+    static constexpr std::string_view name = "get_schedule";
+    static constexpr MCPToolAccess access = MCPToolAccess::Read;
+    static constexpr std::string_view description = "Get the programme guide of scheduled events for the next 48 hours";
+    static constexpr std::string_view input_schema = R"({"type":"object","properties":{}})";
+    struct Args {};
+};
+
+// Order is the tools/list order
+using MCPTools = std::tuple<AddVideoToQueueTool, AddPriorityVideoTool, GetStreamingQueueTool, ClearStreamingQueueTool,
+                            GetStreamStatusTool, InterruptCurrentStreamTool, GetVideoDurationTool,
+                            ValidateVideoSourceTool, ImportPlaylistTool, ScheduleVideoTool, GetScheduleTool>;
+
+// JSON-RPC 2.0 request envelope, read in one pass. Params of methods other than tools/call
+// and notifications/cancelled (initialize's capabilities etc.) are skipped; arguments stay
+// raw until the tool is known.
+struct MCPRequestMeta {
+    glz::raw_json progressToken;  // Empty when absent
+};
+
+struct MCPToolCallParams {
+    std::string name;
+    glz::raw_json arguments{"{}"};
+    std::optional<MCPRequestMeta> _meta;
+    glz::raw_json requestId;  // notifications/cancelled
+};
+
+struct MCPRequest {
+    std::string method;
+    glz::raw_json id;  // Raw JSON echoed back as is; empty when absent, which makes a notification
+    MCPToolCallParams params;
+};
+
+// POST /mcp/call: {"tool":"...","params":{...}}
+struct MCPLegacyCall {
+    std::string tool;
+    glz::raw_json params{"{}"};
+};
@@ -1,23 +1,374 @@
 #include "media_info.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "tool_executor.hpp"
 #include "utils.hpp"
-#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
 #include <sstream>
+#include <stdexcept>
+#include <string_view>
 #include <vector>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 
-double get_media_duration(const std::string& video_path) {
-    std::string command = "/nix/store/dfc4gg05vh5wini7z0wvia3x0slszqxi-ffmpeg-7.1.1-bin/bin/ffprobe -v error -show_entries format=duration -of default=noprint_wrappers=1:nokey=1 " + video_path;
-    std::string duration_str = exec(command.c_str());
+namespace {
+
+constexpr const char* FFPROBE = "/nix/store/dfc4gg05vh5wini7z0wvia3x0slszqxi-ffmpeg-7.1.1-bin/bin/ffprobe";
+
+// Codecs ffprobe reports for a still picture: cover art of an audio file, not video
+constexpr std::string_view STILL_IMAGE_CODECS[] = {"mjpeg", "png", "bmp", "webp", "jpegls"};
+
+template <class T>
+T parse_or_zero(std::string_view text) {
+    T value{};
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc{} ? value : T{};
+}
+
+// Fields of one "key=value|key=value" line
+template <class Visit>
+void for_each_field(std::string_view line, char separator, Visit visit) {
+    while (!line.empty()) {
+        size_t end = line.find(separator);
+        std::string_view field = line.substr(0, end);
+        line = end == std::string_view::npos ? std::string_view{} : line.substr(end + 1);
+        size_t equals = field.find('=');
+        if (equals != std::string_view::npos) {
+            visit(field.substr(0, equals), field.substr(equals + 1));
+        }
+    }
+}
+
+// Recently probed sources, so a looping rotation does not run ffprobe or yt-dlp again for
+// every play. Local files are keyed with their size and modification time and an edited
+// file is probed again; anything else expires after an hour.
+constexpr size_t PROBE_CACHE_LIMIT = 4096;
+constexpr auto REMOTE_DURATION_TTL = std::chrono::hours(1);
+
+struct CachedProbe {
+    MediaProbe probe;
+    bool streams = false;  // From probe_media(); a duration lookup only fills in the duration
+    std::chrono::steady_clock::time_point expires;
+};
+
+std::mutex probe_cache_mutex;
+std::unordered_map<std::string, CachedProbe> probe_cache;
+bool probe_cache_dirty = false;  // Entries added since the last save
+
+// probe.cache: magic, then [u32 key len][key][f64 seconds][i64 expiry in Unix seconds, 0
+// for local files][u8 streams] per entry, followed when streams is 1 by [i32 width]
+// [i32 height][u8 len][video codec][u8 len][audio codec], then an FNV-1a checksum of
+// everything before it. Version 1 files have no streams byte and load as durations only.
+constexpr char PROBE_CACHE_MAGIC[8] = {'M', 'C', 'P', 'R', 'O', 'B', 'E', '2'};
+constexpr char PROBE_CACHE_MAGIC_V1[8] = {'M', 'C', 'P', 'R', 'O', 'B', 'E', '1'};
+
+uint32_t fnv1a(std::string_view data) {
+    uint32_t hash = 2166136261u;
+    for (char c : data) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+template <class T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <class T>
+bool get(std::string_view in, size_t& pos, T& value) {
+    if (in.size() - pos < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, in.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+std::string probe_cache_key(const std::string& source) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(source, ec);
+    if (ec) {
+        return source;
+    }
+    auto mtime = std::filesystem::last_write_time(source, ec).time_since_epoch().count();
+    return source + '\0' + std::to_string(size) + '\0' + std::to_string(mtime);
+}
+
+// streams asks for an entry from probe_media(). count is false for lookups that never
+// lead to a probe, so the hit ratio stays about probes.
+std::optional<MediaProbe> cached_probe(const std::string& key, bool streams, bool count = true) {
+    std::lock_guard<std::mutex> lock(probe_cache_mutex);
+    auto it = probe_cache.find(key);
+    if (it == probe_cache.end() || it->second.expires <= std::chrono::steady_clock::now() ||
+        (streams && !it->second.streams)) {
+        if (count) {
+            channel_metrics().probe_cache_misses.add();
+        }
+        return std::nullopt;
+    }
+    if (count) {
+        channel_metrics().probe_cache_hits.add();
+    }
+    return it->second.probe;
+}
+
+std::optional<double> cached_duration(const std::string& key, bool count = true) {
+    auto probe = cached_probe(key, false, count);
+    return probe ? std::optional<double>(probe->duration) : std::nullopt;
+}
+
+void cache_probe(const std::string& key, const MediaProbe& probe, bool streams, bool local_file) {
+    if (probe.duration <= 0.0) {
+        return;  // Failures are retried on the next lookup
+    }
+    auto now = std::chrono::steady_clock::now();
+    auto expires = local_file ? std::chrono::steady_clock::time_point::max() : now + REMOTE_DURATION_TTL;
+    std::lock_guard<std::mutex> lock(probe_cache_mutex);
+    if (auto it = probe_cache.find(key); !streams && it != probe_cache.end() && it->second.streams &&
+                                         it->second.expires > now) {
+        return;  // A duration lookup adds nothing to a full probe
+    }
+    if (probe_cache.size() >= PROBE_CACHE_LIMIT) {
+        probe_cache.clear();  // Rare; the next plays simply probe again
+    }
+    probe_cache[key] = {probe, streams, expires};
+    probe_cache_dirty = true;
+}
+
+void cache_duration(const std::string& key, double seconds, bool local_file) {
+    cache_probe(key, {.duration = seconds}, false, local_file);
+}
+
+}  // namespace
+
+void remember_media_duration(const std::string& source, double seconds) {
+    std::string key = is_youtube_url(source) ? source : probe_cache_key(source);
+    cache_duration(key, seconds, key != source);
+}
+
+std::optional<double> cached_media_duration(const std::string& source) {
+    return cached_duration(is_youtube_url(source) ? source : probe_cache_key(source), false);
+}
+
+void remember_media_probe(const std::string& source, const MediaProbe& probe) {
+    std::string key = is_youtube_url(source) ? source : probe_cache_key(source);
+    cache_probe(key, probe, true, key != source);
+}
+
+std::optional<MediaProbe> cached_media_probe(const std::string& source) {
+    return cached_probe(is_youtube_url(source) ? source : probe_cache_key(source), true, false);
+}
+
+std::future<ProbeCacheCheck> warm_probe_cache(std::vector<std::string> sources, ToolExecutor& pool, size_t chunk) {
+    struct Shared {
+        std::vector<std::string> sources;
+        std::mutex mutex;
+        ProbeCacheCheck check;
+        size_t chunks_left = 0;
+        std::chrono::steady_clock::time_point started;
+        std::promise<ProbeCacheCheck> done;
+    };
+    auto shared = std::make_shared<Shared>();
+    shared->sources = std::move(sources);
+    shared->started = std::chrono::steady_clock::now();
+    chunk = std::max<size_t>(chunk, 1);
+    shared->chunks_left = (shared->sources.size() + chunk - 1) / chunk;
+    auto result = shared->done.get_future();
+    if (shared->chunks_left == 0) {
+        shared->done.set_value({});
+        return result;
+    }
+
+    auto check_chunk = [shared, chunk](size_t first) {
+        ProbeCacheCheck check;
+        size_t last = std::min(first + chunk, shared->sources.size());
+        for (size_t i = first; i < last; ++i) {
+            const std::string& source = shared->sources[i];
+            if (cached_media_duration(source)) {
+                ++check.unchanged;
+            } else if (is_youtube_url(source) || source.find("://") != std::string::npos) {
+                ++check.remote;  // yt-dlp is slow and rate-limited: left until the item comes up
+            } else if (!std::filesystem::is_regular_file(source)) {
+                ++check.missing;
+            } else {
+                try {
+                    probe_media(source).duration > 0.0 ? ++check.reprobed : ++check.missing;
+                } catch (const std::exception&) {
+                    ++check.missing;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->check.unchanged += check.unchanged;
+        shared->check.reprobed += check.reprobed;
+        shared->check.missing += check.missing;
+        shared->check.remote += check.remote;
+        if (--shared->chunks_left == 0) {
+            log_info(LogCategory::Probe, "🔥 Probe cache checked",
+                     {{"unchanged", shared->check.unchanged}, {"reprobed", shared->check.reprobed},
+                      {"missing", shared->check.missing}, {"remote", shared->check.remote},
+                      {"elapsed_ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shared->started).count()}});
+            shared->done.set_value(shared->check);
+        }
+    };
+    for (size_t first = 0; first < shared->sources.size(); first += chunk) {
+        if (!pool.submit([check_chunk, first] { check_chunk(first); })) {
+            check_chunk(first);  // Pool full: check it here rather than lose the count
+        }
+    }
+    return result;
+}
+
+size_t load_probe_cache(const std::string& path) {
+    MappedFile file(path);
+    std::string_view data = file.data();
+    if (data.size() < sizeof(PROBE_CACHE_MAGIC) + sizeof(uint32_t)) {
+        return 0;
+    }
+    bool v1 = std::memcmp(data.data(), PROBE_CACHE_MAGIC_V1, sizeof(PROBE_CACHE_MAGIC_V1)) == 0;
+    if (!v1 && std::memcmp(data.data(), PROBE_CACHE_MAGIC, sizeof(PROBE_CACHE_MAGIC)) != 0) {
+        return 0;
+    }
+    uint32_t stored_checksum = 0;
+    std::memcpy(&stored_checksum, data.data() + data.size() - sizeof(uint32_t), sizeof(uint32_t));
+    data.remove_suffix(sizeof(uint32_t));
+    if (fnv1a(data) != stored_checksum) {
+        log_warn(LogCategory::Probe, "⚠️ Ignoring corrupt probe cache", {{"path", path}});
+        return 0;
+    }
+
+    auto now = std::chrono::system_clock::now();
+    auto steady_now = std::chrono::steady_clock::now();
+    auto get_name = [&data](size_t& pos, std::string& name) {
+        uint8_t len = 0;
+        if (!get(data, pos, len) || data.size() - pos < len) {
+            return false;
+        }
+        name = data.substr(pos, len);
+        pos += len;
+        return true;
+    };
+    std::unordered_map<std::string, CachedProbe> loaded;
+    for (size_t pos = sizeof(PROBE_CACHE_MAGIC); pos < data.size();) {
+        uint32_t key_len = 0;
+        int64_t expires_at = 0;
+        uint8_t streams = 0;
+        CachedProbe entry;
+        if (!get(data, pos, key_len) || data.size() - pos < key_len) {
+            break;
+        }
+        std::string key(data.substr(pos, key_len));
+        pos += key_len;
+        if (!get(data, pos, entry.probe.duration) || !get(data, pos, expires_at) || (!v1 && !get(data, pos, streams))) {
+            break;
+        }
+        if (streams && (!get(data, pos, entry.probe.width) || !get(data, pos, entry.probe.height) ||
+                        !get_name(pos, entry.probe.video_codec) || !get_name(pos, entry.probe.audio_codec))) {
+            break;
+        }
+        entry.streams = streams != 0;
+        if (expires_at == 0) {
+            entry.expires = std::chrono::steady_clock::time_point::max();
+            loaded[std::move(key)] = std::move(entry);
+        } else if (auto left = std::chrono::system_clock::from_time_t(expires_at) - now; left > left.zero()) {
+            entry.expires = steady_now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(left);
+            loaded[std::move(key)] = std::move(entry);
+        }
+    }
+    size_t entries = loaded.size();
+    std::lock_guard<std::mutex> lock(probe_cache_mutex);
+    probe_cache.merge(loaded);  // Anything probed meanwhile is newer and stays
+    return entries;
+}
+
+bool save_probe_cache(const std::string& path) {
+    std::string out(PROBE_CACHE_MAGIC, sizeof(PROBE_CACHE_MAGIC));
+    {
+        std::lock_guard<std::mutex> lock(probe_cache_mutex);
+        if (!probe_cache_dirty) {
+            return true;
+        }
+        auto now = std::chrono::system_clock::now();
+        auto steady_now = std::chrono::steady_clock::now();
+        for (const auto& [key, cached] : probe_cache) {
+            int64_t expires_at = 0;
+            if (cached.expires != std::chrono::steady_clock::time_point::max()) {
+                if (cached.expires <= steady_now) {
+                    continue;
+                }
+                expires_at = std::chrono::system_clock::to_time_t(
+                    now + std::chrono::duration_cast<std::chrono::system_clock::duration>(cached.expires - steady_now));
+            }
+            put(out, static_cast<uint32_t>(key.size()));
+            out.append(key);
+            put(out, cached.probe.duration);
+            put(out, expires_at);
+            put(out, static_cast<uint8_t>(cached.streams));
+            if (cached.streams) {
+                put(out, cached.probe.width);
+                put(out, cached.probe.height);
+                for (const std::string* name : {&cached.probe.video_codec, &cached.probe.audio_codec}) {
+                    size_t len = std::min<size_t>(name->size(), UINT8_MAX);
+                    put(out, static_cast<uint8_t>(len));
+                    out.append(*name, 0, len);
+                }
+            }
+        }
+        probe_cache_dirty = false;
+    }
+    put(out, fnv1a(out));
+
+    // Written aside and renamed over, so a crash leaves either the old file or the new one
+    std::string temp = path + ".tmp";
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    file.close();
+    std::error_code ec;
+    if (!file || (std::filesystem::rename(temp, path, ec), ec)) {
+        log_warn(LogCategory::Probe, "⚠️ Cannot save probe cache", {{"path", path}});
+        std::lock_guard<std::mutex> lock(probe_cache_mutex);
+        probe_cache_dirty = true;
+        return false;
+    }
+    return true;
+}
+
+double get_media_duration(const std::string& video_path, const ExecLimits& limits) {
+    std::string key = probe_cache_key(video_path);
+    if (auto cached = cached_duration(key)) {
+        return *cached;
+    }
+    std::string command = std::string(FFPROBE) + " -v error -show_entries format=duration -of default=noprint_wrappers=1:nokey=1 " + video_path;
+    auto start = std::chrono::steady_clock::now();
+    std::string duration_str = exec(command.c_str(), limits);
+    channel_metrics().ffprobe_latency.observe(std::chrono::steady_clock::now() - start);
     try {
-        return std::stod(duration_str);
+        double duration = std::stod(duration_str);
+        cache_duration(key, duration, key != video_path);
+        return duration;
     } catch (const std::exception& e) {
-        std::cerr << "Error parsing duration for " << video_path << ": " << e.what() << std::endl;
+        log_warn(LogCategory::Probe, "Error parsing duration", {{"item", video_path}, {"error", e.what()}});
         return 0.0;
     }
 }
 
-double get_youtube_duration(const std::string& youtube_url) {
+double get_youtube_duration(const std::string& youtube_url, const ExecLimits& limits) {
+    if (auto cached = cached_duration(youtube_url)) {
+        return *cached;
+    }
     std::string command = "yt-dlp --get-duration --no-warnings " + youtube_url;
-    std::string duration_str = exec(command.c_str());
+    auto start = std::chrono::steady_clock::now();
+    std::string duration_str = exec(command.c_str(), limits);
+    channel_metrics().ytdlp_latency.observe(std::chrono::steady_clock::now() - start);
     
     // Remove any trailing whitespace/newlines
     duration_str.erase(duration_str.find_last_not_of(" \t\n\r") + 1);
@@ -40,10 +391,147 @@ double get_youtube_duration(const std::string& youtube_url) {
         } else if (parts.size() == 1) { // Just seconds
             total_seconds = parts[0];
         }
-        
+
+        cache_duration(youtube_url, total_seconds, false);
         return total_seconds;
     } catch (const std::exception& e) {
-        std::cerr << "Error parsing YouTube duration for " << youtube_url << ": " << e.what() << std::endl;
+        log_warn(LogCategory::Probe, "Error parsing YouTube duration", {{"item", youtube_url}, {"error", e.what()}});
         return 0.0;
     }
 }
+
+bool validate_media_source(const std::string& item, std::string& error_message) {
+    // If it's a URL (starts with http:// or https://), assume it's valid
+    // The streaming component will handle URL validation
+    if (item.starts_with("http://") || item.starts_with("https://")) {
+        return true;
+    }
+
+    // Convert relative paths to absolute paths based on working directory
+    std::filesystem::path file_path(item);
+    if (file_path.is_relative()) {
+        file_path = std::filesystem::current_path() / file_path;
+    }
+
+    // One stat() answers existence, type and permissions
+    std::error_code ec;
+    auto status = std::filesystem::status(file_path, ec);
+    if (!std::filesystem::exists(status)) {
+        error_message = "File does not exist: " + file_path.string();
+        return false;
+    }
+    if (ec) {
+        error_message = "Cannot check file permissions: " + ec.message();
+        return false;
+    }
+
+    if (!std::filesystem::is_regular_file(status)) {
+        error_message = "Path is not a regular file: " + file_path.string();
+        return false;
+    }
+
+    // Basic check for read permissions
+    auto perms = status.permissions();
+    if ((perms & std::filesystem::perms::owner_read) == std::filesystem::perms::none &&
+        (perms & std::filesystem::perms::group_read) == std::filesystem::perms::none &&
+        (perms & std::filesystem::perms::others_read) == std::filesystem::perms::none) {
+        error_message = "File is not readable: " + file_path.string();
+        return false;
+    }
+
+    return true;
+}
+
+MediaProbe parse_ffprobe_streams(const std::string& output) {
+    MediaProbe probe;
+    std::istringstream lines(output);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::string_view type, codec, width, height, duration;
+        for_each_field(line, '|', [&](std::string_view key, std::string_view value) {
+            if (key == "codec_type") type = value;
+            else if (key == "codec_name") codec = value;
+            else if (key == "width") width = value;
+            else if (key == "height") height = value;
+            else if (key == "duration") duration = value;
+        });
+        if (type == "video" && probe.video_codec.empty()) {
+            probe.video_codec = codec;
+            probe.width = parse_or_zero<int>(width);
+            probe.height = parse_or_zero<int>(height);
+        } else if (type == "audio" && probe.audio_codec.empty()) {
+            probe.audio_codec = codec;
+        } else if (type.empty() && !duration.empty()) {
+            probe.duration = parse_or_zero<double>(duration);
+        }
+    }
+    return probe;
+}
+
+MediaProbe parse_ytdlp_format(const std::string& output) {
+    // yt-dlp prints NA for fields a format does not have, and "none" for a missing stream
+    auto known = [](std::string_view value) { return value != "NA" && value != "none" ? value : std::string_view{}; };
+    std::string_view line(output);
+    line = line.substr(0, line.find('\n'));
+    std::string_view fields[5];
+    for (size_t i = 0; i < 5; ++i) {
+        size_t bar = line.find('|');
+        fields[i] = line.substr(0, bar);
+        line = bar == std::string_view::npos ? std::string_view{} : line.substr(bar + 1);
+    }
+    MediaProbe probe;
+    probe.duration = parse_or_zero<double>(known(fields[0]));
+    probe.video_codec = known(fields[1]);
+    probe.width = parse_or_zero<int>(known(fields[2]));
+    probe.height = parse_or_zero<int>(known(fields[3]));
+    probe.audio_codec = known(fields[4]);
+    return probe;
+}
+
+MediaProbe probe_media(const std::string& source, const ExecLimits& limits) {
+    std::string key = is_youtube_url(source) ? source : probe_cache_key(source);
+    if (auto cached = cached_probe(key, true)) {
+        return *cached;
+    }
+    auto start = std::chrono::steady_clock::now();
+    MediaProbe probe;
+    if (is_youtube_url(source)) {
+        std::string command = "yt-dlp --no-warnings --skip-download --no-playlist --print "
+                              "'%(duration)s|%(vcodec)s|%(width)s|%(height)s|%(acodec)s' " + shell_quote(source) +
+                              " 2>/dev/null";
+        probe = parse_ytdlp_format(exec(command.c_str(), limits));
+        channel_metrics().ytdlp_latency.observe(std::chrono::steady_clock::now() - start);
+    } else {
+        std::string command = std::string(FFPROBE) +
+                              " -v error -show_entries stream=codec_type,codec_name,width,height:format=duration"
+                              " -of compact=p=0 " + shell_quote(source) + " 2>/dev/null";
+        probe = parse_ffprobe_streams(exec(command.c_str(), limits));
+        channel_metrics().ffprobe_latency.observe(std::chrono::steady_clock::now() - start);
+    }
+    if (probe.duration <= 0.0 && probe.video_codec.empty() && probe.audio_codec.empty()) {
+        throw std::runtime_error("Source could not be read");
+    }
+    cache_probe(key, probe, true, key != source);  // Playout will not probe it again
+    return probe;
+}
+
+std::string check_playable(const MediaProbe& probe) {
+    if (probe.video_codec.empty()) {
+        return "No video stream";
+    }
+    for (auto still : STILL_IMAGE_CODECS) {
+        if (probe.video_codec == still) {
+            return "Video stream is a still image (" + probe.video_codec + ")";
+        }
+    }
+    if (probe.duration <= 0.0) {
+        return "Unknown duration (live streams cannot be queued)";
+    }
+    if (probe.height < MIN_VIDEO_HEIGHT) {
+        return "Resolution too low: " + std::to_string(probe.width) + "x" + std::to_string(probe.height);
+    }
+    if (probe.height > MAX_VIDEO_HEIGHT) {
+        return "Resolution above 8K: " + std::to_string(probe.width) + "x" + std::to_string(probe.height);
+    }
+    return {};
+}
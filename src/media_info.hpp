@@ -1,8 +1,73 @@
 #pragma once
+#include "utils.hpp"
+#include <future>
+#include <optional>
 #include <string>
+#include <vector>
 
-// Function to get media duration using ffprobe
-double get_media_duration(const std::string& video_path);
+class ToolExecutor;
 
-// Function to get YouTube video duration using yt-dlp
-double get_youtube_duration(const std::string& youtube_url);
+// Function to get media duration using ffprobe; throws ExecAborted past the limits
+double get_media_duration(const std::string& video_path, const ExecLimits& limits = {});
+
+// Function to get YouTube video duration using yt-dlp; throws ExecAborted past the limits
+double get_youtube_duration(const std::string& youtube_url, const ExecLimits& limits = {});
+
+// Duration from the probe cache alone, never running ffprobe or yt-dlp. For a local file a
+// stat() confirms that its size and modification time still match; nothing when the
+// source would need a probe.
+std::optional<double> cached_media_duration(const std::string& source);
+// Caches a duration found by another probe (ignored unless positive)
+void remember_media_duration(const std::string& source, double seconds);
+
+// The probe cache survives restarts in a file (<state dir>/probe.cache). Loading maps the
+// file and returns the number of entries that are still valid; saving writes a new file
+// only when durations were added since the last save.
+size_t load_probe_cache(const std::string& path);
+bool save_probe_cache(const std::string& path);
+
+struct ProbeCacheCheck {
+    size_t unchanged = 0;  // Size and modification time still match the cache
+    size_t reprobed = 0;   // New or edited since the cache was written, probed again
+    size_t missing = 0;    // Gone or unreadable
+    size_t remote = 0;     // URLs not cached; probed when they come up
+};
+
+// Checks sources against the probe cache on pool's workers, chunk sources per job: a
+// stat() per file, and ffprobe only for the files that changed, so they are ready before
+// they come up. The future is ready once every source is checked.
+std::future<ProbeCacheCheck> warm_probe_cache(std::vector<std::string> sources, ToolExecutor& pool, size_t chunk = 32);
+
+// Function to check that a source can be queued: URLs are accepted as-is (the streamer
+// validates them), local files must exist, be regular files and be readable
+bool validate_media_source(const std::string& item, std::string& error_message);
+
+// Resolution limits for queued video; the encoder scales down to StreamingConfig::MAX_HEIGHT,
+// but sources above 8K do not decode in real time
+inline constexpr int MIN_VIDEO_HEIGHT = 144;
+inline constexpr int MAX_VIDEO_HEIGHT = 4320;
+
+// What a deep probe found out about a source
+struct MediaProbe {
+    double duration = 0.0;    // Seconds; 0 when unknown (live streams, unreadable files)
+    std::string video_codec;  // Empty without a video stream
+    int width = 0;
+    int height = 0;
+    std::string audio_codec;  // Empty without an audio stream
+};
+
+// Streams and duration of a source: yt-dlp for YouTube, ffprobe for files and other URLs.
+// Answered from the probe cache while a file is unchanged (an hour for URLs). Throws
+// ExecAborted past the limits and runtime_error when the source cannot be read.
+MediaProbe probe_media(const std::string& source, const ExecLimits& limits = {});
+// What probe_media() would answer from the cache, never probing
+std::optional<MediaProbe> cached_media_probe(const std::string& source);
+void remember_media_probe(const std::string& source, const MediaProbe& probe);
+
+// Why a probed source cannot go on air; empty when it can
+std::string check_playable(const MediaProbe& probe);
+
+// Parses ffprobe -of compact=p=0 output (stream lines, then the format's duration)
+MediaProbe parse_ffprobe_streams(const std::string& output);
+// Parses the "%(duration)s|%(vcodec)s|%(width)s|%(height)s|%(acodec)s" line from yt-dlp
+MediaProbe parse_ytdlp_format(const std::string& output);
@@ -1,50 +1,487 @@
 #include "media_queue.hpp"
+#include "queue_journal.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <limits>
 
-void ThreadSafeMediaQueue::push(const std::string& item) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.push_back(item);
+namespace {
+
+// Deltas kept for subscribers; older cursors have to resync from a snapshot
+constexpr size_t HISTORY_LIMIT = 1024;
+
+} // namespace
+
+const char* queue_op_name(QueueOp op) {
+    switch (op) {
+        case QueueOp::PushBack:
+        case QueueOp::Enqueue:
+        case QueueOp::Insert:
+        case QueueOp::InsertBatch:
+            return "insert";
+        case QueueOp::PushFront:
+        case QueueOp::InsertFront:
+            return "insert_front";
+        case QueueOp::PopFront:
+            return "pop";
+        case QueueOp::Advance:
+            return "advance";
+        case QueueOp::Remove:
+            return "remove";
+        case QueueOp::Clear:
+            return "clear";
+    }
+    return "unknown";
+}
+
+// Holds mutex_ for a mutation. Drains the submission buffer on entry so submissions are
+// ordered before the mutation, and again after release for anything that arrived while
+// the lock was held (those producers found mutex_ busy and left the drain to us).
+class ThreadSafeMediaQueue::WriterLock {
+public:
+    explicit WriterLock(ThreadSafeMediaQueue& queue) : queue_(queue), lock_(queue.mutex_, std::try_to_lock) {
+        auto& metrics = channel_metrics();
+        metrics.queue_lock_acquisitions.add();
+        if (!lock_.owns_lock()) {
+            // Only contended acquisitions pay for the clock reads
+            auto start = std::chrono::steady_clock::now();
+            lock_.lock();
+            metrics.queue_lock_wait.observe(std::chrono::steady_clock::now() - start);
+        }
+        queue_.drain_locked();
+    }
+
+    ~WriterLock() {
+        lock_.unlock();
+        queue_.drain_pending();
+    }
+
+private:
+    ThreadSafeMediaQueue& queue_;
+    std::unique_lock<std::mutex> lock_;
+};
+
+ThreadSafeMediaQueue::ThreadSafeMediaQueue()
+    : snapshot_(std::make_shared<const QueueSnapshot>()), changes_(std::make_shared<const ChangeLog>()) {
+    policies_[static_cast<size_t>(PriorityClass::Normal)] = InterruptPolicy::EndOfItem;
+    policies_[static_cast<size_t>(PriorityClass::Next)] = InterruptPolicy::EndOfItem;
+    policies_[static_cast<size_t>(PriorityClass::Interrupt)] = InterruptPolicy::Immediate;
+    policies_[static_cast<size_t>(PriorityClass::Breaking)] = InterruptPolicy::Immediate;
+}
+
+void ThreadSafeMediaQueue::store_snapshot_locked(uint64_t version, bool reorder) {
+    auto next = std::make_shared<QueueSnapshot>();
+    next->version = version;
+    next->revision = ++revision_;
+    next->items = reorder ? scheduler_.lineup() : snapshot()->items;
+    for (size_t i = 0; i < PRIORITY_CLASS_COUNT; ++i) {
+        next->class_counts[i] = scheduler_.count(static_cast<PriorityClass>(i));
+    }
+    next->submitters = scheduler_.rotation().stats();
+    for (auto& stats : next->submitters) {
+        stats.queued = scheduler_.queued_by(stats.name);  // Quotas span every class
+    }
+    next->default_submitter_policy = scheduler_.rotation().default_policy();
+    next->rotation_mode = scheduler_.rotation().mode();
+    next->now_playing = now_playing_;
+
+    size_.store(scheduler_.size(), std::memory_order_relaxed);
+    std::atomic_store_explicit(&snapshot_, std::shared_ptr<const QueueSnapshot>(std::move(next)),
+                               std::memory_order_release);
+    version_.store(version, std::memory_order_release);
+}
+
+void ThreadSafeMediaQueue::publish_locked(QueueOp op, const QueueItem* item) {
+    uint64_t version = version_.load(std::memory_order_relaxed) + 1;
+    store_snapshot_locked(version);
+
+    if (journal_) {
+        // Pops and advances only need the lane and submitter to replay deterministically
+        QueueItem record = item ? *item : QueueItem{};
+        if (op == QueueOp::PopFront || op == QueueOp::Advance) {
+            record.source.clear();
+        }
+        std::string payload = item ? QueueJournal::encode_item(record) : std::string();
+        if (op == QueueOp::Advance) {
+            payload.insert(payload.begin(), static_cast<char>(scheduler_.keeps_played()));
+        }
+        journal_->append(op, payload, version);
+    }
+
+    record_delta_locked({version, op, item ? *item : QueueItem{}});
+    notify_changed_locked();
+}
+
+void ThreadSafeMediaQueue::notify_changed_locked() {
+    // Every delta of the version is recorded by now, so the log never shows half a batch
+    auto log = std::make_shared<ChangeLog>();
+    log->version = version_.load(std::memory_order_relaxed);
+    if (!history_.empty()) {
+        log->newest = history_.back();
+    }
+    std::atomic_store_explicit(&changes_, std::shared_ptr<const ChangeLog>(std::move(log)), std::memory_order_release);
+
+    // Waiters check size_ and the log under wait_mutex_, so taking it here orders the
+    // published state before the wakeup
+    { std::lock_guard<std::mutex> lock(wait_mutex_); }
+    changed_cv_.notify_all();
+}
+
+void ThreadSafeMediaQueue::record_delta_locked(QueueDelta delta) {
+    auto node = std::make_shared<ChangeNode>();
+    node->delta = std::move(delta);
+    if (!history_.empty()) {
+        node->prev = history_.back();
+    }
+    history_.push_back(std::move(node));
+    // Trim whole versions, never the one being recorded, so a batch is never delivered
+    // partially; a batch larger than the limit stays whole until the next version
+    uint64_t recording = history_.back()->delta.version;
+    bool trimmed = false;
+    while (history_.size() > HISTORY_LIMIT && history_.front()->delta.version != recording) {
+        uint64_t oldest = history_.front()->delta.version;
+        while (history_.front()->delta.version == oldest) {
+            history_.pop_front();
+        }
+        trimmed = true;
+    }
+    if (trimmed) {
+        std::atomic_store_explicit(&history_.front()->prev, std::shared_ptr<const ChangeNode>(),
+                                   std::memory_order_release);
+    }
+}
+
+bool ThreadSafeMediaQueue::within_quota_locked(const std::string& submitter) const {
+    size_t quota = scheduler_.rotation().policy(submitter).quota;
+    return quota == 0 || scheduler_.queued_by(submitter) < quota;
+}
+
+bool ThreadSafeMediaQueue::insert_within_quota(const QueueItem& item) {
+    WriterLock lock(*this);
+    if (!within_quota_locked(item.submitter)) {
+        return false;
+    }
+    scheduler_.push_back(item);
+    publish_locked(QueueOp::Insert, &item);
+    return true;
+}
+
+void ThreadSafeMediaQueue::submit(QueueItem item) {
+    submissions_.push(std::move(item));
+    pending_submissions_.fetch_add(1, std::memory_order_seq_cst);
+    drain_pending();
+}
+
+size_t ThreadSafeMediaQueue::drain_locked() {
+    std::vector<QueueItem> batch;
+    QueueItem item;
+    while (submissions_.pop(item)) {
+        if (within_quota_locked(item.submitter)) {
+            scheduler_.push_back(item);
+            batch.push_back(std::move(item));
+        } else {
+            rejected_submissions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pending_submissions_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (batch.empty()) {
+        return 0;
+    }
+
+    // Everything drained in one pass is published as one version
+    uint64_t version = version_.load(std::memory_order_relaxed) + 1;
+    store_snapshot_locked(version);
+    if (journal_) {
+        if (batch.size() == 1) {
+            journal_->append(QueueOp::Insert, QueueJournal::encode_item(batch.front()), version);
+        } else {
+            journal_->append(QueueOp::InsertBatch, QueueJournal::encode_batch(batch), version);
+        }
+    }
+    size_t drained = batch.size();
+    for (auto& entry : batch) {
+        record_delta_locked({version, QueueOp::Insert, std::move(entry)});
+    }
+    notify_changed_locked();
+    return drained;
+}
+
+void ThreadSafeMediaQueue::drain_pending() {
+    // Pairs with the seq_cst increment in submit(): either the producer sees mutex_ free,
+    // or the holder sees the pending count after it unlocks
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (pending_submissions_.load(std::memory_order_relaxed) > 0) {
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;  // The holder drains after it releases the lock
+        }
+        if (drain_locked() == 0) {
+            return;  // A producer is still linking its node and drains itself right after
+        }
+    }
+}
+
+bool ThreadSafeMediaQueue::push(const std::string& item, const std::string& submitter, double weight) {
+    QueueItem entry{item, PriorityClass::Normal, submitter, weight};
+    if (quotas_.load(std::memory_order_acquire)) {
+        return insert_within_quota(entry);
+    }
+    submit(std::move(entry));  // No quota to race for
+    return true;
+}
+
+uint64_t ThreadSafeMediaQueue::push_batch(const std::vector<QueueItem>& items, std::vector<bool>& accepted) {
+    accepted.assign(items.size(), false);
+    std::vector<QueueItem> committed;
+    committed.reserve(items.size());
+
+    WriterLock lock(*this);
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (within_quota_locked(items[i].submitter)) {
+            scheduler_.push_back(items[i]);
+            committed.push_back(items[i]);
+            accepted[i] = true;
+        }
+    }
+    if (committed.empty()) {
+        return 0;
+    }
+
+    // One version, one snapshot rebuild and one journal record for the whole batch
+    uint64_t version = version_.load(std::memory_order_relaxed) + 1;
+    store_snapshot_locked(version);
+    if (journal_) {
+        journal_->append(QueueOp::InsertBatch, QueueJournal::encode_batch(committed), version);
+    }
+    for (auto& item : committed) {
+        record_delta_locked({version, QueueOp::Insert, std::move(item)});
+    }
+    notify_changed_locked();
+    return version;
 }
 
 void ThreadSafeMediaQueue::push_front(const std::string& item) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.push_front(item);
+    WriterLock lock(*this);
+    QueueItem entry{item, PriorityClass::Normal, DEFAULT_SUBMITTER};
+    scheduler_.push_front(entry);
+    publish_locked(QueueOp::InsertFront, &entry);
+}
+
+std::optional<InterruptPolicy> ThreadSafeMediaQueue::enqueue(const std::string& item, PriorityClass priority,
+                                                            const std::string& submitter) {
+    InterruptPolicy policy = interrupt_policy(priority);
+    QueueItem entry{item, priority, submitter};
+    if (policy == InterruptPolicy::EndOfItem && !quotas_.load(std::memory_order_acquire)) {
+        submit(std::move(entry));
+        return policy;
+    }
+    if (!insert_within_quota(entry)) {
+        return std::nullopt;
+    }
+    return policy;
 }
 
 bool ThreadSafeMediaQueue::pop(std::string& item) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (queue_.empty()) {
+    QueueItem next;
+    if (!pop(next)) {
+        return false;
+    }
+    item = std::move(next.source);
+    return true;
+}
+
+bool ThreadSafeMediaQueue::pop(QueueItem& item) {
+    WriterLock lock(*this);
+    if (!scheduler_.pop(item)) {
+        return false;
+    }
+    publish_locked(QueueOp::PopFront, &item);
+    return true;
+}
+
+bool ThreadSafeMediaQueue::advance(QueueItem& item) {
+    WriterLock lock(*this);
+    if (!scheduler_.advance(item)) {
+        return false;
+    }
+    now_playing_ = item;
+    publish_locked(QueueOp::Advance, &item);
+    return true;
+}
+
+bool ThreadSafeMediaQueue::remove_played(const QueueItem& item) {
+    WriterLock lock(*this);
+    if (!scheduler_.remove_played(item)) {
         return false;
     }
-    item = queue_.front();
-    queue_.pop_front();
+    now_playing_.reset();
+    publish_locked(QueueOp::Remove, &item);
     return true;
 }
 
+bool ThreadSafeMediaQueue::pop_wait(QueueItem& item, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        {
+            WriterLock lock(*this);
+            if (!scheduler_.empty()) {
+                scheduler_.pop(item);
+                publish_locked(QueueOp::PopFront, &item);
+                return true;
+            }
+        }
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        if (!changed_cv_.wait_until(lock, deadline, [this]() { return size_.load(std::memory_order_relaxed) > 0; })) {
+            return false;
+        }
+    }
+}
+
+bool ThreadSafeMediaQueue::wait_until_nonempty(std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    return changed_cv_.wait_for(lock, timeout, [this]() { return size_.load(std::memory_order_relaxed) > 0; });
+}
+
 void ThreadSafeMediaQueue::push_back(const std::string& item) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.push_back(item);
+    push_back(QueueItem{item, PriorityClass::Normal, DEFAULT_SUBMITTER});
+}
+
+void ThreadSafeMediaQueue::push_back(QueueItem item) {
+    WriterLock lock(*this);
+    scheduler_.push_back(item);
+    publish_locked(QueueOp::Insert, &item);
 }
 
 size_t ThreadSafeMediaQueue::size() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return queue_.size();
+    return size_.load(std::memory_order_relaxed);
 }
 
 bool ThreadSafeMediaQueue::empty() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return queue_.empty();
+    return size() == 0;
 }
 
-std::vector<std::string> ThreadSafeMediaQueue::get_all_items() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+uint64_t ThreadSafeMediaQueue::version() const {
+    return version_.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const QueueSnapshot> ThreadSafeMediaQueue::snapshot() const {
+    return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+}
+
+std::vector<std::string> ThreadSafeMediaQueue::get_items(size_t offset, size_t limit) const {
+    auto snap = snapshot();
     std::vector<std::string> items;
-    for (const auto& item : queue_) {
-        items.push_back(item);
+    if (offset >= snap->items.size()) {
+        return items;
+    }
+    size_t count = std::min(limit, snap->items.size() - offset);
+    items.reserve(count);
+    for (size_t i = offset; i < offset + count; ++i) {
+        items.push_back(snap->items[i].source);
     }
     return items;
 }
 
+std::vector<std::string> ThreadSafeMediaQueue::get_all_items() const {
+    return get_items(0, std::numeric_limits<size_t>::max());
+}
+
 void ThreadSafeMediaQueue::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.clear();
+    WriterLock lock(*this);
+    scheduler_.clear();
+    publish_locked(QueueOp::Clear);
+}
+
+InterruptPolicy ThreadSafeMediaQueue::interrupt_policy(PriorityClass priority) const {
+    return policies_[static_cast<size_t>(priority)].load(std::memory_order_relaxed);
+}
+
+void ThreadSafeMediaQueue::set_interrupt_policy(PriorityClass priority, InterruptPolicy policy) {
+    policies_[static_cast<size_t>(priority)].store(policy, std::memory_order_relaxed);
+}
+
+void ThreadSafeMediaQueue::set_submitter_policy(const std::string& submitter, SubmitterPolicy policy) {
+    WriterLock lock(*this);
+    scheduler_.rotation().set_policy(submitter, policy);
+    quotas_.store(scheduler_.rotation().has_quotas(), std::memory_order_release);
+    store_snapshot_locked(version_.load(std::memory_order_relaxed));  // Same contents, fresh stats
+}
+
+void ThreadSafeMediaQueue::set_default_submitter_policy(SubmitterPolicy policy) {
+    WriterLock lock(*this);
+    scheduler_.rotation().set_default_policy(policy);
+    quotas_.store(scheduler_.rotation().has_quotas(), std::memory_order_release);
+    store_snapshot_locked(version_.load(std::memory_order_relaxed));  // Same contents, fresh stats
+}
+
+void ThreadSafeMediaQueue::record_airtime(const std::string& submitter, double seconds) {
+    WriterLock lock(*this);
+    scheduler_.rotation().record_airtime(submitter, seconds);
+    store_snapshot_locked(version_.load(std::memory_order_relaxed), false);  // Same order, fresh stats
+}
+
+void ThreadSafeMediaQueue::set_rotation_mode(RotationMode mode) {
+    WriterLock lock(*this);
+    scheduler_.rotation().set_mode(mode);
+    store_snapshot_locked(version_.load(std::memory_order_relaxed));  // Same items, new projected order
+}
+
+RotationMode ThreadSafeMediaQueue::rotation_mode() const {
+    return snapshot()->rotation_mode;
+}
+
+std::shared_ptr<const ThreadSafeMediaQueue::ChangeLog> ThreadSafeMediaQueue::change_log() const {
+    return std::atomic_load_explicit(&changes_, std::memory_order_acquire);
+}
+
+QueueChanges ThreadSafeMediaQueue::changes_since(uint64_t version) const {
+    auto log = change_log();
+    QueueChanges changes;
+    changes.version = log->version;
+    if (version >= changes.version) {
+        changes.resync = version > changes.version;  // Cursor from before a restart
+        return changes;
+    }
+    // Walk back from the newest delta to the cursor. The chain ending first means the
+    // deltas right after the cursor were trimmed, unless the cut fell exactly there.
+    auto node = log->newest;
+    while (node && node->delta.version > version) {
+        changes.deltas.push_back(node->delta);
+        node = std::atomic_load_explicit(&node->prev, std::memory_order_acquire);
+    }
+    if (!node && (changes.deltas.empty() || changes.deltas.back().version > version + 1)) {
+        changes.deltas.clear();
+        changes.resync = true;
+        return changes;
+    }
+    std::reverse(changes.deltas.begin(), changes.deltas.end());
+    return changes;
+}
+
+QueueChanges ThreadSafeMediaQueue::wait_for_changes(uint64_t version, std::chrono::milliseconds timeout) const {
+    {
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        changed_cv_.wait_for(lock, timeout, [this, version]() { return change_log()->version != version; });
+    }
+    return changes_since(version);
+}
+
+void ThreadSafeMediaQueue::restore(std::vector<QueueItem> items, uint64_t version) {
+    {
+        // No drain on entry: anything submitted meanwhile goes after the restored lineup
+        std::lock_guard<std::mutex> lock(mutex_);
+        scheduler_.assign(std::move(items));
+        history_.clear();  // Subscribers resync from the restored snapshot
+        store_snapshot_locked(version);
+        notify_changed_locked();
+    }
+    drain_pending();
+}
+
+uint64_t ThreadSafeMediaQueue::rejected_submissions() const {
+    return rejected_submissions_.load(std::memory_order_relaxed);
+}
+
+void ThreadSafeMediaQueue::attach_journal(QueueJournal* journal) {
+    WriterLock lock(*this);
+    journal_ = journal;
 }
@@ -1,23 +1,182 @@
 #pragma once
+#include "priority_scheduler.hpp"
+#include "mpsc_queue.hpp"
 #include <queue>
 #include <string>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <deque>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <optional>
+#include <cstdint>
+
+class QueueJournal;
+
+// Mutation kinds, recorded by the journal and replayed on recovery
+enum class QueueOp : uint8_t {
+    PushBack = 1,     // Legacy: source appended to the normal rotation
+    PushFront = 2,    // Legacy: source inserted at the front of the normal rotation
+    PopFront = 3,     // Pop the next item; payload names the lane and submitter it came from
+    Clear = 4,
+    Enqueue = 5,      // Legacy: class byte + source appended to a priority lane
+    Insert = 6,       // Encoded QueueItem appended to its lane
+    InsertFront = 7,  // Encoded QueueItem inserted at the front of its lane
+    InsertBatch = 8,  // Several encoded QueueItems appended atomically
+    Advance = 9,      // Keep byte + encoded QueueItem (no source): the rotation moved past an item
+    Remove = 10,      // Encoded QueueItem: an advanced item taken back out of the rotation
+};
+
+const char* queue_op_name(QueueOp op);
+
+// One mutation as seen by subscribers; item is the inserted, popped or advanced entry
+struct QueueDelta {
+    uint64_t version = 0;
+    QueueOp op = QueueOp::Clear;
+    QueueItem item;
+};
+
+// Deltas after a subscriber's version; items of one batch share a version. resync means the history no longer reaches back
+// that far (or the queue was restored), so the subscriber must re-read the snapshot.
+struct QueueChanges {
+    uint64_t version = 0;  // Version the subscriber is current with after applying deltas
+    bool resync = false;
+    std::vector<QueueDelta> deltas;
+};
+
+// Immutable, versioned view of the queue handed out to readers
+struct QueueSnapshot {
+    uint64_t version = 0;   // Queue contents; what /queue/changes deltas are numbered by
+    uint64_t revision = 0;  // Every published snapshot, stats-only refreshes included; the ETag
+    QueueLineup items;  // Play order
+    std::array<size_t, PRIORITY_CLASS_COUNT> class_counts{};
+    std::vector<SubmitterStats> submitters;  // Sorted by name
+    SubmitterPolicy default_submitter_policy;
+    RotationMode rotation_mode = RotationMode::Loop;
+    std::optional<QueueItem> now_playing;  // Last item handed out by advance()
+
+    const QueueItem* up_next() const { return items.empty() ? nullptr : &items.front(); }
+};
 
 // Thread-safe queue for media management
 class ThreadSafeMediaQueue {
 private:
-    std::deque<std::string> queue_;  // Changed from queue to deque for front insertion
+    PriorityScheduler scheduler_;  // Per-class FIFO lanes
     mutable std::mutex mutex_;
 
+    // Readers load the published snapshot without touching mutex_ (copy-on-write)
+    std::shared_ptr<const QueueSnapshot> snapshot_;
+    std::atomic<uint64_t> version_{0};
+    uint64_t revision_ = 0;  // Under mutex_
+    std::atomic<size_t> size_{0};
+    QueueJournal* journal_ = nullptr;
+    std::array<std::atomic<InterruptPolicy>, PRIORITY_CLASS_COUNT> policies_;
+
+    // Recent deltas for subscribers as a chain, each node pointing at the one before.
+    // history_ holds the nodes oldest first for trimming, which cuts the oldest retained
+    // node's link; changes_ is published once per version, so subscribers read it without
+    // mutex_. Waiters sleep on changed_cv_ under wait_mutex_.
+    struct ChangeNode {
+        QueueDelta delta;
+        std::shared_ptr<const ChangeNode> prev;  // Atomic access: trimming cuts it under readers
+    };
+    struct ChangeLog {
+        uint64_t version = 0;  // Newest version whose deltas are all in the chain
+        std::shared_ptr<const ChangeNode> newest;
+    };
+    std::deque<std::shared_ptr<ChangeNode>> history_;  // Under mutex_
+    std::shared_ptr<const ChangeLog> changes_;
+    std::optional<QueueItem> now_playing_;
+    mutable std::mutex wait_mutex_;
+    mutable std::condition_variable changed_cv_;
+    void notify_changed_locked();  // Publishes the change log, then wakes waiters; caller must hold mutex_
+
+    // Lock-free ingestion: producers push here and whoever holds (or next gets) mutex_
+    // moves everything into scheduler_ as one batch
+    MpscQueue<QueueItem> submissions_;
+    std::atomic<size_t> pending_submissions_{0};
+    std::atomic<uint64_t> rejected_submissions_{0};
+    // Whether any quota is set; submissions then go through insert_within_quota() so the
+    // caller learns the exact verdict
+    std::atomic<bool> quotas_{false};
+
+    class WriterLock;
+    size_t drain_locked();  // Caller must hold mutex_
+    void drain_pending();   // Drain if mutex_ is free; the current holder drains otherwise
+    void submit(QueueItem item);
+    bool insert_within_quota(const QueueItem& item);
+
+    // Publish a snapshot at the given version; caller must hold mutex_. Without
+    // reorder the lineup of the previous snapshot is carried over as it is.
+    void store_snapshot_locked(uint64_t version, bool reorder = true);
+    // Publish a new version after a mutation, then journal it; caller must hold mutex_
+    void publish_locked(QueueOp op, const QueueItem* item = nullptr);
+    bool within_quota_locked(const std::string& submitter) const;
+    std::shared_ptr<const ChangeLog> change_log() const;
+    void record_delta_locked(QueueDelta delta);
+
 public:
-    void push(const std::string& item);
-    void push_front(const std::string& item);  // Add high-priority item to front
+    ThreadSafeMediaQueue();
+
+    // Append to the normal rotation; false when the submitter is over quota. Without quotas
+    // the item takes the lock-free submission buffer; with them it is committed under the
+    // lock against the exact quota, so true means it is really queued.
+    bool push(const std::string& item, const std::string& submitter = DEFAULT_SUBMITTER, double weight = 1.0);
+    // Append many items under one lock and one version; accepted[i] is false when over quota.
+    // Returns the version that committed the batch, or 0 when nothing was accepted.
+    uint64_t push_batch(const std::vector<QueueItem>& items, std::vector<bool>& accepted);
+    void push_front(const std::string& item);  // Insert at the front of the normal rotation
+    // Append to the lane of the given class; returns the policy for cutting the item on air, or
+    // nothing when the submitter is over quota. A class whose policy cuts the item on air is
+    // committed under the lock against the exact quota, so a caller never cuts for an item
+    // that is then refused; end-of-item classes go the way push() does.
+    std::optional<InterruptPolicy> enqueue(const std::string& item, PriorityClass priority,
+                                           const std::string& submitter = DEFAULT_SUBMITTER);
     bool pop(std::string& item);
+    bool pop(QueueItem& item);
+    // Next item to put on air. The rotation keeps it (moving its cursor instead of
+    // popping and re-appending) unless the rotation mode is Once.
+    bool advance(QueueItem& item);
+    // Take an item advance() just handed out back out of the rotation (it failed its air-time
+    // check), so a queue of dead items empties instead of coming round again
+    bool remove_played(const QueueItem& item);
+    // Block until an item is available or the timeout expires
+    bool pop_wait(QueueItem& item, std::chrono::milliseconds timeout);
+    bool wait_until_nonempty(std::chrono::milliseconds timeout) const;
     void push_back(const std::string& item);
+    void push_back(QueueItem item);  // Append without quota checks
     size_t size() const;
     bool empty() const;
+    uint64_t version() const;
+    std::shared_ptr<const QueueSnapshot> snapshot() const;
+    std::vector<std::string> get_items(size_t offset, size_t limit) const;  // Paginated read
     std::vector<std::string> get_all_items() const;
     void clear();
+
+    // Change subscription: deltas after `version`, optionally waiting for the next change.
+    // Read from the published change log; subscribers never take the queue lock.
+    QueueChanges changes_since(uint64_t version) const;
+    QueueChanges wait_for_changes(uint64_t version, std::chrono::milliseconds timeout) const;
+
+    // Submissions dropped at drain time because a quota was set while they were buffered
+    uint64_t rejected_submissions() const;
+
+    InterruptPolicy interrupt_policy(PriorityClass priority) const;
+    void set_interrupt_policy(PriorityClass priority, InterruptPolicy policy);
+
+    // Weighted fair sharing of the normal rotation between submitters
+    void set_submitter_policy(const std::string& submitter, SubmitterPolicy policy);
+    void set_default_submitter_policy(SubmitterPolicy policy);
+    void record_airtime(const std::string& submitter, double seconds);
+
+    // Loop / once / shuffle / weighted-random playout of the normal rotation
+    void set_rotation_mode(RotationMode mode);
+    RotationMode rotation_mode() const;
+
+    // Replace contents with recovered state; versions continue from the persisted one
+    void restore(std::vector<QueueItem> items, uint64_t version);
+    void attach_journal(QueueJournal* journal);
 };
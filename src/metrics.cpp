@@ -0,0 +1,283 @@
+#include "metrics.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+std::mutex slot_mutex;
+std::vector<size_t> free_slots = [] {
+    std::vector<size_t> slots;
+    for (size_t slot = METRIC_SHARED_SLOT; slot-- > 0;) {
+        slots.push_back(slot);  // Lowest slot handed out first
+    }
+    return slots;
+}();
+
+// The mutex orders a slot's last writes by one thread before the first by the next owner
+struct SlotOwner {
+    size_t slot = METRIC_SHARED_SLOT;
+
+    SlotOwner() {
+        std::lock_guard<std::mutex> lock(slot_mutex);
+        if (!free_slots.empty()) {
+            slot = free_slots.back();
+            free_slots.pop_back();
+        }
+    }
+
+    ~SlotOwner() {
+        if (slot != METRIC_SHARED_SLOT) {
+            std::lock_guard<std::mutex> lock(slot_mutex);
+            free_slots.push_back(slot);
+        }
+    }
+};
+
+}  // namespace
+
+size_t metric_slot() {
+    thread_local SlotOwner owner;
+    return owner.slot;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& slot : slots_) {
+        total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram::Histogram(std::vector<double> bounds) : bounds_(std::move(bounds)) {
+    for (auto& slot : slots_) {
+        slot.buckets = std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1);
+    }
+}
+
+void Histogram::observe(double value) {
+    size_t index = metric_slot();
+    auto& slot = slots_[index];
+    size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+    metrics_detail::add(slot.buckets[bucket], uint64_t{1}, index);
+    metrics_detail::add(slot.sum, value, index);
+}
+
+Histogram::Totals Histogram::totals() const {
+    Totals totals{std::vector<uint64_t>(bounds_.size() + 1, 0), 0.0};
+    for (const auto& slot : slots_) {
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            totals.cumulative[i] += slot.buckets[i].load(std::memory_order_relaxed);
+        }
+        totals.sum += slot.sum.load(std::memory_order_relaxed);
+    }
+    for (size_t i = 1; i < totals.cumulative.size(); ++i) {
+        totals.cumulative[i] += totals.cumulative[i - 1];
+    }
+    return totals;
+}
+
+std::vector<double> latency_buckets() {
+    return {0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 10};
+}
+
+std::vector<double> probe_buckets() {
+    return {0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2, 5, 10, 20, 30, 60};
+}
+
+std::string label(std::string_view key, std::string_view value) {
+    std::string out(key);
+    out += "=\"";
+    for (char c : value) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default: out += c;
+        }
+    }
+    out += '"';
+    return out;
+}
+
+namespace {
+
+void append_number(std::string& out, double value) {
+    if (std::isnan(value)) {
+        out += "NaN";
+    } else if (std::isinf(value)) {
+        out += value > 0 ? "+Inf" : "-Inf";
+    } else {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+}
+
+void append_number(std::string& out, uint64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+// name{labels,extra} with the braces left out when both are empty
+void append_series(std::string& out, std::string_view name, std::string_view labels, std::string_view extra = {}) {
+    out += name;
+    if (labels.empty() && extra.empty()) {
+        return;
+    }
+    out += '{';
+    out += labels;
+    if (!labels.empty() && !extra.empty()) {
+        out += ',';
+    }
+    out += extra;
+    out += '}';
+}
+
+void append_header(std::string& out, std::string_view name, std::string_view help, std::string_view type) {
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+}  // namespace
+
+MetricsRegistry::Series& MetricsRegistry::series(const std::string& name, const std::string& help, Type type,
+                                                 const std::string& labels) {
+    auto [it, inserted] = families_.try_emplace(name);
+    Family& family = it->second;
+    if (inserted) {
+        family.help = help;
+        family.type = type;
+    } else if (family.type != type) {
+        throw std::logic_error("metric " + name + " registered with two types");
+    }
+    for (auto& series : family.series) {
+        if (series->labels == labels) {
+            return *series;
+        }
+    }
+    family.series.push_back(std::make_unique<Series>());
+    family.series.back()->labels = labels;
+    return *family.series.back();
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = series(name, help, Type::Counter, labels);
+    if (!entry.counter) entry.counter = std::make_unique<Counter>();
+    return *entry.counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = series(name, help, Type::Gauge, labels);
+    if (!entry.gauge) entry.gauge = std::make_unique<Gauge>();
+    return *entry.gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                      const std::vector<double>& bounds, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = series(name, help, Type::Histogram, labels);
+    if (!entry.histogram) entry.histogram = std::make_unique<Histogram>(bounds);
+    return *entry.histogram;
+}
+
+void MetricsRegistry::gauge_callback(const std::string& name, const std::string& help, std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series(name, help, Type::Gauge, {}).read = std::move(read);
+}
+
+void MetricsRegistry::counter_callback(const std::string& name, const std::string& help, std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series(name, help, Type::Counter, {}).read = std::move(read);
+}
+
+void MetricsRegistry::render(std::string& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, family] : families_) {
+        append_header(out, name, family.help,
+                      family.type == Type::Counter ? "counter" : family.type == Type::Gauge ? "gauge" : "histogram");
+        for (const auto& series : family.series) {
+            if (family.type != Type::Histogram) {
+                append_series(out, name, series->labels);
+                out += ' ';
+                if (series->read) {
+                    append_number(out, series->read());
+                } else if (series->counter) {
+                    append_number(out, series->counter->value());
+                } else {
+                    append_number(out, series->gauge ? series->gauge->value() : 0.0);
+                }
+                out += '\n';
+                continue;
+            }
+
+            const Histogram& histogram = *series->histogram;
+            auto totals = histogram.totals();
+            std::string bucket_name = name + "_bucket";
+            for (size_t i = 0; i < totals.cumulative.size(); ++i) {
+                std::string le = "le=\"";
+                append_number(le, i < histogram.bounds().size() ? histogram.bounds()[i] : INFINITY);
+                le += '"';
+                append_series(out, bucket_name, series->labels, le);
+                out += ' ';
+                append_number(out, totals.cumulative[i]);
+                out += '\n';
+            }
+            append_series(out, name + "_sum", series->labels);
+            out += ' ';
+            append_number(out, totals.sum);
+            out += '\n';
+            append_series(out, name + "_count", series->labels);
+            out += ' ';
+            append_number(out, totals.cumulative.back());
+            out += '\n';
+        }
+    }
+}
+
+MetricsRegistry& metrics_registry() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+void render_sample(std::string& out, std::string_view name, std::string_view type, std::string_view help, double value) {
+    append_header(out, name, help, type);
+    out += name;
+    out += ' ';
+    append_number(out, value);
+    out += '\n';
+}
+
+ChannelMetrics& channel_metrics() {
+    static ChannelMetrics metrics = [] {
+        auto& r = metrics_registry();
+        r.gauge("process_start_time_seconds", "Start time of the process since the unix epoch in seconds")
+            .set(std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count());
+        const std::string probe_help = "Duration probes that missed the cache, by tool";
+        return ChannelMetrics{
+            r.counter("mychannel_queue_lock_acquisitions_total", "Queue writer lock acquisitions"),
+            r.histogram("mychannel_queue_lock_wait_seconds", "Time spent waiting for a contended queue writer lock",
+                        latency_buckets()),
+            r.histogram("mychannel_probe_duration_seconds", probe_help, probe_buckets(), label("tool", "ffprobe")),
+            r.histogram("mychannel_probe_duration_seconds", probe_help, probe_buckets(), label("tool", "yt-dlp")),
+            r.counter("mychannel_probe_cache_hits_total", "Duration lookups answered from the probe cache"),
+            r.counter("mychannel_probe_cache_misses_total", "Duration lookups that ran ffprobe or yt-dlp"),
+            r.histogram("mychannel_transition_gap_seconds",
+                        "Time from the end of one item to the start of the next encoder", probe_buckets()),
+            r.histogram("mychannel_interrupt_latency_seconds",
+                        "Time from a requested cut to the playout loop leaving the item", probe_buckets()),
+            r.gauge("mychannel_encoder_speed", "Encoder speed as a realtime factor (below 1 is falling behind)"),
+            r.gauge("mychannel_encoder_fps", "Encoder frames per second"),
+            r.gauge("mychannel_encoder_bitrate_kbps", "Encoder output bitrate in kbit/s"),
+            r.counter("mychannel_ffmpeg_starts_total", "Encoder processes started"),
+            r.counter("mychannel_ffmpeg_failures_total", "Encoder processes that exited with an error"),
+            r.counter("mychannel_interrupts_suppressed_total",
+                      "Requested cuts refused because the interrupt cooldown was running"),
+        };
+    }();
+    return metrics;
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// In-process metrics exported in the Prometheus text format (GET /metrics). Every recording
+// thread owns a slot of each metric while it lives, so recording is a plain relaxed load and
+// store: no locks, no read-modify-write, and busy threads do not share cache lines. A scrape
+// sums the slots, so it never waits for the threads that record.
+
+inline constexpr size_t METRIC_SLOTS = 64;
+inline constexpr size_t METRIC_SHARED_SLOT = METRIC_SLOTS - 1;  // For threads beyond the owned slots; atomic adds
+
+// Slot of the calling thread. Slots are taken on first use and handed back when the thread
+// exits, so short-lived threads (one per streamed item) do not use them up.
+size_t metric_slot();
+
+namespace metrics_detail {
+// Single-writer add on an owned slot; the shared slot needs a real atomic add
+template <class T>
+inline void add(std::atomic<T>& value, T n, size_t slot) {
+    if (slot != METRIC_SHARED_SLOT) [[likely]] {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    } else {
+        value.fetch_add(n, std::memory_order_relaxed);
+    }
+}
+}  // namespace metrics_detail
+
+class Counter {
+public:
+    void add(uint64_t n = 1) {
+        size_t slot = metric_slot();
+        metrics_detail::add(slots_[slot].value, n, slot);
+    }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Slot, METRIC_SLOTS> slots_;
+};
+
+// Last value wins; for levels reported by a single writer (encoder speed, start time)
+class Gauge {
+public:
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds);  // Ascending bucket upper bounds; +Inf is implied
+
+    void observe(double value);
+    template <class Rep, class Period>
+    void observe(std::chrono::duration<Rep, Period> elapsed) {
+        observe(std::chrono::duration<double>(elapsed).count());
+    }
+
+    struct Totals {
+        std::vector<uint64_t> cumulative;  // One per bound, then +Inf
+        double sum = 0.0;
+    };
+    Totals totals() const;
+    const std::vector<double>& bounds() const { return bounds_; }
+
+private:
+    struct alignas(64) Slot {
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+        std::atomic<double> sum{0.0};
+    };
+    const std::vector<double> bounds_;
+    std::array<Slot, METRIC_SLOTS> slots_;
+};
+
+// Bucket bounds in seconds
+std::vector<double> latency_buckets();  // 50 µs .. 10 s, for request handling and lock waits
+std::vector<double> probe_buckets();    // 10 ms .. 60 s, for ffprobe/yt-dlp and playout transitions
+
+// label("route", "GET /queue") -> route="GET /queue", escaped for the exposition format
+std::string label(std::string_view key, std::string_view value);
+
+// Named metrics. Lookups create on first use and return the same object afterwards, so
+// hot paths resolve a metric once and keep the reference; they are never removed.
+class MetricsRegistry {
+public:
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = {});
+    Histogram& histogram(const std::string& name, const std::string& help, const std::vector<double>& bounds,
+                         const std::string& labels = {});
+    // Read at scrape time; only for objects that live as long as the process
+    void gauge_callback(const std::string& name, const std::string& help, std::function<double()> read);
+    void counter_callback(const std::string& name, const std::string& help, std::function<double()> read);
+
+    // Appends every metric, grouped by name, in the text exposition format 0.0.4
+    void render(std::string& out) const;
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+    struct Series {
+        std::string labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> read;
+    };
+    struct Family {
+        std::string help;
+        Type type = Type::Counter;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+    Series& series(const std::string& name, const std::string& help, Type type, const std::string& labels);
+
+    mutable std::mutex mutex_;  // Registration and scrapes only
+    std::map<std::string, Family> families_;
+};
+
+MetricsRegistry& metrics_registry();
+
+// Appends one unlabelled sample that is not kept in the registry (values owned by the caller);
+// type is "counter" or "gauge"
+void render_sample(std::string& out, std::string_view name, std::string_view type, std::string_view help, double value);
+
+// Metrics recorded on the playout and queue hot paths, resolved once
+struct ChannelMetrics {
+    Counter& queue_lock_acquisitions;
+    Histogram& queue_lock_wait;  // Contended acquisitions only
+    Histogram& ffprobe_latency;
+    Histogram& ytdlp_latency;
+    Counter& probe_cache_hits;
+    Counter& probe_cache_misses;
+    Histogram& transition_gap;     // End of one item to the start of the next encoder
+    Histogram& interrupt_latency;  // Cut requested to the item being abandoned
+    Gauge& encoder_speed;
+    Gauge& encoder_fps;
+    Gauge& encoder_bitrate_kbps;
+    Counter& ffmpeg_starts;
+    Counter& ffmpeg_failures;
+    Counter& interrupts_suppressed;  // Client cuts refused during the interrupt cooldown
+};
+
+ChannelMetrics& channel_metrics();
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free multi-producer / single-consumer queue (Vyukov's intrusive
+// linked-list design). push() is wait-free: one atomic exchange plus one store.
+// pop() must only be called by one thread at a time (the caller provides that
+// exclusion, e.g. by holding a mutex) and may briefly report empty while a
+// producer is between its exchange and its link store.
+template <typename T>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    alignas(64) std::atomic<Node*> head_;  // Most recently pushed node; producers swap it
+    alignas(64) Node* tail_;               // Next node to consume; consumer only
+    Node stub_;
+
+    void push_node(Node* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+public:
+    MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+    ~MpscQueue() {
+        T discarded;
+        while (pop(discarded)) {
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node;
+        node->value = std::move(value);
+        push_node(node);
+    }
+
+    bool pop(T& out) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (!next) {
+                return false;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            out = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return false;  // A producer has swapped head_ but not linked its node yet
+        }
+        // tail is the last node: re-insert the stub behind it so it can be released
+        push_node(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            out = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+        return false;
+    }
+};
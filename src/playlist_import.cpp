@@ -0,0 +1,276 @@
+#include "playlist_import.hpp"
+#include "media_info.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <regex>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <glaze/glaze.hpp>
+
+namespace {
+
+constexpr const char* PLAYLIST_FORMAT_NAMES[] = {"auto", "json", "m3u", "youtube"};
+
+std::string trim(const std::string& text) {
+    const char* whitespace = " \t\r\n";
+    size_t begin = text.find_first_not_of(whitespace);
+    if (begin == std::string::npos) {
+        return {};
+    }
+    return text.substr(begin, text.find_last_not_of(whitespace) - begin + 1);
+}
+
+bool is_youtube_playlist_url(const std::string& text) {
+    static const std::regex playlist_regex(
+        R"(^https?://(www\.|m\.)?(youtube\.com/(playlist\?|watch\?.*list=)|youtu\.be/.*list=))");
+    return text.find('\n') == std::string::npos && std::regex_search(text, playlist_regex);
+}
+
+bool parse_json_playlist(const std::string& content, std::vector<std::string>& sources, std::string& error) {
+    glz::json_t json;
+    if (glz::read_json(json, content)) {
+        error = "Invalid JSON playlist";
+        return false;
+    }
+    if (json.is_object() && json.contains("items")) {
+        glz::json_t items = std::move(json["items"]);
+        json = std::move(items);
+    }
+    if (!json.is_array()) {
+        error = "JSON playlist must be an array";
+        return false;
+    }
+    for (const auto& entry : json.get_array()) {
+        if (entry.is_string()) {
+            sources.push_back(entry.get_string());
+            continue;
+        }
+        bool found = false;
+        if (entry.is_object()) {
+            const auto& object = entry.get_object();
+            for (std::string_view key : {"source", "url", "path"}) {
+                auto it = object.find(key);
+                if (it != object.end() && it->second.is_string()) {
+                    sources.push_back(it->second.get_string());
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (!found) {
+            sources.emplace_back();  // Reported as an invalid item rather than failing the import
+        }
+    }
+    return true;
+}
+
+void parse_m3u_playlist(const std::string& content, const std::string& base_dir, std::vector<std::string>& sources) {
+    std::istringstream lines(content);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.starts_with("\xEF\xBB\xBF")) {
+            line.erase(0, 3);  // UTF-8 BOM in .m3u8 files
+        }
+        line = trim(line);
+        if (line.empty() || line.starts_with('#')) {
+            continue;  // #EXTM3U, #EXTINF and comments
+        }
+        bool is_url = line.find("://") != std::string::npos;
+        if (!is_url && !base_dir.empty() && std::filesystem::path(line).is_relative()) {
+            line = (std::filesystem::path(base_dir) / line).string();
+        }
+        sources.push_back(line);
+    }
+}
+
+bool expand_youtube_playlist(const std::string& url, std::vector<std::string>& sources, std::string& error) {
+    std::string command = "yt-dlp --flat-playlist --print url --no-warnings " + shell_quote(url);
+    std::string output;
+    try {
+        output = exec(command.c_str());
+    } catch (const std::exception& e) {
+        error = std::string("Failed to run yt-dlp: ") + e.what();
+        return false;
+    }
+    parse_m3u_playlist(output, {}, sources);
+    if (sources.empty()) {
+        error = "No videos found in YouTube playlist";
+        return false;
+    }
+    return true;
+}
+
+void validate_item(PlaylistItemResult& result, bool probe) {
+    if (result.source.empty()) {
+        result.error = "Missing source";
+        return;
+    }
+    if (!validate_media_source(result.source, result.error)) {
+        return;
+    }
+    if (probe) {
+        try {
+            MediaProbe media = probe_media(result.source);
+            result.duration = media.duration;
+            result.error = check_playable(media);
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+    }
+}
+
+} // namespace
+
+const char* playlist_format_name(PlaylistFormat format) {
+    return PLAYLIST_FORMAT_NAMES[static_cast<size_t>(format)];
+}
+
+std::optional<PlaylistFormat> parse_playlist_format(const std::string& name) {
+    for (size_t i = 0; i < std::size(PLAYLIST_FORMAT_NAMES); ++i) {
+        if (name == PLAYLIST_FORMAT_NAMES[i]) {
+            return static_cast<PlaylistFormat>(i);
+        }
+    }
+    if (name == "m3u8") {
+        return PlaylistFormat::M3U;
+    }
+    return std::nullopt;
+}
+
+bool parse_playlist(const std::string& content, const PlaylistImportOptions& options,
+                    std::vector<std::string>& sources, std::string& error) {
+    std::string trimmed = trim(content);
+    PlaylistFormat format = options.format;
+    if (format == PlaylistFormat::Auto) {
+        if (trimmed.starts_with('[') || trimmed.starts_with('{')) {
+            format = PlaylistFormat::Json;
+        } else if (is_youtube_playlist_url(trimmed)) {
+            format = PlaylistFormat::YouTube;
+        } else {
+            format = PlaylistFormat::M3U;
+        }
+    }
+
+    sources.clear();
+    switch (format) {
+        case PlaylistFormat::Json:
+            if (!parse_json_playlist(trimmed, sources, error)) {
+                return false;
+            }
+            break;
+        case PlaylistFormat::YouTube:
+            if (!is_youtube_playlist_url(trimmed)) {
+                error = "Not a YouTube playlist URL";
+                return false;
+            }
+            if (!expand_youtube_playlist(trimmed, sources, error)) {
+                return false;
+            }
+            break;
+        case PlaylistFormat::M3U:
+        case PlaylistFormat::Auto:
+            parse_m3u_playlist(content, options.base_dir, sources);
+            break;
+    }
+
+    if (sources.empty()) {
+        error = "Playlist is empty";
+        return false;
+    }
+    if (sources.size() > options.max_items) {
+        error = "Playlist has " + std::to_string(sources.size()) + " items, limit is " + std::to_string(options.max_items);
+        return false;
+    }
+    return true;
+}
+
+PlaylistImportResult import_sources(ThreadSafeMediaQueue& queue, const std::vector<std::string>& sources,
+                                    const PlaylistImportOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    PlaylistImportResult result;
+    result.ok = true;
+    result.items.resize(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        result.items[i].source = sources[i];
+    }
+
+    // Bounded pool: workers claim the next unvalidated index until the list is exhausted
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < result.items.size(); i = next.fetch_add(1)) {
+            validate_item(result.items[i], options.probe);
+        }
+    };
+    size_t workers = std::min(std::max<size_t>(options.max_parallel, 1), result.items.size());
+    std::vector<std::thread> threads;
+    threads.reserve(workers > 0 ? workers - 1 : 0);
+    for (size_t i = 1; i < workers; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Commit everything that validated in one lock acquisition and one queue version
+    std::vector<QueueItem> batch;
+    std::vector<size_t> batch_index;
+    batch.reserve(result.items.size());
+    for (size_t i = 0; i < result.items.size(); ++i) {
+        if (result.items[i].error.empty()) {
+            batch.push_back({result.items[i].source, PriorityClass::Normal, options.submitter});
+            batch_index.push_back(i);
+        }
+    }
+    std::vector<bool> accepted;
+    result.version = queue.push_batch(batch, accepted);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        auto& item = result.items[batch_index[i]];
+        if (accepted[i]) {
+            item.queued = true;
+            ++result.queued;
+        } else {
+            item.error = "Queue quota exceeded for submitter " + options.submitter;
+        }
+    }
+
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::optional<std::filesystem::path> resolve_import_path(const std::string& import_dir, const std::string& path) {
+    if (import_dir.empty()) {
+        return std::nullopt;
+    }
+    std::error_code ec;
+    auto root = std::filesystem::weakly_canonical(std::filesystem::absolute(import_dir, ec), ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    // An absolute path replaces root here and then fails the check like "../" does
+    auto resolved = std::filesystem::weakly_canonical(root / path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    auto relative = resolved.lexically_relative(root);
+    if (relative.empty() || relative == "." || *relative.begin() == "..") {
+        return std::nullopt;
+    }
+    return resolved;
+}
+
+PlaylistImportResult import_playlist(ThreadSafeMediaQueue& queue, const std::string& content,
+                                     const PlaylistImportOptions& options) {
+    std::vector<std::string> sources;
+    std::string error;
+    if (!parse_playlist(content, options, sources, error)) {
+        PlaylistImportResult result;
+        result.error = error;
+        return result;
+    }
+    return import_sources(queue, sources, options);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "media_queue.hpp"
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+enum class PlaylistFormat : uint8_t {
+    Auto = 0,     // Guess from the content
+    Json = 1,     // ["a.mp4", {"source": "b.mp4"}, ...] or {"items": [...]}
+    M3U = 2,      // M3U/M3U8 (also plain one-source-per-line lists)
+    YouTube = 3,  // YouTube playlist URL, expanded with yt-dlp
+};
+
+const char* playlist_format_name(PlaylistFormat format);
+std::optional<PlaylistFormat> parse_playlist_format(const std::string& name);
+
+struct PlaylistImportOptions {
+    PlaylistFormat format = PlaylistFormat::Auto;
+    std::string submitter = DEFAULT_SUBMITTER;
+    std::string base_dir;     // Resolves relative M3U entries (directory of the playlist file)
+    size_t max_parallel = 8;  // Concurrent validation/probe workers
+    size_t max_items = 5000;  // Larger playlists are rejected outright
+    bool probe = false;       // Also probe streams with ffprobe/yt-dlp and reject what validation would
+};
+
+struct PlaylistItemResult {
+    std::string source;
+    bool queued = false;
+    std::string error;      // Why the item was rejected
+    double duration = 0.0;  // Seconds, when probed
+};
+
+struct PlaylistImportResult {
+    bool ok = false;    // False when the playlist itself could not be read
+    std::string error;
+    std::vector<PlaylistItemResult> items;  // Same order as the playlist
+    size_t queued = 0;
+    uint64_t version = 0;  // Queue version that committed the import, 0 if nothing was queued
+    double elapsed_ms = 0.0;
+};
+
+// A playlist file named by a client, resolved under import_dir (symlinks included); nothing
+// when import_dir is empty or the path leads outside it
+std::optional<std::filesystem::path> resolve_import_path(const std::string& import_dir, const std::string& path);
+
+// Split playlist content into sources
+bool parse_playlist(const std::string& content, const PlaylistImportOptions& options,
+                    std::vector<std::string>& sources, std::string& error);
+
+// Validate (and optionally probe) every source in parallel, then append all valid
+// items to the queue in a single commit
+PlaylistImportResult import_sources(ThreadSafeMediaQueue& queue, const std::vector<std::string>& sources,
+                                    const PlaylistImportOptions& options);
+PlaylistImportResult import_playlist(ThreadSafeMediaQueue& queue, const std::string& content,
+                                     const PlaylistImportOptions& options);
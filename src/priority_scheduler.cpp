@@ -0,0 +1,278 @@
+#include "priority_scheduler.hpp"
+#include <bit>
+
+namespace {
+
+constexpr const char* PRIORITY_CLASS_NAMES[PRIORITY_CLASS_COUNT] = {"normal", "next", "interrupt", "breaking"};
+constexpr const char* INTERRUPT_POLICY_NAMES[] = {"end_of_item", "segment", "immediate"};
+
+size_t lane_index(PriorityClass priority) {
+    return static_cast<size_t>(priority);
+}
+
+} // namespace
+
+const char* priority_class_name(PriorityClass priority) {
+    return PRIORITY_CLASS_NAMES[lane_index(priority)];
+}
+
+std::optional<PriorityClass> parse_priority_class(const std::string& name) {
+    for (size_t i = 0; i < PRIORITY_CLASS_COUNT; ++i) {
+        if (name == PRIORITY_CLASS_NAMES[i]) {
+            return static_cast<PriorityClass>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+const char* interrupt_policy_name(InterruptPolicy policy) {
+    return INTERRUPT_POLICY_NAMES[static_cast<size_t>(policy)];
+}
+
+std::optional<InterruptPolicy> parse_interrupt_policy(const std::string& name) {
+    for (size_t i = 0; i < std::size(INTERRUPT_POLICY_NAMES); ++i) {
+        if (name == INTERRUPT_POLICY_NAMES[i]) {
+            return static_cast<InterruptPolicy>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+QueueLineup::QueueLineup(std::vector<LineupPart> lanes, std::vector<LineupPart> rotation)
+    : parts_(std::make_shared<Parts>()) {
+    for (const auto& part : lanes) {
+        size_ += part.size();
+    }
+    for (const auto& part : rotation) {
+        size_ += part.size();
+    }
+    parts_->lanes = std::move(lanes);
+    parts_->rotation = std::move(rotation);
+}
+
+const QueueItem& QueueLineup::front() const {
+    for (const auto& part : parts_->lanes) {
+        if (part.size() > 0) {
+            return part.at(0);
+        }
+    }
+    return parts_->rotation.front().at(0);  // Active submitters all have items
+}
+
+const std::vector<QueueItem>& QueueLineup::items() const {
+    static const std::vector<QueueItem> none;
+    if (!parts_) {
+        return none;
+    }
+    std::call_once(parts_->built, [this]() {
+        parts_->items.reserve(size_);
+        append_to(parts_->items);
+    });
+    return parts_->items;
+}
+
+void QueueLineup::append_to(std::vector<QueueItem>& out) const {
+    if (!parts_) {
+        return;
+    }
+    for (const auto& part : parts_->lanes) {
+        for (size_t k = 0; k < part.size(); ++k) {
+            out.push_back(part.at(k));
+        }
+    }
+    append_round_robin(parts_->rotation, out);
+}
+
+void PriorityScheduler::added(const QueueItem& item) {
+    nonempty_mask_ |= 1u << lane_index(item.priority);
+    ++queued_by_submitter_[item.submitter];
+    ++size_;
+}
+
+void PriorityScheduler::removed(const QueueItem& item) {
+    size_t lane = lane_index(item.priority);
+    bool lane_empty = item.priority == PriorityClass::Normal ? rotation_.empty() : lanes_[lane].empty();
+    if (lane_empty) {
+        nonempty_mask_ &= ~(1u << lane);
+    }
+    auto it = queued_by_submitter_.find(item.submitter);
+    if (it != queued_by_submitter_.end() && --it->second == 0) {
+        queued_by_submitter_.erase(it);
+    }
+    --size_;
+}
+
+void PriorityScheduler::push_back(QueueItem item) {
+    added(item);
+    if (item.priority == PriorityClass::Normal) {
+        rotation_.push_back(std::move(item));
+    } else {
+        published_lanes_[lane_index(item.priority)].reset();
+        lanes_[lane_index(item.priority)].push_back(std::move(item));
+    }
+}
+
+void PriorityScheduler::push_front(QueueItem item) {
+    added(item);
+    if (item.priority == PriorityClass::Normal) {
+        rotation_.push_front(std::move(item));
+    } else {
+        published_lanes_[lane_index(item.priority)].reset();
+        lanes_[lane_index(item.priority)].push_front(std::move(item));
+    }
+}
+
+bool PriorityScheduler::pop(QueueItem& item) {
+    auto top = top_class();
+    if (!top) {
+        return false;
+    }
+    if (*top == PriorityClass::Normal) {
+        rotation_.pop(item);
+    } else {
+        pop_lane(lane_index(*top), item);
+    }
+    removed(item);
+    return true;
+}
+
+bool PriorityScheduler::advance(QueueItem& item) {
+    auto top = top_class();
+    if (!top) {
+        return false;
+    }
+    if (*top == PriorityClass::Normal) {
+        rotation_.advance(item);
+        if (!keeps_played()) {
+            removed(item);
+        }
+        return true;
+    }
+    pop_from(*top, {}, item);
+    if (keeps_played()) {
+        requeue_played(item);
+    }
+    return true;
+}
+
+bool PriorityScheduler::advance_from(PriorityClass priority, const std::string& submitter, bool keep,
+                                     QueueItem& item) {
+    if (priority == PriorityClass::Normal) {
+        if (!rotation_.advance_from(submitter, keep, item)) {
+            return false;
+        }
+        if (!keep) {
+            removed(item);
+        }
+        return true;
+    }
+    if (!pop_from(priority, submitter, item)) {
+        return false;
+    }
+    if (keep) {
+        requeue_played(item);
+    }
+    return true;
+}
+
+bool PriorityScheduler::remove_played(const QueueItem& item) {
+    // Kept lane items rejoined the rotation as normal ones
+    QueueItem played{item.source, PriorityClass::Normal, item.submitter, item.weight};
+    if (!keeps_played() || !rotation_.remove_played(played)) {
+        return false;
+    }
+    removed(played);
+    return true;
+}
+
+void PriorityScheduler::requeue_played(const QueueItem& item) {
+    // Played priority content rejoins its submitter's share of the rotation
+    QueueItem played{item.source, PriorityClass::Normal, item.submitter, item.weight};
+    added(played);
+    rotation_.push_played(std::move(played));
+}
+
+bool PriorityScheduler::pop_from(PriorityClass priority, const std::string& submitter, QueueItem& item) {
+    if (priority == PriorityClass::Normal) {
+        if (!rotation_.pop_from(submitter, item)) {
+            return false;
+        }
+    } else {
+        if (lanes_[lane_index(priority)].empty()) {
+            return false;
+        }
+        pop_lane(lane_index(priority), item);
+    }
+    removed(item);
+    return true;
+}
+
+void PriorityScheduler::pop_lane(size_t lane, QueueItem& item) {
+    item = std::move(lanes_[lane].front());
+    lanes_[lane].pop_front();
+    ++published_lane_begin_[lane];  // Still a prefix of the published copy
+}
+
+void PriorityScheduler::clear() {
+    rotation_.clear();
+    for (auto& lane : lanes_) {
+        lane.clear();
+    }
+    for (auto& published : published_lanes_) {
+        published.reset();
+    }
+    queued_by_submitter_.clear();
+    nonempty_mask_ = 0;
+    size_ = 0;
+}
+
+size_t PriorityScheduler::count(PriorityClass priority) const {
+    return priority == PriorityClass::Normal ? rotation_.size() : lanes_[lane_index(priority)].size();
+}
+
+size_t PriorityScheduler::queued_by(const std::string& submitter) const {
+    auto it = queued_by_submitter_.find(submitter);
+    return it != queued_by_submitter_.end() ? it->second : 0;
+}
+
+std::optional<PriorityClass> PriorityScheduler::top_class() const {
+    if (nonempty_mask_ == 0) {
+        return std::nullopt;
+    }
+    return static_cast<PriorityClass>(std::bit_width(nonempty_mask_) - 1);
+}
+
+std::vector<QueueItem> PriorityScheduler::flatten() const {
+    std::vector<QueueItem> items;
+    items.reserve(size_);
+    lineup().append_to(items);
+    return items;
+}
+
+QueueLineup PriorityScheduler::lineup() const {
+    std::vector<LineupPart> lanes;
+    for (size_t i = PRIORITY_CLASS_COUNT; i-- > 1;) {
+        if (lanes_[i].empty()) {
+            continue;
+        }
+        if (!published_lanes_[i]) {
+            published_lanes_[i] = std::make_shared<const std::vector<QueueItem>>(lanes_[i].begin(), lanes_[i].end());
+            published_lane_begin_[i] = 0;
+        }
+        LineupPart part;
+        part.items = published_lanes_[i];
+        part.begin = published_lane_begin_[i];
+        part.count = lanes_[i].size();
+        lanes.push_back(std::move(part));
+    }
+    std::vector<LineupPart> rotation;
+    rotation_.freeze(rotation);
+    return QueueLineup(std::move(lanes), std::move(rotation));
+}
+
+void PriorityScheduler::assign(std::vector<QueueItem> items) {
+    clear();
+    for (auto& item : items) {
+        push_back(std::move(item));
+    }
+}
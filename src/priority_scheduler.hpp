@@ -0,0 +1,108 @@
+#pragma once
+#include "queue_item.hpp"
+#include "fair_queue.hpp"
+#include <array>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+
+// How the item on air is cut when higher-priority content arrives
+enum class InterruptPolicy : uint8_t {
+    EndOfItem = 0,        // Wait for the current item to finish
+    SegmentBoundary = 1,  // Cut at the next keyframe/segment boundary
+    Immediate = 2,        // Kill the encoder right away
+};
+
+const char* priority_class_name(PriorityClass priority);
+std::optional<PriorityClass> parse_priority_class(const std::string& name);
+const char* interrupt_policy_name(InterruptPolicy policy);
+std::optional<InterruptPolicy> parse_interrupt_policy(const std::string& name);
+
+// Play order as published in a snapshot: the lanes from the highest class down, then
+// the rotation's round-robin rounds. The parts share their items with the scheduler, so
+// taking a lineup copies no items; the flat list is built on first indexed access, by
+// the first reader that needs it, outside the queue lock.
+class QueueLineup {
+private:
+    struct Parts {
+        std::vector<LineupPart> lanes;
+        std::vector<LineupPart> rotation;
+        std::once_flag built;
+        std::vector<QueueItem> items;
+    };
+    std::shared_ptr<Parts> parts_;
+    size_t size_ = 0;
+
+public:
+    QueueLineup() = default;
+    QueueLineup(std::vector<LineupPart> lanes, std::vector<LineupPart> rotation);
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const QueueItem& front() const;  // Without building the list
+    const QueueItem& operator[](size_t i) const { return items()[i]; }
+    std::vector<QueueItem>::const_iterator begin() const { return items().begin(); }
+    std::vector<QueueItem>::const_iterator end() const { return items().end(); }
+    const std::vector<QueueItem>& items() const;
+    void append_to(std::vector<QueueItem>& out) const;
+};
+
+// One FIFO lane per priority class plus a bitmask of non-empty lanes, so that
+// pop() finds the highest class in O(1). The normal class is a FairQueue shared
+// between submitters. Not thread-safe; owned by ThreadSafeMediaQueue.
+class PriorityScheduler {
+private:
+    FairQueue rotation_;                                             // PriorityClass::Normal
+    std::array<std::deque<QueueItem>, PRIORITY_CLASS_COUNT> lanes_;  // Higher classes; [0] unused
+    std::unordered_map<std::string, size_t> queued_by_submitter_;    // Across all classes, for quotas
+    uint32_t nonempty_mask_ = 0;
+    size_t size_ = 0;
+
+    // Last frozen copy of each lane and how many entries have been popped off it since;
+    // null once the lane changes any other way
+    mutable std::array<std::shared_ptr<const std::vector<QueueItem>>, PRIORITY_CLASS_COUNT> published_lanes_;
+    mutable std::array<size_t, PRIORITY_CLASS_COUNT> published_lane_begin_{};
+
+    void pop_lane(size_t lane, QueueItem& item);
+
+    void added(const QueueItem& item);
+    void removed(const QueueItem& item);
+    void requeue_played(const QueueItem& item);
+
+public:
+    void push_back(QueueItem item);
+    void push_front(QueueItem item);
+    bool pop(QueueItem& item);
+    // Take the next item to put on air. Normal items stay in the rotation behind its cursor,
+    // lane items join the rotation after playing; nothing is kept in RotationMode::Once.
+    bool advance(QueueItem& item);
+    // Pop the head of a specific lane (and submitter, for the normal class); used by journal replay
+    bool pop_from(PriorityClass priority, const std::string& submitter, QueueItem& item);
+    bool advance_from(PriorityClass priority, const std::string& submitter, bool keep, QueueItem& item);
+    // Take an item advance() kept back out of the rotation; false when it was not kept
+    bool remove_played(const QueueItem& item);
+    void clear();
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t count(PriorityClass priority) const;
+    size_t queued_by(const std::string& submitter) const;
+    std::optional<PriorityClass> top_class() const;
+
+    bool keeps_played() const { return rotation_.mode() != RotationMode::Once; }
+
+    FairQueue& rotation() { return rotation_; }
+    const FairQueue& rotation() const { return rotation_; }
+
+    // Items in play order: highest class first, FIFO within each priority class,
+    // projected round-robin order for the normal rotation
+    std::vector<QueueItem> flatten() const;
+    // The same order for a snapshot, sharing what has not changed since the last lineup
+    QueueLineup lineup() const;
+    void assign(std::vector<QueueItem> items);
+};
@@ -0,0 +1,260 @@
+#include "process_policy.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+constexpr const char* CGROUP_ROOT = "/sys/fs/cgroup";
+constexpr int IOPRIO_WHO_PROCESS = 1;
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+constexpr int64_t CPU_MAX_PERIOD_US = 100000;
+
+bool parse_int(std::string_view text, int& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc{} && result.ptr == text.data() + text.size();
+}
+
+bool write_file(const std::string& path, std::string_view value) {
+    std::ofstream file(path);
+    file << value;
+    file.flush();
+    return static_cast<bool>(file);
+}
+
+// Path of the server's own cgroup v2 group, from the "0::<path>" line
+std::optional<std::string> own_cgroup() {
+    std::ifstream file("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.starts_with("0::")) {
+            return std::string(CGROUP_ROOT) + line.substr(3);
+        }
+    }
+    return std::nullopt;
+}
+
+// CPU time the kernel held back from a group by its cpu.max, from cpu.stat
+double throttled_seconds(const std::string& cgroup) {
+    std::ifstream file(cgroup + "/cpu.stat");
+    std::string key;
+    double value = 0.0;
+    while (file >> key >> value) {
+        if (key == "throttled_usec") {
+            return value / 1e6;
+        }
+    }
+    return 0.0;
+}
+
+}  // namespace
+
+bool parse_io_priority(std::string_view text, IoPriority& priority) {
+    size_t colon = text.find(':');
+    std::string_view name = text.substr(0, colon);
+    IoPriority parsed;
+    if (name == "idle") {
+        if (colon != std::string_view::npos) {
+            return false;  // The idle class has no levels
+        }
+        parsed.io_class = IoClass::Idle;
+        parsed.level = 7;
+        priority = parsed;
+        return true;
+    }
+    if (name == "best-effort") {
+        parsed.io_class = IoClass::BestEffort;
+    } else if (name == "realtime") {
+        parsed.io_class = IoClass::RealTime;
+    } else {
+        return false;
+    }
+    if (colon != std::string_view::npos &&
+        (!parse_int(text.substr(colon + 1), parsed.level) || parsed.level < 0 || parsed.level > 7)) {
+        return false;
+    }
+    priority = parsed;
+    return true;
+}
+
+bool parse_cpu_max(std::string_view text, std::string& cpu_max) {
+    if (text == "max") {
+        cpu_max = "max " + std::to_string(CPU_MAX_PERIOD_US);
+        return true;
+    }
+    if (size_t space = text.find(' '); space != std::string_view::npos) {
+        int64_t quota = 0;
+        int64_t period = 0;
+        auto q = std::from_chars(text.data(), text.data() + space, quota);
+        auto p = std::from_chars(text.data() + space + 1, text.data() + text.size(), period);
+        if (q.ec != std::errc{} || q.ptr != text.data() + space || p.ec != std::errc{} ||
+            p.ptr != text.data() + text.size() || quota < 1000 || period < 1000 || period > 1000000) {
+            return false;
+        }
+        cpu_max = std::string(text);
+        return true;
+    }
+    double cores = 0.0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), cores);
+    if (result.ec != std::errc{} || result.ptr != text.data() + text.size() || !(cores >= 0.01) || cores > 4096) {
+        return false;
+    }
+    cpu_max = std::to_string(std::llround(cores * CPU_MAX_PERIOD_US)) + " " + std::to_string(CPU_MAX_PERIOD_US);
+    return true;
+}
+
+std::optional<std::string> make_child_cgroup(std::string_view name, const std::string& cpu_max, std::string& error) {
+    auto base = own_cgroup();
+    if (base && base->ends_with("/server")) {
+        base->resize(base->size() - 7);  // Started by a server that had already moved itself there
+    }
+    if (!base || !std::filesystem::exists(*base + "/cgroup.controllers")) {
+        error = "cgroup v2 is not mounted at /sys/fs/cgroup";
+        return std::nullopt;
+    }
+    std::string server = *base + "/server";
+    std::string child = *base + "/" + std::string(name);
+    std::error_code ec;
+    std::filesystem::create_directory(server, ec);
+    std::filesystem::create_directory(child, ec);
+    if (!std::filesystem::exists(child)) {
+        error = "cannot create " + child + " (is the cgroup delegated to this user?)";
+        return std::nullopt;
+    }
+    if (!write_file(server + "/cgroup.procs", "0")) {
+        error = "cannot move the server into " + server;
+        return std::nullopt;
+    }
+    if (!write_file(*base + "/cgroup.subtree_control", "+cpu")) {
+        error = "cannot enable the cpu controller in " + *base;
+        return std::nullopt;
+    }
+    if (!write_file(child + "/cpu.max", cpu_max)) {
+        error = "cannot write " + child + "/cpu.max";
+        return std::nullopt;
+    }
+    return child;
+}
+
+ProcessPolicy encoder_policy_from_env() {
+    ProcessPolicy policy;
+    if (const char* cpus = std::getenv("MYCHANNEL_ENCODER_CPUS")) {
+        CpuSet parsed;
+        const CpuSet& allowed = process_cpu_set();
+        if (!parse_cpu_set(cpus, parsed)) {
+            log_warn(LogCategory::Stream, "⚠️ Ignoring invalid encoder CPUs", {{"value", cpus}});
+        } else if (!std::includes(allowed.begin(), allowed.end(), parsed.begin(), parsed.end())) {
+            // The kernel would refuse the whole mask in the child, where nobody can report it
+            log_warn(LogCategory::Stream, "⚠️ Ignoring encoder CPUs outside the server's own",
+                     {{"value", cpus}, {"allowed", format_cpu_set(allowed)}});
+        } else {
+            policy.cpus = std::move(parsed);
+        }
+    }
+    if (const char* nice = std::getenv("MYCHANNEL_ENCODER_NICE")) {
+        int value = 0;
+        if (parse_int(nice, value) && value >= -20 && value <= 19) {
+            policy.nice = value;
+        } else {
+            log_warn(LogCategory::Stream, "⚠️ Ignoring invalid encoder nice value", {{"value", nice}});
+        }
+    }
+    if (const char* io = std::getenv("MYCHANNEL_ENCODER_IOPRIO")) {
+        IoPriority priority;
+        if (parse_io_priority(io, priority)) {
+            policy.io_priority = priority;
+        } else {
+            log_warn(LogCategory::Stream, "⚠️ Ignoring invalid encoder I/O priority", {{"value", io}});
+        }
+    }
+    if (const char* cap = std::getenv("MYCHANNEL_ENCODER_CPU_MAX")) {
+        std::string cpu_max;
+        std::string error;
+        if (!parse_cpu_max(cap, cpu_max)) {
+            log_warn(LogCategory::Stream, "⚠️ Ignoring invalid encoder CPU cap", {{"value", cap}});
+        } else if (auto cgroup = make_child_cgroup("encoder", cpu_max, error)) {
+            policy.cgroup = *cgroup;
+            metrics_registry().counter_callback(
+                "mychannel_encoder_throttled_seconds_total", "CPU time held back from the encoder by its cpu.max",
+                [cgroup = *cgroup] { return throttled_seconds(cgroup); });
+        } else {
+            log_warn(LogCategory::Stream, "⚠️ Encoder CPU cap unavailable", {{"error", error}});
+        }
+    }
+    log_info(LogCategory::Stream, "🧮 Encoder resource policy",
+             {{"cpus", policy.cpus.empty() ? std::string("all") : format_cpu_set(policy.cpus)},
+              {"nice", policy.nice ? std::to_string(*policy.nice) : std::string("inherit")},
+              {"io_class", policy.io_priority ? static_cast<int>(policy.io_priority->io_class) : 0},
+              {"cgroup", policy.cgroup.empty() ? std::string("none") : policy.cgroup}});
+    return policy;
+}
+
+ChildProcess spawn_with_policy(const std::string& command, const ProcessPolicy& policy) {
+    // Everything the child needs is prepared here: after fork only system calls are safe
+    const CpuSet& cpus = policy.cpus.empty() ? process_cpu_set() : policy.cpus;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &cpu_set);
+    }
+    int ioprio = policy.io_priority ? (static_cast<int>(policy.io_priority->io_class) << IOPRIO_CLASS_SHIFT) |
+                                          policy.io_priority->level
+                                    : -1;
+    int cgroup_fd = -1;
+    if (!policy.cgroup.empty()) {
+        cgroup_fd = open((policy.cgroup + "/cgroup.procs").c_str(), O_WRONLY | O_CLOEXEC);
+    }
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        if (cgroup_fd >= 0) close(cgroup_fd);
+        throw std::runtime_error("pipe() failed!");
+    }
+    const char* argv[] = {"sh", "-c", command.c_str(), nullptr};
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        setpgid(0, 0);
+        if (cgroup_fd >= 0) {
+            [[maybe_unused]] auto written = write(cgroup_fd, "0", 1);  // Before anything else runs
+        }
+        if (!cpus.empty()) {
+            sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+        }
+        if (policy.nice) {
+            setpriority(PRIO_PROCESS, 0, *policy.nice);
+        }
+        if (ioprio >= 0) {
+            syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, ioprio);
+        }
+        dup2(fds[1], STDOUT_FILENO);  // dup2 clears close-on-exec on the copy
+        execve("/bin/sh", const_cast<char* const*>(argv), environ);
+        _exit(127);
+    }
+    int fork_errno = errno;
+    close(fds[1]);
+    if (cgroup_fd >= 0) {
+        close(cgroup_fd);
+    }
+    if (pid < 0) {
+        close(fds[0]);
+        throw std::runtime_error(std::string("fork() failed: ") + std::strerror(fork_errno));
+    }
+    setpgid(pid, pid);  // Also from here, so a kill of the group cannot race the child's own call
+    int pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    return {pid, fds[0], pidfd};
+}
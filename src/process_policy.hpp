@@ -0,0 +1,51 @@
+#pragma once
+#include "runtime.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+
+// Where and how eagerly a child process runs. The encoder gets one so that a preset that
+// would use every core leaves room for the HTTP/MCP threads and the playout loop, and so
+// that channels sharing a host stay within their own share.
+
+enum class IoClass { RealTime = 1, BestEffort = 2, Idle = 3 };  // The kernel's IOPRIO_CLASS_*
+
+struct IoPriority {
+    IoClass io_class = IoClass::BestEffort;
+    int level = 4;  // 0 (highest) to 7; ignored for Idle
+};
+
+struct ProcessPolicy {
+    CpuSet cpus;              // Empty: every CPU the server started with
+    std::optional<int> nice;  // -20..19; below the server's own needs CAP_SYS_NICE
+    std::optional<IoPriority> io_priority;  // RealTime needs CAP_SYS_ADMIN
+    std::string cgroup;       // cgroup v2 directory the child joins; empty for none
+};
+
+// "idle", "best-effort", "best-effort:7", "realtime:0"
+bool parse_io_priority(std::string_view text, IoPriority& priority);
+// cpu.max value from CPU cores ("1.5"), "max", or the raw "<quota_us> <period_us>"
+bool parse_cpu_max(std::string_view text, std::string& cpu_max);
+
+// MYCHANNEL_ENCODER_CPUS, _NICE, _IOPRIO and _CPU_MAX; invalid values are reported and
+// skipped. A CPU cap makes a cgroup (see make_child_cgroup) and is dropped with a warning
+// when that is not possible.
+ProcessPolicy encoder_policy_from_env();
+
+// Creates <own cgroup>/<name> with the cpu controller and writes cpu.max. cgroup v2 only
+// lets leaf groups hold processes, so the server first moves itself into <own>/server.
+// Needs a delegated subtree (systemd Delegate=yes); returns the directory, or nothing
+// with the reason in error.
+std::optional<std::string> make_child_cgroup(std::string_view name, const std::string& cpu_max, std::string& error);
+
+// "sh -c command" in its own process group with stdout on a pipe; the policy is applied
+// between fork and exec, so nothing the shell starts runs outside it. Throws
+// runtime_error when the process cannot be started; a setting the kernel refuses is
+// skipped in the child.
+struct ChildProcess {
+    pid_t pid = -1;  // Also the process group
+    int stdout_fd = -1;
+    int pidfd = -1;  // Readable once it has exited, from any process; -1 without pidfd_open
+};
+ChildProcess spawn_with_policy(const std::string& command, const ProcessPolicy& policy);
@@ -0,0 +1,466 @@
+#include "push_server.hpp"
+#include "runtime.hpp"
+#include "json_response.hpp"
+#include "logger.hpp"
+#include "media_queue.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t MAX_REQUEST_HEAD = 8192;
+constexpr size_t MAX_IOV = 16;
+
+PushEventPtr static_event(std::string_view kind, std::string frame) {
+    return std::make_shared<const PushEvent>(PushEvent{std::string(kind), false, std::move(frame)});
+}
+
+// Frames every subscriber gets the same bytes of
+const PushEventPtr& stream_head() {
+    static const PushEventPtr event = static_event(
+        "head",
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: close\r\n"
+        "X-Accel-Buffering: no\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "\r\n");
+    return event;
+}
+
+const PushEventPtr& resync_event() {
+    static const PushEventPtr event = static_event("resync", "event: resync\ndata: {}\n\n");
+    return event;
+}
+
+const PushEventPtr& keepalive_event() {
+    static const PushEventPtr event =
+        std::make_shared<const PushEvent>(PushEvent{"keepalive", true, ": keepalive\n\n"});
+    return event;
+}
+
+const PushEventPtr& plain_response(int status) {
+    static const PushEventPtr not_found = static_event(
+        "404", "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    static const PushEventPtr busy = static_event(
+        "503", "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    static const PushEventPtr preflight = static_event(
+        "204",
+        "HTTP/1.1 204 No Content\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Access-Control-Allow-Methods: GET, OPTIONS\r\n"
+        "Access-Control-Allow-Headers: Last-Event-ID, Cache-Control\r\n"
+        "Connection: close\r\n\r\n");
+    return status == 204 ? preflight : status == 503 ? busy : not_found;
+}
+
+}  // namespace
+
+size_t PushBacklog::push(PushEventPtr event) {
+    size_t discarded = 0;
+    // The front event may be partly written; everything behind it is still ours to drop
+    auto unsent = events_.begin() + (head_offset_ > 0 ? 1 : 0);
+    if (event->coalesce) {
+        auto stale = std::find_if(unsent, events_.end(), [&](const PushEventPtr& queued) {
+            return queued->coalesce && queued->kind == event->kind;
+        });
+        if (stale != events_.end()) {
+            events_.erase(stale);
+            ++discarded;
+        }
+    }
+    if (events_.size() >= max_events_) {
+        unsent = events_.begin() + (head_offset_ > 0 ? 1 : 0);
+        discarded += static_cast<size_t>(events_.end() - unsent);
+        events_.erase(unsent, events_.end());
+        events_.push_back(resync_event());
+    }
+    events_.push_back(std::move(event));
+    return discarded;
+}
+
+size_t PushBacklog::gather(iovec* iov, size_t max) const {
+    size_t count = 0;
+    for (auto it = events_.begin(); it != events_.end() && count < max; ++it, ++count) {
+        const std::string& frame = (*it)->frame;
+        size_t offset = count == 0 ? head_offset_ : 0;
+        iov[count].iov_base = const_cast<char*>(frame.data() + offset);
+        iov[count].iov_len = frame.size() - offset;
+    }
+    return count;
+}
+
+void PushBacklog::consume(size_t bytes) {
+    while (bytes > 0 && !events_.empty()) {
+        size_t left = events_.front()->frame.size() - head_offset_;
+        if (bytes < left) {
+            head_offset_ += bytes;
+            return;
+        }
+        bytes -= left;
+        events_.pop_front();
+        head_offset_ = 0;
+    }
+}
+
+PushServer::PushServer() : PushServer(Options{}) {}
+
+PushServer::PushServer(Options options) : options_(options) {}
+
+PushServer::~PushServer() {
+    stop();
+}
+
+int PushServer::start(const std::string& host, int port) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error(std::string("push socket: ") + std::strerror(errno));
+    }
+    int yes = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        stop();
+        throw std::runtime_error("push server: invalid host " + host);
+    }
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd_, SOMAXCONN) < 0) {
+        std::string error = std::strerror(errno);
+        stop();
+        throw std::runtime_error("push server: cannot listen on " + host + ":" + std::to_string(port) + ": " + error);
+    }
+    socklen_t length = sizeof(addr);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &length);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        std::string error = std::strerror(errno);
+        stop();
+        throw std::runtime_error("push server: " + error);
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listen_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+
+    stopping_ = false;
+    loop_ = std::thread([this] {
+        enter_thread_role(ThreadRole::Http, "push");
+        run();
+    });
+    pthread_getcpuclockid(loop_.native_handle(), &loop_clock_);
+    return ntohs(addr.sin_port);
+}
+
+void PushServer::stop() {
+    stopping_ = true;
+    if (wake_fd_ >= 0) {
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = write(wake_fd_, &one, sizeof(one));
+    }
+    if (loop_.joinable()) {
+        loop_.join();
+    }
+    if (queue_watcher_.joinable()) {
+        queue_watcher_.join();
+    }
+    for (auto& [fd, connection] : connections_) {
+        close(fd);
+    }
+    connections_.clear();
+    subscribers_ = 0;
+    for (int* fd : {&listen_fd_, &epoll_fd_, &wake_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void PushServer::publish(std::string_view kind, std::string_view data, bool coalesce) {
+    if (subscribers() == 0) {
+        return;
+    }
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(outbox_mutex_);
+        // Numbered under the lock so ids go out in order
+        std::string frame;
+        frame.reserve(kind.size() + data.size() + 40);
+        frame.append("id: ").append(std::to_string(next_id_++)).append("\nevent: ").append(kind);
+        frame.append("\ndata: ").append(data).append("\n\n");
+        wake = outbox_.empty();
+        outbox_.push_back(std::make_shared<const PushEvent>(PushEvent{std::string(kind), coalesce, std::move(frame)}));
+    }
+    published_.fetch_add(1, std::memory_order_relaxed);
+    if (wake) {
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = write(wake_fd_, &one, sizeof(one));
+    }
+}
+
+void PushServer::watch_queue(ThreadSafeMediaQueue& queue) {
+    queue_watcher_ = std::thread([this, &queue] {
+        enter_thread_role(ThreadRole::Http, "push-watch");
+        uint64_t version = queue.snapshot()->version;
+        while (!stopping_) {
+            auto changes = queue.wait_for_changes(version, std::chrono::seconds(1));
+            if (changes.version == version && !changes.resync) {
+                continue;
+            }
+            version = changes.version;
+            publish("queue", write_json_response(queue_changes_response(changes)));
+        }
+    });
+}
+
+std::chrono::nanoseconds PushServer::loop_cpu_time() const {
+    timespec ts{};
+    if (!loop_.joinable() || clock_gettime(loop_clock_, &ts) != 0) {
+        return {};
+    }
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+void PushServer::run() {
+    std::vector<epoll_event> ready(256);
+    std::vector<PushEventPtr> events;
+    auto next_keepalive = std::chrono::steady_clock::now() + options_.keepalive;
+
+    while (!stopping_) {
+        int timeout_ms = static_cast<int>(std::min<std::chrono::milliseconds::rep>(options_.keepalive.count(), 1000));
+        int count = epoll_wait(epoll_fd_, ready.data(), static_cast<int>(ready.size()), timeout_ms);
+        if (count < 0 && errno != EINTR) {
+            log_error(LogCategory::Push, "⚠️ Push server epoll_wait failed", {{"error", std::strerror(errno)}});
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = ready[i].data.fd;
+            if (fd == listen_fd_) {
+                accept_connections();
+                continue;
+            }
+            if (fd == wake_fd_) {
+                uint64_t value;
+                [[maybe_unused]] auto got = read(wake_fd_, &value, sizeof(value));
+                {
+                    std::lock_guard<std::mutex> lock(outbox_mutex_);
+                    events.swap(outbox_);
+                }
+                if (!events.empty()) {
+                    fan_out(events);
+                    events.clear();
+                }
+                continue;
+            }
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            Connection& connection = *it->second;
+            if (ready[i].events & (EPOLLHUP | EPOLLERR)) {
+                close_connection(fd);
+                continue;
+            }
+            if (ready[i].events & EPOLLIN) {
+                read_request(connection);
+                if (!connections_.contains(fd)) {
+                    continue;
+                }
+            }
+            if ((ready[i].events & EPOLLOUT) && !flush(connection)) {
+                close_connection(fd);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_keepalive) {
+            fan_out({keepalive_event()});
+            next_keepalive = now + options_.keepalive;
+        }
+        check_stalled(now);
+    }
+}
+
+void PushServer::accept_connections() {
+    for (;;) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;  // EAGAIN once the backlog is empty; other errors are per-connection
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            continue;
+        }
+        auto connection = std::make_unique<Connection>(fd, options_.max_backlog);
+        connection->last_progress = std::chrono::steady_clock::now();
+        connections_.emplace(fd, std::move(connection));
+    }
+}
+
+void PushServer::read_request(Connection& connection) {
+    char buffer[2048];
+    for (;;) {
+        ssize_t n = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            close_connection(connection.fd);
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        // Subscribers have nothing more to say; whatever they send is ignored
+        if (!connection.streaming && !connection.close_after_flush) {
+            connection.request.append(buffer, static_cast<size_t>(n));
+        }
+    }
+    if (connection.streaming || connection.close_after_flush) {
+        return;
+    }
+
+    auto head_end = connection.request.find("\r\n\r\n");
+    if (head_end == std::string::npos) {
+        if (connection.request.size() > MAX_REQUEST_HEAD) {
+            close_connection(connection.fd);
+        }
+        return;
+    }
+
+    std::string_view line(connection.request.data(), connection.request.find("\r\n"));
+    auto method_end = line.find(' ');
+    auto method = line.substr(0, method_end);
+    auto target = method_end == std::string_view::npos ? std::string_view{} : line.substr(method_end + 1);
+    auto path = target.substr(0, std::min(target.find(' '), target.find('?')));
+
+    if (method == "GET" && path == "/events") {
+        if (subscribers() >= options_.max_subscribers) {
+            connection.close_after_flush = true;
+            connection.backlog.push(plain_response(503));
+        } else {
+            // Every stream opens with a resync: the client loads the current state, then
+            // applies the events that follow
+            connection.streaming = true;
+            connection.backlog.push(stream_head());
+            connection.backlog.push(resync_event());
+            subscribers_.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        connection.close_after_flush = true;
+        connection.backlog.push(plain_response(method == "OPTIONS" ? 204 : 404));
+    }
+    connection.request.clear();
+    connection.request.shrink_to_fit();
+    if (!flush(connection)) {
+        close_connection(connection.fd);
+    }
+}
+
+void PushServer::fan_out(const std::vector<PushEventPtr>& events) {
+    auto now = std::chrono::steady_clock::now();
+    uint64_t discarded = 0;
+    std::vector<int> finished;
+    for (auto& [fd, connection] : connections_) {
+        if (!connection->streaming) {
+            continue;
+        }
+        if (connection->backlog.empty()) {
+            connection->last_progress = now;  // The stall clock starts with the first unsent byte
+        }
+        for (const auto& event : events) {
+            discarded += connection->backlog.push(event);
+        }
+        // A subscriber already waiting for EPOLLOUT is flushed when the socket drains
+        if (!connection->want_write && !flush(*connection)) {
+            finished.push_back(fd);
+        }
+    }
+    for (int fd : finished) {
+        close_connection(fd);
+    }
+    if (discarded > 0) {
+        dropped_.fetch_add(discarded, std::memory_order_relaxed);
+    }
+}
+
+bool PushServer::flush(Connection& connection) {
+    iovec iov[MAX_IOV];
+    while (!connection.backlog.empty()) {
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = connection.backlog.gather(iov, MAX_IOV);
+        ssize_t n = sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                set_write_interest(connection, true);
+                return true;
+            }
+            return false;
+        }
+        connection.backlog.consume(static_cast<size_t>(n));
+        connection.last_progress = std::chrono::steady_clock::now();
+    }
+    set_write_interest(connection, false);
+    return !connection.close_after_flush;
+}
+
+void PushServer::set_write_interest(Connection& connection, bool enabled) {
+    if (connection.want_write == enabled) {
+        return;
+    }
+    connection.want_write = enabled;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (enabled ? EPOLLOUT : 0u);
+    ev.data.fd = connection.fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &ev);
+}
+
+void PushServer::close_connection(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    if (it->second->streaming) {
+        subscribers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(it);
+}
+
+void PushServer::check_stalled(std::chrono::steady_clock::time_point now) {
+    std::vector<int> stalled;
+    for (const auto& [fd, connection] : connections_) {
+        bool idle_request = !connection->streaming && !connection->close_after_flush;
+        // Half-sent requests and subscribers that stopped reading both hold a slot
+        if ((idle_request || !connection->backlog.empty()) && now - connection->last_progress > options_.stall_timeout) {
+            stalled.push_back(fd);
+        }
+    }
+    for (int fd : stalled) {
+        close_connection(fd);
+    }
+}
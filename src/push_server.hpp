@@ -0,0 +1,123 @@
+#pragma once
+#include <sys/uio.h>
+#include <ctime>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class ThreadSafeMediaQueue;
+
+// One published event, serialized once into a complete Server-Sent Events frame and
+// shared by every subscriber's backlog
+struct PushEvent {
+    std::string kind;
+    bool coalesce = false;  // A newer event of the same kind supersedes it (status-like state)
+    std::string frame;
+};
+using PushEventPtr = std::shared_ptr<const PushEvent>;
+
+// Events not yet written to one subscriber. A coalescing event replaces an unsent one of
+// the same kind; when the backlog is full the unsent events are dropped for a single
+// "resync" event, telling the client to re-read /status and /queue/changes?since=<version>.
+class PushBacklog {
+public:
+    explicit PushBacklog(size_t max_events) : max_events_(max_events < 2 ? 2 : max_events) {}
+
+    // Returns how many queued events it discarded to make room
+    size_t push(PushEventPtr event);
+    // Unwritten bytes, front first, for one writev
+    size_t gather(iovec* iov, size_t max) const;
+    void consume(size_t bytes);
+
+    bool empty() const { return events_.empty(); }
+    size_t size() const { return events_.size(); }
+
+private:
+    const size_t max_events_;
+    std::deque<PushEventPtr> events_;
+    size_t head_offset_ = 0;  // Bytes of the front event already written; it can no longer be dropped
+};
+
+// Push channel for dashboards: GET /events streams item, interrupt, queue and encoder events
+// as Server-Sent Events. It runs its own port on one epoll thread with non-blocking
+// sockets, so a thousand idle subscribers cost file descriptors rather than one HTTP
+// worker thread each.
+class PushServer {
+public:
+    struct Options {
+        size_t max_subscribers = 4096;
+        size_t max_backlog = 64;                    // Events per subscriber before it is resynced
+        std::chrono::milliseconds keepalive{15000};  // Comment frame so proxies keep idle streams open
+        std::chrono::milliseconds stall_timeout{30000};  // Close a subscriber that accepts no bytes for this long
+    };
+
+    PushServer();
+    explicit PushServer(Options options);
+    ~PushServer();
+
+    PushServer(const PushServer&) = delete;
+    PushServer& operator=(const PushServer&) = delete;
+
+    // Binds and starts the event loop; port 0 picks a free one. Returns the bound port;
+    // throws std::runtime_error when the socket cannot be set up.
+    int start(const std::string& host, int port);
+    void stop();
+
+    // Thread safe. data is one line of JSON. Dropped at once when nobody is subscribed.
+    void publish(std::string_view kind, std::string_view data, bool coalesce = false);
+    // Publishes the deltas of every queue change as "queue" events until stop()
+    void watch_queue(ThreadSafeMediaQueue& queue);
+
+    size_t subscribers() const { return subscribers_.load(std::memory_order_relaxed); }
+    uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }  // Coalesced or resynced away
+    std::chrono::nanoseconds loop_cpu_time() const;  // CPU used by the event loop thread so far
+
+private:
+    struct Connection {
+        explicit Connection(int fd, size_t max_backlog) : fd(fd), backlog(max_backlog) {}
+        int fd;
+        std::string request;  // Request head until it is complete
+        bool streaming = false;
+        bool close_after_flush = false;
+        bool want_write = false;
+        PushBacklog backlog;
+        std::chrono::steady_clock::time_point last_progress;
+    };
+
+    void run();
+    void accept_connections();
+    void read_request(Connection& connection);
+    void fan_out(const std::vector<PushEventPtr>& events);
+    bool flush(Connection& connection);  // False once the connection should be closed
+    void set_write_interest(Connection& connection, bool enabled);
+    void close_connection(int fd);
+    void check_stalled(std::chrono::steady_clock::time_point now);
+
+    const Options options_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;  // eventfd: events queued or stopping
+    std::atomic<bool> stopping_{false};
+
+    std::mutex outbox_mutex_;
+    std::vector<PushEventPtr> outbox_;
+    uint64_t next_id_ = 1;  // SSE id, under outbox_mutex_
+
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;  // Loop thread only
+    std::atomic<size_t> subscribers_{0};
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    std::thread loop_;
+    clockid_t loop_clock_{};
+    std::thread queue_watcher_;
+};
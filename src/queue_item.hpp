@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Priority classes, lowest to highest. Higher classes always play first.
+enum class PriorityClass : uint8_t {
+    Normal = 0,     // Regular rotation, shared fairly between submitters
+    Next = 1,       // Play next, never cuts the item on air
+    Interrupt = 2,  // Cut the item on air (per policy) unless it is a higher class
+    Breaking = 3,   // Preempts everything, including other priority content
+};
+
+constexpr size_t PRIORITY_CLASS_COUNT = 4;
+
+// Submitter used when a client does not identify itself
+constexpr const char* DEFAULT_SUBMITTER = "default";
+constexpr size_t MAX_SUBMITTER_LENGTH = 64;
+
+struct QueueItem {
+    std::string source;
+    PriorityClass priority = PriorityClass::Normal;
+    std::string submitter = DEFAULT_SUBMITTER;
+    double weight = 1.0;  // Relative play frequency in weighted-random rotation
+};
@@ -0,0 +1,462 @@
+#include "queue_journal.hpp"
+#include "runtime.hpp"
+#include "logger.hpp"
+#include "utils.hpp"
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[4] = {'M', 'C', 'Q', 'S'};
+// 1: sources only, 2: priority class byte per item, 3: submitter per item, 4: weight per item
+constexpr uint32_t SNAPSHOT_FORMAT = 4;
+
+// Set on an encoded item's class byte when a non-default weight follows the submitter
+constexpr uint8_t ITEM_HAS_WEIGHT = 0x80;
+
+// FNV-1a, enough to detect torn or partially written records
+uint32_t checksum(const char* data, size_t len, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool get(std::string_view in, size_t& pos, T& value) {
+    if (in.size() - pos < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, in.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = ::write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        len -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+int sync_fd(int fd) {
+#if defined(__APPLE__)
+    return ::fsync(fd);
+#else
+    return ::fdatasync(fd);
+#endif
+}
+
+void apply(PriorityScheduler& scheduler, QueueOp op, std::string payload) {
+    QueueItem item;
+    switch (op) {
+        case QueueOp::PushBack:
+            scheduler.push_back({std::move(payload), PriorityClass::Normal});
+            break;
+        case QueueOp::PushFront:
+            scheduler.push_front({std::move(payload), PriorityClass::Normal});
+            break;
+        case QueueOp::PopFront:
+            // Pops name their lane and submitter so replay does not depend on fairness state
+            if (payload.empty()) {
+                scheduler.pop(item);
+            } else if (QueueItem origin; QueueJournal::decode_item(payload, origin)) {
+                scheduler.pop_from(origin.priority, origin.submitter, item);
+            }
+            break;
+        case QueueOp::Clear:
+            scheduler.clear();
+            break;
+        case QueueOp::Enqueue:
+            if (!payload.empty() && static_cast<uint8_t>(payload[0]) < PRIORITY_CLASS_COUNT) {
+                scheduler.push_back({payload.substr(1), static_cast<PriorityClass>(payload[0])});
+            }
+            break;
+        case QueueOp::Insert:
+            if (QueueJournal::decode_item(payload, item)) {
+                scheduler.push_back(std::move(item));
+            }
+            break;
+        case QueueOp::InsertFront:
+            if (QueueJournal::decode_item(payload, item)) {
+                scheduler.push_front(std::move(item));
+            }
+            break;
+        case QueueOp::Advance:
+            if (QueueItem origin; payload.size() > 1 && QueueJournal::decode_item(payload.substr(1), origin)) {
+                scheduler.advance_from(origin.priority, origin.submitter, payload[0] != 0, item);
+            }
+            break;
+        case QueueOp::Remove:
+            if (QueueJournal::decode_item(payload, item)) {
+                scheduler.remove_played(item);
+            }
+            break;
+        case QueueOp::InsertBatch:
+            if (std::vector<QueueItem> batch; QueueJournal::decode_batch(payload, batch)) {
+                for (auto& entry : batch) {
+                    scheduler.push_back(std::move(entry));
+                }
+            }
+            break;
+    }
+}
+
+} // namespace
+
+std::string QueueJournal::encode_item(const QueueItem& item) {
+    std::string out;
+    bool weighted = item.weight != 1.0;
+    out.reserve(sizeof(uint8_t) + sizeof(uint16_t) + item.submitter.size() + sizeof(double) + item.source.size());
+    put(out, static_cast<uint8_t>(static_cast<uint8_t>(item.priority) | (weighted ? ITEM_HAS_WEIGHT : 0)));
+    put(out, static_cast<uint16_t>(item.submitter.size()));
+    out.append(item.submitter);
+    if (weighted) {
+        put(out, item.weight);
+    }
+    out.append(item.source);
+    return out;
+}
+
+bool QueueJournal::decode_item(const std::string& payload, QueueItem& item) {
+    size_t pos = 0;
+    uint8_t priority = 0;
+    uint16_t submitter_len = 0;
+    if (!get(payload, pos, priority) || (priority & ~ITEM_HAS_WEIGHT) >= PRIORITY_CLASS_COUNT ||
+        !get(payload, pos, submitter_len) || payload.size() - pos < submitter_len) {
+        return false;
+    }
+    item.priority = static_cast<PriorityClass>(priority & ~ITEM_HAS_WEIGHT);
+    item.submitter.assign(payload, pos, submitter_len);
+    pos += submitter_len;
+    item.weight = 1.0;
+    if ((priority & ITEM_HAS_WEIGHT) && !get(payload, pos, item.weight)) {
+        return false;
+    }
+    item.source.assign(payload, pos);
+    return true;
+}
+
+std::string QueueJournal::encode_batch(const std::vector<QueueItem>& items) {
+    std::string out;
+    put(out, static_cast<uint32_t>(items.size()));
+    for (const auto& item : items) {
+        std::string encoded = encode_item(item);
+        put(out, static_cast<uint32_t>(encoded.size()));
+        out.append(encoded);
+    }
+    return out;
+}
+
+bool QueueJournal::decode_batch(const std::string& payload, std::vector<QueueItem>& items) {
+    size_t pos = 0;
+    uint32_t count = 0;
+    if (!get(payload, pos, count)) {
+        return false;
+    }
+    items.clear();
+    items.reserve(std::min<size_t>(count, payload.size()));
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t len = 0;
+        QueueItem item;
+        if (!get(payload, pos, len) || payload.size() - pos < len ||
+            !decode_item(payload.substr(pos, len), item)) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        pos += len;
+    }
+    return true;
+}
+
+QueueJournal::QueueJournal(const std::string& dir, QueueJournalOptions options)
+    : dir_(dir), options_(options) {
+    std::filesystem::create_directories(dir_);
+    journal_path_ = (std::filesystem::path(dir_) / "queue.journal").string();
+    snapshot_path_ = (std::filesystem::path(dir_) / "queue.snapshot").string();
+
+    fd_ = ::open(journal_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open queue journal " + journal_path_ + ": " + std::strerror(errno));
+    }
+}
+
+QueueJournal::~QueueJournal() {
+    if (queue_) {
+        queue_->attach_journal(nullptr);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    flush_cv_.notify_all();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool QueueJournal::load_snapshot(std::vector<QueueItem>& items, uint64_t& version) const {
+    MappedFile file(snapshot_path_);
+    std::string_view data = file.data();
+    if (file.empty()) {
+        return false;
+    }
+    if (data.size() < sizeof(SNAPSHOT_MAGIC) + sizeof(uint32_t) ||
+        std::memcmp(data.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        log_warn(LogCategory::Queue, "⚠️ Ignoring queue snapshot with bad header", {{"path", snapshot_path_}});
+        return false;
+    }
+
+    size_t body_end = data.size() - sizeof(uint32_t);
+    uint32_t stored_checksum = 0;
+    std::memcpy(&stored_checksum, data.data() + body_end, sizeof(uint32_t));
+    if (checksum(data.data() + sizeof(SNAPSHOT_MAGIC), body_end - sizeof(SNAPSHOT_MAGIC)) != stored_checksum) {
+        log_warn(LogCategory::Queue, "⚠️ Ignoring corrupt queue snapshot", {{"path", snapshot_path_}});
+        return false;
+    }
+    data = data.substr(0, body_end);
+
+    size_t pos = sizeof(SNAPSHOT_MAGIC);
+    uint32_t format = 0;
+    uint64_t count = 0;
+    if (!get(data, pos, format) || format < 1 || format > SNAPSHOT_FORMAT ||
+        !get(data, pos, version) || !get(data, pos, count)) {
+        return false;
+    }
+
+    items.clear();
+    items.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; ++i) {
+        uint8_t priority = 0;
+        uint16_t submitter_len = 0;
+        uint32_t len = 0;
+        if ((format >= 2 && !get(data, pos, priority)) || priority >= PRIORITY_CLASS_COUNT) {
+            return false;
+        }
+        std::string submitter = DEFAULT_SUBMITTER;
+        if (format >= 3) {
+            if (!get(data, pos, submitter_len) || data.size() - pos < submitter_len) {
+                return false;
+            }
+            submitter.assign(data.substr(pos, submitter_len));
+            pos += submitter_len;
+        }
+        double weight = 1.0;
+        if ((format >= 4 && !get(data, pos, weight)) || !get(data, pos, len) || data.size() - pos < len) {
+            return false;
+        }
+        items.push_back({std::string(data.data() + pos, len), static_cast<PriorityClass>(priority),
+                         std::move(submitter), weight});
+        pos += len;
+    }
+    return true;
+}
+
+QueueRecoveryStats QueueJournal::open(ThreadSafeMediaQueue& queue) {
+    auto start = std::chrono::steady_clock::now();
+    QueueRecoveryStats stats;
+
+    std::vector<QueueItem> snapshot_items;
+    uint64_t version = 0;
+    if (load_snapshot(snapshot_items, version)) {
+        stats.snapshot_items = snapshot_items.size();
+    } else {
+        snapshot_items.clear();
+        version = 0;
+    }
+    PriorityScheduler items;
+    items.assign(std::move(snapshot_items));
+
+    // Replay journal records newer than the snapshot, stopping at the first torn record
+    auto journal = std::make_unique<MappedFile>(journal_path_);
+    std::string_view data = journal->data();
+    size_t pos = 0;
+    size_t valid_end = 0;
+    size_t journal_records = 0;
+    while (pos < data.size()) {
+        size_t record_start = pos;
+        uint32_t len = 0;
+        uint8_t op = 0;
+        uint64_t record_version = 0;
+        uint32_t stored_checksum = 0;
+        if (!get(data, pos, len) || !get(data, pos, op) || !get(data, pos, record_version) ||
+            data.size() - pos < static_cast<size_t>(len) + sizeof(uint32_t)) {
+            break;
+        }
+        size_t payload_pos = pos;
+        pos += len;
+        get(data, pos, stored_checksum);
+        size_t checked_len = sizeof(uint8_t) + sizeof(uint64_t) + len;
+        if (checksum(data.data() + record_start + sizeof(uint32_t), checked_len) != stored_checksum) {
+            break;
+        }
+
+        if (record_version > version) {
+            apply(items, static_cast<QueueOp>(op), std::string(data.data() + payload_pos, len));
+            version = record_version;
+            ++stats.replayed_records;
+        }
+        ++journal_records;
+        valid_end = pos;
+    }
+    size_t journal_size = data.size();
+    journal.reset();  // Unmapped before the file can shrink
+    if (valid_end < journal_size) {
+        log_warn(LogCategory::Queue, "⚠️ Discarding torn queue journal tail", {{"bytes", journal_size - valid_end}});
+        if (::ftruncate(fd_, static_cast<off_t>(valid_end)) != 0) {
+            log_error(LogCategory::Queue, "❌ Failed to truncate queue journal", {{"error", std::strerror(errno)}});
+        }
+    }
+    records_since_compact_ = journal_records;
+
+    stats.items = items.size();
+    stats.version = version;
+    queue.restore(items.flatten(), version);
+
+    queue_ = &queue;
+    flusher_ = std::thread([this]() {
+        enter_thread_role(ThreadRole::Background, "journal");
+        flusher_loop();
+    });
+    queue.attach_journal(this);
+
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+void QueueJournal::append(QueueOp op, const std::string& item, uint64_t version) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t record_start = pending_.size();
+    put(pending_, static_cast<uint32_t>(item.size()));
+    put(pending_, static_cast<uint8_t>(op));
+    put(pending_, version);
+    pending_.append(item);
+    size_t checked_start = record_start + sizeof(uint32_t);
+    put(pending_, checksum(pending_.data() + checked_start, pending_.size() - checked_start));
+    ++appended_records_;
+
+    if (pending_.size() >= options_.max_batch_bytes) {
+        flush_cv_.notify_one();
+    }
+}
+
+void QueueJournal::sync() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = appended_records_;
+    if (durable_records_ >= target || !flusher_.joinable()) {
+        return;
+    }
+    ++sync_waiters_;
+    flush_cv_.notify_one();
+    durable_cv_.wait(lock, [this, target]() { return durable_records_ >= target; });
+    --sync_waiters_;
+}
+
+void QueueJournal::flusher_loop() {
+    std::string batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        flush_cv_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            break;  // Stopping with nothing left to write
+        }
+
+        // Group commit: let concurrent mutations join this batch before paying for fsync
+        flush_cv_.wait_for(lock, options_.flush_interval, [this]() {
+            return stopping_ || sync_waiters_ > 0 || pending_.size() >= options_.max_batch_bytes;
+        });
+
+        batch.swap(pending_);
+        uint64_t batch_end = appended_records_;
+        size_t batch_records = static_cast<size_t>(batch_end - durable_records_);
+        lock.unlock();
+
+        write_batch(batch);
+        batch.clear();
+        records_since_compact_ += batch_records;
+        if (records_since_compact_ >= options_.compact_after_records) {
+            compact();
+        }
+
+        lock.lock();
+        durable_records_ = batch_end;
+        durable_cv_.notify_all();
+    }
+}
+
+void QueueJournal::write_batch(const std::string& batch) {
+    if (!write_all(fd_, batch.data(), batch.size())) {
+        log_error(LogCategory::Queue, "❌ Queue journal write failed", {{"error", std::strerror(errno)}});
+        return;
+    }
+    if (sync_fd(fd_) != 0) {
+        log_error(LogCategory::Queue, "❌ Queue journal fsync failed", {{"error", std::strerror(errno)}});
+    }
+}
+
+void QueueJournal::compact() {
+    // Every record written so far is covered by this snapshot; newer ones are still pending
+    auto snapshot = queue_->snapshot();
+
+    std::string out(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    put(out, SNAPSHOT_FORMAT);
+    put(out, snapshot->version);
+    put(out, static_cast<uint64_t>(snapshot->items.size()));
+    for (const auto& item : snapshot->items) {
+        put(out, static_cast<uint8_t>(item.priority));
+        put(out, static_cast<uint16_t>(item.submitter.size()));
+        out.append(item.submitter);
+        put(out, item.weight);
+        put(out, static_cast<uint32_t>(item.source.size()));
+        out.append(item.source);
+    }
+    put(out, checksum(out.data() + sizeof(SNAPSHOT_MAGIC), out.size() - sizeof(SNAPSHOT_MAGIC)));
+
+    std::string tmp_path = snapshot_path_ + ".tmp";
+    int snapshot_fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (snapshot_fd < 0) {
+        log_error(LogCategory::Queue, "❌ Cannot write queue snapshot", {{"error", std::strerror(errno)}});
+        return;
+    }
+    bool ok = write_all(snapshot_fd, out.data(), out.size()) && ::fsync(snapshot_fd) == 0;
+    ::close(snapshot_fd);
+    if (!ok || std::rename(tmp_path.c_str(), snapshot_path_.c_str()) != 0) {
+        log_error(LogCategory::Queue, "❌ Failed to publish queue snapshot", {{"error", std::strerror(errno)}});
+        return;
+    }
+
+    // Make the rename durable before dropping the journal it replaces
+    int dir_fd = ::open(dir_.c_str(), O_RDONLY);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+
+    if (::ftruncate(fd_, 0) != 0) {
+        log_error(LogCategory::Queue, "❌ Failed to truncate queue journal", {{"error", std::strerror(errno)}});
+        return;
+    }
+    records_since_compact_ = 0;
+}
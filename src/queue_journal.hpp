@@ -0,0 +1,78 @@
+#pragma once
+#include "media_queue.hpp"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+// Tuning for group commit and compaction
+struct QueueJournalOptions {
+    std::chrono::milliseconds flush_interval{5};  // Group commit window before fsync
+    size_t max_batch_bytes = 64 * 1024;           // Flush early once this much is pending
+    size_t compact_after_records = 10000;         // Write a fresh snapshot after this many records
+};
+
+// Result of loading persisted state at startup
+struct QueueRecoveryStats {
+    size_t items = 0;             // Items restored into the queue
+    size_t snapshot_items = 0;    // Items loaded from the compacted snapshot
+    size_t replayed_records = 0;  // Journal records applied on top of the snapshot
+    uint64_t version = 0;         // Queue version after recovery
+    double elapsed_ms = 0.0;
+};
+
+// Append-only write-ahead log of queue mutations with periodic compacted snapshots.
+// Records are buffered in memory and written + fsynced by a background thread in batches.
+class QueueJournal {
+private:
+    std::string dir_;
+    std::string journal_path_;
+    std::string snapshot_path_;
+    QueueJournalOptions options_;
+    ThreadSafeMediaQueue* queue_ = nullptr;
+    int fd_ = -1;
+
+    std::mutex mutex_;
+    std::condition_variable flush_cv_;
+    std::condition_variable durable_cv_;
+    std::string pending_;            // Encoded records waiting for the next group commit
+    uint64_t appended_records_ = 0;  // Total records handed to append()
+    uint64_t durable_records_ = 0;   // Total records written and fsynced
+    size_t records_since_compact_ = 0;  // Owned by the flusher thread once open() returns
+    int sync_waiters_ = 0;
+    bool stopping_ = false;
+    std::thread flusher_;
+
+    void flusher_loop();
+    void write_batch(const std::string& batch);
+    void compact();
+    bool load_snapshot(std::vector<QueueItem>& items, uint64_t& version) const;
+
+public:
+    explicit QueueJournal(const std::string& dir, QueueJournalOptions options = QueueJournalOptions());
+    ~QueueJournal();
+
+    QueueJournal(const QueueJournal&) = delete;
+    QueueJournal& operator=(const QueueJournal&) = delete;
+
+    // Load snapshot + journal into the queue, then start journaling its mutations
+    QueueRecoveryStats open(ThreadSafeMediaQueue& queue);
+
+    // Called by the queue under its lock; only buffers the record
+    void append(QueueOp op, const std::string& item, uint64_t version);
+
+    // Block until every record appended so far is on disk
+    void sync();
+
+    const std::string& directory() const { return dir_; }
+
+    // Record payload for Insert/InsertFront/PopFront: [u8 class][u16 submitter len][submitter][source]
+    static std::string encode_item(const QueueItem& item);
+    static bool decode_item(const std::string& payload, QueueItem& item);
+    // Record payload for InsertBatch: [u32 count] then [u32 len][encoded item] per item
+    static std::string encode_batch(const std::vector<QueueItem>& items);
+    static bool decode_batch(const std::string& payload, std::vector<QueueItem>& items);
+};
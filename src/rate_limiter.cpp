@@ -0,0 +1,168 @@
+#include "rate_limiter.hpp"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <functional>
+
+namespace {
+
+constexpr const char* RATE_CLASS_NAMES[RATE_CLASS_COUNT] = {"read", "write", "priority", "mcp"};
+
+int64_t nanoseconds(TokenBucket::Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+bool parse_positive(std::string_view text, double& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc{} && result.ptr == text.data() + text.size() && value > 0;
+}
+
+}  // namespace
+
+const char* rate_class_name(RateClass cls) {
+    return RATE_CLASS_NAMES[static_cast<size_t>(cls)];
+}
+
+std::optional<RateClass> parse_rate_class(std::string_view name) {
+    for (size_t i = 0; i < RATE_CLASS_COUNT; ++i) {
+        if (name == RATE_CLASS_NAMES[i]) {
+            return static_cast<RateClass>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+RateLimits default_rate_limits() {
+    RateLimits limits{};
+    limits[static_cast<size_t>(RateClass::Write)] = {20.0, 40.0};
+    limits[static_cast<size_t>(RateClass::Priority)] = {0.2, 3.0};  // A burst of 3 cuts, then one per 5 s
+    limits[static_cast<size_t>(RateClass::Mcp)] = {20.0, 40.0};
+    return limits;
+}
+
+bool parse_rate_limits(std::string_view spec, RateLimits& limits) {
+    if (spec == "off") {
+        limits = RateLimits{};
+        return true;
+    }
+    bool valid = true;
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        std::string_view entry = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view{} : spec.substr(comma + 1);
+
+        size_t equals = entry.find('=');
+        auto cls = parse_rate_class(entry.substr(0, equals));
+        if (equals == std::string_view::npos || !cls) {
+            valid = false;
+            continue;
+        }
+        std::string_view value = entry.substr(equals + 1);
+        RateLimit limit;
+        if (value != "off") {
+            size_t slash = value.find('/');
+            if (!parse_positive(value.substr(0, slash), limit.rate)) {
+                valid = false;
+                continue;
+            }
+            limit.burst = std::max(1.0, limit.rate);  // One second's worth by default
+            if (slash != std::string_view::npos && !parse_positive(value.substr(slash + 1), limit.burst)) {
+                valid = false;
+                continue;
+            }
+        }
+        limits[static_cast<size_t>(*cls)] = limit;
+    }
+    return valid;
+}
+
+std::chrono::nanoseconds TokenBucket::try_acquire(const RateLimit& limit, Clock::time_point now) {
+    if (limit.rate <= 0) {
+        return std::chrono::nanoseconds::zero();
+    }
+    const auto interval = static_cast<int64_t>(1e9 / limit.rate);  // Per token
+    const auto capacity = static_cast<int64_t>(static_cast<double>(interval) * std::max(limit.burst, 1.0));
+    const int64_t now_ns = nanoseconds(now);
+    int64_t full_at = full_at_.load(std::memory_order_relaxed);
+    while (true) {
+        int64_t next = std::max(full_at, now_ns) + interval;
+        if (next - now_ns > capacity) {
+            return std::chrono::nanoseconds(next - now_ns - capacity);
+        }
+        if (full_at_.compare_exchange_weak(full_at, next, std::memory_order_relaxed)) {
+            return std::chrono::nanoseconds::zero();
+        }
+    }
+}
+
+bool TokenBucket::full(Clock::time_point now) const {
+    return full_at_.load(std::memory_order_relaxed) <= nanoseconds(now);
+}
+
+RateLimiter::RateLimiter(const RateLimits& limits, size_t slots)
+    : limits_(limits),
+      mask_(std::bit_ceil(std::max<size_t>(slots, MAX_PROBES)) - 1),
+      slots_(std::make_unique<Slot[]>(mask_ + 1)) {}
+
+RateLimiter::Decision RateLimiter::admit(std::string_view client, RateClass cls, Clock::time_point now) {
+    const RateLimit& limit = limits_[static_cast<size_t>(cls)];
+    if (limit.rate <= 0) {
+        return {};
+    }
+    auto charge = [&](TokenBucket& bucket) {
+        auto wait = bucket.try_acquire(limit, now);
+        return Decision{wait == std::chrono::nanoseconds::zero(), wait};
+    };
+
+    // Fibonacci mix of the class into the client hash; 0 marks an unused slot
+    uint64_t key = std::hash<std::string_view>{}(client) ^ ((static_cast<uint64_t>(cls) + 1) * 0x9E3779B97F4A7C15ull);
+    key = key ? key : 1;
+    Slot* idle = nullptr;
+    for (size_t i = 0; i < MAX_PROBES; ++i) {
+        Slot& slot = slots_[(key + i) & mask_];
+        uint64_t owner = slot.key.load(std::memory_order_acquire);
+        if (owner == 0 && slot.key.compare_exchange_strong(owner, key, std::memory_order_acq_rel)) {
+            return charge(slot.bucket);
+        }
+        if (owner == key) {
+            return charge(slot.bucket);
+        }
+        if (!idle && slot.bucket.full(now)) {
+            idle = &slot;
+        }
+    }
+    // A full bucket carries no state, so its slot can change hands; losing that race only
+    // means two clients briefly share one bucket
+    if (idle) {
+        uint64_t owner = idle->key.load(std::memory_order_acquire);
+        if (owner == key || idle->key.compare_exchange_strong(owner, key, std::memory_order_acq_rel)) {
+            return charge(idle->bucket);
+        }
+    }
+    return charge(overflow_[static_cast<size_t>(cls)]);
+}
+
+bool AdmissionGate::try_enter() {
+    if (in_flight_.fetch_add(1, std::memory_order_acquire) >= limit_) {
+        in_flight_.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+void AdmissionGate::leave() {
+    in_flight_.fetch_sub(1, std::memory_order_release);
+}
+
+AdmissionGate* AdmissionGates::gate(RateClass cls) {
+    switch (cls) {
+    case RateClass::Read:
+        return nullptr;
+    case RateClass::Mcp:
+        return &mcp_;
+    case RateClass::Write:
+    case RateClass::Priority:
+        break;
+    }
+    return &shared_;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+// Admission control for the HTTP API. Every request that costs something is charged to a
+// token bucket per client credential and request class before its handler runs, and the
+// expensive classes also need a free slot under a global in-flight limit; a request that
+// gets neither is answered 429 without touching the queue or the encoder.
+
+enum class RateClass { Read, Write, Priority, Mcp };  // Priority: anything that may cut the item on air
+inline constexpr size_t RATE_CLASS_COUNT = 4;
+
+const char* rate_class_name(RateClass cls);
+std::optional<RateClass> parse_rate_class(std::string_view name);
+
+struct RateLimit {
+    double rate = 0.0;   // Tokens per second; 0 turns the limit off
+    double burst = 1.0;  // Tokens a client may spend at once after being idle
+};
+using RateLimits = std::array<RateLimit, RATE_CLASS_COUNT>;
+
+// write=20/40, priority=0.2/3, mcp=20/40; reads are cheap (cached, 304s) and unlimited
+RateLimits default_rate_limits();
+
+// Applies "write=20/40,priority=0.2/3,read=off" (rate per second / burst) over limits;
+// "off" alone turns every limit off. Returns false when an entry was invalid; the valid
+// ones are still applied.
+bool parse_rate_limits(std::string_view spec, RateLimits& limits);
+
+// A token bucket kept as one atomic word, the time at which it would be full again
+// (GCRA). Taking a token is a load and a compare-exchange; there is no lock and no refill
+// thread.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Zero when a token was taken, otherwise how long until one is available
+    std::chrono::nanoseconds try_acquire(const RateLimit& limit, Clock::time_point now);
+    bool full(Clock::time_point now) const;  // Idle long enough to have refilled
+
+private:
+    std::atomic<int64_t> full_at_{0};  // Nanoseconds on Clock
+};
+
+// Buckets per (client, class) in a fixed open-addressing table. Clients are identified by
+// a hash only, so credentials are never stored. A lookup probes a few slots and claims an
+// empty one, or one whose bucket is full again (its client has been idle), with a
+// compare-exchange; when all of them are busy the request is charged to a bucket shared by
+// the overflow, which errs on the side of limiting.
+class RateLimiter {
+public:
+    using Clock = TokenBucket::Clock;
+
+    struct Decision {
+        bool admitted = true;
+        std::chrono::nanoseconds retry_after{0};
+    };
+
+    explicit RateLimiter(const RateLimits& limits = default_rate_limits(), size_t slots = 1024);
+
+    Decision admit(std::string_view client, RateClass cls, Clock::time_point now = Clock::now());
+    const RateLimit& limit(RateClass cls) const { return limits_[static_cast<size_t>(cls)]; }
+
+private:
+    static constexpr size_t MAX_PROBES = 8;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> key{0};  // 0: never used
+        TokenBucket bucket;
+    };
+
+    const RateLimits limits_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::array<TokenBucket, RATE_CLASS_COUNT> overflow_;
+};
+
+// Bounds requests in flight across all clients
+class AdmissionGate {
+public:
+    explicit AdmissionGate(size_t limit) : limit_(limit) {}
+
+    bool try_enter();
+    void leave();
+    size_t in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+    size_t limit() const { return limit_; }
+
+private:
+    const size_t limit_;
+    std::atomic<size_t> in_flight_{0};
+};
+
+// In-flight slots by class. MCP calls have a gate of their own, so a run of slow tools/call
+// requests cannot take the slots queue writes and priority cuts need; reads are not gated.
+class AdmissionGates {
+public:
+    AdmissionGates(size_t limit, size_t mcp_limit) : shared_(limit), mcp_(mcp_limit) {}
+
+    // The gate a class is charged to; null for reads
+    AdmissionGate* gate(RateClass cls);
+    const AdmissionGate& shared() const { return shared_; }
+    const AdmissionGate& mcp() const { return mcp_; }
+
+private:
+    AdmissionGate shared_;  // Write and priority
+    AdmissionGate mcp_;
+};
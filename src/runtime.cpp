@@ -0,0 +1,179 @@
+#include "runtime.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* THREAD_ROLE_NAMES[] = {"playout", "http", "background"};
+constexpr size_t MAX_THREAD_NAME = 15;  // Without the terminator
+constexpr int MAX_CPU = CPU_SETSIZE - 1;
+
+// Affinity of the process before any thread was pinned; read during static initialization
+const std::optional<cpu_set_t> process_cpus = []() -> std::optional<cpu_set_t> {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return std::nullopt;
+    }
+    return set;
+}();
+
+bool parse_cpu(std::string_view text, int& cpu) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), cpu);
+    return result.ec == std::errc{} && result.ptr == text.data() + text.size() && cpu >= 0 && cpu <= MAX_CPU;
+}
+
+}  // namespace
+
+bool parse_cpu_set(std::string_view text, CpuSet& cpus) {
+    CpuSet parsed;
+    while (!text.empty()) {
+        size_t plus = text.find('+');
+        std::string_view range = text.substr(0, plus);
+        text = plus == std::string_view::npos ? std::string_view{} : text.substr(plus + 1);
+        size_t dash = range.find('-');
+        int first = 0;
+        int last = 0;
+        if (!parse_cpu(range.substr(0, dash), first) ||
+            !parse_cpu(dash == std::string_view::npos ? range : range.substr(dash + 1), last) || last < first) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            parsed.push_back(cpu);
+        }
+    }
+    if (parsed.empty()) {
+        return false;
+    }
+    std::sort(parsed.begin(), parsed.end());
+    parsed.erase(std::unique(parsed.begin(), parsed.end()), parsed.end());
+    cpus = std::move(parsed);
+    return true;
+}
+
+const char* thread_role_name(ThreadRole role) {
+    return THREAD_ROLE_NAMES[static_cast<size_t>(role)];
+}
+
+std::optional<ThreadRole> parse_thread_role(std::string_view name) {
+    for (size_t i = 0; i < THREAD_ROLE_COUNT; ++i) {
+        if (name == THREAD_ROLE_NAMES[i]) {
+            return static_cast<ThreadRole>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+std::string format_cpu_set(const CpuSet& cpus) {
+    std::string text;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t last = i;
+        while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1) {
+            ++last;
+        }
+        text += (text.empty() ? "" : "+") + std::to_string(cpus[i]);
+        if (last > i) {
+            text += '-' + std::to_string(cpus[last]);
+        }
+        i = last + 1;
+    }
+    return text;
+}
+
+bool parse_role_cpus(std::string_view spec, RoleCpus& cpus) {
+    bool valid = true;
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        std::string_view entry = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view{} : spec.substr(comma + 1);
+
+        size_t equals = entry.find('=');
+        auto role = parse_thread_role(entry.substr(0, equals));
+        if (equals == std::string_view::npos || !role ||
+            !parse_cpu_set(entry.substr(equals + 1), cpus[static_cast<size_t>(*role)])) {
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+const CpuSet& role_cpus(ThreadRole role) {
+    // No logging here: the logger's own thread comes through this. main reports a bad spec.
+    static const RoleCpus cpus = [] {
+        RoleCpus parsed{};
+        if (const char* spec = std::getenv("MYCHANNEL_THREAD_CPUS")) {
+            parse_role_cpus(spec, parsed);
+        }
+        return parsed;
+    }();
+    return cpus[static_cast<size_t>(role)];
+}
+
+const CpuSet& process_cpu_set() {
+    static const CpuSet cpus = [] {
+        CpuSet set;
+        if (process_cpus) {
+            for (int cpu = 0; cpu <= MAX_CPU; ++cpu) {
+                if (CPU_ISSET(cpu, &*process_cpus)) {
+                    set.push_back(cpu);
+                }
+            }
+        }
+        return set;
+    }();
+    return cpus;
+}
+
+bool pin_current_thread(const CpuSet& cpus) {
+    if (cpus.empty()) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void enter_thread_role(ThreadRole role, std::string_view name) {
+    std::string truncated(name.substr(0, MAX_THREAD_NAME));
+    pthread_setname_np(pthread_self(), truncated.c_str());
+    if (!pin_current_thread(role_cpus(role)) && process_cpus) {
+        pthread_setaffinity_np(pthread_self(), sizeof(*process_cpus), &*process_cpus);
+    }
+}
+
+std::optional<double> process_uptime_seconds() {
+    std::ifstream stat("/proc/self/stat");
+    std::string line;
+    if (!std::getline(stat, line)) {
+        return std::nullopt;
+    }
+    // The command name in parentheses may contain spaces: fields are counted after it.
+    // starttime is field 22, in clock ticks since boot.
+    size_t paren = line.rfind(')');
+    if (paren == std::string::npos) {
+        return std::nullopt;
+    }
+    std::istringstream fields(line.substr(paren + 2));
+    std::string field;
+    for (int i = 3; i < 22 && fields >> field; ++i) {
+    }
+    unsigned long long start_ticks = 0;
+    timespec now{};
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    if (!(fields >> start_ticks) || ticks_per_second <= 0 || clock_gettime(CLOCK_BOOTTIME, &now) != 0) {
+        return std::nullopt;
+    }
+    double since_boot = static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) / 1e9;
+    return since_boot - static_cast<double>(start_ticks) / static_cast<double>(ticks_per_second);
+}
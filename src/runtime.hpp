@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Every long-lived thread belongs to a role. Each thread has a name (top -H, gdb,
+// /proc/<pid>/task/*/comm) and can be kept on its role's CPUs, so the playout loop and
+// encoder supervision do not compete with HTTP bursts or probes for the same cores.
+
+enum class ThreadRole {
+    Playout,     // Playout loop, encoder supervision, event scheduler
+    Http,        // REST/MCP workers and listener, push channel
+    Background,  // Probes, validation, journal, logger
+};
+inline constexpr size_t THREAD_ROLE_COUNT = 3;
+
+const char* thread_role_name(ThreadRole role);
+std::optional<ThreadRole> parse_thread_role(std::string_view name);
+
+using CpuSet = std::vector<int>;  // Sorted CPU numbers; empty: wherever the kernel schedules
+using RoleCpus = std::array<CpuSet, THREAD_ROLE_COUNT>;
+
+// "3", "0-3" or "0-3+6"; false for anything else
+bool parse_cpu_set(std::string_view text, CpuSet& cpus);
+std::string format_cpu_set(const CpuSet& cpus);
+
+// CPUs the process was allowed when it started, before any thread was pinned
+const CpuSet& process_cpu_set();
+
+// Applies "playout=0,http=1-2,background=2+3" (a CPU set per role) over cpus. Returns
+// false when an entry was invalid; the valid ones are still applied.
+bool parse_role_cpus(std::string_view spec, RoleCpus& cpus);
+
+// CPUs of a role, from MYCHANNEL_THREAD_CPUS (read once, invalid entries ignored)
+const CpuSet& role_cpus(ThreadRole role);
+
+// Names the calling thread (the kernel keeps 15 characters) and pins it to its role's
+// CPUs. A role without CPUs gets the process's CPUs back, since a new thread inherits the
+// placement of the one that started it. Called first thing by every thread the server starts.
+void enter_thread_role(ThreadRole role, std::string_view name);
+
+// Seconds since the kernel started this process (from /proc/self/stat), so time spent
+// before main, loading the binary and its libraries, is included; nothing without /proc
+std::optional<double> process_uptime_seconds();
+
+// Pins the calling thread; false when the set is empty or the kernel refused it (CPUs
+// outside the process's cgroup or affinity)
+bool pin_current_thread(const CpuSet& cpus);
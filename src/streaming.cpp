@@ -1,7 +1,9 @@
 #include "streaming.hpp"
 #include "streaming_config.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "tool_executor.hpp"
 #include "utils.hpp"
-#include <iostream>
 #include <future>
 #include <sstream>
 #include <signal.h>
@@ -10,210 +12,541 @@
 #include <thread>
 #include <chrono>
 #include <sys/select.h>
+#include <poll.h>
+#include <cerrno>
+#include <cmath>
+#include <charconv>
 #include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// The encoder forces a keyframe every SEGMENT_SECONDS of output time
+double next_segment_boundary(double out_time_seconds) {
+    return (std::floor(out_time_seconds / StreamingConfig::SEGMENT_SECONDS) + 1) * StreamingConfig::SEGMENT_SECONDS;
+}
+
+}  // namespace
 
 // Global stream process manager
 std::shared_ptr<StreamProcess> g_stream_process = std::make_shared<StreamProcess>();
 
-StreamProcess::StreamProcess() : current_pid_(0), should_terminate_(false) {}
+StreamProcess::StreamProcess()
+    : current_pid_(0), should_terminate_(false), segment_interrupt_pending_(false),
+      on_air_priority_(PriorityClass::Normal),
+      interrupt_cooldown_(std::chrono::steady_clock::duration(DEFAULT_INTERRUPT_COOLDOWN).count()) {}
 
 void StreamProcess::set_current_pid(pid_t pid) {
     current_pid_.store(pid);
 }
 
 void StreamProcess::request_termination() {
+    note_interrupt_requested();
     should_terminate_.store(true);
 }
 
+void StreamProcess::note_interrupt_requested() {
+    std::chrono::steady_clock::rep none = 0;
+    interrupt_requested_at_.compare_exchange_strong(none, std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+std::optional<std::chrono::steady_clock::time_point> StreamProcess::interrupt_requested_at() const {
+    auto ticks = interrupt_requested_at_.load();
+    if (ticks == 0) {
+        return std::nullopt;
+    }
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ticks));
+}
+
 bool StreamProcess::should_terminate() const {
     return should_terminate_.load();
 }
 
 void StreamProcess::kill_current_process() {
     pid_t pid = current_pid_.load();
-    if (pid > 0) {
-        std::cout << "🛑 Terminating current stream process (PID: " << pid << ")" << std::endl;
-        
-        // First try to terminate gracefully
-        if (kill(pid, SIGTERM) == 0) {
-            std::cout << "Sent SIGTERM to process " << pid << std::endl;
-            
-            // Give process time to terminate gracefully
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            
-            // Check if process is still running
-            if (kill(pid, 0) == 0) {
-                std::cout << "🔥 Process still running, force killing with SIGKILL..." << std::endl;
-                kill(pid, SIGKILL);
-                
-                // Also try to kill the process group in case there are child processes
-                kill(-pid, SIGKILL);
-                
-                // Wait a bit more
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            } else {
-                std::cout << "✅ Process terminated gracefully" << std::endl;
-            }
+    if (pid <= 0) {
+        log_info(LogCategory::Stream, "⚠️ No current stream process to terminate");
+        return;
+    }
+    log_info(LogCategory::Stream, "🛑 Terminating current stream process", {{"pid", pid}});
+
+    // The encoder leads its own process group, so this reaches the shell and ffmpeg but
+    // never another channel's encoder on the same host
+    if (kill(-pid, SIGTERM) == 0) {
+        // Give process time to terminate gracefully
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+        // Still there once the encoder thread has reaped it is gone for good
+        if (current_pid_.load() == pid && kill(-pid, 0) == 0) {
+            log_warn(LogCategory::Stream, "🔥 Process still running, force killing with SIGKILL", {{"pid", pid}});
+            kill(-pid, SIGKILL);
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
         } else {
-            std::cout << "⚠️ Failed to send signal to process " << pid << " (may have already terminated)" << std::endl;
+            log_info(LogCategory::Stream, "✅ Process terminated gracefully", {{"pid", pid}});
         }
     } else {
-        std::cout << "⚠️ No current process PID available, trying pattern-based kill..." << std::endl;
-    }
-    
-    // As a fallback, always try to kill any ffmpeg processes that might be streaming
-    std::cout << "🔪 Attempting to kill all ffmpeg streaming processes..." << std::endl;
-    int result = system("pkill -f 'ffmpeg.*rtmp'");
-    if (result == 0) {
-        std::cout << "✅ Successfully killed ffmpeg streaming processes" << std::endl;
-    } else {
-        std::cout << "⚠️ No ffmpeg streaming processes found or kill failed" << std::endl;
+        log_info(LogCategory::Stream, "⚠️ Failed to send signal to process (may have already terminated)", {{"pid", pid}});
     }
 }
 
 void StreamProcess::reset() {
     current_pid_.store(0);
     should_terminate_.store(false);
+    detach_requested_.store(false);
+    interrupt_requested_at_.store(0);
+    std::lock_guard<std::mutex> lock(boundary_mutex_);
+    segment_interrupt_pending_.store(false);
+    encoder_time_ = -1.0;
+    segment_cut_at_ = -1.0;
+}
+
+void StreamProcess::encoder_stopped() {
+    current_pid_.store(0);
+    detach_requested_.store(false);
+}
+
+void StreamProcess::set_on_air_priority(PriorityClass priority) {
+    on_air_priority_.store(priority);
+}
+
+PriorityClass StreamProcess::on_air_priority() const {
+    return on_air_priority_.load();
+}
+
+void StreamProcess::set_interrupt_cooldown(std::chrono::milliseconds cooldown) {
+    interrupt_cooldown_.store(std::chrono::steady_clock::duration(cooldown).count());
+}
+
+std::chrono::milliseconds StreamProcess::interrupt_cooldown() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::duration(interrupt_cooldown_.load()));
+}
+
+bool StreamProcess::claim_cut() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto cooldown = interrupt_cooldown_.load();
+    auto last = last_cut_at_.load();
+    do {
+        if (last != 0 && now - last < cooldown) {
+            channel_metrics().interrupts_suppressed.add();
+            log_debug(LogCategory::Stream, "Interrupt cooldown running, not cutting the item on air");
+            return false;
+        }
+    } while (!last_cut_at_.compare_exchange_weak(last, now));  // One winner among concurrent requests
+    return true;
+}
+
+bool StreamProcess::interrupt() {
+    if (!claim_cut()) {
+        return false;
+    }
+    request_termination();
+    kill_current_process();
+    return true;
+}
+
+bool StreamProcess::preempt(PriorityClass priority, InterruptPolicy policy) {
+    if (priority <= on_air_priority_.load()) {
+        return false;  // Equal or higher priority content on air keeps playing; FIFO within class
+    }
+
+    switch (policy) {
+        case InterruptPolicy::Immediate:
+            return interrupt();
+        case InterruptPolicy::SegmentBoundary:
+            if (segment_interrupt_pending_.load()) {
+                return true;  // Already cutting at the next boundary
+            }
+            if (!claim_cut()) {
+                return false;
+            }
+            log_info(LogCategory::Stream, "⏱️ Interrupt scheduled for next segment boundary",
+                     {{"class", priority_class_name(priority)}});
+            note_interrupt_requested();
+            {
+                std::lock_guard<std::mutex> lock(boundary_mutex_);
+                segment_cut_at_ = encoder_time_ < 0.0 ? -1.0 : next_segment_boundary(encoder_time_);
+                segment_interrupt_pending_.store(true);
+            }
+            return true;
+        case InterruptPolicy::EndOfItem:
+            break;
+    }
+    return false;
+}
+
+bool StreamProcess::segment_interrupt_pending() const {
+    return segment_interrupt_pending_.load();
+}
+
+void StreamProcess::note_encoder_time(double out_time_seconds) {
+    bool due = false;
+    {
+        std::lock_guard<std::mutex> lock(boundary_mutex_);
+        encoder_time_ = out_time_seconds;
+        if (segment_interrupt_pending_.load()) {
+            if (segment_cut_at_ < 0.0) {
+                segment_cut_at_ = next_segment_boundary(out_time_seconds);
+            }
+            due = encoder_time_ >= segment_cut_at_;
+        }
+    }
+    if (due) {
+        boundary_cv_.notify_all();
+    }
+}
+
+bool StreamProcess::segment_boundary_reached() const {
+    std::lock_guard<std::mutex> lock(boundary_mutex_);
+    return segment_interrupt_pending_.load() && segment_cut_at_ >= 0.0 && encoder_time_ >= segment_cut_at_;
+}
+
+bool StreamProcess::wait_for_segment_boundary(std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(boundary_mutex_);
+    return boundary_cv_.wait_for(lock, timeout, [this] {
+        return segment_interrupt_pending_.load() && segment_cut_at_ >= 0.0 && encoder_time_ >= segment_cut_at_;
+    });
 }
 
+void StreamProcess::set_telemetry_listener(std::function<void(const EncoderTelemetry&)> listener) {
+    telemetry_listener_ = std::move(listener);
+}
+
+void StreamProcess::report_telemetry(const EncoderTelemetry& telemetry) const {
+    if (telemetry_listener_) {
+        telemetry_listener_(telemetry);
+    }
+}
+
+void StreamProcess::set_encoder_policy(ProcessPolicy policy) {
+    encoder_policy_ = std::move(policy);
+}
+
+const ProcessPolicy& StreamProcess::encoder_policy() const {
+    return encoder_policy_;
+}
+
+void StreamProcess::set_hls_fifo(std::string path) {
+    hls_fifo_ = std::move(path);
+}
+
+const std::string& StreamProcess::hls_fifo() const {
+    return hls_fifo_;
+}
+
+void StreamProcess::request_detach() {
+    detach_requested_.store(true);
+}
+
+bool StreamProcess::detach_requested() const {
+    return detach_requested_.load();
+}
+
+void StreamProcess::set_detached(EncoderHandle encoder) {
+    std::lock_guard<std::mutex> lock(detached_mutex_);
+    current_pid_.store(0);  // No longer ours to cut
+    detached_ = std::move(encoder);
+}
+
+std::optional<EncoderHandle> StreamProcess::take_detached() {
+    std::lock_guard<std::mutex> lock(detached_mutex_);
+    return std::exchange(detached_, std::nullopt);
+}
+
+// Leading number of an ffmpeg progress value ("2500.1kbits/s", "1.01x"); 0 for N/A
+template <class T>
+static T progress_number(std::string_view value) {
+    T number{};
+    std::from_chars(value.data(), value.data() + value.size(), number);
+    return number;
+}
+
+bool EncoderProgressParser::feed(std::string_view line) {
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.remove_suffix(1);
+    }
+    auto eq = line.find('=');
+    if (eq == std::string_view::npos) {
+        return false;
+    }
+    auto key = line.substr(0, eq);
+    auto value = line.substr(eq + 1);
+    while (!value.empty() && value.front() == ' ') {
+        value.remove_prefix(1);
+    }
+
+    if (key == "frame") {
+        telemetry_.frame = progress_number<uint64_t>(value);
+    } else if (key == "fps") {
+        telemetry_.fps = progress_number<double>(value);
+    } else if (key == "bitrate") {
+        telemetry_.bitrate_kbps = progress_number<double>(value);
+    } else if (key == "speed") {
+        telemetry_.speed = progress_number<double>(value);
+    } else if (key == "out_time_us") {
+        telemetry_.out_time_seconds = progress_number<int64_t>(value) / 1e6;
+    } else if (key == "total_size") {
+        telemetry_.total_size = progress_number<uint64_t>(value);
+    } else if (key == "drop_frames") {
+        telemetry_.dropped_frames = progress_number<uint64_t>(value);
+    } else if (key == "dup_frames") {
+        telemetry_.duplicated_frames = progress_number<uint64_t>(value);
+    } else if (key == "progress") {
+        return true;
+    }
+    return false;
+}
+
+namespace {
+
+// One long-lived thread supervises ffmpeg for every item, instead of a fresh std::async
+// thread per item; ffmpeg gets the encoder policy's CPUs, not this thread's. Never
+// destroyed: playout runs until the process exits.
+ToolExecutor& encoder_thread() {
+    static auto* executor = new ToolExecutor(1, 1, ThreadRole::Playout, "encoder");
+    return *executor;
+}
+
+// True once the encoder has exited (a zombie counts); only the pidfd can tell for an
+// adopted encoder, since kill() still finds a zombie that is not ours to reap
+bool encoder_exited(const EncoderHandle& encoder) {
+    if (encoder.process.pidfd >= 0) {
+        pollfd ready{encoder.process.pidfd, POLLIN, 0};
+        return poll(&ready, 1, 0) > 0;
+    }
+    if (!encoder.adopted) {
+        return waitpid(encoder.process.pid, nullptr, WNOHANG) != 0;
+    }
+    return kill(encoder.process.pid, 0) != 0 && errno == ESRCH;
+}
+
+// Waits for the encoder to exit and returns its wait status. An adopted encoder's status
+// goes to whoever inherited it, so a clean exit is assumed.
+int reap_encoder(const EncoderHandle& encoder) {
+    if (!encoder.adopted) {
+        int status = 0;
+        while (waitpid(encoder.process.pid, &status, 0) < 0 && errno == EINTR) {
+        }
+        return status;
+    }
+    while (!encoder_exited(encoder)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return 0;
+}
+
+void close_encoder(EncoderHandle& encoder) {
+    for (int* fd : {&encoder.process.stdout_fd, &encoder.process.pidfd}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+// SIGTERM to the encoder's process group, SIGKILL if it is still there after two seconds;
+// reaps the shell either way
+void stop_encoder(const EncoderHandle& encoder) {
+    kill(-encoder.process.pid, SIGTERM);
+    for (int i = 0; i < 20; ++i) {
+        if (encoder_exited(encoder)) {
+            reap_encoder(encoder);
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    kill(-encoder.process.pid, SIGKILL);
+    reap_encoder(encoder);
+}
+
+// Reads the -progress reports until the encoder exits, is cut, or is released for a
+// handoff. Runs on the encoder thread.
+void supervise_encoder(EncoderHandle encoder, const std::string& video_path) {
+    g_stream_process->set_current_pid(encoder.process.pid);
+    int fd = encoder.process.stdout_fd;
+
+    // stdout carries the -progress reports; the log and console stats stay on stderr.
+    // Read the fd directly: fgets would leave lines in the stdio buffer that select()
+    // cannot see, holding each report back until the next one arrives.
+    char buffer[4096];
+    std::string pending = std::move(encoder.pending);
+    std::string unreported;  // Lines of the report in progress, replayed by whoever takes over
+    EncoderProgressParser progress;
+    bool process_terminated = false;
+
+    // Read output while checking for termination requests
+    while (!process_terminated) {
+        if (g_stream_process->should_terminate()) {
+            log_info(LogCategory::Stream, "🛑 Stream termination requested, stopping",
+                     {{"item", video_path}, {"pid", encoder.process.pid}});
+            stop_encoder(encoder);
+            close_encoder(encoder);
+            return;
+        }
+        if (g_stream_process->detach_requested()) {
+            // The encoder keeps running; whoever takes it reads on from here
+            log_info(LogCategory::Stream, "🤝 Releasing encoder for handoff",
+                     {{"item", video_path}, {"pid", encoder.process.pid}});
+            encoder.pending = unreported + pending;
+            g_stream_process->set_detached(std::move(encoder));
+            return;
+        }
+
+        // Try to read from pipe with timeout
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        FD_SET(fd, &read_fds);
+
+        struct timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 100000; // 100ms
+
+        int select_result = select(fd + 1, &read_fds, nullptr, nullptr, &timeout);
+
+        if (select_result > 0 && FD_ISSET(fd, &read_fds)) {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                pending.append(buffer, static_cast<size_t>(n));
+                size_t start = 0;
+                for (size_t end; (end = pending.find('\n', start)) != std::string::npos; start = end + 1) {
+                    if (progress.feed(std::string_view(pending).substr(start, end - start))) {
+                        g_stream_process->report_telemetry(progress.telemetry());
+                        g_stream_process->note_encoder_time(progress.telemetry().out_time_seconds);
+                        unreported.clear();
+                    } else {
+                        unreported.append(pending, start, end + 1 - start);
+                    }
+                }
+                pending.erase(0, start);
+            } else {
+                // End of stream
+                process_terminated = true;
+            }
+        } else if (select_result == 0) {
+            // Timeout - continue checking for termination
+            continue;
+        } else if (errno != EINTR) {
+            // Error or end of stream
+            process_terminated = true;
+        }
+    }
+
+    int status = reap_encoder(encoder);
+    close_encoder(encoder);
+    if (status == 0) {
+        log_info(LogCategory::Stream, "Successfully pushed to YouTube Live Stream", {{"item", video_path}});
+    } else if (!g_stream_process->should_terminate()) {
+        channel_metrics().ffmpeg_failures.add();
+        log_error(LogCategory::Stream, "ffmpeg process failed", {{"item", video_path}, {"status", status}});
+    }
+}
+
+// Where ffmpeg writes: RTMP, the local HLS FIFO, or both through the tee muxer. A failing
+// HLS branch (no reader) is dropped without taking the RTMP stream down.
+std::string encoder_outputs(const std::string& rtmp_target, const std::string& hls_fifo) {
+    if (hls_fifo.empty()) {
+        return " -f flv " + rtmp_target;
+    }
+    if (rtmp_target.empty()) {
+        return " -f mpegts " + shell_quote(hls_fifo);
+    }
+    return " -map 0:v:0 -map '0:a:0?' -flags +global_header -f tee " +
+           shell_quote("[f=flv]" + rtmp_target + "|[f=mpegts:onfail=ignore]" + hls_fifo);
+}
+
+}  // namespace
+
 std::future<void> push_to_youtube_async(const std::string& video_path, const std::string& rtmp_url, const std::string& stream_key) {
-    return std::async(std::launch::async, [video_path, rtmp_url, stream_key]() {
-        if (rtmp_url.empty() || stream_key.empty()) {
-            std::cerr << "Error: RTMP URL or Stream Key is empty." << std::endl;
-            std::cout << "Skipping YouTube push for " << video_path << std::endl;
+    auto task = std::make_shared<std::packaged_task<void()>>([video_path, rtmp_url, stream_key]() {
+        const std::string& hls_fifo = g_stream_process->hls_fifo();
+        std::string rtmp_target = rtmp_url.empty() || stream_key.empty() ? std::string() : rtmp_url + "/" + stream_key;
+        if (rtmp_target.empty() && hls_fifo.empty()) {
+            log_error(LogCategory::Stream, "RTMP URL or Stream Key is empty, skipping YouTube push", {{"item", video_path}});
             return;
         }
 
-        std::cout << "Pushing " << video_path << " to YouTube Live Stream..." << std::endl;
-        std::cout << "🎬 Quality Settings: " << StreamingConfig::MAX_HEIGHT << "p @ " 
-                  << StreamingConfig::VIDEO_BITRATE << "k video, " 
-                  << StreamingConfig::AUDIO_BITRATE << "k audio" << std::endl;
+        log_info(LogCategory::Stream, "Pushing to YouTube Live Stream",
+                 {{"item", video_path}, {"height", StreamingConfig::MAX_HEIGHT},
+                  {"video_kbps", StreamingConfig::VIDEO_BITRATE}, {"audio_kbps", StreamingConfig::AUDIO_BITRATE},
+                  {"yt_dlp", is_youtube_url(video_path)}, {"rtmp", !rtmp_target.empty()}, {"hls", !hls_fifo.empty()}});
 
         std::string ffmpeg_command;
         
         if (is_youtube_url(video_path)) {
             // For YouTube URLs, use yt-dlp to pipe the stream directly to ffmpeg
-            std::cout << "Detected YouTube URL, using yt-dlp to stream..." << std::endl;
-            
             std::stringstream cmd;
             cmd << "yt-dlp -f 'best[height<=" << StreamingConfig::MAX_HEIGHT << "]' -o - " << video_path
-                << " | /nix/store/dfc4gg05vh5wini7z0wvia3x0slszqxi-ffmpeg-7.1.1-bin/bin/ffmpeg -re -i pipe:0"
+                << " | /nix/store/dfc4gg05vh5wini7z0wvia3x0slszqxi-ffmpeg-7.1.1-bin/bin/ffmpeg -progress pipe:1 -re -i pipe:0"
                 << " -c:v libx264 -preset " << StreamingConfig::VIDEO_PRESET 
                 << " -crf " << StreamingConfig::CRF_VALUE
                 << " -maxrate " << StreamingConfig::VIDEO_BITRATE << "k"
                 << " -bufsize " << StreamingConfig::BUFFER_SIZE << "k"
                 << " -pix_fmt " << StreamingConfig::PIXEL_FORMAT
+                << " -r " << StreamingConfig::FRAME_RATE
                 << " -g " << StreamingConfig::GOP_SIZE
+                << " -force_key_frames 'expr:gte(t,n_forced*" << StreamingConfig::SEGMENT_SECONDS << ")'"
                 << " -c:a aac -b:a " << StreamingConfig::AUDIO_BITRATE << "k"
                 << " -ar " << StreamingConfig::AUDIO_SAMPLE_RATE
-                << " -f flv " << rtmp_url << "/" << stream_key;
+                << encoder_outputs(rtmp_target, hls_fifo);
             ffmpeg_command = cmd.str();
         } else {
             // For local files, use the original ffmpeg command
             std::stringstream cmd;
-            cmd << "/nix/store/dfc4gg05vh5wini7z0wvia3x0slszqxi-ffmpeg-7.1.1-bin/bin/ffmpeg -re -i " << video_path
+            cmd << "/nix/store/dfc4gg05vh5wini7z0wvia3x0slszqxi-ffmpeg-7.1.1-bin/bin/ffmpeg -progress pipe:1 -re -i " << video_path
                 << " -c:v libx264 -preset " << StreamingConfig::VIDEO_PRESET
                 << " -crf " << StreamingConfig::CRF_VALUE
                 << " -maxrate " << StreamingConfig::VIDEO_BITRATE << "k"
                 << " -bufsize " << StreamingConfig::BUFFER_SIZE << "k"
                 << " -pix_fmt " << StreamingConfig::PIXEL_FORMAT
+                << " -r " << StreamingConfig::FRAME_RATE
                 << " -g " << StreamingConfig::GOP_SIZE
+                << " -force_key_frames 'expr:gte(t,n_forced*" << StreamingConfig::SEGMENT_SECONDS << ")'"
                 << " -c:a aac -b:a " << StreamingConfig::AUDIO_BITRATE << "k"
                 << " -ar " << StreamingConfig::AUDIO_SAMPLE_RATE
-                << " -f flv " << rtmp_url << "/" << stream_key;
+                << encoder_outputs(rtmp_target, hls_fifo);
             ffmpeg_command = cmd.str();
         }
 
         try {
-            std::cout << "🎬 Starting ffmpeg command: " << ffmpeg_command << std::endl;
-            
-            // Use popen but with process group management
-            FILE* pipe = popen(ffmpeg_command.c_str(), "r");
-            if (!pipe) {
-                throw std::runtime_error("Failed to start ffmpeg process");
-            }
+            log_debug(LogCategory::Stream, "🎬 Starting ffmpeg", {{"command", ffmpeg_command}});
             
-            // Get the process ID of the popen command
-            // We'll use a different approach - find the ffmpeg process by command line
-            std::string pid_command = "pgrep -f 'ffmpeg.*" + rtmp_url + "'";
-            FILE* pid_pipe = popen(pid_command.c_str(), "r");
-            
-            pid_t ffmpeg_pid = 0;
-            if (pid_pipe) {
-                char pid_buffer[32];
-                if (fgets(pid_buffer, sizeof(pid_buffer), pid_pipe)) {
-                    ffmpeg_pid = std::stoi(std::string(pid_buffer));
-                    g_stream_process->set_current_pid(ffmpeg_pid);
-                    std::cout << "🎬 Found ffmpeg process with PID: " << ffmpeg_pid << std::endl;
-                }
-                pclose(pid_pipe);
+            // ffmpeg leads its own process group, so stopping it never needs a pattern
+            // match that could hit another channel's encoder on the same host
+            EncoderHandle encoder;
+            try {
+                encoder.process = spawn_with_policy(ffmpeg_command, g_stream_process->encoder_policy());
+            } catch (const std::exception&) {
+                channel_metrics().ffmpeg_failures.add();
+                throw;
             }
-            
-            // If we couldn't find the PID, set a placeholder (the shell PID)
-            if (ffmpeg_pid == 0) {
-                std::cout << "⚠️ Could not determine exact ffmpeg PID, using shell process for termination" << std::endl;
-                // We'll use a different strategy - track by command pattern
-            }
-            
-            char buffer[256];
-            std::string result = "";
-            bool process_terminated = false;
-            
-            // Read output while checking for termination requests
-            while (!process_terminated) {
-                if (g_stream_process->should_terminate()) {
-                    std::cout << "🛑 Stream termination requested, stopping..." << std::endl;
-                    
-                    // Kill all ffmpeg processes related to our stream
-                    std::string kill_command = "pkill -f 'ffmpeg.*" + rtmp_url + "'";
-                    std::cout << "🔪 Executing kill command: " << kill_command << std::endl;
-                    int kill_result = system(kill_command.c_str());
-                    std::cout << "Kill command result: " << kill_result << std::endl;
-                    
-                    // Close the pipe
-                    pclose(pipe);
-                    return;
-                }
-                
-                // Try to read from pipe with timeout
-                fd_set read_fds;
-                FD_ZERO(&read_fds);
-                FD_SET(fileno(pipe), &read_fds);
-                
-                struct timeval timeout;
-                timeout.tv_sec = 0;
-                timeout.tv_usec = 100000; // 100ms
-                
-                int select_result = select(fileno(pipe) + 1, &read_fds, nullptr, nullptr, &timeout);
-                
-                if (select_result > 0 && FD_ISSET(fileno(pipe), &read_fds)) {
-                    if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-                        result += buffer;
-                        std::cout << "ffmpeg: " << buffer; // Show output in real-time
-                    } else {
-                        // End of stream
-                        process_terminated = true;
-                    }
-                } else if (select_result == 0) {
-                    // Timeout - continue checking for termination
-                    continue;
-                } else {
-                    // Error or end of stream
-                    process_terminated = true;
-                }
-            }
-            
-            int status = pclose(pipe);
-            if (status == 0) {
-                std::cout << "Successfully pushed " << video_path << " to YouTube Live Stream." << std::endl;
-            } else if (!g_stream_process->should_terminate()) {
-                std::cout << "ffmpeg process ended with status: " << status << std::endl;
-            }
-            
+            channel_metrics().ffmpeg_starts.add();
+            log_debug(LogCategory::Stream, "🎬 Started ffmpeg", {{"pid", encoder.process.pid}});
+            supervise_encoder(std::move(encoder), video_path);
         } catch (const std::exception& e) {
-            std::cerr << "Error pushing to YouTube: " << e.what() << std::endl;
+            log_error(LogCategory::Stream, "Error pushing to YouTube", {{"item", video_path}, {"error", e.what()}});
         }
         
-        g_stream_process->reset();
+        g_stream_process->encoder_stopped();
     });
+    auto done = task->get_future();
+    if (!encoder_thread().submit([task] { (*task)(); })) {
+        throw std::runtime_error("Encoder is still busy with the previous item");
+    }
+    return done;
+}
+
+std::future<void> supervise_encoder_async(EncoderHandle encoder, const std::string& video_path) {
+    auto task = std::make_shared<std::packaged_task<void()>>([encoder = std::move(encoder), video_path]() mutable {
+        log_info(LogCategory::Stream, "🤝 Supervising running encoder",
+                 {{"item", video_path}, {"pid", encoder.process.pid}, {"adopted", encoder.adopted}});
+        supervise_encoder(std::move(encoder), video_path);
+        g_stream_process->encoder_stopped();
+    });
+    auto done = task->get_future();
+    if (!encoder_thread().submit([task] { (*task)(); })) {
+        throw std::runtime_error("Encoder is still busy with the previous item");
+    }
+    return done;
 }
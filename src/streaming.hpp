@@ -1,14 +1,65 @@
 #pragma once
+#include "priority_scheduler.hpp"
+#include "process_policy.hpp"
 #include <string>
 #include <future>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <optional>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string_view>
+
+// Encoder statistics from one ffmpeg -progress report (every half second while streaming)
+struct EncoderTelemetry {
+    uint64_t frame = 0;
+    double fps = 0.0;
+    double bitrate_kbps = 0.0;  // 0 while ffmpeg reports N/A
+    double speed = 0.0;         // Realtime factor; below 1 means the encoder is falling behind
+    double out_time_seconds = 0.0;
+    uint64_t total_size = 0;
+    uint64_t dropped_frames = 0;
+    uint64_t duplicated_frames = 0;
+};
+
+// Reads ffmpeg's -progress key=value lines; a report ends with progress=continue or progress=end
+class EncoderProgressParser {
+public:
+    // True when the line completed a report, which telemetry() then holds
+    bool feed(std::string_view line);
+    const EncoderTelemetry& telemetry() const { return telemetry_; }
+
+private:
+    EncoderTelemetry telemetry_;
+};
+
+// The encoder on air as it passes between supervisors: the encoder thread and, across a
+// restart, the next server process (see handoff.hpp)
+struct EncoderHandle {
+    ChildProcess process;
+    std::string pending;   // Progress output read but not parsed yet (a partial line)
+    bool adopted = false;  // Started by an earlier server process: not our child to reap
+};
+
+// Minimum time between client-requested cuts unless MYCHANNEL_INTERRUPT_COOLDOWN_MS says otherwise
+inline constexpr std::chrono::seconds DEFAULT_INTERRUPT_COOLDOWN{10};
 
 // Process management for controlling ffmpeg streams
 class StreamProcess {
 private:
     std::atomic<pid_t> current_pid_;
     std::atomic<bool> should_terminate_;
+    std::atomic<bool> segment_interrupt_pending_;
+    std::atomic<PriorityClass> on_air_priority_;
+    std::atomic<std::chrono::steady_clock::rep> interrupt_requested_at_{0};  // First cut request since reset(); 0 for none
+    std::atomic<std::chrono::steady_clock::rep> last_cut_at_{0};  // Last client cut granted; survives reset()
+    std::atomic<std::chrono::steady_clock::rep> interrupt_cooldown_;
+
+    void note_interrupt_requested();
+    bool claim_cut();  // False while the cooldown since the last granted cut is running
 
 public:
     StreamProcess();
@@ -16,15 +67,85 @@ public:
     void request_termination();
     bool should_terminate() const;
     void kill_current_process();
+    // Between items, from the playout loop only: clears cut and detach requests
     void reset();
+    // From the encoder thread when it lets go of an encoder (exited, cut or detached): forgets
+    // its pid and a detach request it has served. A cut request stays until the playout loop
+    // has seen it and calls reset().
+    void encoder_stopped();
+
+    // Priority class of the item on air; only strictly higher classes may cut it
+    void set_on_air_priority(PriorityClass priority);
+    PriorityClass on_air_priority() const;
+    // Cut the item on air for newly queued content according to its class policy.
+    // Returns true when an interrupt was requested (immediately or at the next segment boundary);
+    // false during the interrupt cooldown, when the item waits to play next instead.
+    bool preempt(PriorityClass priority, InterruptPolicy policy);
+    // Client request to cut the item on air now; false during the interrupt cooldown
+    bool interrupt();
+    // Minimum time between cuts requested by clients, so a flood of priority submissions
+    // cannot restart the encoder over and over; 0 turns it off. Scheduled events and
+    // playout's own cuts are not limited.
+    void set_interrupt_cooldown(std::chrono::milliseconds cooldown);
+    std::chrono::milliseconds interrupt_cooldown() const;
+    bool segment_interrupt_pending() const;
+    // Encoder output time from each -progress report. A segment cut is due once it reaches
+    // the first forced keyframe after the request (the first report's, if none had come yet).
+    void note_encoder_time(double out_time_seconds);
+    bool segment_boundary_reached() const;
+    // Sleep up to the timeout, waking early once a pending segment cut is due
+    bool wait_for_segment_boundary(std::chrono::milliseconds timeout) const;
+    // When the first cut (immediate or at a segment boundary) was requested for the item on air
+    std::optional<std::chrono::steady_clock::time_point> interrupt_requested_at() const;
+
+    // Called from the streaming thread with each encoder report; set once at startup,
+    // before the first item is pushed
+    void set_telemetry_listener(std::function<void(const EncoderTelemetry&)> listener);
+    void report_telemetry(const EncoderTelemetry& telemetry) const;
+
+    // CPUs, nice, I/O priority and cgroup each encoder is started with; set once at
+    // startup, like the telemetry listener
+    void set_encoder_policy(ProcessPolicy policy);
+    const ProcessPolicy& encoder_policy() const;
+
+    // FIFO the encoder also writes MPEG-TS to for the local HLS output (see hls.hpp); empty
+    // for RTMP only. Without an RTMP URL and key, HLS is the only output. Set once at startup.
+    void set_hls_fifo(std::string path);
+    const std::string& hls_fifo() const;
+
+    // Handoff: the encoder thread stops supervising the encoder on air and parks it for
+    // take_detached() instead of stopping it. The item's future completes either way;
+    // take_detached() is empty when the encoder had already exited.
+    void request_detach();
+    bool detach_requested() const;
+    void set_detached(EncoderHandle encoder);
+    std::optional<EncoderHandle> take_detached();
+
+private:
+    std::function<void(const EncoderTelemetry&)> telemetry_listener_;
+    ProcessPolicy encoder_policy_;
+    std::string hls_fifo_;
+    std::atomic<bool> detach_requested_{false};
+    std::mutex detached_mutex_;
+    std::optional<EncoderHandle> detached_;
+    mutable std::mutex boundary_mutex_;
+    mutable std::condition_variable boundary_cv_;
+    double encoder_time_ = -1.0;    // Seconds of output so far; negative before the first report
+    double segment_cut_at_ = -1.0;  // Output time of the keyframe a pending segment cut waits for
 };
 
 // Global stream process manager
 extern std::shared_ptr<StreamProcess> g_stream_process;
 
-// Asynchronous streaming function
+// Streams one item on the encoder thread; the future is ready once ffmpeg has exited.
+// Throws when the previous item is still streaming.
 std::future<void> push_to_youtube_async(
     const std::string& video_path, 
     const std::string& rtmp_url, 
     const std::string& stream_key
 );
+
+// Supervises an encoder that is already running, as push_to_youtube_async does with the
+// one it starts: one handed over by the previous server process, or our own taken back
+// after a failed handoff
+std::future<void> supervise_encoder_async(EncoderHandle encoder, const std::string& video_path);
@@ -7,6 +7,8 @@ namespace StreamingConfig {
     constexpr int VIDEO_BITRATE = 8000;       // Video bitrate in kbps (8Mbps)
     constexpr int BUFFER_SIZE = 16000;        // Buffer size in kbps (16Mbps)
     constexpr int GOP_SIZE = 60;              // Group of pictures size (2 seconds at 30fps)
+    constexpr int FRAME_RATE = 30;            // Output frame rate (-r), whatever the source's
+    constexpr int SEGMENT_SECONDS = GOP_SIZE / FRAME_RATE;  // Keyframes forced at this output time spacing
     constexpr int CRF_VALUE = 18;             // Constant Rate Factor (18 = high quality)
     
     // Audio settings  
@@ -14,6 +16,6 @@ namespace StreamingConfig {
     constexpr int AUDIO_SAMPLE_RATE = 48000;  // Audio sample rate in Hz (48kHz)
     
     // Encoder settings
-    const char* VIDEO_PRESET = "medium";      // x264 preset (medium = balanced quality/speed)
-    const char* PIXEL_FORMAT = "yuv420p";    // Pixel format for compatibility
+    constexpr const char* VIDEO_PRESET = "medium";      // x264 preset (medium = balanced quality/speed)
+    constexpr const char* PIXEL_FORMAT = "yuv420p";    // Pixel format for compatibility
 }
@@ -0,0 +1,114 @@
+#include "timer_wheel.hpp"
+#include <algorithm>
+
+namespace {
+
+constexpr uint64_t SLOT_MASK = TimerWheel::SLOTS - 1;
+
+size_t slot_index(uint64_t tick, size_t level) {
+    return static_cast<size_t>((tick >> (level * TimerWheel::SLOT_BITS)) & SLOT_MASK);
+}
+
+} // namespace
+
+TimerWheel::TimerWheel(uint64_t now_tick) : now_(now_tick) {}
+
+bool TimerWheel::live(const Timer& timer) const {
+    auto it = expiry_.find(timer.id);
+    return it != expiry_.end() && it->second == timer.expiry;
+}
+
+void TimerWheel::place(Timer timer) {
+    uint64_t delta = timer.expiry - now_;
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t{1} << ((level + 1) * SLOT_BITS))) {
+        ++level;
+    }
+    uint64_t horizon = uint64_t{1} << (LEVELS * SLOT_BITS);
+    // Beyond the top level: park in the slot that cascades last and re-place from there
+    uint64_t slot_tick = delta < horizon ? timer.expiry : now_ + horizon - 1;
+    slots_[level][slot_index(slot_tick, level)].push_back(timer);
+}
+
+void TimerWheel::schedule(uint64_t id, uint64_t expiry_tick) {
+    expiry_tick = std::max(expiry_tick, now_ + 1);
+    expiry_[id] = expiry_tick;
+    place({id, expiry_tick});
+}
+
+bool TimerWheel::cancel(uint64_t id) {
+    return expiry_.erase(id) > 0;  // The slot entry is dropped lazily
+}
+
+void TimerWheel::advance(uint64_t tick, std::vector<uint64_t>& expired) {
+    if (expiry_.empty() && now_ < tick) {
+        // Nothing live: jump straight there and drop any cancelled leftovers
+        for (auto& level : slots_) {
+            for (auto& slot : level) {
+                slot.clear();
+            }
+        }
+        now_ = tick;
+        return;
+    }
+    while (now_ < tick) {
+        // Skip the ticks where no slot is visited
+        uint64_t next = next_busy_tick();
+        if (next > tick) {
+            now_ = tick;
+            break;
+        }
+        now_ = next;
+        // Cascade from the top down so timers land in lower slots before those are visited
+        for (size_t level = LEVELS - 1; level > 0; --level) {
+            if ((now_ & ((uint64_t{1} << (level * SLOT_BITS)) - 1)) != 0) {
+                continue;
+            }
+            auto pending = std::move(slots_[level][slot_index(now_, level)]);
+            slots_[level][slot_index(now_, level)].clear();
+            for (const auto& timer : pending) {
+                if (live(timer)) {
+                    place(timer);
+                }
+            }
+        }
+
+        auto& slot = slots_[0][slot_index(now_, 0)];
+        for (const auto& timer : slot) {
+            if (live(timer)) {
+                expired.push_back(timer.id);
+                expiry_.erase(timer.id);
+            }
+        }
+        slot.clear();
+    }
+}
+
+uint64_t TimerWheel::next_busy_tick() const {
+    uint64_t best = UINT64_MAX;
+    for (uint64_t tick = now_ + 1; tick <= now_ + SLOTS; ++tick) {
+        if (!slots_[0][slot_index(tick, 0)].empty()) {
+            best = tick;
+            break;
+        }
+    }
+    // Each upper level only matters on its own boundaries, when that slot cascades
+    for (size_t level = 1; level < LEVELS; ++level) {
+        uint64_t span = uint64_t{1} << (level * SLOT_BITS);
+        uint64_t boundary = (now_ / span + 1) * span;
+        for (size_t i = 0; i < SLOTS && boundary < best; ++i, boundary += span) {
+            if (!slots_[level][slot_index(boundary, level)].empty()) {
+                best = boundary;
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+std::optional<uint64_t> TimerWheel::next_wakeup() const {
+    if (expiry_.empty()) {
+        return std::nullopt;
+    }
+    return next_busy_tick();
+}
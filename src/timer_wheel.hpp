@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Hierarchical timer wheel over integer ticks: 4 levels of 256 slots, covering 2^32 ticks
+// ahead (497 days at 10 ms). Scheduling and cancelling are O(1); advancing jumps over
+// empty stretches and visits only non-empty slots, cascading an upper-level slot into the
+// levels below when its boundary is reached. Timers further out than the wheel covers are
+// parked in the last slot and re-placed when it cascades.
+// Not thread-safe; owned by EventScheduler.
+class TimerWheel {
+public:
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 8;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+
+    explicit TimerWheel(uint64_t now_tick = 0);
+
+    // Fire `id` at `expiry_tick`; ticks at or before now() fire on the next advance.
+    // Rescheduling an id replaces its previous expiry.
+    void schedule(uint64_t id, uint64_t expiry_tick);
+    bool cancel(uint64_t id);
+
+    // Move time forward to `tick`, appending expired ids in expiry order
+    void advance(uint64_t tick, std::vector<uint64_t>& expired);
+
+    // Earliest tick at which advance() may fire something: an occupied level-0 slot or the
+    // next cascade (call again after advancing there)
+    std::optional<uint64_t> next_wakeup() const;
+
+    uint64_t now() const { return now_; }
+    size_t size() const { return expiry_.size(); }
+    bool empty() const { return expiry_.empty(); }
+
+private:
+    struct Timer {
+        uint64_t id;
+        uint64_t expiry;
+    };
+
+    std::array<std::array<std::vector<Timer>, SLOTS>, LEVELS> slots_;
+    std::unordered_map<uint64_t, uint64_t> expiry_;  // Live timers; stale slot entries are skipped
+    uint64_t now_;
+
+    void place(Timer timer);
+    bool live(const Timer& timer) const;
+    uint64_t next_busy_tick() const;  // Next tick with an occupied slot to visit; UINT64_MAX if none
+};
@@ -0,0 +1,158 @@
+#include "tool_executor.hpp"
+#include "json_response.hpp"
+#include <algorithm>
+
+ToolTask::ToolTask(std::optional<Clock::duration> timeout, std::string progress_token)
+    : deadline_(timeout ? std::optional(Clock::now() + *timeout) : std::nullopt),
+      progress_token_(std::move(progress_token)) {}
+
+void ToolTask::progress(double done, double total, std::string_view message) {
+    if (progress_token_.empty()) {
+        return;
+    }
+    ProgressNotification notification{
+        .params = {.progressToken = {progress_token_}, .progress = done, .total = total, .message = message}};
+    std::string event = write_json_response(notification);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.push_back(std::move(event));
+    }
+    cv_.notify_all();
+}
+
+void ToolTask::finish(std::string response) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        response_ = std::move(response);
+    }
+    cv_.notify_all();
+}
+
+void ToolTask::cancel() {
+    {
+        // Under the lock so a waiter cannot check the flag and then miss the wakeup
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_.store(true, std::memory_order_relaxed);
+    }
+    cv_.notify_all();
+}
+
+ToolTask::Wait ToolTask::wait(std::vector<std::string>& events, std::string& response, Clock::time_point until) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_until(lock, until, [&] { return !events_.empty() || response_.has_value() || cancelled(); });
+    // Notifications go out before the response they led up to
+    if (!events_.empty()) {
+        events.insert(events.end(), std::make_move_iterator(events_.begin()), std::make_move_iterator(events_.end()));
+        events_.clear();
+    }
+    if (response_) {
+        response = std::move(*response_);
+        response_.reset();
+        return Wait::Done;
+    }
+    if (cancelled()) {
+        return Wait::Done;  // No need to wait for a job that may still be queued
+    }
+    return events.empty() ? Wait::Idle : Wait::Progress;
+}
+
+PendingCalls::PendingCalls(size_t max_calls, Clock::duration retention)
+    : max_calls_(max_calls), retention_(retention) {}
+
+std::string PendingCalls::add(std::shared_ptr<ToolTask> task, Clock::time_point give_up, Finish finish) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::erase_if(calls_, [now](const auto& entry) { return entry.second.expires <= now; });
+    if (!calls_.empty() && calls_.size() >= max_calls_) {
+        // Full of calls nobody fetched: the one that would expire first goes
+        calls_.erase(std::min_element(calls_.begin(), calls_.end(), [](const auto& a, const auto& b) {
+            return a.second.expires < b.second.expires;
+        }));
+    }
+    std::string call_id = "call-" + std::to_string(++next_id_);
+    calls_.emplace(call_id, Call{std::move(task), give_up, std::move(finish), std::nullopt, give_up + retention_});
+    return call_id;
+}
+
+PendingCalls::State PendingCalls::poll(const std::string& call_id, std::string& response) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = calls_.find(call_id);
+    if (it == calls_.end() || it->second.expires <= now) {
+        return State::Unknown;
+    }
+    auto& call = it->second;
+    if (!call.response) {
+        std::vector<std::string> events;  // Progress only reaches callers answered inline
+        std::string finished;
+        if (call.task->wait(events, finished, now) == ToolTask::Wait::Done) {
+            call.response = call.finish(*call.task, std::move(finished));
+        } else if (now >= call.give_up) {
+            call.response = call.finish(*call.task, {});
+            call.task->cancel();
+        } else {
+            return State::Running;
+        }
+        call.expires = now + retention_;
+    }
+    response = *call.response;
+    return State::Finished;
+}
+
+size_t PendingCalls::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return calls_.size();
+}
+
+ToolExecutor::ToolExecutor(size_t workers, size_t max_queued, ThreadRole role, std::string_view name)
+    : max_queued_(max_queued) {
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back(&ToolExecutor::run, this, role, std::string(name) + '-' + std::to_string(i));
+    }
+}
+
+ToolExecutor::~ToolExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool ToolExecutor::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || jobs_.size() >= max_queued_) {
+            return false;
+        }
+        jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+size_t ToolExecutor::queued() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+void ToolExecutor::run(ThreadRole role, std::string name) {
+    enter_thread_role(role, name);
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;  // Stopping and drained
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "runtime.hpp"
+#include "utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// A long-running tool call in flight. The worker reports progress and then the final
+// JSON-RPC response; the HTTP side waits for them and may cancel. The deadline starts at
+// construction, so time spent queued counts against the tool's timeout.
+class ToolTask {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // progress_token is the raw JSON params._meta.progressToken; empty means no progress
+    // notifications are wanted
+    explicit ToolTask(std::optional<Clock::duration> timeout, std::string progress_token = {});
+
+    // Worker side
+    void progress(double done, double total, std::string_view message);
+    void finish(std::string response);
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+    // Probes run under these so a timeout or cancel kills the external command
+    ExecLimits exec_limits() const { return {deadline_, &cancelled_}; }
+    std::optional<Clock::time_point> deadline() const { return deadline_; }
+
+    // Waiting side
+    void cancel();
+    enum class Wait { Progress, Done, Idle };
+    // Moves queued notifications into events and, once finished, the response into
+    // response (Done). Done with an empty response once cancelled; Idle when until passes
+    // with nothing new.
+    Wait wait(std::vector<std::string>& events, std::string& response, Clock::time_point until);
+
+private:
+    const std::optional<Clock::time_point> deadline_;
+    const std::string progress_token_;
+    std::atomic<bool> cancelled_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::string> events_;
+    std::optional<std::string> response_;
+};
+
+// Tool calls answered before they finished (202 and a status URL), by call id, so the
+// client can fetch the response later without an HTTP worker waiting on the task. A call
+// is kept until `retention` after it finished; when max_calls are kept, the one due to
+// expire first goes.
+class PendingCalls {
+public:
+    using Clock = ToolTask::Clock;
+    // Turns what the task finished with (empty once cancelled or timed out) into the
+    // response served for the call
+    using Finish = std::function<std::string(const ToolTask& task, std::string response)>;
+
+    PendingCalls(size_t max_calls, Clock::duration retention);
+
+    // From give_up on, a task still running is cancelled and answered with finish(task, "").
+    // Returns the call id.
+    std::string add(std::shared_ptr<ToolTask> task, Clock::time_point give_up, Finish finish);
+
+    enum class State { Unknown, Running, Finished };
+    // Never blocks. Unknown for ids never handed out or expired; Finished fills response.
+    State poll(const std::string& call_id, std::string& response);
+    size_t size() const;
+
+private:
+    struct Call {
+        std::shared_ptr<ToolTask> task;
+        Clock::time_point give_up;
+        Finish finish;
+        std::optional<std::string> response;  // Once finished
+        Clock::time_point expires;
+    };
+
+    const size_t max_calls_;
+    const Clock::duration retention_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Call> calls_;
+    uint64_t next_id_ = 0;
+};
+
+// Fixed worker pool for long-running tool calls, off the HTTP threads. The queue is
+// bounded: when it is full submit() refuses and the caller answers "busy" at once instead
+// of stacking up probes behind each other. Workers are named "<name>-<n>" and placed per
+// their role.
+class ToolExecutor {
+public:
+    ToolExecutor(size_t workers, size_t max_queued, ThreadRole role = ThreadRole::Background,
+                 std::string_view name = "worker");
+    ~ToolExecutor();  // Runs whatever is still queued, then joins
+
+    ToolExecutor(const ToolExecutor&) = delete;
+    ToolExecutor& operator=(const ToolExecutor&) = delete;
+
+    bool submit(std::function<void()> job);
+    size_t queued() const;
+
+private:
+    void run(ThreadRole role, std::string name);
+
+    const size_t max_queued_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
@@ -1,5 +1,16 @@
 #include "utils.hpp"
 #include <regex>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
 
 std::string exec(const char* cmd) {
     std::array<char, 128> buffer;
@@ -14,7 +25,118 @@ std::string exec(const char* cmd) {
     return result;
 }
 
+std::string exec(const char* cmd, const ExecLimits& limits) {
+    if (!limits.deadline && !limits.cancelled) {
+        return exec(cmd);
+    }
+
+    // Close-on-exec so probes spawned concurrently by other threads do not hold our write end
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        throw std::runtime_error("pipe() failed!");
+    }
+    // Own process group, so a kill also reaches whatever the shell started
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    pid_t pid = 0;
+    const char* argv[] = {"sh", "-c", cmd, nullptr};
+    int rc = posix_spawn(&pid, "/bin/sh", &actions, &attr, const_cast<char* const*>(argv), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(fds[1]);
+    if (rc != 0) {
+        close(fds[0]);
+        throw std::runtime_error("posix_spawn() failed!");
+    }
+
+    auto abort = [&](const char* why) {
+        kill(-pid, SIGKILL);
+        close(fds[0]);
+        waitpid(pid, nullptr, 0);
+        throw ExecAborted(why);
+    };
+
+    std::string result;
+    std::array<char, 4096> buffer;
+    for (;;) {
+        if (limits.cancelled && limits.cancelled->load(std::memory_order_relaxed)) {
+            abort("cancelled");
+        }
+        // Wake at least every 50 ms to notice a cancel
+        int wait_ms = 50;
+        if (limits.deadline) {
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(*limits.deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0) {
+                abort("timed out");
+            }
+            wait_ms = static_cast<int>(std::min<int64_t>(left.count(), wait_ms));
+        }
+        pollfd pfd{fds[0], POLLIN, 0};
+        int ready = poll(&pfd, 1, wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            abort("poll() failed");
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        ssize_t n = read(fds[0], buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        result.append(buffer.data(), static_cast<size_t>(n));
+    }
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return result;
+}
+
 bool is_youtube_url(const std::string& path) {
-    std::regex youtube_regex(R"(^https?://(www\.)?(youtube\.com/watch\?v=|youtu\.be/))");
+    static const std::regex youtube_regex(R"(^https?://(www\.)?(youtube\.com/watch\?v=|youtu\.be/))");
     return std::regex_search(path, youtube_regex);
 }
+
+std::string shell_quote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            data_ = mapped;
+            size_ = static_cast<size_t>(info.st_size);
+        }
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(data_, size_);
+    }
+}
@@ -4,9 +4,48 @@
 #include <memory>
 #include <stdexcept>
 #include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string_view>
 
 // Function to execute a shell command and return its output
 std::string exec(const char* cmd);
 
+// Bounds for a command run on behalf of a client: past the deadline, or once *cancelled is
+// set, the command's whole process group is killed and exec throws ExecAborted
+struct ExecLimits {
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    const std::atomic<bool>* cancelled = nullptr;
+};
+
+class ExecAborted : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+std::string exec(const char* cmd, const ExecLimits& limits);
+
+// Single-quote for /bin/sh so client-supplied sources cannot inject commands
+std::string shell_quote(const std::string& text);
+
 // Function to check if a string is a YouTube URL
 bool is_youtube_url(const std::string& path);
+
+// Read-only mapping of a whole file, for loading persisted state without copying it.
+// Empty when the file is missing, empty or cannot be mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view data() const { return {static_cast<const char*>(data_), size_}; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
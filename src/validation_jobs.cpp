@@ -0,0 +1,216 @@
+#include "validation_jobs.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+namespace {
+
+// Jobs waiting or probing over every instance, for /metrics
+std::atomic<int64_t> pending_jobs{0};
+
+Counter& finished_jobs(ValidationState state) {
+    static auto& registry = metrics_registry();
+    static const std::string help = "Finished validation jobs of queue submissions, by result";
+    static Counter& playable = []() -> Counter& {
+        registry.gauge_callback("mychannel_validation_pending_jobs", "Queue submissions waiting for or in validation",
+                                [] { return static_cast<double>(pending_jobs.load(std::memory_order_relaxed)); });
+        return registry.counter("mychannel_validation_jobs_total", help, label("result", "playable"));
+    }();
+    static Counter& rejected = registry.counter("mychannel_validation_jobs_total", help, label("result", "rejected"));
+    return state == ValidationState::Playable ? playable : rejected;
+}
+
+std::string boot_prefix() {
+    auto now = std::chrono::system_clock::now().time_since_epoch().count();
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<uint64_t>(now) % 2176782336u, 36);  // 6 digits
+    return std::string(buffer, result.ptr);
+}
+
+}  // namespace
+
+const char* validation_state_name(ValidationState state) {
+    switch (state) {
+        case ValidationState::Pending: return "pending";
+        case ValidationState::Playable: return "playable";
+        case ValidationState::Rejected: return "rejected";
+    }
+    return "pending";
+}
+
+ValidationJobs::ValidationJobs(Options options, Accept accept, Probe probe)
+    : options_(options),
+      accept_(std::move(accept)),
+      probe_(std::move(probe)),
+      id_prefix_(boot_prefix()),
+      executor_(std::max<size_t>(options.workers, 1), std::max<size_t>(options.max_pending, 1), ThreadRole::Background,
+                "validate") {
+    finished_jobs(ValidationState::Playable);  // Registers the metrics
+}
+
+ValidationJobs::~ValidationJobs() {
+    stopping_.store(true);  // Queued jobs finish at once; running probes see it through their ExecLimits
+}
+
+void ValidationJobs::set_listener(std::function<void(const ValidationJob&)> listener) {
+    listener_ = std::move(listener);
+}
+
+std::optional<std::string> ValidationJobs::submit(QueueItem item) {
+    std::string id = id_prefix_ + '-' + std::to_string(next_id_.fetch_add(1) + 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.size() >= options_.max_pending) {
+            return std::nullopt;
+        }
+        ValidationJob job{.id = id, .item = std::move(item), .submitted_at = std::chrono::system_clock::now()};
+        jobs_.emplace(id, std::move(job));
+        pending_.push_back(id);
+    }
+    pending_jobs.fetch_add(1, std::memory_order_relaxed);
+    if (!executor_.submit([this, id] { run(id); })) {
+        settle(id, ValidationState::Rejected, "Validation queue full", std::nullopt);
+        return std::nullopt;
+    }
+    return id;
+}
+
+void ValidationJobs::run(const std::string& id) {
+    QueueItem item;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        item = jobs_.at(id).item;
+    }
+    if (stopping_.load()) {
+        settle(id, ValidationState::Rejected, "Server shutting down", std::nullopt);
+        return;
+    }
+
+    MediaProbe media;
+    try {
+        media = probe_(item.source, {std::chrono::steady_clock::now() + options_.probe_timeout, &stopping_});
+    } catch (const ExecAborted&) {
+        settle(id, ValidationState::Rejected, stopping_.load() ? "Server shutting down" : "Probe timed out",
+               std::nullopt);
+        return;
+    } catch (const std::exception& e) {
+        settle(id, ValidationState::Rejected, e.what(), std::nullopt);
+        return;
+    }
+
+    if (std::string reason = check_playable(media); !reason.empty()) {
+        settle(id, ValidationState::Rejected, std::move(reason), media);
+        return;
+    }
+    settle(id, ValidationState::Playable, {}, std::move(media));
+}
+
+void ValidationJobs::settle(const std::string& id, ValidationState state, std::string error,
+                            std::optional<MediaProbe> media) {
+    if (state == ValidationState::Playable) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.at(id).media = std::move(media);
+        playable_.insert(id);
+    } else {
+        finish(id, state, std::move(error), std::move(media));
+    }
+    commit_ready();
+}
+
+void ValidationJobs::commit_ready() {
+    std::lock_guard<std::mutex> commit(commit_mutex_);
+    for (;;) {
+        std::string id;
+        QueueItem item;
+        std::optional<MediaProbe> media;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.empty() || !playable_.contains(pending_.front())) {
+                return;  // Whoever settles the head job commits the ones behind it
+            }
+            id = pending_.front();
+            playable_.erase(id);
+            item = jobs_.at(id).item;
+            media = jobs_.at(id).media;
+        }
+        std::string error = accept_(item);
+        auto state = error.empty() ? ValidationState::Playable : ValidationState::Rejected;
+        finish(id, state, std::move(error), std::move(media));
+    }
+}
+
+void ValidationJobs::finish(const std::string& id, ValidationState state, std::string error,
+                            std::optional<MediaProbe> media) {
+    ValidationJob finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& job = jobs_.at(id);
+        job.state = state;
+        job.error = std::move(error);
+        job.media = std::move(media);
+        job.finished_at = std::chrono::system_clock::now();
+        finished = job;
+
+        pending_.erase(std::find(pending_.begin(), pending_.end(), id));
+        finished_.push_back(id);
+        while (finished_.size() > options_.retained) {
+            jobs_.erase(finished_.front());
+            finished_.pop_front();
+        }
+    }
+    pending_jobs.fetch_sub(1, std::memory_order_relaxed);
+    finished_jobs(state).add();
+
+    if (state == ValidationState::Playable) {
+        log_info(LogCategory::Queue, "✅ Validated and queued",
+                 {{"job", id}, {"item", finished.item.source}, {"submitter", finished.item.submitter}});
+    } else {
+        log_info(LogCategory::Queue, "❌ Rejected by validation",
+                 {{"job", id}, {"item", finished.item.source}, {"error", finished.error}});
+    }
+    if (listener_ && !stopping_.load()) {
+        listener_(finished);
+    }
+}
+
+std::optional<ValidationJob> ValidationJobs::find(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::vector<ValidationJob> ValidationJobs::recent(size_t limit) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ValidationJob> jobs;
+    for (auto it = pending_.begin(); it != pending_.end() && jobs.size() < limit; ++it) {
+        jobs.push_back(jobs_.at(*it));
+    }
+    for (auto it = finished_.rbegin(); it != finished_.rend() && jobs.size() < limit; ++it) {
+        jobs.push_back(jobs_.at(*it));
+    }
+    return jobs;
+}
+
+bool ValidationJobs::probe_async(std::string source, std::function<void(std::optional<MediaProbe>)> done) {
+    return executor_.submit([this, source = std::move(source), done = std::move(done)] {
+        std::optional<MediaProbe> media;
+        if (!stopping_.load()) {
+            try {
+                media = probe_(source, {std::chrono::steady_clock::now() + options_.probe_timeout, &stopping_});
+            } catch (const std::exception&) {
+                // Nothing to report but the missing result
+            }
+        }
+        done(std::move(media));
+    });
+}
+
+size_t ValidationJobs::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
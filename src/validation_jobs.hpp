@@ -0,0 +1,94 @@
+#pragma once
+#include "media_info.hpp"
+#include "queue_item.hpp"
+#include "tool_executor.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Deep validation of submissions off the request path. A submission becomes a job that
+// is answered 202 at once; a worker probes the source (streams, codec, resolution,
+// duration) and only a playable item is handed to the queue, so playout never meets a
+// source nobody has looked at. Playable items reach the queue in submission order: a job
+// whose probe finishes early waits for the jobs submitted before it. Jobs live in memory:
+// a restart forgets pending ones.
+
+enum class ValidationState { Pending, Playable, Rejected };
+
+const char* validation_state_name(ValidationState state);
+
+struct ValidationJob {
+    std::string id;
+    QueueItem item;
+    ValidationState state = ValidationState::Pending;
+    std::string error;  // Why it was rejected
+    std::optional<MediaProbe> media;  // Once probed
+    std::chrono::system_clock::time_point submitted_at;
+    std::optional<std::chrono::system_clock::time_point> finished_at;
+};
+
+class ValidationJobs {
+public:
+    struct Options {
+        size_t workers = 4;
+        size_t max_pending = 256;  // Jobs waiting or probing; submit() refuses beyond
+        std::chrono::seconds probe_timeout{30};
+        size_t retained = 1024;    // Finished jobs kept for status queries, newest first
+    };
+
+    using Probe = std::function<MediaProbe(const std::string& source, const ExecLimits& limits)>;
+    // Queues a playable item; returns an error (over quota) or empty once it is queued
+    using Accept = std::function<std::string(const QueueItem& item)>;
+
+    ValidationJobs(Options options, Accept accept, Probe probe = probe_media);
+    ~ValidationJobs();  // Pending jobs are rejected without probing; running probes are killed
+
+    ValidationJobs(const ValidationJobs&) = delete;
+    ValidationJobs& operator=(const ValidationJobs&) = delete;
+
+    // Id of the new job, or nothing when max_pending jobs are already in flight
+    std::optional<std::string> submit(QueueItem item);
+    std::optional<ValidationJob> find(const std::string& id) const;
+    std::vector<ValidationJob> recent(size_t limit) const;  // Pending first, then newest finished
+    size_t pending() const;
+
+    // Probes a source on the same workers without queueing anything (the EPG duration of a
+    // scheduled event). done gets nothing when the probe fails; false when the workers are full.
+    bool probe_async(std::string source, std::function<void(std::optional<MediaProbe>)> done);
+
+    // Called from a worker with every finished job; set before the first submit()
+    void set_listener(std::function<void(const ValidationJob&)> listener);
+
+private:
+    void run(const std::string& id);
+    // Rejections finish at once; a playable job waits until every earlier one has finished
+    void settle(const std::string& id, ValidationState state, std::string error, std::optional<MediaProbe> media);
+    void commit_ready();  // Hands playable jobs at the head of pending_ to accept_
+    void finish(const std::string& id, ValidationState state, std::string error, std::optional<MediaProbe> media);
+
+    const Options options_;
+    const Accept accept_;
+    const Probe probe_;
+    const std::string id_prefix_;  // Differs per process, so ids are not reused across restarts
+    std::function<void(const ValidationJob&)> listener_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> next_id_{0};
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, ValidationJob> jobs_;
+    std::vector<std::string> pending_;   // Submission order
+    std::unordered_set<std::string> playable_;  // Probed and playable, not yet handed to accept_
+    std::deque<std::string> finished_;   // Oldest first
+    std::mutex commit_mutex_;            // One committer at a time, so accept_ sees submission order
+
+    ToolExecutor executor_;  // Last: joined before the state above is destroyed
+};
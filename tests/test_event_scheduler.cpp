@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include "../src/event_scheduler.hpp"
+#include "../src/priority_scheduler.hpp"
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+const Clock::time_point T0 = *parse_schedule_time("2026-01-01T12:00:00Z");
+
+ScheduledEvent event_at(Clock::time_point start, const std::string& source,
+                        JoinPolicy join = JoinPolicy::WaitForEnd) {
+    ScheduledEvent event;
+    event.title = source;
+    event.item = {source, PriorityClass::Normal, "schedule"};
+    event.start = start;
+    event.join = join;
+    return event;
+}
+
+// Records cuts; pretends `on_air` is playing
+struct FakePlayout {
+    PriorityClass on_air = PriorityClass::Normal;
+    int cuts = 0;
+
+    PlayoutControl control() {
+        return {[this] { return on_air; }, [this] { ++cuts; }};
+    }
+};
+
+} // namespace
+
+TEST(EventSchedulerTest, ParsesAndFormatsTimes) {
+    EXPECT_EQ(format_schedule_time(T0), "2026-01-01T12:00:00Z");
+    EXPECT_EQ(parse_schedule_time("1767268800"), T0);
+    EXPECT_FALSE(parse_schedule_time("2026-01-01T12:00:00").has_value());
+    EXPECT_FALSE(parse_schedule_time("2026-13-01T12:00:00Z").has_value());
+    EXPECT_FALSE(parse_schedule_time("noon").has_value());
+    EXPECT_EQ(parse_join_policy("trim_filler"), JoinPolicy::TrimFiller);
+    EXPECT_FALSE(parse_join_policy("later").has_value());
+}
+
+// Events fire at (never before) their start, within one tick, in start order
+TEST(EventSchedulerTest, FiresAtScheduledTime) {
+    EventScheduler scheduler({}, {}, T0);
+    scheduler.schedule(event_at(T0 + seconds(60), "news"));
+    scheduler.schedule(event_at(T0 + milliseconds(30005), "weather"));
+
+    EXPECT_EQ(scheduler.poll(T0 + milliseconds(30000)), 0u);
+    EXPECT_FALSE(scheduler.has_due());
+    EXPECT_EQ(scheduler.poll(T0 + milliseconds(30010)), 1u);
+    EXPECT_EQ(scheduler.poll(T0 + seconds(59)), 0u);
+    EXPECT_EQ(scheduler.poll(T0 + seconds(60)), 1u);
+
+    ScheduledEvent event;
+    ASSERT_TRUE(scheduler.take_due(event));
+    EXPECT_EQ(event.item.source, "weather");
+    ASSERT_TRUE(scheduler.take_due(event));
+    EXPECT_EQ(event.item.source, "news");
+    EXPECT_FALSE(scheduler.take_due(event));
+
+    auto stats = scheduler.stats();
+    EXPECT_EQ(stats.fired, 2u);
+    EXPECT_EQ(stats.pending, 0u);
+    EXPECT_GE(stats.max_lateness_ms, 0.0);
+    EXPECT_LE(stats.max_lateness_ms, 10.0);
+}
+
+TEST(EventSchedulerTest, JoinPolicies) {
+    FakePlayout playout;
+    EventScheduler scheduler(playout.control(), {}, T0);
+    scheduler.schedule(event_at(T0 + seconds(1), "wait", JoinPolicy::WaitForEnd));
+    scheduler.poll(T0 + seconds(1));
+    EXPECT_EQ(playout.cuts, 0);
+
+    scheduler.schedule(event_at(T0 + seconds(2), "cut", JoinPolicy::HardCut));
+    playout.on_air = PriorityClass::Breaking;
+    scheduler.poll(T0 + seconds(2));
+    EXPECT_EQ(playout.cuts, 1);
+
+    // Trim filler only cuts rotation content
+    scheduler.schedule(event_at(T0 + seconds(3), "trim", JoinPolicy::TrimFiller));
+    scheduler.poll(T0 + seconds(3));
+    EXPECT_EQ(playout.cuts, 1);
+    playout.on_air = PriorityClass::Normal;
+    scheduler.schedule(event_at(T0 + seconds(4), "trim", JoinPolicy::TrimFiller));
+    scheduler.poll(T0 + seconds(4));
+    EXPECT_EQ(playout.cuts, 2);
+}
+
+TEST(EventSchedulerTest, CancelAndRepeat) {
+    EventScheduler scheduler({}, {}, T0);
+    auto cancelled = scheduler.schedule(event_at(T0 + seconds(10), "cancelled"));
+    auto hourly = event_at(T0 + seconds(30), "bulletin");
+    hourly.repeat = std::chrono::hours(1);
+    scheduler.schedule(hourly);
+    EXPECT_TRUE(scheduler.cancel(cancelled));
+    EXPECT_FALSE(scheduler.cancel(cancelled));
+
+    EXPECT_EQ(scheduler.poll(T0 + seconds(30)), 1u);
+    EXPECT_EQ(scheduler.poll(T0 + std::chrono::minutes(30)), 0u);
+    EXPECT_EQ(scheduler.poll(T0 + std::chrono::hours(1) + seconds(30)), 1u);
+    // Missed occurrences fire once, then the event re-arms in the future
+    EXPECT_EQ(scheduler.poll(T0 + std::chrono::hours(5)), 1u);
+    EXPECT_EQ(scheduler.stats().pending, 1u);
+    auto upcoming = scheduler.listing(T0 + std::chrono::hours(5), T0 + std::chrono::hours(6));
+    ASSERT_EQ(upcoming.size(), 1u);
+    EXPECT_EQ(upcoming[0].start, T0 + std::chrono::hours(5) + seconds(30));
+}
+
+TEST(EventSchedulerTest, FillsInProbedDurations) {
+    EventScheduler scheduler({}, {}, T0);
+    auto film = scheduler.schedule(event_at(T0 + std::chrono::minutes(10), "videos/film.mp4"));
+    EXPECT_EQ(scheduler.listing(T0, T0 + std::chrono::hours(1))[0].duration, 0.0);  // Not probed yet
+    EXPECT_TRUE(scheduler.set_duration(film, 5400));
+    EXPECT_EQ(scheduler.listing(T0, T0 + std::chrono::hours(1))[0].duration, 5400.0);
+
+    EXPECT_EQ(scheduler.poll(T0 + std::chrono::minutes(10)), 1u);
+    EXPECT_FALSE(scheduler.set_duration(film, 60));  // The probe came back after air time
+}
+
+TEST(EventSchedulerTest, ExportsEpg) {
+    EventSchedulerOptions options;
+    options.epg_horizon = std::chrono::hours(3);
+    EventScheduler scheduler({}, options, T0);
+    auto news = event_at(T0 + std::chrono::hours(1), "videos/news.mp4", JoinPolicy::HardCut);
+    news.title = "News & \"Weather\" <live>";
+    news.duration = 600;
+    news.repeat = std::chrono::hours(1);
+    scheduler.schedule(news);
+    scheduler.schedule(event_at(T0 + std::chrono::minutes(90), "videos/film.mp4"));
+
+    auto json = scheduler.epg_json(T0);
+    EXPECT_NE(json.find("\"title\":\"News & \\\"Weather\\\" <live>\""), std::string::npos);
+    EXPECT_NE(json.find("\"start\":\"2026-01-01T13:00:00Z\",\"stop\":\"2026-01-01T13:10:00Z\""), std::string::npos);
+    EXPECT_NE(json.find("\"join\":\"hard_cut\""), std::string::npos);
+    // Hourly repeats expand within the horizon: news at 13:00 and 14:00, plus the film
+    EXPECT_EQ(scheduler.listing(T0, T0 + options.epg_horizon).size(), 3u);
+
+    auto xml = scheduler.epg_xmltv(T0);
+    EXPECT_NE(xml.find("<channel id=\"mychannel\">"), std::string::npos);
+    EXPECT_NE(xml.find("<programme start=\"20260101130000 +0000\" stop=\"20260101131000 +0000\" channel=\"mychannel\">"),
+              std::string::npos);
+    EXPECT_NE(xml.find("<title>News &amp; &quot;Weather&quot; &lt;live&gt;</title>"), std::string::npos);
+    EXPECT_NE(xml.find("<title>videos/film.mp4</title>"), std::string::npos);
+}
+
+// The background thread fires events close to their wall-clock start
+TEST(EventSchedulerTest, BackgroundThreadFires) {
+    EventScheduler scheduler({}, {milliseconds(1)});
+    scheduler.start();
+    scheduler.schedule(event_at(Clock::now() + milliseconds(50), "soon"));
+    auto deadline = std::chrono::steady_clock::now() + seconds(5);
+    while (!scheduler.has_due() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+    scheduler.stop();
+    EXPECT_TRUE(scheduler.has_due());
+    EXPECT_GE(scheduler.stats().last_lateness_ms, 0.0);
+}
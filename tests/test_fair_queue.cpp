@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include "../src/fair_queue.hpp"
+#include "../src/media_queue.hpp"
+#include <map>
+#include <set>
+
+namespace {
+
+QueueItem item_from(const std::string& submitter, int n) {
+    return {submitter + std::to_string(n), PriorityClass::Normal, submitter};
+}
+
+} // namespace
+
+// Equal weights alternate between submitters regardless of submission order
+TEST(FairQueueTest, EqualWeightsAlternate) {
+    FairQueue queue;
+    for (int i = 0; i < 3; ++i) queue.push_back(item_from("a", i));
+    for (int i = 0; i < 3; ++i) queue.push_back(item_from("b", i));
+
+    std::vector<std::string> order;
+    QueueItem item;
+    while (queue.pop(item)) {
+        order.push_back(item.source);
+    }
+    EXPECT_EQ(order, (std::vector<std::string>{"a0", "b0", "a1", "b1", "a2", "b2"}));
+    EXPECT_TRUE(queue.empty());
+}
+
+// A submitter with weight 3 gets three items for every one of a weight-1 submitter
+TEST(FairQueueTest, WeightsSetShareOfPops) {
+    FairQueue queue;
+    queue.set_policy("editorial", {3.0, 0});
+    for (int i = 0; i < 30; ++i) queue.push_back(item_from("editorial", i));
+    for (int i = 0; i < 30; ++i) queue.push_back(item_from("agent", i));
+
+    std::map<std::string, int> served;
+    QueueItem item;
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(queue.pop(item));
+        ++served[item.submitter];
+    }
+    EXPECT_EQ(served["editorial"], 15);
+    EXPECT_EQ(served["agent"], 5);
+}
+
+// Long items eat into the submitter's credit, so short items from others catch up
+TEST(FairQueueTest, AirtimeIsChargedToSubmitter) {
+    FairQueue queue(60.0);
+    for (int i = 0; i < 4; ++i) queue.push_back(item_from("long", i));
+    for (int i = 0; i < 4; ++i) queue.push_back(item_from("short", i));
+
+    std::vector<std::string> order;
+    QueueItem item;
+    while (queue.pop(item)) {
+        order.push_back(item.submitter);
+        queue.record_airtime(item.submitter, item.submitter == "long" ? 180.0 : 60.0);
+    }
+    // After one 3-minute item, "long" must sit out until "short" has had comparable airtime
+    EXPECT_EQ(order, (std::vector<std::string>{"long", "short", "short", "short", "long", "short", "long", "long"}));
+    auto stats = queue.stats();
+    ASSERT_EQ(stats.size(), 2);
+    EXPECT_EQ(stats[0].name, "long");
+    EXPECT_DOUBLE_EQ(stats[0].airtime, 720.0);
+}
+
+// The projected order matches what pop() hands out
+TEST(FairQueueTest, ProjectedOrderFollowsWeights) {
+    FairQueue queue;
+    queue.set_policy("a", {2.0, 0});
+    for (int i = 0; i < 4; ++i) queue.push_back(item_from("a", i));
+    for (int i = 0; i < 2; ++i) queue.push_back(item_from("b", i));
+
+    std::vector<QueueItem> projected;
+    queue.append_in_order(projected);
+    std::vector<std::string> sources;
+    for (const auto& entry : projected) sources.push_back(entry.source);
+    EXPECT_EQ(sources, (std::vector<std::string>{"a0", "a1", "b0", "a2", "a3", "b1"}));
+
+    QueueItem item;
+    for (const auto& expected : sources) {
+        ASSERT_TRUE(queue.pop(item));
+        EXPECT_EQ(item.source, expected);
+    }
+}
+
+// Quotas cap queued items per submitter across all priority classes
+TEST(FairQueueTest, QuotaRejectsExcessSubmissions) {
+    ThreadSafeMediaQueue queue;
+    queue.set_submitter_policy("agent", {1.0, 2});
+
+    EXPECT_TRUE(queue.push("a.mp4", "agent"));
+    EXPECT_TRUE(queue.enqueue("b.mp4", PriorityClass::Next, "agent").has_value());
+    EXPECT_FALSE(queue.push("c.mp4", "agent"));
+    EXPECT_FALSE(queue.enqueue("d.mp4", PriorityClass::Breaking, "agent").has_value());
+    EXPECT_TRUE(queue.push("e.mp4", "editorial"));
+
+    // Playing an item frees a slot; re-appending it to the rotation is not quota-checked
+    QueueItem item;
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item.source, "b.mp4");
+    EXPECT_TRUE(queue.push("c.mp4", "agent"));
+    queue.push_back(QueueItem{item.source, PriorityClass::Normal, item.submitter});
+    EXPECT_EQ(queue.size(), 4);
+
+    auto snapshot = queue.snapshot();
+    ASSERT_EQ(snapshot->submitters.size(), 2);
+    EXPECT_EQ(snapshot->submitters[0].name, "agent");
+    EXPECT_EQ(snapshot->submitters[0].quota, 2);
+    EXPECT_EQ(snapshot->submitters[0].queued, 3);
+}
+
+// Loop mode walks a cursor over the playlist instead of popping and re-appending
+TEST(FairQueueTest, LoopAdvancesCursorInPlace) {
+    FairQueue queue;
+    for (int i = 0; i < 3; ++i) queue.push_back(item_from("a", i));
+
+    std::vector<std::string> order;
+    QueueItem item;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.advance(item));
+        order.push_back(item.source);
+    }
+    EXPECT_EQ(order, (std::vector<std::string>{"a0", "a1", "a2", "a0"}));
+    EXPECT_EQ(queue.size(), 3);
+    EXPECT_EQ(queue.stats()[0].position, 1);
+
+    std::vector<QueueItem> projected;
+    queue.append_in_order(projected);
+    ASSERT_EQ(projected.size(), 3);
+    EXPECT_EQ(projected[0].source, "a1");
+    EXPECT_EQ(projected[2].source, "a0");
+}
+
+// Front inserts play next, then come round again last
+TEST(FairQueueTest, PushFrontPlaysNextThenJoinsLoop) {
+    FairQueue queue;
+    queue.push_back(item_from("a", 0));
+    queue.push_back(item_from("a", 1));
+    QueueItem item;
+    queue.advance(item);
+    queue.push_front({"x", PriorityClass::Normal, "a"});
+
+    std::vector<std::string> order;
+    for (int i = 0; i < 4; ++i) {
+        queue.advance(item);
+        order.push_back(item.source);
+    }
+    EXPECT_EQ(order, (std::vector<std::string>{"x", "a1", "a0", "x"}));
+    EXPECT_EQ(queue.size(), 3);
+}
+
+// Shuffle plays every item exactly once per pass and never repeats across a pass boundary
+TEST(FairQueueTest, ShufflePlaysEveryItemOncePerPass) {
+    FairQueue queue;
+    queue.seed(42);
+    queue.set_mode(RotationMode::Shuffle);
+    for (int i = 0; i < 10; ++i) queue.push_back(item_from("a", i));
+
+    QueueItem item;
+    std::string previous;
+    for (int pass = 0; pass < 5; ++pass) {
+        std::set<std::string> seen;
+        for (int i = 0; i < 10; ++i) {
+            ASSERT_TRUE(queue.advance(item));
+            EXPECT_NE(item.source, previous);
+            seen.insert(item.source);
+            previous = item.source;
+        }
+        EXPECT_EQ(seen.size(), 10);
+    }
+    EXPECT_EQ(queue.size(), 10);
+}
+
+// Weighted random picks items in proportion to their weight
+TEST(FairQueueTest, WeightedRandomFollowsItemWeights) {
+    FairQueue queue;
+    queue.seed(7);
+    queue.set_mode(RotationMode::WeightedRandom);
+    queue.push_back({"heavy", PriorityClass::Normal, "a", 3.0});
+    queue.push_back({"light", PriorityClass::Normal, "a", 1.0});
+
+    std::map<std::string, int> plays;
+    QueueItem item;
+    for (int i = 0; i < 8000; ++i) {
+        queue.advance(item);
+        ++plays[item.source];
+    }
+    double ratio = static_cast<double>(plays["heavy"]) / plays["light"];
+    EXPECT_NEAR(ratio, 3.0, 0.3);
+}
+
+// Once mode consumes items as they play
+TEST(FairQueueTest, OnceConsumesItems) {
+    FairQueue queue;
+    queue.set_mode(RotationMode::Once);
+    for (int i = 0; i < 3; ++i) queue.push_back(item_from("a", i));
+    QueueItem item;
+    int played = 0;
+    while (queue.advance(item)) {
+        ++played;
+    }
+    EXPECT_EQ(played, 3);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(parse_rotation_mode("sometimes"));
+    EXPECT_EQ(parse_rotation_mode("weighted_random"), RotationMode::WeightedRandom);
+}
@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+#include "../src/handoff.hpp"
+#include "../src/streaming.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int FRAMES = 200;
+
+// Stands in for ffmpeg: every frame goes to the "stream" (a file, with the time it was
+// written) and a report goes to -progress
+std::string fake_encoder(const std::string& output) {
+    return "i=0; while [ $i -lt " + std::to_string(FRAMES) + " ]; do echo \"$i $(date +%s%N)\" >> " + output +
+           "; printf 'frame=%d\\nprogress=continue\\n' $i; i=$((i+1)); sleep 0.01; done";
+}
+
+}  // namespace
+
+TEST(HandoffTest, RoundTripsState) {
+    HandoffState state;
+    state.item = {"videos/a.mp4", PriorityClass::Breaking, "alice"};
+    state.origin = "queue";
+    state.duration = 93.5;
+    auto started_at = std::chrono::steady_clock::now() - std::chrono::milliseconds(41250);
+    state.started_at_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(started_at.time_since_epoch()).count();
+    state.encoder = EncoderHandle{};
+    state.encoder->process.pid = 4242;
+    state.encoder->pending = "frame=7\nfps=2";
+
+    HandoffState decoded;
+    ASSERT_TRUE(decode_handoff(encode_handoff(state), decoded));
+    EXPECT_EQ(decoded.item.source, "videos/a.mp4");
+    EXPECT_EQ(decoded.item.priority, PriorityClass::Breaking);
+    EXPECT_EQ(decoded.item.submitter, "alice");
+    EXPECT_EQ(decoded.origin, "queue");
+    EXPECT_DOUBLE_EQ(decoded.duration, 93.5);
+    EXPECT_EQ(decoded.started_at_ns, state.started_at_ns);
+    ASSERT_TRUE(decoded.encoder);
+    EXPECT_EQ(decoded.encoder->process.pid, 4242);
+    EXPECT_EQ(decoded.encoder->pending, "frame=7\nfps=2");
+
+    HandoffState between_items;
+    ASSERT_TRUE(decode_handoff(encode_handoff({}), between_items));
+    EXPECT_FALSE(between_items.encoder);
+
+    std::string payload = encode_handoff(state);
+    EXPECT_FALSE(decode_handoff(payload.substr(0, payload.size() - 1), decoded));
+    EXPECT_FALSE(decode_handoff(payload + "x", decoded));
+    EXPECT_FALSE(decode_handoff("", decoded));
+
+    // Time spent between sending and resuming (the successor's startup) counts
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(decode_handoff(payload, decoded));
+    EXPECT_GE(decoded.elapsed_seconds(), 41.3);
+    EXPECT_EQ(decoded.started_at(), started_at);
+
+    // A server deployed before the start time was sent passes the elapsed seconds
+    std::string old_payload = payload;
+    old_payload[0] = 1;
+    double elapsed = 41.25;
+    size_t at = payload.size() - sizeof(int32_t) - sizeof(uint32_t) - state.encoder->pending.size() - 1 - sizeof(int64_t);
+    old_payload.replace(at, sizeof(elapsed), reinterpret_cast<const char*>(&elapsed), sizeof(elapsed));
+    ASSERT_TRUE(decode_handoff(old_payload, decoded));
+    EXPECT_NEAR(decoded.elapsed_seconds(), 41.25, 0.5);
+}
+
+TEST(HandoffTest, PassesDescriptorsOverTheSocket) {
+    int sockets[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets), 0);
+    int pipe_fds[2];
+    ASSERT_EQ(pipe(pipe_fds), 0);
+
+    ASSERT_TRUE(send_with_fds(sockets[0], "state", {pipe_fds[0]}));
+    close(pipe_fds[0]);
+    std::string payload;
+    std::vector<int> fds;
+    ASSERT_TRUE(receive_with_fds(sockets[1], payload, fds, std::chrono::milliseconds(1000)));
+    EXPECT_EQ(payload, "state");
+    ASSERT_EQ(fds.size(), 1u);
+
+    // The received descriptor reads the same pipe
+    ASSERT_EQ(write(pipe_fds[1], "hi", 2), 2);
+    char buffer[4] = {};
+    EXPECT_EQ(read(fds[0], buffer, sizeof(buffer)), 2);
+    EXPECT_STREQ(buffer, "hi");
+    close(fds[0]);
+    close(pipe_fds[1]);
+
+    EXPECT_FALSE(receive_with_fds(sockets[1], payload, fds, std::chrono::milliseconds(10)));  // Timeout
+    close(sockets[0]);
+    EXPECT_FALSE(receive_with_fds(sockets[1], payload, fds, std::chrono::milliseconds(1000)));  // EOF
+    close(sockets[1]);
+}
+
+// The successor half of EncoderOutputContinuesAcrossHandoff, run in a process of its own
+TEST(HandoffTest, SuccessorSide) {
+    const char* result_path = std::getenv("HANDOFF_TEST_RESULT");
+    if (!std::getenv("MYCHANNEL_HANDOFF_FD") || !result_path) {
+        GTEST_SKIP() << "Started by EncoderOutputContinuesAcrossHandoff";
+    }
+    auto state = receive_handoff();
+    ASSERT_TRUE(state && state->encoder);
+    EXPECT_TRUE(state->encoder->adopted);
+
+    std::vector<uint64_t> frames;
+    g_stream_process->set_telemetry_listener([&frames](const EncoderTelemetry& t) { frames.push_back(t.frame); });
+    supervise_encoder_async(std::move(*state->encoder), state->item.source).wait();
+
+    std::ofstream result(result_path);
+    for (uint64_t frame : frames) {
+        result << frame << "\n";
+    }
+}
+
+TEST(HandoffTest, EncoderOutputContinuesAcrossHandoff) {
+    auto dir = std::filesystem::temp_directory_path() / ("handoff_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    std::string output = (dir / "stream").string();
+    std::string result = (dir / "successor").string();
+    setenv("HANDOFF_TEST_RESULT", result.c_str(), 1);
+
+    // The successor is this test binary again, running only its half
+    pid_t successor = -1;
+    pid_t encoder_pid = -1;
+    std::vector<uint64_t> before;  // Reports the old server saw; read once its future is ready
+    {
+        Handoff handoff({"--gtest_filter=HandoffTest.SuccessorSide"});
+        ASSERT_TRUE(handoff.begin());
+        ASSERT_TRUE(handoff.requested());
+        successor = handoff.successor();
+
+        g_stream_process->reset();
+        g_stream_process->set_telemetry_listener([&before](const EncoderTelemetry& t) { before.push_back(t.frame); });
+        EncoderHandle encoder;
+        encoder.process = spawn_with_policy(fake_encoder(output), {});
+        encoder_pid = encoder.process.pid;
+        auto playing = supervise_encoder_async(std::move(encoder), "continuity-test");
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        // What the playout loop does at its next tick
+        g_stream_process->request_detach();
+        playing.wait();
+        HandoffState state{{"continuity-test"}, "queue", 10.0, 0, g_stream_process->take_detached()};
+        g_stream_process->set_telemetry_listener({});
+        g_stream_process->reset();
+        ASSERT_TRUE(state.encoder) << "The encoder ended before the handoff";
+        EXPECT_EQ(state.encoder->process.pid, encoder_pid);
+        ASSERT_TRUE(handoff.complete(state));
+        close(state.encoder->process.stdout_fd);
+        close(state.encoder->process.pidfd);
+    }  // The old server exits here
+
+    int status = -1;
+    ASSERT_EQ(waitpid(successor, &status, 0), successor);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0) << status;
+    waitpid(encoder_pid, nullptr, 0);
+    unsetenv("HANDOFF_TEST_RESULT");
+
+    // Every frame reached the stream once, in order, without a stall at the handoff
+    std::ifstream stream(output);
+    int64_t frame = 0;
+    int64_t at = 0;
+    int64_t expected = 0;
+    int64_t previous_at = 0;
+    int64_t longest_gap_ns = 0;
+    while (stream >> frame >> at) {
+        EXPECT_EQ(frame, expected++);
+        if (previous_at) {
+            longest_gap_ns = std::max(longest_gap_ns, at - previous_at);
+        }
+        previous_at = at;
+    }
+    EXPECT_EQ(expected, FRAMES);
+    EXPECT_LT(longest_gap_ns, 1'000'000'000);
+
+    // The successor read the reports on from exactly where the old server stopped
+    ASSERT_FALSE(before.empty());
+    std::ifstream successor_frames(result);
+    std::vector<uint64_t> after;
+    for (uint64_t value; successor_frames >> value;) {
+        after.push_back(value);
+    }
+    ASSERT_FALSE(after.empty());
+    EXPECT_EQ(after.front(), before.back() + 1);
+    EXPECT_EQ(after.back(), static_cast<uint64_t>(FRAMES - 1));
+    for (size_t i = 1; i < after.size(); ++i) {
+        EXPECT_EQ(after[i], after[i - 1] + 1);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+// A cut stops the encoder at once, but the playout loop looks at the request only once a
+// second: it must still be there when the loop looks, and the next item must play in full
+TEST(EncoderSupervisionTest, CutItemMakesWayForTheNextOne) {
+    auto dir = std::filesystem::temp_directory_path() / ("supervision_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    g_stream_process->set_interrupt_cooldown(std::chrono::milliseconds(0));
+
+    g_stream_process->reset();  // Top of the playout loop
+    EncoderHandle first;
+    first.process = spawn_with_policy("sleep 30", {});
+    auto playing = supervise_encoder_async(std::move(first), "cut-item");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_TRUE(g_stream_process->interrupt());  // What /queue/priority does
+    ASSERT_EQ(playing.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));  // Playout is still asleep
+    EXPECT_TRUE(g_stream_process->should_terminate());
+    EXPECT_TRUE(g_stream_process->interrupt_requested_at());
+
+    g_stream_process->reset();  // The loop saw the cut; the next item goes on air
+    std::vector<uint64_t> frames;
+    g_stream_process->set_telemetry_listener([&frames](const EncoderTelemetry& t) { frames.push_back(t.frame); });
+    EncoderHandle next;
+    next.process = spawn_with_policy(fake_encoder((dir / "stream").string()), {});
+    supervise_encoder_async(std::move(next), "next-item").wait();
+    g_stream_process->set_telemetry_listener({});
+    g_stream_process->set_interrupt_cooldown(DEFAULT_INTERRUPT_COOLDOWN);
+
+    EXPECT_FALSE(g_stream_process->should_terminate());
+    ASSERT_FALSE(frames.empty());
+    EXPECT_EQ(frames.back(), static_cast<uint64_t>(FRAMES - 1));
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include "../src/hls.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int VIDEO_PID = 0x100;
+constexpr int AUDIO_PID = 0x101;
+constexpr int PMT_PID = 0x1000;
+constexpr int64_t FRAME_TICKS = 3000;  // 30 fps at 90 kHz
+constexpr int GOP = 60;
+
+// One 188-byte packet; the adaptation field pads the payload and carries the keyframe flag
+std::string packet(int pid, bool unit_start, bool random_access, const std::string& payload) {
+    std::string p(188, '\xff');
+    p[0] = 0x47;
+    p[1] = static_cast<char>((unit_start ? 0x40 : 0) | (pid >> 8));
+    p[2] = static_cast<char>(pid & 0xff);
+    size_t adaptation = 188 - 4 - payload.size();
+    p[3] = static_cast<char>(adaptation > 0 ? 0x30 : 0x10);
+    if (adaptation > 0) {
+        p[4] = static_cast<char>(adaptation - 1);
+        if (adaptation > 1) {
+            p[5] = static_cast<char>(random_access ? 0x40 : 0x00);
+        }
+    }
+    p.replace(4 + adaptation, payload.size(), payload);
+    return p;
+}
+
+std::string pat() {
+    std::string section = {0x00, '\xb0', 0x0d, 0x00, 0x01, '\xc1', 0x00, 0x00,
+                           0x00, 0x01, static_cast<char>(0xe0 | (PMT_PID >> 8)), static_cast<char>(PMT_PID & 0xff)};
+    return packet(0, true, false, std::string(1, '\0') + section + std::string(4, '\0'));
+}
+
+std::string pmt() {
+    std::string section = {0x02, '\xb0', 0x17, 0x00, 0x01, '\xc1', 0x00, 0x00,
+                           static_cast<char>(0xe0 | (VIDEO_PID >> 8)), static_cast<char>(VIDEO_PID & 0xff), '\xf0', 0x00,
+                           0x1b, static_cast<char>(0xe0 | (VIDEO_PID >> 8)), static_cast<char>(VIDEO_PID & 0xff), '\xf0', 0x00,
+                           0x0f, static_cast<char>(0xe0 | (AUDIO_PID >> 8)), static_cast<char>(AUDIO_PID & 0xff), '\xf0', 0x00};
+    return packet(PMT_PID, true, false, std::string(1, '\0') + section + std::string(4, '\0'));
+}
+
+std::string video_frame(int64_t pts, bool keyframe) {
+    std::string pes = {0x00, 0x00, 0x01, '\xe0', 0x00, 0x00, '\x80', '\x80', 0x05};
+    pes += static_cast<char>(0x21 | ((pts >> 29) & 0x0e));
+    pes += static_cast<char>((pts >> 22) & 0xff);
+    pes += static_cast<char>(0x01 | ((pts >> 14) & 0xfe));
+    pes += static_cast<char>((pts >> 7) & 0xff);
+    pes += static_cast<char>(0x01 | ((pts << 1) & 0xfe));
+    pes += std::string(100, '\x11');
+    return packet(VIDEO_PID, true, keyframe, pes);
+}
+
+// What ffmpeg writes for `frames` frames from first_pts: tables every second, a keyframe
+// every GOP, an audio packet per frame
+std::string stream(int frames, int64_t first_pts = 126000) {
+    std::string ts;
+    for (int i = 0; i < frames; ++i) {
+        if (i % 30 == 0) {
+            ts += pat() + pmt();
+        }
+        ts += video_frame(first_pts + i * FRAME_TICKS, i % GOP == 0);
+        ts += packet(AUDIO_PID, true, false, std::string(120, '\x22'));
+    }
+    return ts;
+}
+
+// Feeds in uneven chunks, as reads from the FIFO come
+void feed(HlsOutput& hls, const std::string& ts) {
+    for (size_t pos = 0; pos < ts.size(); pos += 1000) {
+        hls.write(std::string_view(ts).substr(pos, 1000));
+    }
+}
+
+bool contains(const std::string& text, const std::string& needle) {
+    return text.find(needle) != std::string::npos;
+}
+
+}  // namespace
+
+TEST(HlsTest, CutsSegmentsAtKeyframes) {
+    HlsOutput hls;
+    EXPECT_FALSE(hls.window()->playlist);
+    feed(hls, std::string(50, 'x') + stream(10 * 30));  // Out of sync at first
+
+    auto window = hls.window();
+    ASSERT_EQ(window->segments.size(), 4u);  // The fifth is still being written
+    EXPECT_EQ(window->next_sequence, 4u);
+    for (uint64_t i = 0; i < 4; ++i) {
+        const HlsSegment* segment = window->find(i);
+        ASSERT_TRUE(segment && segment->data);
+        EXPECT_DOUBLE_EQ(segment->duration, 2.0);
+        EXPECT_EQ(segment->data->size() % 188, 0u);
+        EXPECT_EQ(segment->data->substr(0, 188), pat());  // Decodable from its first byte
+    }
+    EXPECT_FALSE(window->find(4));
+
+    ASSERT_TRUE(window->playlist);
+    const std::string& playlist = *window->playlist;
+    EXPECT_TRUE(playlist.starts_with("#EXTM3U\n"));
+    EXPECT_TRUE(contains(playlist, "#EXT-X-TARGETDURATION:2\n"));
+    EXPECT_TRUE(contains(playlist, "#EXT-X-MEDIA-SEQUENCE:0\n"));
+    EXPECT_TRUE(contains(playlist, "#EXTINF:2.000,\nseg/0.ts\n"));
+    EXPECT_TRUE(contains(playlist, "seg/3.ts\n"));
+    EXPECT_FALSE(contains(playlist, "#EXT-X-PART"));
+}
+
+TEST(HlsTest, SlidesWindowAndMarksDiscontinuities) {
+    HlsOptions options;
+    options.playlist_segments = 3;
+    options.kept_segments = 4;
+    HlsOutput hls(options);
+    feed(hls, stream(20 * 30));
+    feed(hls, stream(4 * 30));  // The next item's encoder starts its timestamps over
+
+    auto window = hls.window();
+    ASSERT_EQ(window->segments.size(), 4u);
+    EXPECT_EQ(window->segments.front()->sequence, 7u);
+    EXPECT_FALSE(window->find(6));
+    ASSERT_TRUE(window->find(10));
+    EXPECT_TRUE(window->find(10)->discontinuity);
+    EXPECT_DOUBLE_EQ(window->find(9)->duration, 2.0);  // Ended by the jump, not by a keyframe
+
+    const std::string& playlist = *window->playlist;
+    EXPECT_TRUE(contains(playlist, "#EXT-X-MEDIA-SEQUENCE:8\n#EXT-X-DISCONTINUITY-SEQUENCE:0\n"));
+    EXPECT_TRUE(contains(playlist, "seg/9.ts\n#EXT-X-DISCONTINUITY\n#EXTINF:2.000,\nseg/10.ts\n"));
+    EXPECT_FALSE(contains(playlist, "seg/7.ts"));
+
+    feed(hls, stream(6 * 30, 5000000));  // A jump forward is one too
+    window = hls.window();
+    EXPECT_TRUE(window->find(12)->discontinuity);
+    EXPECT_TRUE(contains(*window->playlist, "#EXT-X-DISCONTINUITY-SEQUENCE:1\n"));  // seg/10 left the playlist
+}
+
+TEST(HlsTest, CutsPartialSegments) {
+    HlsOptions options;
+    options.part_target = std::chrono::milliseconds(500);
+    HlsOutput hls(options);
+    feed(hls, stream(5 * 30));
+
+    auto window = hls.window();
+    ASSERT_EQ(window->segments.size(), 2u);
+    const HlsSegment& segment = *window->segments[0];
+    ASSERT_EQ(segment.parts.size(), 4u);
+    std::string joined;
+    for (size_t i = 0; i < segment.parts.size(); ++i) {
+        EXPECT_DOUBLE_EQ(segment.parts[i].duration, 0.5);
+        EXPECT_EQ(segment.parts[i].independent, i == 0);
+        joined += *segment.parts[i].data;
+    }
+    EXPECT_EQ(joined, *segment.data);
+
+    ASSERT_TRUE(window->open);
+    EXPECT_EQ(window->open->sequence, 2u);
+    EXPECT_EQ(window->open->parts.size(), 1u);  // 4.5 s of the third segment so far
+    EXPECT_TRUE(window->has(2, 0));
+    EXPECT_FALSE(window->has(2, 1));
+    EXPECT_FALSE(window->has(2, std::nullopt));
+
+    const std::string& playlist = *window->playlist;
+    EXPECT_TRUE(contains(playlist, "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.500\n"));
+    EXPECT_TRUE(contains(playlist, "#EXT-X-PART-INF:PART-TARGET=0.500\n"));
+    EXPECT_TRUE(contains(playlist, "#EXT-X-PART:DURATION=0.500,URI=\"part/1.0.ts\",INDEPENDENT=YES\n"));
+    EXPECT_TRUE(contains(playlist, "#EXT-X-PART:DURATION=0.500,URI=\"part/2.0.ts\",INDEPENDENT=YES\n"));
+    EXPECT_TRUE(playlist.ends_with("#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"part/2.1.ts\"\n"));
+}
+
+TEST(HlsTest, WaitsForSegments) {
+    HlsOutput hls;
+    feed(hls, stream(3 * 30));
+    EXPECT_FALSE(hls.wait_for(1, std::nullopt, std::chrono::milliseconds(20))->has(1, std::nullopt));
+
+    std::thread writer([&hls] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        feed(hls, stream(2 * 30, 126000 + 4 * 30 * FRAME_TICKS));  // Keyframe at 4 s
+    });
+    auto window = hls.wait_for(1, std::nullopt, std::chrono::seconds(5));
+    writer.join();
+    EXPECT_TRUE(window->has(1, std::nullopt));
+}
+
+TEST(HlsTest, ReadsTheFifo) {
+    auto dir = std::filesystem::temp_directory_path() / ("mychannel_hls_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    std::string path = (dir / "hls.fifo").string();
+    {
+        HlsOutput hls;
+        HlsIngest ingest(path, hls);
+        ingest.start();
+        EXPECT_TRUE(std::filesystem::is_fifo(path));
+
+        // What the encoder does: open by name (never blocks, the reader is there) and write
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        ASSERT_GE(fd, 0);
+        std::string ts = stream(5 * 30);
+        ASSERT_EQ(write(fd, ts.data(), ts.size()), static_cast<ssize_t>(ts.size()));
+        close(fd);
+        EXPECT_TRUE(hls.wait_for(1, std::nullopt, std::chrono::seconds(5))->has(1, std::nullopt));
+
+        HlsIngest again(path, hls);  // An existing FIFO is reused, as by a successor
+    }
+    std::ofstream(dir / "plain") << "x";
+    HlsOutput hls;
+    EXPECT_THROW(HlsIngest ingest((dir / "plain").string(), hls), std::runtime_error);
+    std::filesystem::remove_all(dir);
+}
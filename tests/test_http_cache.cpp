@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "../src/http_cache.hpp"
+#include "../src/media_queue.hpp"
+#include <zlib.h>
+#include <string>
+
+namespace {
+
+// Inflates gzip or zlib data (windowBits 15 + 32 detects the wrapper)
+std::string inflate_any(const std::string& data) {
+    z_stream stream{};
+    EXPECT_EQ(inflateInit2(&stream, 15 + 32), Z_OK);
+    std::string out(data.size() * 50 + 1024, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+    out.resize(stream.total_out);
+    inflateEnd(&stream);
+    return out;
+}
+
+std::string large_body() {
+    std::string body = "[";
+    for (int i = 0; i < 200; ++i) {
+        body += "{\"source\":\"videos/clip" + std::to_string(i) + ".mp4\",\"priority\":\"normal\"},";
+    }
+    body.back() = ']';
+    return body;
+}
+
+}  // namespace
+
+TEST(HttpCacheTest, NegotiatesGzipThenDeflateAndHonoursQZero) {
+    EXPECT_EQ(negotiate_encoding(""), ContentEncoding::Identity);
+    EXPECT_EQ(negotiate_encoding("gzip, deflate, br"), ContentEncoding::Gzip);
+    EXPECT_EQ(negotiate_encoding("deflate"), ContentEncoding::Deflate);
+    EXPECT_EQ(negotiate_encoding("gzip;q=0, deflate;q=0.5"), ContentEncoding::Deflate);
+    EXPECT_EQ(negotiate_encoding("gzip; q=0.0"), ContentEncoding::Identity);
+    EXPECT_EQ(negotiate_encoding("*"), ContentEncoding::Gzip);
+    EXPECT_EQ(negotiate_encoding("br, identity"), ContentEncoding::Identity);
+}
+
+TEST(HttpCacheTest, MatchesEtagsWeaklyInLists) {
+    std::string etag = snapshot_etag(7);
+    EXPECT_TRUE(etag.starts_with("W/\""));
+    EXPECT_NE(etag, snapshot_etag(8));
+
+    std::string strong = etag.substr(2);
+    EXPECT_TRUE(etag_matches(etag, etag));
+    EXPECT_TRUE(etag_matches(strong, etag));  // Weak comparison ignores W/
+    EXPECT_TRUE(etag_matches("\"other\", " + etag, etag));
+    EXPECT_TRUE(etag_matches("*", etag));
+    EXPECT_FALSE(etag_matches("", etag));
+    EXPECT_FALSE(etag_matches(snapshot_etag(8), etag));
+    EXPECT_FALSE(etag_matches("garbage", etag));
+}
+
+TEST(HttpCacheTest, CompressesToGzipAndZlib) {
+    std::string body = large_body();
+    std::string gzip = compress(body, ContentEncoding::Gzip);
+    std::string deflate = compress(body, ContentEncoding::Deflate);
+    EXPECT_EQ(static_cast<unsigned char>(gzip[0]), 0x1f);  // gzip magic
+    EXPECT_EQ(static_cast<unsigned char>(gzip[1]), 0x8b);
+    EXPECT_EQ(static_cast<unsigned char>(deflate[0]) & 0x0f, 8);  // zlib header, CM = deflate
+    EXPECT_LT(gzip.size(), body.size() / 4);
+    EXPECT_EQ(inflate_any(gzip), body);
+    EXPECT_EQ(inflate_any(deflate), body);
+}
+
+TEST(HttpCacheTest, RendersAndCompressesOncePerRevision) {
+    ResponseCache cache;
+    int renders = 0;
+    auto render = [&] {
+        ++renders;
+        return large_body();
+    };
+
+    auto first = cache.get("queue", 1, ContentEncoding::Gzip, render);
+    auto second = cache.get("queue", 1, ContentEncoding::Gzip, render);
+    EXPECT_EQ(first.encoding, ContentEncoding::Gzip);
+    EXPECT_EQ(first.data, second.data);  // The same compressed bytes, not a copy
+    EXPECT_EQ(inflate_any(*first.data), large_body());
+
+    // Identity for the same revision reuses the render
+    auto plain = cache.get("queue", 1, ContentEncoding::Identity, render);
+    EXPECT_EQ(*plain.data, large_body());
+    EXPECT_EQ(renders, 1);
+    EXPECT_EQ(cache.hits(), 2u);
+
+    // A new revision renders again
+    cache.get("queue", 2, ContentEncoding::Gzip, render);
+    EXPECT_EQ(renders, 2);
+    // A late render for an older revision does not replace the newer entry
+    cache.get("queue", 1, ContentEncoding::Identity, render);
+    cache.get("queue", 2, ContentEncoding::Gzip, render);
+    EXPECT_EQ(renders, 3);
+}
+
+TEST(HttpCacheTest, SmallBodiesAreNotCompressed) {
+    ResponseCache cache;
+    auto body = cache.get("status", 1, ContentEncoding::Gzip, [] { return std::string("{\"status\":\"running\"}"); });
+    EXPECT_EQ(body.encoding, ContentEncoding::Identity);
+    EXPECT_EQ(*body.data, "{\"status\":\"running\"}");
+    cache.get("status", 1, ContentEncoding::Deflate, [] { return std::string("unused"); });
+    EXPECT_EQ(cache.hits(), 1u);
+}
+
+TEST(HttpCacheTest, KeyLimitStartsOver) {
+    ResponseCache cache(2);
+    int renders = 0;
+    auto render = [&] {
+        ++renders;
+        return std::string("x");
+    };
+    cache.get("a", 1, ContentEncoding::Identity, render);
+    cache.get("b", 1, ContentEncoding::Identity, render);
+    cache.get("c", 1, ContentEncoding::Identity, render);  // Full: cleared
+    cache.get("a", 1, ContentEncoding::Identity, render);
+    EXPECT_EQ(renders, 4);
+}
+
+TEST(HttpCacheTest, SnapshotRevisionTracksStatsOnlyChanges) {
+    ThreadSafeMediaQueue queue;
+    queue.push("videos/a.mp4");
+    auto before = queue.snapshot();
+    queue.record_airtime(DEFAULT_SUBMITTER, 30.0);  // Same items, new stats for /status
+    auto after = queue.snapshot();
+    EXPECT_EQ(after->version, before->version);
+    EXPECT_GT(after->revision, before->revision);
+}
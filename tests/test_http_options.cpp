@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include "../src/http_server.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const char* const HTTP_ENV[] = {
+    "MYCHANNEL_HTTP_THREADS",           "MYCHANNEL_HTTP_MAX_CONNECTIONS", "MYCHANNEL_HTTP_KEEPALIVE_REQUESTS",
+    "MYCHANNEL_HTTP_KEEPALIVE_TIMEOUT", "MYCHANNEL_HTTP_READ_TIMEOUT_MS", "MYCHANNEL_HTTP_WRITE_TIMEOUT_MS",
+    "MYCHANNEL_HTTP_MAX_PAYLOAD",       "MYCHANNEL_IMPORT_DIR",           "MYCHANNEL_HTTP_MAX_INFLIGHT_MCP",
+};
+
+class HttpOptionsTest : public ::testing::Test {
+protected:
+    void SetUp() override { clear(); }
+    void TearDown() override { clear(); }
+
+    static void clear() {
+        for (const char* name : HTTP_ENV) {
+            unsetenv(name);
+        }
+    }
+};
+
+// Holds every job until release() so the queue's occupancy can be observed
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return open; });
+    }
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = true;
+        }
+        cv.notify_all();
+    }
+};
+
+template <typename Predicate>
+bool eventually(Predicate predicate) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST_F(HttpOptionsTest, DefaultsWithoutEnvironment) {
+    auto options = HttpServer::Options::from_env();
+    EXPECT_EQ(options.worker_threads, 0u);
+    EXPECT_GE(options.workers(), 8u);
+    EXPECT_EQ(options.max_connections, 1024u);
+    EXPECT_EQ(options.keep_alive_max_requests, 100u);
+    EXPECT_EQ(options.keep_alive_timeout, std::chrono::seconds(5));
+    EXPECT_EQ(options.read_timeout, std::chrono::milliseconds(5000));
+    EXPECT_EQ(options.write_timeout, std::chrono::milliseconds(5000));
+    EXPECT_EQ(options.max_payload_bytes, 16u * 1024 * 1024);
+    EXPECT_TRUE(options.tcp_nodelay);
+    EXPECT_TRUE(options.import_dir.empty());  // /queue/import?path= is refused
+    EXPECT_EQ(options.inflight_limit(), options.workers() / 2);
+    EXPECT_EQ(options.mcp_inflight_limit(), options.workers() / 4);
+}
+
+TEST_F(HttpOptionsTest, ReadsEnvironment) {
+    setenv("MYCHANNEL_HTTP_THREADS", "32", 1);
+    setenv("MYCHANNEL_HTTP_MAX_CONNECTIONS", "4096", 1);
+    setenv("MYCHANNEL_HTTP_KEEPALIVE_REQUESTS", "1000", 1);
+    setenv("MYCHANNEL_HTTP_KEEPALIVE_TIMEOUT", "30", 1);
+    setenv("MYCHANNEL_HTTP_READ_TIMEOUT_MS", "250", 1);
+    setenv("MYCHANNEL_HTTP_WRITE_TIMEOUT_MS", "1500", 1);
+    setenv("MYCHANNEL_HTTP_MAX_PAYLOAD", "65536", 1);
+    setenv("MYCHANNEL_IMPORT_DIR", "/srv/playlists", 1);
+    setenv("MYCHANNEL_HTTP_MAX_INFLIGHT_MCP", "3", 1);
+    auto options = HttpServer::Options::from_env();
+    EXPECT_EQ(options.workers(), 32u);
+    EXPECT_EQ(options.max_connections, 4096u);
+    EXPECT_EQ(options.keep_alive_max_requests, 1000u);
+    EXPECT_EQ(options.keep_alive_timeout, std::chrono::seconds(30));
+    EXPECT_EQ(options.read_timeout, std::chrono::milliseconds(250));
+    EXPECT_EQ(options.write_timeout, std::chrono::milliseconds(1500));
+    EXPECT_EQ(options.max_payload_bytes, 65536u);
+    EXPECT_EQ(options.import_dir, "/srv/playlists");
+    EXPECT_EQ(options.mcp_inflight_limit(), 3u);
+}
+
+TEST_F(HttpOptionsTest, InvalidValuesKeepDefaults) {
+    setenv("MYCHANNEL_HTTP_THREADS", "many", 1);
+    setenv("MYCHANNEL_HTTP_MAX_CONNECTIONS", "0", 1);
+    setenv("MYCHANNEL_HTTP_KEEPALIVE_TIMEOUT", "-1", 1);
+    setenv("MYCHANNEL_HTTP_READ_TIMEOUT_MS", "100ms", 1);
+    auto options = HttpServer::Options::from_env();
+    EXPECT_EQ(options.worker_threads, 0u);
+    EXPECT_EQ(options.max_connections, 1024u);
+    EXPECT_EQ(options.keep_alive_timeout, std::chrono::seconds(5));
+    EXPECT_EQ(options.read_timeout, std::chrono::milliseconds(5000));
+}
+
+TEST(HttpConnectionQueueTest, RejectsConnectionsBeyondWorkersPlusWaiting) {
+    Gate gate;
+    std::atomic<int> served{0};
+    HttpConnectionQueue queue(2, 3);
+    auto job = [&] {
+        gate.wait();
+        ++served;
+    };
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(queue.enqueue(job)) << i;
+    }
+    ASSERT_TRUE(eventually([&] { return queue.active() == 2; }));
+    EXPECT_EQ(queue.waiting(), 3u);
+
+    // Over the limit: refused at once, which makes httplib close the socket
+    EXPECT_FALSE(queue.enqueue(job));
+    EXPECT_EQ(queue.rejected(), 1u);
+
+    gate.release();
+    ASSERT_TRUE(eventually([&] { return served == 5; }));
+    EXPECT_TRUE(eventually([&] { return queue.active() == 0 && queue.waiting() == 0; }));
+    queue.shutdown();
+}
+
+TEST(HttpConnectionQueueTest, ShutdownServesQueuedConnections) {
+    std::atomic<int> served{0};
+    HttpConnectionQueue queue(1, 16);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(queue.enqueue([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ++served;
+        }));
+    }
+    queue.shutdown();
+    EXPECT_EQ(served, 10);
+    EXPECT_FALSE(queue.enqueue([] {}));  // Nothing takes work after shutdown
+    EXPECT_FALSE(queue.enqueue([] {}));
+    EXPECT_EQ(queue.open(), 0u);
+    EXPECT_EQ(queue.rejected(), 0u);  // Not over the limit, just closed
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "../src/json_response.hpp"
+#include "../src/media_queue.hpp"
+
+namespace {
+
+glz::json_t parse(const std::string& json) {
+    glz::json_t value;
+    EXPECT_FALSE(glz::read_json(value, json)) << json;
+    return value;
+}
+
+} // namespace
+
+// Sources with quotes, backslashes and control characters still produce valid JSON
+TEST(JsonResponseTest, EscapesQueueSources) {
+    ThreadSafeMediaQueue queue;
+    const std::string tricky = "videos/say \"hi\"\\n\tnow.mp4";
+    queue.push_back(QueueItem{tricky, PriorityClass::Normal, "ed\"itor"});
+    queue.push_back(QueueItem{"videos/plain.mp4", PriorityClass::Normal, DEFAULT_SUBMITTER});
+
+    auto snapshot = queue.snapshot();
+    auto json = parse(write_json_response(queue_page(*snapshot, 0, 10)));
+    ASSERT_EQ(json["queue"].get_array().size(), 2u);
+    EXPECT_EQ(json["queue"][0].get_string(), tricky);
+    EXPECT_EQ(json["size"].get<size_t>(), 2u);
+    EXPECT_EQ(json["version"].get<uint64_t>(), snapshot->version);
+
+    QueuePositionResponse position{.mode = "loop"};
+    position.up_next = queue_item_view(snapshot->items[0]);
+    auto view = parse(write_json_response(position));
+    EXPECT_EQ(view["up_next"]["submitter"].get_string(), "ed\"itor");
+    EXPECT_EQ(view["up_next"]["class"].get_string(), "normal");
+    EXPECT_FALSE(view.contains("now_playing"));
+}
+
+TEST(JsonResponseTest, PagesAreClamped) {
+    ThreadSafeMediaQueue queue;
+    for (int i = 0; i < 5; ++i) {
+        queue.push_back(QueueItem{"videos/" + std::to_string(i) + ".mp4"});
+    }
+    auto snapshot = queue.snapshot();
+    auto page = queue_page(*snapshot, 3, 10);
+    EXPECT_EQ(page.queue, (std::vector<std::string_view>{"videos/3.mp4", "videos/4.mp4"}));
+    EXPECT_EQ(page.offset, 3u);
+    EXPECT_TRUE(queue_page(*snapshot, 9, 1).queue.empty());
+}
+
+// Optional fields are left out, and renamed fields use their JSON names
+TEST(JsonResponseTest, OptionalAndRenamedFields) {
+    QueueChangesResponse changes{7, false, {{6, "clear"}, {7, "insert", "a.mp4", "breaking", "desk"}}};
+    EXPECT_EQ(write_json_response(changes),
+              R"({"version":7,"resync":false,"changes":[{"version":6,"op":"clear"},)"
+              R"({"version":7,"op":"insert","source":"a.mp4","class":"breaking","submitter":"desk"}]})");
+
+    EXPECT_EQ(write_json_response(ErrorResponse{.message = "Cannot read \"x\""}),
+              R"({"status":"error","message":"Cannot read \"x\""})");
+}
+
+// The buffer is reused: a second, smaller response does not keep the first one's tail
+TEST(JsonResponseTest, ReusesThreadBuffer) {
+    const std::string* first = &write_json_response(MessageResponse{.message = std::string(1000, 'x')});
+    const std::string& second = write_json_response(MessageResponse{.message = "ok"});
+    EXPECT_EQ(first, &second);
+    EXPECT_EQ(second, R"({"status":"success","message":"ok"})");
+    EXPECT_GE(second.capacity(), 1000u);
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include "../src/logger.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Pipe the logger writes into; read() collects everything written so far
+class LogPipe {
+public:
+    LogPipe() {
+        EXPECT_EQ(pipe(fds_), 0);
+        fcntl(fds_[0], F_SETFL, O_NONBLOCK);
+        fcntl(fds_[1], F_SETPIPE_SZ, 1 << 20);
+    }
+    ~LogPipe() {
+        close(fds_[0]);
+        close(fds_[1]);
+    }
+    int fd() const { return fds_[1]; }
+
+    std::string read() {
+        std::string out;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::read(fds_[0], buffer, sizeof(buffer))) > 0) {
+            out.append(buffer, static_cast<size_t>(n));
+        }
+        return out;
+    }
+
+private:
+    int fds_[2];
+};
+
+size_t count_lines(const std::string& text) {
+    return static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+}
+
+LogRecord make_record(LogLevel level, LogCategory category, std::string_view message,
+                      std::initializer_list<LogField> fields) {
+    LogRecord record;
+    record.time_ns = 1760779800125000000;  // 2025-10-18T09:30:00.125Z
+    record.level = level;
+    record.category = category;
+    Logger::encode(record, message, fields);
+    return record;
+}
+
+}  // namespace
+
+TEST(LoggerTest, FormatsTextAsLogfmtFields) {
+    auto record = make_record(LogLevel::Info, LogCategory::Http, "Item added to queue",
+                              {{"item", "videos/a b.mp4"}, {"submitter", "alice"}, {"weight", 1.5}, {"count", 3}});
+    std::string line;
+    Logger::format(record, LogFormat::Text, line);
+    EXPECT_EQ(line, "2025-10-18T09:30:00.125Z INFO  [http] Item added to queue item=\"videos/a b.mp4\" "
+                    "submitter=alice weight=1.5 count=3\n");
+}
+
+TEST(LoggerTest, FormatsJsonWithTypedAndEscapedFields) {
+    auto record = make_record(LogLevel::Warn, LogCategory::Queue, "say \"hi\"\n",
+                              {{"path", "C:\\tmp"}, {"ok", false}, {"bytes", size_t{42}}, {"ratio", 1.0 / 0.0}});
+    std::string line;
+    Logger::format(record, LogFormat::Json, line);
+    EXPECT_EQ(line, "{\"ts\":\"2025-10-18T09:30:00.125Z\",\"level\":\"warn\",\"category\":\"queue\","
+                    "\"msg\":\"say \\\"hi\\\"\\n\",\"path\":\"C:\\\\tmp\",\"ok\":false,\"bytes\":42,\"ratio\":null}\n");
+}
+
+TEST(LoggerTest, TruncatesOversizedRecordsOnCharacterBoundaries) {
+    std::string long_value;
+    for (int i = 0; i < 400; ++i) long_value += "é";  // Two bytes each
+    auto record = make_record(LogLevel::Info, LogCategory::Main, "big", {{"value", long_value}, {"dropped", 1}});
+    EXPECT_TRUE(record.truncated);
+    EXPECT_LE(record.size, sizeof(record.data));
+
+    std::string line;
+    Logger::format(record, LogFormat::Json, line);
+    EXPECT_NE(line.find(",\"truncated\":true}"), std::string::npos);
+    EXPECT_EQ(line.find("dropped"), std::string::npos);
+    // The value ends on a whole "é"
+    size_t end = line.find("\",\"truncated\"");
+    ASSERT_NE(end, std::string::npos);
+    EXPECT_EQ(line.substr(end - 2, 2), "é");
+}
+
+TEST(LoggerTest, WritesRecordsInOrderFromTheBackgroundThread) {
+    LogPipe pipe;
+    Logger::Options options;
+    options.fd = pipe.fd();
+    Logger logger(options);
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(logger.log(LogLevel::Info, LogCategory::Playout, "tick", {{"n", i}}));
+    }
+    EXPECT_FALSE(logger.log(LogLevel::Debug, LogCategory::Playout, "filtered"));
+    ASSERT_TRUE(logger.flush());
+
+    std::string out = pipe.read();
+    EXPECT_EQ(count_lines(out), 100u);
+    EXPECT_LT(out.find("n=0\n"), out.find("n=99\n"));
+    EXPECT_EQ(out.find("filtered"), std::string::npos);
+    EXPECT_EQ(logger.written(), 100u);
+
+    logger.set_level(LogLevel::Debug);
+    EXPECT_TRUE(logger.log(LogLevel::Debug, LogCategory::Playout, "now shown"));
+    ASSERT_TRUE(logger.flush());
+    EXPECT_NE(pipe.read().find("DEBUG [playout] now shown"), std::string::npos);
+}
+
+TEST(LoggerTest, SamplesInfoButNeverWarnings) {
+    LogPipe pipe;
+    Logger::Options options;
+    options.fd = pipe.fd();
+    options.sample_every = parse_log_sampling("progress=10,bogus=3,stream=x");
+    EXPECT_EQ(options.sample_every[static_cast<size_t>(LogCategory::Stream)], 0u);
+    Logger logger(options);
+
+    for (int i = 0; i < 100; ++i) {
+        logger.log(LogLevel::Info, LogCategory::Progress, "Playing", {{"second", i + 1}});
+        logger.log(LogLevel::Warn, LogCategory::Progress, "Late");
+    }
+    ASSERT_TRUE(logger.flush());
+    std::string out = pipe.read();
+    EXPECT_EQ(count_lines(out), 110u);
+    EXPECT_NE(out.find("second=1\n"), std::string::npos);  // The first of each ten is kept
+    EXPECT_EQ(out.find("second=2\n"), std::string::npos);
+    EXPECT_EQ(logger.sampled_out(), 90u);
+}
+
+TEST(LoggerTest, DropsInsteadOfBlockingWhenTheRingIsFull) {
+    LogPipe pipe;
+    Logger::Options options;
+    options.fd = pipe.fd();
+    options.capacity = 8;
+    options.idle_interval = std::chrono::hours(1);  // Only flush() wakes the writer
+    Logger logger(options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));  // Let the writer go to sleep
+
+    for (int i = 0; i < 1000; ++i) {
+        logger.log(LogLevel::Info, LogCategory::Http, "burst", {{"n", i}});
+    }
+    EXPECT_GE(logger.dropped(), 1000u - 8u);
+    ASSERT_TRUE(logger.flush());
+    EXPECT_EQ(logger.written() + logger.dropped(), 1000u);
+    EXPECT_EQ(count_lines(pipe.read()), logger.written());
+}
+
+TEST(LoggerTest, ConcurrentProducersLoseNothingWithRoom) {
+    LogPipe pipe;
+    Logger::Options options;
+    options.fd = pipe.fd();
+    options.capacity = 8192;
+    Logger logger(options);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 500; ++i) {
+                logger.log(LogLevel::Info, LogCategory::Http, "request", {{"thread", t}, {"n", i}});
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    ASSERT_TRUE(logger.flush());
+    EXPECT_EQ(logger.dropped(), 0u);
+    EXPECT_EQ(count_lines(pipe.read()), 4000u);
+}
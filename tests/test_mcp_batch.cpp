@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <glaze/glaze.hpp>
+#include "../src/mcp_server.hpp"
+#include "../src/http_server.hpp"
+#include "../src/media_queue.hpp"
+
+class MCPBatchTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        queue = std::make_unique<ThreadSafeMediaQueue>();
+        HttpServer::Options options;
+        options.validate_on_add = false;  // Queue at once; validation has its own tests
+        http_server = std::make_unique<HttpServer>(*queue, nullptr, options);
+        mcp_server = std::make_unique<MCPServer>(*http_server);
+    }
+
+    static std::string add_call(int id, const std::string& source) {
+        return R"({"jsonrpc":"2.0","id":)" + std::to_string(id) +
+               R"(,"method":"tools/call","params":{"name":"add_video_to_queue","arguments":{"source":")" + source +
+               R"("}}})";
+    }
+
+    std::unique_ptr<ThreadSafeMediaQueue> queue;
+    std::unique_ptr<HttpServer> http_server;
+    std::unique_ptr<MCPServer> mcp_server;
+};
+
+// Ids come back as the client sent them, numbers included
+TEST_F(MCPBatchTest, SingleRequestEchoesRawId) {
+    auto response = mcp_server->handle_jsonrpc(R"({"jsonrpc":"2.0","id":7,"method":"tools/list"})", true);
+    ASSERT_TRUE(response);
+    auto json = mcp_server->parse_json(*response);
+    ASSERT_TRUE(json["id"].is_number());
+    EXPECT_EQ(json["id"].get_number(), 7.0);
+    EXPECT_EQ(json["result"]["tools"].size(), std::tuple_size_v<MCPTools>);
+}
+
+// The agent workflow: queue several items and read the status in one round trip
+TEST_F(MCPBatchTest, WritesThenReadInOrder) {
+    std::string body = "[" + add_call(1, "videos/a.mp4") + "," + add_call(2, "videos/b.mp4") + "," +
+                       add_call(3, "videos/c.mp4") +
+                       R"(,{"jsonrpc":"2.0","id":"status","method":"tools/call","params":{"name":"get_stream_status","arguments":{}}}])";
+
+    auto response = mcp_server->handle_jsonrpc(body, true);
+    ASSERT_TRUE(response);
+    auto json = mcp_server->parse_json(*response);
+    ASSERT_TRUE(json.is_array());
+    auto& responses = json.get_array();
+    ASSERT_EQ(responses.size(), 4u);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(responses[i]["id"].get_number(), i + 1.0);
+        EXPECT_TRUE(responses[i].contains("result")) << *response;
+    }
+    EXPECT_EQ(responses[3]["id"].get_string(), "status");
+    // The read follows the writes, so it sees all three
+    auto status = mcp_server->parse_json(responses[3]["result"]["content"][0]["text"].dump().value_or(""));
+    EXPECT_EQ(status["result"]["queue_size"].get_number(), 3.0);
+    EXPECT_EQ(queue->size(), 3u);
+}
+
+// Notifications run but are not answered; a batch of only notifications has no body
+TEST_F(MCPBatchTest, NotificationsGetNoResponse) {
+    std::string body = R"([{"jsonrpc":"2.0","method":"notifications/initialized"},
+        {"jsonrpc":"2.0","method":"tools/call","params":{"name":"add_video_to_queue","arguments":{"source":"videos/a.mp4"}}}])";
+    EXPECT_FALSE(mcp_server->handle_jsonrpc(body, true));
+    EXPECT_EQ(queue->size(), 1u);
+
+    EXPECT_FALSE(mcp_server->handle_jsonrpc(R"({"jsonrpc":"2.0","method":"notifications/initialized"})", true));
+
+    // An explicit null id is a request, not a notification
+    auto response = mcp_server->handle_jsonrpc(R"({"jsonrpc":"2.0","id":null,"method":"initialize"})", true);
+    ASSERT_TRUE(response);
+    EXPECT_NE(response->find(R"("id":null)"), std::string::npos);
+}
+
+TEST_F(MCPBatchTest, InvalidMembersAndBatches) {
+    auto response = mcp_server->handle_jsonrpc(R"([1,{"jsonrpc":"2.0","id":2,"method":"tools/list"}])", true);
+    ASSERT_TRUE(response);
+    auto json = mcp_server->parse_json(*response);
+    ASSERT_EQ(json.size(), 2u);
+    EXPECT_EQ(json[0]["error"]["code"].get_number(), -32600.0);
+    EXPECT_TRUE(json[0]["id"].is_null());
+    EXPECT_EQ(json[1]["id"].get_number(), 2.0);
+
+    auto empty = mcp_server->parse_json(*mcp_server->handle_jsonrpc("[]", true));
+    EXPECT_EQ(empty["error"]["code"].get_number(), -32600.0);
+
+    auto broken = mcp_server->parse_json(*mcp_server->handle_jsonrpc(R"([{"jsonrpc":"2.0",)", true));
+    EXPECT_EQ(broken["error"]["code"].get_number(), -32700.0);
+
+    std::string oversized = "[";
+    for (int i = 0; i <= 100; ++i) {
+        oversized += (i ? "," : "") + std::string(R"({"jsonrpc":"2.0","id":1,"method":"tools/list"})");
+    }
+    oversized += "]";
+    auto too_big = mcp_server->parse_json(*mcp_server->handle_jsonrpc(oversized, true));
+    EXPECT_EQ(too_big["error"]["code"].get_number(), -32600.0);
+}
+
+// Authentication is checked once per HTTP request and applies to every tool call in it
+TEST_F(MCPBatchTest, UnauthenticatedToolCallsAreRefused) {
+    std::string body = R"([{"jsonrpc":"2.0","id":1,"method":"initialize"},)" + add_call(2, "videos/a.mp4") + "]";
+    auto json = mcp_server->parse_json(*mcp_server->handle_jsonrpc(body, false));
+    ASSERT_EQ(json.size(), 2u);
+    EXPECT_TRUE(json[0].contains("result"));
+    EXPECT_EQ(json[1]["error"]["code"].get_number(), -32001.0);
+    EXPECT_EQ(queue->size(), 0u);
+}
+
+// A run of probes and reads is spread over the pool; responses still come back in request order
+TEST_F(MCPBatchTest, ParallelReadsKeepOrder) {
+    std::string body = "[";
+    for (int i = 0; i < 40; ++i) {
+        std::string call = i % 2 ? R"({"name":"get_streaming_queue","arguments":{}})"
+                                 : R"({"name":"get_video_duration","arguments":{"source":"/nonexistent/clip.mp4"}})";
+        body += (i ? "," : "") + std::string(R"({"jsonrpc":"2.0","id":)") + std::to_string(i) +
+                R"(,"method":"tools/call","params":)" + call + "}";
+    }
+    body += "]";
+    auto json = mcp_server->parse_json(*mcp_server->handle_jsonrpc(body, true));
+    ASSERT_EQ(json.size(), 40u);
+    for (int i = 0; i < 40; ++i) {
+        EXPECT_EQ(json[i]["id"].get_number(), double(i));
+        EXPECT_TRUE(json[i].contains("result"));
+    }
+}
+
+// notifications/cancelled for an id that is not running is a no-op, never an error
+TEST_F(MCPBatchTest, CancelUnknownRequestIsSilent) {
+    EXPECT_FALSE(mcp_server->handle_jsonrpc(
+        R"({"jsonrpc":"2.0","method":"notifications/cancelled","params":{"requestId":5,"reason":"user"}})", true));
+}
+
+// Probes run inline on the synchronous path, under the tool's timeout
+TEST_F(MCPBatchTest, ProbeRunsInline) {
+    auto response = mcp_server->handle_jsonrpc(
+        R"({"jsonrpc":"2.0","id":9,"method":"tools/call","params":{"name":"get_video_duration","arguments":{"source":"/nonexistent/clip.mp4"},"_meta":{"progressToken":"p"}}})",
+        true);
+    ASSERT_TRUE(response);
+    auto json = mcp_server->parse_json(*response);
+    EXPECT_EQ(json["id"].get_number(), 9.0);
+    EXPECT_TRUE(json.contains("result")) << *response;
+}
@@ -8,7 +8,9 @@ class MCPToolsCallTest : public ::testing::Test {
 protected:
     void SetUp() override {
         queue = std::make_unique<ThreadSafeMediaQueue>();
-        http_server = std::make_unique<HttpServer>(*queue);
+        HttpServer::Options options;
+        options.validate_on_add = false;  // Queue at once; validation has its own tests
+        http_server = std::make_unique<HttpServer>(*queue, nullptr, options);
         mcp_server = std::make_unique<MCPServer>(*http_server);
     }
 
@@ -130,3 +132,50 @@ TEST_F(MCPToolsCallTest, IdExtractionTypes) {
     ASSERT_TRUE(result_null.contains("id"));
     ASSERT_TRUE(result_null["id"].is_null());
 }
+
+// Arguments are read straight into the tool's struct and reach the handler
+TEST_F(MCPToolsCallTest, TypedArgumentsReachHandler) {
+    std::string json = R"({"jsonrpc":"2.0","method":"tools/call","params":{"name":"add_video_to_queue","arguments":{"source":"videos/a.mp4","submitter":"alice","extra":1}},"id":"call-1"})";
+
+    std::string result = mcp_server->handle_mcp_tool_call("call-1", mcp_server->parse_json(json));
+    EXPECT_NE(result.find("Video added to queue: videos/a.mp4"), std::string::npos) << result;
+
+    auto snapshot = queue->snapshot();
+    ASSERT_EQ(snapshot->items.size(), 1u);
+    EXPECT_EQ(snapshot->items[0].source, "videos/a.mp4");
+    EXPECT_EQ(snapshot->items[0].submitter, "alice");
+}
+
+TEST_F(MCPToolsCallTest, MistypedArgumentsAreInvalidParams) {
+    std::string json = R"({"jsonrpc":"2.0","method":"tools/call","params":{"name":"import_playlist","arguments":{"playlist":"[]","probe":"yes"}},"id":"call-2"})";
+
+    std::string result = mcp_server->handle_mcp_tool_call("call-2", mcp_server->parse_json(json));
+    auto response = mcp_server->parse_json(result);
+    ASSERT_TRUE(response.contains("error")) << result;
+    EXPECT_EQ(response["error"]["code"].get_number(), -32602.0);
+    EXPECT_EQ(queue->size(), 0u);
+}
+
+TEST_F(MCPToolsCallTest, UnknownToolIsNotFound) {
+    std::string json = R"({"jsonrpc":"2.0","method":"tools/call","params":{"name":"no_such_tool","arguments":{}},"id":"call-3"})";
+
+    auto response = mcp_server->parse_json(mcp_server->handle_mcp_tool_call("call-3", mcp_server->parse_json(json)));
+    ASSERT_TRUE(response.contains("error"));
+    EXPECT_EQ(response["error"]["code"].get_number(), -32601.0);
+}
+
+// tools/list is built from the registry, in registry order
+TEST_F(MCPToolsCallTest, ToolsSchemaMatchesRegistry) {
+    auto tools = mcp_server->get_available_tools();
+    ASSERT_EQ(tools.size(), std::tuple_size_v<MCPTools>);
+    EXPECT_EQ(tools.front().name, AddVideoToQueueTool::name);
+    EXPECT_EQ(tools.back().name, GetScheduleTool::name);
+
+    auto schema = mcp_server->parse_json(mcp_server->get_tools_schema());
+    auto& listed = schema["tools"].get_array();
+    ASSERT_EQ(listed.size(), tools.size());
+    for (size_t i = 0; i < tools.size(); ++i) {
+        EXPECT_EQ(listed[i]["name"].get_string(), tools[i].name);
+        EXPECT_TRUE(listed[i]["inputSchema"].is_object());
+    }
+}
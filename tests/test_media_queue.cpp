@@ -0,0 +1,410 @@
+#include <gtest/gtest.h>
+#include "../src/media_queue.hpp"
+#include <thread>
+#include <atomic>
+
+class MediaQueueTest : public ::testing::Test {
+protected:
+    ThreadSafeMediaQueue queue;
+};
+
+// Snapshots are immutable and carry the version they were taken at
+TEST_F(MediaQueueTest, SnapshotIsImmutableAndVersioned) {
+    queue.push("a.mp4");
+    queue.push("b.mp4");
+    auto before = queue.snapshot();
+    uint64_t version_before = queue.version();
+    EXPECT_EQ(before->version, version_before);
+
+    queue.push_front("priority.mp4");
+
+    EXPECT_EQ(before->items.size(), 2);
+    EXPECT_EQ(before->items[0].source, "a.mp4");
+    EXPECT_GT(queue.version(), version_before);
+
+    auto after = queue.snapshot();
+    ASSERT_EQ(after->items.size(), 3);
+    EXPECT_EQ(after->items[0].source, "priority.mp4");
+    EXPECT_EQ(after->version, queue.version());
+}
+
+// Size and empty are answered without building a copy
+TEST_F(MediaQueueTest, SizeTracksMutations) {
+    EXPECT_TRUE(queue.empty());
+    queue.push("a.mp4");
+    queue.push("b.mp4");
+    EXPECT_EQ(queue.size(), 2);
+
+    std::string item;
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item, "a.mp4");
+    EXPECT_EQ(queue.size(), 1);
+
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop(item));
+}
+
+// Paginated reads clamp to the queue bounds
+TEST_F(MediaQueueTest, PaginatedReads) {
+    for (int i = 0; i < 10; ++i) {
+        queue.push("item" + std::to_string(i));
+    }
+
+    auto page = queue.get_items(3, 4);
+    ASSERT_EQ(page.size(), 4);
+    EXPECT_EQ(page.front(), "item3");
+    EXPECT_EQ(page.back(), "item6");
+
+    EXPECT_EQ(queue.get_items(8, 100).size(), 2);
+    EXPECT_TRUE(queue.get_items(10, 5).empty());
+    EXPECT_EQ(queue.get_all_items().size(), 10);
+}
+
+// Readers observe consistent snapshots while the playout path rotates items
+TEST_F(MediaQueueTest, ConcurrentReadersSeeConsistentSnapshots) {
+    for (int i = 0; i < 100; ++i) {
+        queue.push("item" + std::to_string(i));
+    }
+
+    std::atomic<bool> running{true};
+    std::atomic<bool> inconsistent{false};
+    std::thread reader([&]() {
+        while (running.load()) {
+            auto snapshot = queue.snapshot();
+            if (snapshot->items.size() != 100 && snapshot->items.size() != 99) {
+                inconsistent.store(true);
+            }
+        }
+    });
+
+    std::string item;
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(queue.pop(item));
+        queue.push_back(item);
+    }
+    running.store(false);
+    reader.join();
+
+    EXPECT_FALSE(inconsistent.load());
+    EXPECT_EQ(queue.size(), 100);
+}
+
+// Higher classes play first and each class keeps FIFO order under bursts
+TEST_F(MediaQueueTest, PriorityClassesAreFifoWithinClass) {
+    queue.push("normal1.mp4");
+    queue.enqueue("next1.mp4", PriorityClass::Next);
+    queue.enqueue("interrupt1.mp4", PriorityClass::Interrupt);
+    queue.enqueue("interrupt2.mp4", PriorityClass::Interrupt);
+    queue.enqueue("breaking1.mp4", PriorityClass::Breaking);
+    queue.enqueue("next2.mp4", PriorityClass::Next);
+
+    auto snapshot = queue.snapshot();
+    EXPECT_EQ(snapshot->class_counts[static_cast<size_t>(PriorityClass::Interrupt)], 2);
+
+    std::vector<std::string> order;
+    QueueItem item;
+    while (queue.pop(item)) {
+        order.push_back(item.source);
+    }
+    std::vector<std::string> expected = {"breaking1.mp4", "interrupt1.mp4", "interrupt2.mp4",
+                                         "next1.mp4", "next2.mp4", "normal1.mp4"};
+    EXPECT_EQ(order, expected);
+}
+
+// enqueue reports the configured interrupt policy for the class
+TEST_F(MediaQueueTest, InterruptPolicyPerClass) {
+    EXPECT_EQ(queue.enqueue("a.mp4", PriorityClass::Next), InterruptPolicy::EndOfItem);
+    EXPECT_EQ(queue.enqueue("b.mp4", PriorityClass::Breaking), InterruptPolicy::Immediate);
+
+    queue.set_interrupt_policy(PriorityClass::Interrupt, InterruptPolicy::SegmentBoundary);
+    EXPECT_EQ(queue.enqueue("c.mp4", PriorityClass::Interrupt), InterruptPolicy::SegmentBoundary);
+
+    EXPECT_EQ(parse_priority_class("breaking"), PriorityClass::Breaking);
+    EXPECT_FALSE(parse_priority_class("urgent").has_value());
+    EXPECT_EQ(parse_interrupt_policy("segment"), InterruptPolicy::SegmentBoundary);
+}
+
+// A class that cuts the item on air is only reported accepted once it is really queued,
+// however many producers race for the last quota slot
+TEST_F(MediaQueueTest, CuttingEnqueueHonoursQuotaExactly) {
+    queue.set_submitter_policy("agent", {1.0, 1});
+    std::atomic<bool> go{false};
+    std::atomic<int> accepted{0};
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 8; ++t) {
+        producers.emplace_back([&, t] {
+            while (!go.load()) {
+            }
+            for (int i = 0; i < 20; ++i) {
+                auto source = "breaking" + std::to_string(t) + "_" + std::to_string(i) + ".mp4";
+                if (queue.enqueue(source, PriorityClass::Breaking, "agent")) {
+                    ++accepted;
+                }
+            }
+        });
+    }
+    go.store(true);
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(accepted.load(), 1);
+    EXPECT_EQ(queue.size(), 1u);
+    EXPECT_EQ(queue.rejected_submissions(), 0u);
+}
+
+// push() and end-of-item classes report the exact verdict for a submitter with a quota:
+// true means queued, and nothing is dropped behind the caller's back at drain time
+TEST_F(MediaQueueTest, PushHonoursQuotaExactly) {
+    queue.set_submitter_policy("agent", {1.0, 3});
+    std::atomic<bool> go{false};
+    std::atomic<int> accepted{0};
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 8; ++t) {
+        producers.emplace_back([&, t] {
+            while (!go.load()) {
+            }
+            for (int i = 0; i < 20; ++i) {
+                auto source = "clip" + std::to_string(t) + "_" + std::to_string(i) + ".mp4";
+                bool queued = i % 2 ? queue.push(source, "agent")
+                                    : queue.enqueue(source, PriorityClass::Next, "agent").has_value();
+                if (queued) {
+                    ++accepted;
+                }
+            }
+        });
+    }
+    go.store(true);
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(accepted.load(), 3);
+    EXPECT_EQ(queue.size(), 3u);
+    EXPECT_EQ(queue.rejected_submissions(), 0u);
+    EXPECT_TRUE(queue.push("other.mp4", "someone-else"));
+}
+
+// pop_wait returns as soon as another thread enqueues, and times out on an idle queue
+TEST_F(MediaQueueTest, PopWaitWakesOnFirstEnqueue) {
+    QueueItem item;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.pop_wait(item, std::chrono::milliseconds(20)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    std::thread producer([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue.enqueue("breaking.mp4", PriorityClass::Breaking);
+    });
+    ASSERT_TRUE(queue.pop_wait(item, std::chrono::seconds(5)));
+    producer.join();
+    EXPECT_EQ(item.source, "breaking.mp4");
+    EXPECT_EQ(item.priority, PriorityClass::Breaking);
+    EXPECT_TRUE(queue.empty());
+}
+
+// Subscribers get version-stamped deltas and are told to resync once history is gone
+TEST_F(MediaQueueTest, ChangesSinceDeliversDeltas) {
+    uint64_t cursor = queue.version();
+    queue.push("a.mp4", "agent");
+    queue.enqueue("b.mp4", PriorityClass::Next);
+    QueueItem item;
+    queue.pop(item);
+
+    auto changes = queue.changes_since(cursor);
+    EXPECT_FALSE(changes.resync);
+    EXPECT_EQ(changes.version, queue.version());
+    ASSERT_EQ(changes.deltas.size(), 3);
+    EXPECT_EQ(changes.deltas[0].version, cursor + 1);
+    EXPECT_EQ(changes.deltas[0].op, QueueOp::Insert);
+    EXPECT_EQ(changes.deltas[0].item.submitter, "agent");
+    EXPECT_EQ(changes.deltas[1].item.priority, PriorityClass::Next);
+    EXPECT_EQ(changes.deltas[2].op, QueueOp::PopFront);
+    EXPECT_EQ(changes.deltas[2].item.source, "b.mp4");
+
+    EXPECT_TRUE(queue.changes_since(queue.version()).deltas.empty());
+    EXPECT_TRUE(queue.changes_since(queue.version() + 5).resync);
+
+    for (int i = 0; i < 2000; ++i) {
+        queue.push("item" + std::to_string(i));
+    }
+    EXPECT_TRUE(queue.changes_since(cursor).resync);
+}
+
+// wait_for_changes blocks until the version moves past the subscriber's cursor
+TEST_F(MediaQueueTest, WaitForChangesWakesSubscriber) {
+    uint64_t cursor = queue.version();
+    EXPECT_TRUE(queue.wait_for_changes(cursor, std::chrono::milliseconds(10)).deltas.empty());
+
+    std::thread producer([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue.push("a.mp4");
+    });
+    auto changes = queue.wait_for_changes(cursor, std::chrono::seconds(5));
+    producer.join();
+    ASSERT_EQ(changes.deltas.size(), 1);
+    EXPECT_EQ(changes.deltas[0].item.source, "a.mp4");
+}
+
+// Concurrent lock-free submissions all land exactly once, in each producer's order
+TEST_F(MediaQueueTest, ConcurrentSubmissionsKeepProducerOrder) {
+    constexpr int PRODUCERS = 8;
+    constexpr int PER_PRODUCER = 2000;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([this, p]() {
+            for (int i = 0; i < PER_PRODUCER; ++i) {
+                queue.push(std::to_string(p) + ":" + std::to_string(i), "producer" + std::to_string(p));
+            }
+        });
+    }
+    // A subscriber follows the change log concurrently. It never takes the lock, so every
+    // drain is done by a producer; counting inserts only adds up if no batch is seen partially.
+    std::atomic<bool> done{false};
+    size_t followed = 0;
+    std::thread reader([this, &done, &followed]() {
+        uint64_t cursor = 0;
+        auto follow = [&] {
+            auto changes = queue.changes_since(cursor);
+            if (changes.resync) {
+                auto snapshot = queue.snapshot();
+                cursor = snapshot->version;
+                followed = snapshot->items.size();
+                return;
+            }
+            followed += changes.deltas.size();
+            cursor = changes.version;
+        };
+        while (!done.load()) {
+            follow();
+        }
+        follow();
+    });
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(followed, static_cast<size_t>(PRODUCERS * PER_PRODUCER));
+
+    auto snapshot = queue.snapshot();
+    ASSERT_EQ(snapshot->items.size(), PRODUCERS * PER_PRODUCER);
+    EXPECT_EQ(queue.rejected_submissions(), 0);
+    std::vector<int> next(PRODUCERS, 0);
+    for (const auto& item : snapshot->items) {
+        size_t colon = item.source.find(':');
+        int p = std::stoi(item.source.substr(0, colon));
+        EXPECT_EQ(std::stoi(item.source.substr(colon + 1)), next[p]++);
+    }
+}
+
+// advance() plays the rotation in place: one version per step, now playing and up next published
+TEST_F(MediaQueueTest, AdvanceReportsNowPlayingAndUpNext) {
+    queue.push("a.mp4");
+    queue.push("b.mp4");
+    queue.push("c.mp4");
+    uint64_t version = queue.version();
+
+    QueueItem item;
+    ASSERT_TRUE(queue.advance(item));
+    EXPECT_EQ(item.source, "a.mp4");
+    EXPECT_EQ(queue.version(), version + 1);
+    auto snapshot = queue.snapshot();
+    ASSERT_TRUE(snapshot->now_playing);
+    EXPECT_EQ(snapshot->now_playing->source, "a.mp4");
+    ASSERT_NE(snapshot->up_next(), nullptr);
+    EXPECT_EQ(snapshot->up_next()->source, "b.mp4");
+    EXPECT_EQ(snapshot->items.size(), 3);
+    EXPECT_EQ(queue.changes_since(version).deltas[0].op, QueueOp::Advance);
+
+    // Priority content plays first, then joins the rotation behind the cursor
+    queue.enqueue("p.mp4", PriorityClass::Next);
+    ASSERT_TRUE(queue.advance(item));
+    EXPECT_EQ(item.source, "p.mp4");
+    EXPECT_EQ(item.priority, PriorityClass::Next);
+    snapshot = queue.snapshot();
+    ASSERT_EQ(snapshot->items.size(), 4);
+    EXPECT_EQ(snapshot->items[0].source, "b.mp4");
+    EXPECT_EQ(snapshot->items[3].source, "p.mp4");
+    EXPECT_EQ(snapshot->items[3].priority, PriorityClass::Normal);
+
+    queue.set_rotation_mode(RotationMode::Once);
+    while (queue.advance(item)) {
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+// What the playout loop does when every queued item fails its air-time check: each one is
+// taken back out as it is skipped, so the queue empties and the fallback is left alone
+TEST_F(MediaQueueTest, UnplayableItemsLeaveTheRotation) {
+    for (RotationMode mode : {RotationMode::Loop, RotationMode::Shuffle, RotationMode::Once}) {
+        queue.clear();
+        queue.set_rotation_mode(mode);
+        queue.push("dead1.mp4");
+        queue.push("dead2.mp4", "alice");
+        queue.push("dead1.mp4");  // Duplicates go one at a time
+        queue.enqueue("dead3.mp4", PriorityClass::Next);
+        uint64_t version = queue.version();
+
+        size_t skipped = 0;
+        QueueItem item;
+        while (queue.advance(item)) {
+            EXPECT_EQ(queue.remove_played(item), mode != RotationMode::Once);
+            ASSERT_LE(++skipped, 4u);
+        }
+        EXPECT_EQ(skipped, 4u);
+        EXPECT_TRUE(queue.empty());
+        EXPECT_TRUE(queue.snapshot()->items.empty());
+        EXPECT_FALSE(queue.wait_until_nonempty(std::chrono::milliseconds(20)));
+        if (mode == RotationMode::Loop) {
+            EXPECT_FALSE(queue.snapshot()->now_playing);
+            EXPECT_EQ(queue.changes_since(version).deltas[1].op, QueueOp::Remove);
+        }
+    }
+}
+
+// A skipped item only takes its own entry with it
+TEST_F(MediaQueueTest, RemovingAPlayedItemKeepsTheRest) {
+    queue.push("a.mp4");
+    queue.push("dead.mp4");
+    queue.push("c.mp4");
+    QueueItem item;
+    ASSERT_TRUE(queue.advance(item));
+    ASSERT_TRUE(queue.advance(item));
+    ASSERT_TRUE(queue.remove_played(item));
+    EXPECT_FALSE(queue.remove_played(item));
+    auto snapshot = queue.snapshot();
+    ASSERT_EQ(snapshot->items.size(), 2);
+    EXPECT_EQ(snapshot->items[0].source, "c.mp4");
+    EXPECT_EQ(snapshot->items[1].source, "a.mp4");
+}
+
+// Advancing the rotation publishes without copying: snapshots share the frozen playlist
+TEST_F(MediaQueueTest, AdvanceSharesItemsWithEarlierSnapshots) {
+    for (const char* source : {"a.mp4", "b.mp4", "c.mp4"}) {
+        queue.push(source);
+    }
+    queue.enqueue("p.mp4", PriorityClass::Next);
+    QueueItem item;
+    ASSERT_TRUE(queue.advance(item));  // p.mp4 joins the rotation: copied once here
+    auto before = queue.snapshot();
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.advance(item));
+    }
+    auto after = queue.snapshot();
+
+    // A full pass later a.mp4 is up next again, as the very same entry
+    ASSERT_EQ(after->items.size(), 4);
+    EXPECT_EQ(after->items[3].source, "p.mp4");
+    EXPECT_EQ(before->up_next()->source, "a.mp4");
+    EXPECT_EQ(after->up_next(), before->up_next());
+
+    queue.record_airtime(DEFAULT_SUBMITTER, 30.0);
+    auto stats_only = queue.snapshot();
+    EXPECT_GT(stats_only->revision, after->revision);
+    EXPECT_EQ(stats_only->up_next(), after->up_next());
+
+    queue.push("d.mp4");  // A changed playlist is copied again; earlier snapshots keep theirs
+    EXPECT_NE(queue.snapshot()->up_next(), after->up_next());
+    EXPECT_EQ(queue.snapshot()->items[3].source, "d.mp4");
+    EXPECT_EQ(after->items.size(), 4);
+}
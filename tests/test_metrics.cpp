@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "../src/metrics.hpp"
+#include "../src/media_queue.hpp"
+#include "../src/streaming.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(MetricsTest, CounterSumsEveryThread) {
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) counter.add();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(counter.value(), 80000u);
+}
+
+TEST(MetricsTest, SlotsAreRecycledAndSharedWhenExhausted) {
+    Counter counter;
+    // More live threads than owned slots: the rest share the atomic slot
+    std::atomic<int> ready{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < METRIC_SLOTS + 16; ++t) {
+        threads.emplace_back([&] {
+            ready.fetch_add(1);
+            while (ready.load() < static_cast<int>(METRIC_SLOTS + 16)) std::this_thread::yield();
+            for (int i = 0; i < 1000; ++i) counter.add();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(counter.value(), (METRIC_SLOTS + 16) * 1000);
+
+    // Exited threads handed their slots back
+    std::thread([] { EXPECT_NE(metric_slot(), METRIC_SHARED_SLOT); }).join();
+}
+
+TEST(MetricsTest, HistogramBucketsAreCumulativeAndInclusive) {
+    Histogram histogram({0.1, 1.0});
+    histogram.observe(0.1);  // le="0.1" includes the bound
+    histogram.observe(0.5);
+    histogram.observe(std::chrono::seconds(5));
+    auto totals = histogram.totals();
+    EXPECT_EQ(totals.cumulative, (std::vector<uint64_t>{1, 2, 3}));
+    EXPECT_DOUBLE_EQ(totals.sum, 5.6);
+}
+
+TEST(MetricsTest, RegistryReturnsTheSameSeries) {
+    MetricsRegistry registry;
+    Counter& a = registry.counter("requests_total", "Requests", label("route", "GET /queue"));
+    Counter& b = registry.counter("requests_total", "Requests", label("route", "GET /queue"));
+    Counter& c = registry.counter("requests_total", "Requests", label("route", "GET /status"));
+    EXPECT_EQ(&a, &b);
+    EXPECT_NE(&a, &c);
+    EXPECT_THROW(registry.gauge("requests_total", "Requests"), std::logic_error);
+}
+
+TEST(MetricsTest, RendersTextExpositionFormat) {
+    MetricsRegistry registry;
+    registry.counter("jobs_total", "Jobs run", label("kind", "probe")).add(3);
+    registry.gauge("speed", "Encoder speed").set(1.5);
+    registry.histogram("wait_seconds", "Waits", {0.5, 1}).observe(0.25);
+    registry.gauge_callback("depth", "Queue depth", [] { return 7.0; });
+
+    std::string out;
+    registry.render(out);
+    EXPECT_EQ(out,
+              "# HELP depth Queue depth\n"
+              "# TYPE depth gauge\n"
+              "depth 7\n"
+              "# HELP jobs_total Jobs run\n"
+              "# TYPE jobs_total counter\n"
+              "jobs_total{kind=\"probe\"} 3\n"
+              "# HELP speed Encoder speed\n"
+              "# TYPE speed gauge\n"
+              "speed 1.5\n"
+              "# HELP wait_seconds Waits\n"
+              "# TYPE wait_seconds histogram\n"
+              "wait_seconds_bucket{le=\"0.5\"} 1\n"
+              "wait_seconds_bucket{le=\"1\"} 1\n"
+              "wait_seconds_bucket{le=\"+Inf\"} 1\n"
+              "wait_seconds_sum 0.25\n"
+              "wait_seconds_count 1\n");
+
+    out.clear();
+    render_sample(out, "queue_depth", "gauge", "Items", 2);
+    EXPECT_EQ(out, "# HELP queue_depth Items\n# TYPE queue_depth gauge\nqueue_depth 2\n");
+}
+
+TEST(MetricsTest, EscapesLabelValues) {
+    EXPECT_EQ(label("path", "a\"b\\c\nd"), "path=\"a\\\"b\\\\c\\nd\"");
+}
+
+TEST(MetricsTest, QueueWriterLockIsCounted) {
+    ThreadSafeMediaQueue queue;
+    auto before = channel_metrics().queue_lock_acquisitions.value();
+    queue.clear();
+    EXPECT_GT(channel_metrics().queue_lock_acquisitions.value(), before);
+}
+
+TEST(MetricsTest, StreamProcessRemembersFirstInterruptRequest) {
+    StreamProcess process;
+    EXPECT_FALSE(process.interrupt_requested_at());
+    process.request_termination();
+    auto first = process.interrupt_requested_at();
+    ASSERT_TRUE(first);
+    process.request_termination();
+    EXPECT_EQ(process.interrupt_requested_at(), first);
+    process.reset();
+    EXPECT_FALSE(process.interrupt_requested_at());
+}
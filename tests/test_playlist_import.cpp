@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "../src/playlist_import.hpp"
+#include "../src/queue_journal.hpp"
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+class PlaylistImportTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() /
+              ("mychannel_playlist_" + std::to_string(::getpid()) + "_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string make_file(const std::string& name) {
+        auto path = dir / name;
+        std::ofstream(path) << "media";
+        return path.string();
+    }
+
+    std::filesystem::path dir;
+    ThreadSafeMediaQueue queue;
+};
+
+// M3U comments and #EXTINF lines are skipped and relative entries resolve against the playlist
+TEST_F(PlaylistImportTest, ParsesM3U) {
+    PlaylistImportOptions options;
+    options.base_dir = "/media";
+    std::vector<std::string> sources;
+    std::string error;
+    ASSERT_TRUE(parse_playlist("\xEF\xBB\xBF#EXTM3U\r\n#EXTINF:10,Intro\r\nintro.mp4\r\n\r\n"
+                               "https://www.youtube.com/watch?v=abc\n/abs/clip.mp4\n",
+                               options, sources, error));
+    ASSERT_EQ(sources.size(), 3);
+    EXPECT_EQ(sources[0], "/media/intro.mp4");
+    EXPECT_EQ(sources[1], "https://www.youtube.com/watch?v=abc");
+    EXPECT_EQ(sources[2], "/abs/clip.mp4");
+}
+
+// JSON playlists accept plain strings and objects with a source/url/path field
+// Playlist files named by clients stay inside the import directory
+TEST_F(PlaylistImportTest, ResolvesImportPathsInsideTheImportDirectory) {
+    std::filesystem::create_directories(dir / "lists" / "sub");
+    std::ofstream(dir / "lists" / "sub" / "show.m3u") << "a.mp4\n";
+    std::string root = (dir / "lists").string();
+
+    auto resolved = resolve_import_path(root, "sub/show.m3u");
+    ASSERT_TRUE(resolved);
+    EXPECT_EQ(*resolved, std::filesystem::canonical(dir / "lists" / "sub" / "show.m3u"));
+    EXPECT_TRUE(resolve_import_path(root, "sub/../sub/show.m3u"));
+    EXPECT_TRUE(resolve_import_path(root, "new.m3u"));  // Missing files fail when opened
+
+    EXPECT_FALSE(resolve_import_path(root, "../secret.txt"));
+    EXPECT_FALSE(resolve_import_path(root, "sub/../../secret.txt"));
+    EXPECT_FALSE(resolve_import_path(root, "/etc/passwd"));
+    EXPECT_FALSE(resolve_import_path(root, "."));
+    EXPECT_FALSE(resolve_import_path("", "sub/show.m3u"));  // No import directory, no files
+
+    std::filesystem::create_directory_symlink("/etc", dir / "lists" / "etc");
+    EXPECT_FALSE(resolve_import_path(root, "etc/passwd"));
+}
+
+TEST_F(PlaylistImportTest, ParsesJson) {
+    PlaylistImportOptions options;
+    std::vector<std::string> sources;
+    std::string error;
+    ASSERT_TRUE(parse_playlist(R"(["a.mp4", {"url": "https://example.com/b.mp4"}, {"title": "no source"}])",
+                               options, sources, error));
+    ASSERT_EQ(sources.size(), 3);
+    EXPECT_EQ(sources[1], "https://example.com/b.mp4");
+    EXPECT_EQ(sources[2], "");
+
+    EXPECT_FALSE(parse_playlist("[1, 2", options, sources, error));
+    options.max_items = 1;
+    EXPECT_FALSE(parse_playlist(R"(["a.mp4", "b.mp4"])", options, sources, error));
+}
+
+// Valid items land in one queue version; invalid ones are reported per item
+TEST_F(PlaylistImportTest, CommitsValidItemsAtomically) {
+    std::vector<std::string> sources;
+    for (int i = 0; i < 50; ++i) {
+        sources.push_back(make_file("clip" + std::to_string(i) + ".mp4"));
+    }
+    sources.insert(sources.begin() + 10, (dir / "missing.mp4").string());
+    sources.push_back("");
+
+    PlaylistImportOptions options;
+    options.submitter = "editorial";
+    options.max_parallel = 4;
+    uint64_t version_before = queue.version();
+    auto result = import_sources(queue, sources, options);
+
+    ASSERT_TRUE(result.ok);
+    EXPECT_EQ(result.queued, 50);
+    EXPECT_EQ(result.version, version_before + 1);
+    EXPECT_EQ(queue.version(), version_before + 1);
+    ASSERT_EQ(result.items.size(), 52);
+    EXPECT_FALSE(result.items[10].queued);
+    EXPECT_NE(result.items[10].error.find("does not exist"), std::string::npos);
+    EXPECT_EQ(result.items[51].error, "Missing source");
+
+    auto snapshot = queue.snapshot();
+    ASSERT_EQ(snapshot->items.size(), 50);
+    EXPECT_EQ(snapshot->items[0].source, sources[0]);
+    EXPECT_EQ(snapshot->items[0].submitter, "editorial");
+
+    auto changes = queue.changes_since(version_before);
+    EXPECT_EQ(changes.deltas.size(), 50);
+}
+
+// Items beyond the submitter's quota are rejected individually
+TEST_F(PlaylistImportTest, RespectsQuota) {
+    queue.set_submitter_policy("agent", {1.0, 3});
+    std::vector<std::string> sources;
+    for (int i = 0; i < 5; ++i) {
+        sources.push_back(make_file("clip" + std::to_string(i) + ".mp4"));
+    }
+    PlaylistImportOptions options;
+    options.submitter = "agent";
+    auto result = import_sources(queue, sources, options);
+    EXPECT_EQ(result.queued, 3);
+    EXPECT_TRUE(result.items[2].queued);
+    EXPECT_FALSE(result.items[3].queued);
+    EXPECT_EQ(queue.size(), 3);
+}
+
+// A batch is a single journal record and is recovered as a whole
+TEST_F(PlaylistImportTest, BatchSurvivesRestart) {
+    std::string state = (dir / "state").string();
+    {
+        ThreadSafeMediaQueue journaled;
+        QueueJournal journal(state);
+        journal.open(journaled);
+        auto result = import_playlist(journaled, "[\"" + make_file("a.mp4") + "\",\"" + make_file("b.mp4") + "\"]",
+                                      PlaylistImportOptions());
+        EXPECT_EQ(result.queued, 2);
+        journal.sync();
+    }
+
+    ThreadSafeMediaQueue restored;
+    QueueJournal journal(state);
+    auto stats = journal.open(restored);
+    EXPECT_EQ(stats.replayed_records, 1);
+    ASSERT_EQ(restored.size(), 2);
+    EXPECT_EQ(restored.snapshot()->items[1].source, (dir / "b.mp4").string());
+}
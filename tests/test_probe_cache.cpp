@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "../src/media_info.hpp"
+#include "../src/tool_executor.hpp"
+#include "../src/utils.hpp"
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+class ProbeCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() /
+              ("mychannel_probe_" + std::to_string(::getpid()) + "_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        cache_path = (dir / "probe.cache").string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string write_file(const std::string& name, const std::string& content) {
+        std::string path = (dir / name).string();
+        std::ofstream(path) << content;
+        return path;
+    }
+
+    std::filesystem::path dir;
+    std::string cache_path;
+};
+
+TEST_F(ProbeCacheTest, MapsFiles) {
+    MappedFile mapped(write_file("a.bin", "hello"));
+    EXPECT_EQ(mapped.data(), "hello");
+    EXPECT_TRUE(MappedFile(write_file("empty.bin", "")).empty());
+    EXPECT_TRUE(MappedFile((dir / "missing").string()).empty());
+}
+
+TEST_F(ProbeCacheTest, SavesAndLoads) {
+    std::string a = write_file("a.mp4", "a");
+    std::string b = write_file("b.mp4", "bb");
+    remember_media_duration(a, 12.5);
+    remember_media_duration(b, 30.0);
+    remember_media_duration("https://www.youtube.com/watch?v=probecache", 95.0);
+    ASSERT_TRUE(save_probe_cache(cache_path));
+    EXPECT_GE(load_probe_cache(cache_path), 3u);  // Other tests may have cached more
+
+    EXPECT_EQ(cached_media_duration(a), 12.5);
+    EXPECT_EQ(cached_media_duration("https://www.youtube.com/watch?v=probecache"), 95.0);
+
+    // An edited file no longer matches its size and modification time
+    std::ofstream(b, std::ios::app) << "more";
+    EXPECT_FALSE(cached_media_duration(b));
+
+    // Nothing new: the file is not written again
+    std::filesystem::remove(cache_path);
+    ASSERT_TRUE(save_probe_cache(cache_path));
+    EXPECT_FALSE(std::filesystem::exists(cache_path));
+}
+
+TEST_F(ProbeCacheTest, KeepsStreamsOfFullProbes) {
+    std::string a = write_file("streams.mp4", "a");
+    MediaProbe probe{.duration = 42.0, .video_codec = "h264", .width = 1920, .height = 1080, .audio_codec = "aac"};
+    remember_media_probe(a, probe);
+    remember_media_duration(a, 42.0);  // A later duration lookup keeps the streams
+    ASSERT_TRUE(save_probe_cache(cache_path));
+    EXPECT_GE(load_probe_cache(cache_path), 1u);
+
+    auto cached = cached_media_probe(a);
+    ASSERT_TRUE(cached);
+    EXPECT_EQ(cached->video_codec, "h264");
+    EXPECT_EQ(cached->height, 1080);
+    EXPECT_EQ(cached->audio_codec, "aac");
+    EXPECT_EQ(probe_media(a).width, 1920);  // Answered without running ffprobe
+
+    // Durations alone are not enough to answer a probe
+    std::string b = write_file("duration.mp4", "b");
+    remember_media_duration(b, 10.0);
+    EXPECT_EQ(cached_media_duration(b), 10.0);
+    EXPECT_FALSE(cached_media_probe(b));
+}
+
+TEST_F(ProbeCacheTest, LoadsVersionOneFiles) {
+    std::string key = "https://www.youtube.com/watch?v=probecachev1";
+    std::string data = "MCPROBE1";
+    uint32_t key_len = key.size();
+    double seconds = 33.0;
+    int64_t expires_at = std::time(nullptr) + 600;
+    data.append(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
+    data += key;
+    data.append(reinterpret_cast<const char*>(&seconds), sizeof(seconds));
+    data.append(reinterpret_cast<const char*>(&expires_at), sizeof(expires_at));
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (char c : data) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    data.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    std::ofstream(cache_path, std::ios::binary | std::ios::trunc) << data;
+
+    EXPECT_EQ(load_probe_cache(cache_path), 1u);
+    EXPECT_EQ(cached_media_duration(key), 33.0);
+    EXPECT_FALSE(cached_media_probe(key));
+}
+
+TEST_F(ProbeCacheTest, IgnoresDamagedFiles) {
+    remember_media_duration(write_file("a.mp4", "a"), 7.0);
+    ASSERT_TRUE(save_probe_cache(cache_path));
+    std::string saved;
+    {
+        MappedFile mapped(cache_path);
+        saved = std::string(mapped.data());
+    }
+    ASSERT_GT(saved.size(), 12u);
+
+    std::string flipped = saved;
+    flipped[10] ^= 0x20;
+    std::ofstream(cache_path, std::ios::binary | std::ios::trunc) << flipped;
+    EXPECT_EQ(load_probe_cache(cache_path), 0u);
+
+    std::ofstream(cache_path, std::ios::binary | std::ios::trunc) << saved.substr(0, saved.size() - 3);
+    EXPECT_EQ(load_probe_cache(cache_path), 0u);
+
+    std::ofstream(cache_path, std::ios::binary | std::ios::trunc) << "not a cache";
+    EXPECT_EQ(load_probe_cache(cache_path), 0u);
+    EXPECT_EQ(load_probe_cache((dir / "missing").string()), 0u);
+}
+
+TEST_F(ProbeCacheTest, WarmsInChunks) {
+    std::vector<std::string> sources;
+    for (int i = 0; i < 10; ++i) {
+        sources.push_back(write_file("item" + std::to_string(i) + ".mp4", std::to_string(i)));
+        remember_media_duration(sources.back(), 60.0 + i);
+    }
+    sources.push_back((dir / "gone.mp4").string());
+    sources.push_back("https://www.youtube.com/watch?v=notcached");
+
+    ToolExecutor pool(2, 16, ThreadRole::Background, "cache");
+    auto result = warm_probe_cache(sources, pool, 3);
+    ASSERT_EQ(result.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto check = result.get();
+    EXPECT_EQ(check.unchanged, 10u);
+    EXPECT_EQ(check.reprobed, 0u);
+    EXPECT_EQ(check.missing, 1u);
+    EXPECT_EQ(check.remote, 1u);
+
+    EXPECT_EQ(warm_probe_cache({}, pool).get().unchanged, 0u);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "../src/process_policy.hpp"
+#include <algorithm>
+#include <string>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+std::string read_all(int fd) {
+    std::string output;
+    char buffer[256];
+    for (ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0;) {
+        output.append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+    return output;
+}
+
+int exit_status(pid_t pid) {
+    int status = -1;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+}  // namespace
+
+TEST(ProcessPolicyTest, ParsesIoPriority) {
+    IoPriority priority;
+    ASSERT_TRUE(parse_io_priority("idle", priority));
+    EXPECT_EQ(priority.io_class, IoClass::Idle);
+    ASSERT_TRUE(parse_io_priority("best-effort:7", priority));
+    EXPECT_EQ(priority.io_class, IoClass::BestEffort);
+    EXPECT_EQ(priority.level, 7);
+    ASSERT_TRUE(parse_io_priority("realtime", priority));
+    EXPECT_EQ(priority.io_class, IoClass::RealTime);
+    EXPECT_EQ(priority.level, 4);
+
+    EXPECT_FALSE(parse_io_priority("idle:3", priority));
+    EXPECT_FALSE(parse_io_priority("best-effort:8", priority));
+    EXPECT_FALSE(parse_io_priority("best-effort:", priority));
+    EXPECT_FALSE(parse_io_priority("batch", priority));
+}
+
+TEST(ProcessPolicyTest, ParsesCpuMax) {
+    std::string cpu_max;
+    ASSERT_TRUE(parse_cpu_max("1.5", cpu_max));
+    EXPECT_EQ(cpu_max, "150000 100000");
+    ASSERT_TRUE(parse_cpu_max("max", cpu_max));
+    EXPECT_EQ(cpu_max, "max 100000");
+    ASSERT_TRUE(parse_cpu_max("50000 200000", cpu_max));
+    EXPECT_EQ(cpu_max, "50000 200000");
+
+    EXPECT_FALSE(parse_cpu_max("0", cpu_max));
+    EXPECT_FALSE(parse_cpu_max("-1", cpu_max));
+    EXPECT_FALSE(parse_cpu_max("2 cores", cpu_max));
+    EXPECT_FALSE(parse_cpu_max("50000 10", cpu_max));
+}
+
+TEST(ProcessPolicyTest, SpawnCapturesStdoutInItsOwnGroup) {
+    auto child = spawn_with_policy("echo hi; exit 3", {});
+    EXPECT_EQ(getpgid(child.pid), child.pid);
+    EXPECT_EQ(read_all(child.stdout_fd), "hi\n");
+    EXPECT_EQ(exit_status(child.pid), 3);
+}
+
+TEST(ProcessPolicyTest, SpawnAppliesPolicyBeforeExec) {
+    ProcessPolicy policy;
+    policy.cpus = {process_cpu_set().front()};
+    policy.nice = std::min(getpriority(PRIO_PROCESS, 0) + 5, 19);
+    policy.io_priority = IoPriority{IoClass::Idle, 7};
+
+    // Once the shell has written, it runs under the policy and is still there to inspect
+    auto child = spawn_with_policy("nproc; sleep 0.3", policy);
+    char line[16] = {};
+    ASSERT_GT(read(child.stdout_fd, line, sizeof(line) - 1), 0);
+    EXPECT_STREQ(line, "1\n");
+    EXPECT_EQ(getpriority(PRIO_PROCESS, child.pid), *policy.nice);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    ASSERT_EQ(sched_getaffinity(child.pid, sizeof(set), &set), 0);
+    EXPECT_EQ(CPU_COUNT(&set), 1);
+    EXPECT_TRUE(CPU_ISSET(policy.cpus.front(), &set));
+    int ioprio = static_cast<int>(syscall(SYS_ioprio_get, 1, child.pid));
+    EXPECT_EQ(ioprio >> 13, static_cast<int>(IoClass::Idle));
+    EXPECT_EQ(read_all(child.stdout_fd), "");
+    EXPECT_EQ(exit_status(child.pid), 0);
+}
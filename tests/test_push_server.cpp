@@ -0,0 +1,324 @@
+#include <gtest/gtest.h>
+#include "../src/push_server.hpp"
+#include "../src/media_queue.hpp"
+#include "../src/json_response.hpp"
+#include "../src/streaming.hpp"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+PushEventPtr event(std::string kind, std::string frame, bool coalesce = false) {
+    return std::make_shared<const PushEvent>(PushEvent{std::move(kind), coalesce, std::move(frame)});
+}
+
+std::string unsent(const PushBacklog& backlog) {
+    iovec iov[64];
+    std::string bytes;
+    for (size_t i = 0, n = backlog.gather(iov, 64); i < n; ++i) {
+        bytes.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    return bytes;
+}
+
+int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int subscribe(int port) {
+    int fd = connect_to(port);
+    std::string_view request = "GET /events HTTP/1.1\r\nHost: localhost\r\nAccept: text/event-stream\r\n\r\n";
+    if (fd >= 0 && send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads until the received bytes contain needle or the timeout passes
+std::string read_until(int fd, std::string_view needle, std::chrono::milliseconds timeout = 2s) {
+    timeval tv{0, 100000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    std::string received;
+    auto until = std::chrono::steady_clock::now() + timeout;
+    char buffer[4096];
+    while (received.find(needle) == std::string::npos && std::chrono::steady_clock::now() < until) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n == 0) break;
+        if (n > 0) received.append(buffer, static_cast<size_t>(n));
+    }
+    return received;
+}
+
+template <class Predicate>
+bool eventually(Predicate predicate, std::chrono::milliseconds timeout = 5s) {
+    auto until = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() >= until) return false;
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+std::chrono::nanoseconds thread_cpu_time() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+}  // namespace
+
+TEST(PushBacklogTest, CoalescesUnsentEventOfSameKind) {
+    PushBacklog backlog(8);
+    backlog.push(event("telemetry", "t1;", true));
+    backlog.push(event("queue", "q1;"));
+    EXPECT_EQ(backlog.push(event("telemetry", "t2;", true)), 1u);
+    EXPECT_EQ(unsent(backlog), "q1;t2;");
+}
+
+TEST(PushBacklogTest, PartlyWrittenEventIsKept) {
+    PushBacklog backlog(8);
+    backlog.push(event("telemetry", "t1;", true));
+    backlog.consume(1);
+    EXPECT_EQ(backlog.push(event("telemetry", "t2;", true)), 0u);
+    EXPECT_EQ(unsent(backlog), "1;t2;");
+    backlog.consume(2);
+    EXPECT_EQ(unsent(backlog), "t2;");
+}
+
+TEST(PushBacklogTest, OverflowResyncs) {
+    PushBacklog backlog(4);
+    for (int i = 0; i < 4; ++i) {
+        backlog.push(event("queue", "q" + std::to_string(i) + ";"));
+    }
+    backlog.consume(1);  // q0 is partly written
+    EXPECT_EQ(backlog.push(event("queue", "q4;")), 3u);
+    EXPECT_EQ(unsent(backlog), "0;event: resync\ndata: {}\n\nq4;");
+    EXPECT_EQ(backlog.size(), 3u);
+}
+
+TEST(EncoderProgressTest, ParsesProgressReport) {
+    EncoderProgressParser parser;
+    const char* lines[] = {"frame=250\n", "fps=25.01\n", "stream_0_0_q=23.0\n", "bitrate=2512.3kbits/s\n",
+                           "total_size=3145728\n", "out_time_us=10000000\n", "out_time=00:00:10.000000\n",
+                           "dup_frames=2\n", "drop_frames=1\n", "speed=1.01x\n"};
+    for (const char* line : lines) {
+        EXPECT_FALSE(parser.feed(line));
+    }
+    EXPECT_TRUE(parser.feed("progress=continue\n"));
+    const auto& t = parser.telemetry();
+    EXPECT_EQ(t.frame, 250u);
+    EXPECT_DOUBLE_EQ(t.fps, 25.01);
+    EXPECT_DOUBLE_EQ(t.bitrate_kbps, 2512.3);
+    EXPECT_EQ(t.total_size, 3145728u);
+    EXPECT_DOUBLE_EQ(t.out_time_seconds, 10.0);
+    EXPECT_EQ(t.duplicated_frames, 2u);
+    EXPECT_EQ(t.dropped_frames, 1u);
+    EXPECT_DOUBLE_EQ(t.speed, 1.01);
+
+    EXPECT_FALSE(parser.feed("bitrate=N/A"));
+    EXPECT_DOUBLE_EQ(parser.telemetry().bitrate_kbps, 0.0);
+}
+
+TEST(PushServerTest, StreamsPublishedEvents) {
+    PushServer server;
+    int port = server.start("127.0.0.1", 0);
+    int fd = subscribe(port);
+    ASSERT_GE(fd, 0);
+
+    std::string head = read_until(fd, "event: resync\ndata: {}\n\n");
+    EXPECT_EQ(head.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(head.find("Content-Type: text/event-stream"), std::string::npos);
+    ASSERT_TRUE(eventually([&] { return server.subscribers() == 1; }));
+
+    server.publish("item_started", R"({"source":"a.mp4"})");
+    EXPECT_NE(read_until(fd, "\n\n").find("id: 1\nevent: item_started\ndata: {\"source\":\"a.mp4\"}\n\n"),
+              std::string::npos);
+
+    close(fd);
+    EXPECT_TRUE(eventually([&] { return server.subscribers() == 0; }));
+}
+
+TEST(PushServerTest, PublishesQueueDeltas) {
+    ThreadSafeMediaQueue queue;
+    PushServer server;
+    int port = server.start("127.0.0.1", 0);
+    server.watch_queue(queue);
+    int fd = subscribe(port);
+    ASSERT_GE(fd, 0);
+    read_until(fd, "event: resync");
+    ASSERT_TRUE(eventually([&] { return server.subscribers() == 1; }));
+
+    queue.push("videos/a.mp4");
+    std::string received = read_until(fd, "videos/a.mp4");
+    EXPECT_NE(received.find("event: queue\ndata: {\"version\":"), std::string::npos);
+    close(fd);
+}
+
+TEST(PushServerTest, UnknownPathIsNotFound) {
+    PushServer server;
+    int port = server.start("127.0.0.1", 0);
+    int fd = connect_to(port);
+    ASSERT_GE(fd, 0);
+    std::string_view request = "GET /status HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    EXPECT_EQ(read_until(fd, "\r\n\r\n").rfind("HTTP/1.1 404", 0), 0u);
+    close(fd);
+    EXPECT_EQ(server.subscribers(), 0u);
+}
+
+TEST(PushServerTest, SlowSubscriberIsResyncedWithoutStallingOthers) {
+    PushServer server(PushServer::Options{.max_backlog = 8});
+    int port = server.start("127.0.0.1", 0);
+    int slow = subscribe(port);
+    int fast = subscribe(port);
+    ASSERT_GE(slow, 0);
+    ASSERT_GE(fast, 0);
+    read_until(fast, "event: resync");
+    ASSERT_TRUE(eventually([&] { return server.subscribers() == 2; }));
+
+    // Large events fill the slow reader's socket buffers, then its backlog
+    std::string payload = "\"" + std::string(64 * 1024, 'x') + "\"";
+    for (int i = 0; i < 200; ++i) {
+        server.publish("queue", payload);
+        if (i % 8 == 7) {
+            read_until(fast, "\n\n", 10ms);  // Keep the fast reader draining as it goes
+        }
+    }
+    server.publish("item_started", R"({"last":true})");
+    EXPECT_NE(read_until(fast, R"({"last":true})", 10s).find(R"({"last":true})"), std::string::npos);
+    EXPECT_GT(server.dropped(), 0u);
+
+    // The slow reader eventually sees a resync instead of every missed event
+    EXPECT_NE(read_until(slow, R"({"last":true})", 10s).find("event: resync\ndata: {}\n\nid: "), std::string::npos);
+    close(slow);
+    close(fast);
+}
+
+// 1000 dashboards following the queue: one serialization fanned out to every stream costs
+// less server CPU than each dashboard polling GET /queue once per change. Only the polling
+// side's JSON work is counted, not its request parsing or socket writes.
+TEST(PushServerTest, FanOutToThousandSubscribersCostsLessThanPolling) {
+    constexpr int SUBSCRIBERS = 1000;
+    constexpr int EVENTS = 50;
+
+    rlimit limit{};
+    getrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < 2 * SUBSCRIBERS + 64) {
+        limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, 2 * SUBSCRIBERS + 256);
+        if (limit.rlim_cur < 2 * SUBSCRIBERS + 64 || setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+            GTEST_SKIP() << "Needs " << 2 * SUBSCRIBERS + 64 << " file descriptors";
+        }
+    }
+
+    ThreadSafeMediaQueue queue;
+    for (int i = 0; i < 200; ++i) {
+        queue.push("https://www.youtube.com/watch?v=video" + std::to_string(i), "editorial");
+    }
+
+    PushServer server(PushServer::Options{.max_backlog = EVENTS + 8});
+    int port = server.start("127.0.0.1", 0);
+
+    // Clients count frames ("\n\n"; the HTTP head ends in "\r\n\r\n") on their own thread
+    int client_epoll = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<int> clients;
+    std::vector<char> last_newline(SUBSCRIBERS, 0);
+    for (int i = 0; i < SUBSCRIBERS; ++i) {
+        int fd = subscribe(port);
+        ASSERT_GE(fd, 0) << "subscriber " << i;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        epoll_ctl(client_epoll, EPOLL_CTL_ADD, fd, &ev);
+        clients.push_back(fd);
+    }
+    std::atomic<long> frames{0};
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        std::vector<epoll_event> ready(256);
+        char buffer[16384];
+        while (!done) {
+            int count = epoll_wait(client_epoll, ready.data(), static_cast<int>(ready.size()), 50);
+            for (int i = 0; i < count; ++i) {
+                uint32_t index = ready[i].data.u32;
+                ssize_t n;
+                while ((n = recv(clients[index], buffer, sizeof(buffer), 0)) > 0) {
+                    long found = 0;
+                    for (ssize_t b = 0; b < n; ++b) {
+                        if (buffer[b] == '\n') {
+                            found += last_newline[index];
+                            last_newline[index] = 1;
+                        } else {
+                            last_newline[index] = 0;
+                        }
+                    }
+                    frames.fetch_add(found, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+    ASSERT_TRUE(eventually([&] { return frames.load() == SUBSCRIBERS; }, 20s));  // Everyone has the opening resync
+    ASSERT_EQ(server.subscribers(), static_cast<size_t>(SUBSCRIBERS));
+
+    // Push: serialize each change once and wait until every subscriber has it
+    auto loop_before = server.loop_cpu_time();
+    std::chrono::nanoseconds publisher_cpu{0};
+    uint64_t version = queue.snapshot()->version;
+    for (int e = 0; e < EVENTS; ++e) {
+        queue.push("https://www.youtube.com/watch?v=new" + std::to_string(e), "agent");
+        auto start = thread_cpu_time();
+        auto changes = queue.changes_since(version);
+        version = changes.version;
+        server.publish("queue", write_json_response(queue_changes_response(changes)));
+        publisher_cpu += thread_cpu_time() - start;
+        ASSERT_TRUE(eventually([&] { return frames.load() == static_cast<long>(SUBSCRIBERS) * (e + 2); }, 20s));
+    }
+    auto push_cpu = server.loop_cpu_time() - loop_before + publisher_cpu;
+    EXPECT_EQ(server.dropped(), 0u);
+
+    // Polling: every client fetches the queue page once per change
+    auto start = thread_cpu_time();
+    size_t bytes = 0;
+    for (int e = 0; e < EVENTS; ++e) {
+        for (int c = 0; c < SUBSCRIBERS; ++c) {
+            auto snapshot = queue.snapshot();
+            std::string body = write_json_response(queue_page(*snapshot, 0, snapshot->items.size()));
+            bytes += body.size();
+        }
+    }
+    auto poll_cpu = thread_cpu_time() - start;
+    EXPECT_GT(bytes, 0u);
+
+    std::cout << "push: " << std::chrono::duration<double, std::milli>(push_cpu).count() << " ms CPU, poll: "
+              << std::chrono::duration<double, std::milli>(poll_cpu).count() << " ms CPU for " << SUBSCRIBERS
+              << " clients x " << EVENTS << " changes" << std::endl;
+    EXPECT_LT(push_cpu, poll_cpu);
+
+    done = true;
+    reader.join();
+    for (int fd : clients) {
+        close(fd);
+    }
+    close(client_epoll);
+}
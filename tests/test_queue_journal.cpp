@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include "../src/queue_journal.hpp"
+#include "../src/media_queue.hpp"
+#include <filesystem>
+#include <fstream>
+
+class QueueJournalTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() /
+               ("mychannel_journal_" + std::to_string(::getpid()) + "_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name())).string();
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string dir;
+};
+
+// Mutations survive a restart and versions continue where they left off
+TEST_F(QueueJournalTest, RecoversQueueAfterRestart) {
+    uint64_t version_before = 0;
+    {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir);
+        journal.open(queue);
+
+        queue.push("a.mp4");
+        queue.push("b.mp4");
+        queue.push_front("priority.mp4");
+        std::string item;
+        queue.pop(item);
+        queue.push_back(item);
+        journal.sync();
+        version_before = queue.version();
+    }
+
+    ThreadSafeMediaQueue restored;
+    QueueJournal journal(dir);
+    auto stats = journal.open(restored);
+
+    EXPECT_EQ(stats.items, 3);
+    EXPECT_EQ(stats.version, version_before);
+    EXPECT_EQ(restored.version(), version_before);
+    auto items = restored.get_all_items();
+    ASSERT_EQ(items.size(), 3);
+    EXPECT_EQ(items[0], "a.mp4");
+    EXPECT_EQ(items[1], "b.mp4");
+    EXPECT_EQ(items[2], "priority.mp4");
+}
+
+// Priority lanes are restored from both journal records and snapshots
+TEST_F(QueueJournalTest, RecoversPriorityClasses) {
+    QueueJournalOptions options;
+    options.compact_after_records = 3;
+    {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir, options);
+        journal.open(queue);
+        queue.push("normal.mp4");
+        queue.enqueue("breaking.mp4", PriorityClass::Breaking);
+        journal.sync();
+        queue.enqueue("next.mp4", PriorityClass::Next);
+        queue.enqueue("breaking2.mp4", PriorityClass::Breaking);
+        journal.sync();
+    }
+
+    ThreadSafeMediaQueue restored;
+    QueueJournal journal(dir, options);
+    journal.open(restored);
+    auto snapshot = restored.snapshot();
+    ASSERT_EQ(snapshot->items.size(), 4);
+    EXPECT_EQ(snapshot->items[0].source, "breaking.mp4");
+    EXPECT_EQ(snapshot->items[1].source, "breaking2.mp4");
+    EXPECT_EQ(snapshot->items[2].priority, PriorityClass::Next);
+    EXPECT_EQ(snapshot->items[3].priority, PriorityClass::Normal);
+}
+
+// Compaction writes a snapshot and the journal keeps only newer records
+TEST_F(QueueJournalTest, CompactsIntoSnapshot) {
+    QueueJournalOptions options;
+    options.compact_after_records = 10;
+    {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir, options);
+        journal.open(queue);
+        for (int i = 0; i < 50; ++i) {
+            queue.push("item" + std::to_string(i));
+            journal.sync();
+        }
+        queue.clear();
+        queue.push("last.mp4");
+        journal.sync();
+    }
+
+    EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(dir) / "queue.snapshot"));
+
+    ThreadSafeMediaQueue restored;
+    QueueJournal journal(dir, options);
+    auto stats = journal.open(restored);
+    EXPECT_LT(stats.replayed_records, 50);
+    auto items = restored.get_all_items();
+    ASSERT_EQ(items.size(), 1);
+    EXPECT_EQ(items[0], "last.mp4");
+}
+
+// A torn record at the end of the journal is discarded, earlier records are kept
+TEST_F(QueueJournalTest, IgnoresTornTail) {
+    {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir);
+        journal.open(queue);
+        queue.push("a.mp4");
+        queue.push("b.mp4");
+        journal.sync();
+    }
+    {
+        std::ofstream out(std::filesystem::path(dir) / "queue.journal", std::ios::binary | std::ios::app);
+        out.write("\x20\x00\x00\x00\x01garbage", 12);
+    }
+
+    {
+        ThreadSafeMediaQueue restored;
+        QueueJournal journal(dir);
+        auto stats = journal.open(restored);
+        EXPECT_EQ(stats.items, 2);
+
+        // New records land after the truncated tail
+        restored.push("c.mp4");
+        journal.sync();
+    }
+
+    ThreadSafeMediaQueue again;
+    QueueJournal journal(dir);
+    auto stats = journal.open(again);
+    ASSERT_EQ(stats.items, 3);
+    EXPECT_EQ(again.get_all_items()[2], "c.mp4");
+}
+
+// Submitters survive a restart, and replayed pops take items from the lane they were journaled from
+TEST_F(QueueJournalTest, RecoversSubmitters) {
+    QueueJournalOptions options;
+    options.compact_after_records = 4;
+    {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir, options);
+        journal.open(queue);
+        queue.set_submitter_policy("editorial", {2.0, 0});
+        queue.push("e1.mp4", "editorial");
+        queue.push("e2.mp4", "editorial");
+        queue.push("a1.mp4", "agent");
+        journal.sync();
+        queue.push("a2.mp4", "agent");
+        QueueItem item;
+        queue.pop(item);
+        queue.pop(item);
+        queue.enqueue("n1.mp4", PriorityClass::Next, "agent");
+        journal.sync();
+    }
+
+    ThreadSafeMediaQueue restored;
+    QueueJournal journal(dir, options);
+    journal.open(restored);
+    auto snapshot = restored.snapshot();
+    ASSERT_EQ(snapshot->items.size(), 3);
+    EXPECT_EQ(snapshot->items[0].source, "n1.mp4");
+    EXPECT_EQ(snapshot->items[0].submitter, "agent");
+    EXPECT_EQ(snapshot->items[1].source, "a1.mp4");
+    EXPECT_EQ(snapshot->items[2].source, "a2.mp4");
+    EXPECT_EQ(snapshot->items[2].submitter, "agent");
+}
+
+// The rotation position and item weights survive a restart, from the journal and from a snapshot
+TEST_F(QueueJournalTest, RecoversRotationPosition) {
+    for (size_t compact_after : {1000, 3}) {
+        std::filesystem::remove_all(dir);
+        QueueJournalOptions options;
+        options.compact_after_records = compact_after;
+        {
+            ThreadSafeMediaQueue queue;
+            QueueJournal journal(dir, options);
+            journal.open(queue);
+            queue.push("a.mp4");
+            queue.push("b.mp4", DEFAULT_SUBMITTER, 2.5);
+            queue.push("c.mp4");
+            journal.sync();
+            QueueItem item;
+            queue.advance(item);
+            queue.advance(item);
+            journal.sync();
+        }
+
+        ThreadSafeMediaQueue restored;
+        QueueJournal journal(dir, options);
+        journal.open(restored);
+        auto snapshot = restored.snapshot();
+        ASSERT_EQ(snapshot->items.size(), 3);
+        EXPECT_EQ(snapshot->items[0].source, "c.mp4");
+        EXPECT_EQ(snapshot->items[2].source, "b.mp4");
+        EXPECT_EQ(snapshot->items[2].weight, 2.5);
+        QueueItem item;
+        ASSERT_TRUE(restored.advance(item));
+        EXPECT_EQ(item.source, "c.mp4");
+    }
+}
+
+TEST_F(QueueJournalTest, RecoversRemovedItems) {
+    {
+        ThreadSafeMediaQueue queue;
+        QueueJournal journal(dir);
+        journal.open(queue);
+        queue.push("a.mp4");
+        queue.push("dead.mp4");
+        queue.push("c.mp4");
+        QueueItem item;
+        queue.advance(item);
+        queue.advance(item);
+        queue.remove_played(item);
+        journal.sync();
+    }
+
+    ThreadSafeMediaQueue restored;
+    QueueJournal journal(dir);
+    journal.open(restored);
+    auto snapshot = restored.snapshot();
+    ASSERT_EQ(snapshot->items.size(), 2);
+    EXPECT_EQ(snapshot->items[0].source, "c.mp4");
+    EXPECT_EQ(snapshot->items[1].source, "a.mp4");
+}
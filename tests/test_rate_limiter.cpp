@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+#include "../src/rate_limiter.hpp"
+#include "../src/metrics.hpp"
+#include "../src/streaming.hpp"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+RateLimits only(RateClass cls, RateLimit limit) {
+    RateLimits limits{};
+    limits[static_cast<size_t>(cls)] = limit;
+    return limits;
+}
+
+}  // namespace
+
+TEST(RateLimiterTest, BucketSpendsBurstThenRefillsAtRate) {
+    TokenBucket bucket;
+    RateLimit limit{10.0, 3.0};  // One token per 100 ms
+    auto now = TokenBucket::Clock::now();
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(bucket.try_acquire(limit, now), 0ns) << i;
+    }
+    auto wait = bucket.try_acquire(limit, now);
+    EXPECT_GT(wait, 0ns);
+    EXPECT_LE(wait, 100ms);
+
+    EXPECT_GT(bucket.try_acquire(limit, now + 50ms), 0ns);
+    EXPECT_EQ(bucket.try_acquire(limit, now + 100ms), 0ns);
+    EXPECT_FALSE(bucket.full(now + 100ms));
+    EXPECT_TRUE(bucket.full(now + 400ms));
+}
+
+TEST(RateLimiterTest, ConcurrentClientsGetExactlyTheBurst) {
+    RateLimiter limiter(only(RateClass::Priority, {1.0, 5.0}));
+    auto now = RateLimiter::Clock::now();
+    std::atomic<int> admitted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 100; ++i) {
+                admitted += limiter.admit("agent", RateClass::Priority, now).admitted;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(admitted, 5);
+}
+
+TEST(RateLimiterTest, SeparatesClientsAndClasses) {
+    RateLimits limits{};
+    limits[static_cast<size_t>(RateClass::Write)] = {1.0, 1.0};
+    limits[static_cast<size_t>(RateClass::Mcp)] = {1.0, 1.0};
+    RateLimiter limiter(limits);
+    auto now = RateLimiter::Clock::now();
+    EXPECT_TRUE(limiter.admit("a", RateClass::Write, now).admitted);
+    auto refused = limiter.admit("a", RateClass::Write, now);
+    EXPECT_FALSE(refused.admitted);
+    EXPECT_GT(refused.retry_after, 900ms);
+    EXPECT_TRUE(limiter.admit("b", RateClass::Write, now).admitted);
+    EXPECT_TRUE(limiter.admit("a", RateClass::Mcp, now).admitted);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(limiter.admit("a", RateClass::Read, now).admitted);  // No read limit
+    }
+    EXPECT_TRUE(limiter.admit("a", RateClass::Write, now + 1s).admitted);
+}
+
+TEST(RateLimiterTest, IdleSlotsAreReusedByNewClients) {
+    RateLimiter limiter(only(RateClass::Write, {10.0, 1.0}), 16);
+    auto now = RateLimiter::Clock::now();
+    for (int i = 0; i < 1000; ++i) {
+        now += 200ms;  // Every earlier client's bucket has refilled
+        EXPECT_TRUE(limiter.admit("client" + std::to_string(i), RateClass::Write, now).admitted) << i;
+    }
+    // With every slot busy, new clients share the overflow bucket instead of going unlimited
+    int admitted = 0;
+    for (int i = 0; i < 100; ++i) {
+        admitted += limiter.admit("burst" + std::to_string(i), RateClass::Write, now).admitted;
+    }
+    EXPECT_LT(admitted, 100);
+}
+
+TEST(RateLimiterTest, ParsesLimits) {
+    RateLimits limits = default_rate_limits();
+    EXPECT_EQ(limits[static_cast<size_t>(RateClass::Read)].rate, 0.0);
+    EXPECT_TRUE(parse_rate_limits("read=100/200,priority=0.5,write=off", limits));
+    EXPECT_EQ(limits[static_cast<size_t>(RateClass::Read)].rate, 100.0);
+    EXPECT_EQ(limits[static_cast<size_t>(RateClass::Read)].burst, 200.0);
+    EXPECT_EQ(limits[static_cast<size_t>(RateClass::Priority)].rate, 0.5);
+    EXPECT_EQ(limits[static_cast<size_t>(RateClass::Priority)].burst, 1.0);
+    EXPECT_EQ(limits[static_cast<size_t>(RateClass::Write)].rate, 0.0);
+    EXPECT_EQ(limits[static_cast<size_t>(RateClass::Mcp)].rate, 20.0);
+
+    EXPECT_FALSE(parse_rate_limits("mcp=5/10,bogus=1,write=-1", limits));
+    EXPECT_EQ(limits[static_cast<size_t>(RateClass::Mcp)].rate, 5.0);
+    EXPECT_EQ(limits[static_cast<size_t>(RateClass::Write)].rate, 0.0);
+
+    EXPECT_TRUE(parse_rate_limits("off", limits));
+    for (const auto& limit : limits) {
+        EXPECT_EQ(limit.rate, 0.0);
+    }
+}
+
+TEST(RateLimiterTest, AdmissionGateBoundsInFlight) {
+    AdmissionGate gate(2);
+    EXPECT_TRUE(gate.try_enter());
+    EXPECT_TRUE(gate.try_enter());
+    EXPECT_FALSE(gate.try_enter());
+    EXPECT_EQ(gate.in_flight(), 2u);
+    gate.leave();
+    EXPECT_TRUE(gate.try_enter());
+}
+
+// MCP calls parked on slow probes fill their own gate; queue writes and priority cuts
+// still get in
+TEST(RateLimiterTest, ParkedMcpCallsDoNotBlockPriority) {
+    AdmissionGates gates(2, 4);
+    size_t parked = 0;
+    while (gates.gate(RateClass::Mcp)->try_enter()) {
+        ++parked;
+    }
+    EXPECT_EQ(parked, 4u);
+    EXPECT_EQ(gates.shared().in_flight(), 0u);
+
+    AdmissionGate* priority = gates.gate(RateClass::Priority);
+    ASSERT_NE(priority, nullptr);
+    EXPECT_TRUE(priority->try_enter());
+    EXPECT_TRUE(gates.gate(RateClass::Write)->try_enter());
+    EXPECT_EQ(gates.gate(RateClass::Read), nullptr);  // Reads are never gated
+
+    // And the other way round: a write backlog leaves MCP its slots
+    EXPECT_FALSE(gates.gate(RateClass::Write)->try_enter());
+    gates.gate(RateClass::Mcp)->leave();
+    EXPECT_TRUE(gates.gate(RateClass::Mcp)->try_enter());
+}
+
+// A storm of interrupting submissions against a simulated playout loop: the cooldown lets
+// one cut through per period, so the encoder restarts a handful of times instead of once
+// per request.
+TEST(RateLimiterTest, InterruptStormKeepsPlayoutStable) {
+    StreamProcess process;
+    process.set_interrupt_cooldown(100ms);
+    auto suppressed_before = channel_metrics().interrupts_suppressed.value();
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> requests{0};
+    std::atomic<int> granted{0};
+    std::atomic<int> restarts{0};
+    std::thread playout([&] {
+        while (!stop) {
+            if (process.should_terminate()) {
+                ++restarts;
+                process.reset();  // Next item goes on air
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < 4; ++t) {
+        clients.emplace_back([&] {
+            while (std::chrono::steady_clock::now() - start < 500ms) {
+                granted += process.preempt(PriorityClass::Breaking, InterruptPolicy::Immediate);
+                ++requests;
+                std::this_thread::sleep_for(100us);
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::this_thread::sleep_for(10ms);
+    stop = true;
+    playout.join();
+
+    int periods = static_cast<int>(elapsed / 100ms) + 1;
+    EXPECT_GT(requests, 100);
+    EXPECT_GE(granted, 1);
+    EXPECT_LE(granted, periods);
+    EXPECT_EQ(restarts, granted);
+    EXPECT_EQ(channel_metrics().interrupts_suppressed.value() - suppressed_before,
+              static_cast<uint64_t>(requests - granted));
+}
+
+TEST(RateLimiterTest, InterruptCooldownOffCutsEveryTime) {
+    StreamProcess process;
+    process.set_interrupt_cooldown(0ms);
+    EXPECT_TRUE(process.preempt(PriorityClass::Interrupt, InterruptPolicy::SegmentBoundary));
+    process.reset();
+    EXPECT_TRUE(process.preempt(PriorityClass::Interrupt, InterruptPolicy::SegmentBoundary));
+
+    process.set_interrupt_cooldown(1h);
+    process.reset();
+    EXPECT_FALSE(process.preempt(PriorityClass::Interrupt, InterruptPolicy::SegmentBoundary));
+    EXPECT_FALSE(process.segment_interrupt_pending());
+}
+
+// Segment cuts wait for the encoder's output clock to reach the next forced keyframe
+TEST(RateLimiterTest, SegmentCutWaitsForTheEncodersKeyframe) {
+    StreamProcess process;
+    process.set_interrupt_cooldown(0ms);
+    process.note_encoder_time(4.5);
+    ASSERT_TRUE(process.preempt(PriorityClass::Interrupt, InterruptPolicy::SegmentBoundary));
+    process.note_encoder_time(5.9);
+    EXPECT_FALSE(process.segment_boundary_reached());
+    EXPECT_FALSE(process.wait_for_segment_boundary(1ms));
+
+    std::thread encoder([&process] {
+        std::this_thread::sleep_for(20ms);
+        process.note_encoder_time(6.0);
+    });
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(process.wait_for_segment_boundary(5s));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+    encoder.join();
+    EXPECT_TRUE(process.segment_boundary_reached());
+
+    // A new item's encoder starts its clock over; before its first report the boundary is
+    // taken from that report
+    process.reset();
+    ASSERT_TRUE(process.preempt(PriorityClass::Interrupt, InterruptPolicy::SegmentBoundary));
+    EXPECT_FALSE(process.segment_boundary_reached());
+    process.note_encoder_time(0.5);
+    EXPECT_FALSE(process.segment_boundary_reached());
+    process.note_encoder_time(2.0);
+    EXPECT_TRUE(process.segment_boundary_reached());
+}
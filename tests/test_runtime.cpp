@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "../src/runtime.hpp"
+#include "../src/tool_executor.hpp"
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+std::string current_thread_name() {
+    char name[16] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    return name;
+}
+
+}  // namespace
+
+TEST(RuntimeTest, ParsesRoleCpus) {
+    RoleCpus cpus{};
+    EXPECT_TRUE(parse_role_cpus("playout=0,http=1-3,background=2+5-6+2", cpus));
+    EXPECT_EQ(cpus[static_cast<size_t>(ThreadRole::Playout)], CpuSet{0});
+    EXPECT_EQ(cpus[static_cast<size_t>(ThreadRole::Http)], (CpuSet{1, 2, 3}));
+    EXPECT_EQ(cpus[static_cast<size_t>(ThreadRole::Background)], (CpuSet{2, 5, 6}));
+    EXPECT_EQ(format_cpu_set(cpus[static_cast<size_t>(ThreadRole::Background)]), "2+5-6");
+    EXPECT_EQ(format_cpu_set(cpus[static_cast<size_t>(ThreadRole::Http)]), "1-3");
+
+    // Bad entries are reported and skipped; the good ones still apply
+    RoleCpus partial{};
+    EXPECT_FALSE(parse_role_cpus("encoder=1,http=3-1,playout=x,background=4", partial));
+    EXPECT_TRUE(partial[static_cast<size_t>(ThreadRole::Playout)].empty());
+    EXPECT_TRUE(partial[static_cast<size_t>(ThreadRole::Http)].empty());
+    EXPECT_EQ(partial[static_cast<size_t>(ThreadRole::Background)], CpuSet{4});
+    EXPECT_FALSE(parse_role_cpus("http=", partial));
+    EXPECT_FALSE(parse_role_cpus("http=-1", partial));
+}
+
+TEST(RuntimeTest, NamesAndPinsThreads) {
+    std::thread([] {
+        enter_thread_role(ThreadRole::Background, "a-rather-long-thread-name");
+        EXPECT_EQ(current_thread_name(), "a-rather-long-t");  // The kernel keeps 15 characters
+
+        ASSERT_TRUE(pin_current_thread({0}));
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        ASSERT_EQ(sched_getaffinity(0, sizeof(set), &set), 0);
+        EXPECT_EQ(CPU_COUNT(&set), 1);
+        EXPECT_TRUE(CPU_ISSET(0, &set));
+        EXPECT_FALSE(pin_current_thread({}));
+    }).join();
+}
+
+TEST(RuntimeTest, ThreadsStartedFromAPinnedThreadGetTheirRoleBack) {
+    cpu_set_t process;
+    CPU_ZERO(&process);
+    ASSERT_EQ(sched_getaffinity(0, sizeof(process), &process), 0);
+    std::thread([&] {
+        ASSERT_TRUE(pin_current_thread({0}));
+        std::thread([&] {
+            enter_thread_role(ThreadRole::Http, "child");  // No CPUs configured for the role
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            ASSERT_EQ(sched_getaffinity(0, sizeof(set), &set), 0);
+            EXPECT_TRUE(CPU_EQUAL(&set, &process));
+        }).join();
+    }).join();
+}
+
+TEST(RuntimeTest, ExecutorWorkersAreNamed) {
+    ToolExecutor executor(2, 4, ThreadRole::Background, "probe");
+    std::promise<std::string> name;
+    ASSERT_TRUE(executor.submit([&] { name.set_value(current_thread_name()); }));
+    auto worker = name.get_future().get();
+    EXPECT_TRUE(worker == "probe-0" || worker == "probe-1") << worker;
+}
+
+TEST(RuntimeTest, MeasuresProcessUptime) {
+    auto first = process_uptime_seconds();
+    ASSERT_TRUE(first);
+    EXPECT_GE(*first, 0.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto second = process_uptime_seconds();
+    ASSERT_TRUE(second);
+    EXPECT_GT(*second, *first);
+}
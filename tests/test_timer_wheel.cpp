@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "../src/timer_wheel.hpp"
+
+// Timers fire on their tick, in expiry order, and not before
+TEST(TimerWheelTest, FiresInExpiryOrder) {
+    TimerWheel wheel;
+    wheel.schedule(1, 30);
+    wheel.schedule(2, 10);
+    wheel.schedule(3, 20);
+
+    std::vector<uint64_t> expired;
+    wheel.advance(9, expired);
+    EXPECT_TRUE(expired.empty());
+    wheel.advance(25, expired);
+    EXPECT_EQ(expired, (std::vector<uint64_t>{2, 3}));
+    wheel.advance(30, expired);
+    EXPECT_EQ(expired, (std::vector<uint64_t>{2, 3, 1}));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, CancelAndReschedule) {
+    TimerWheel wheel;
+    wheel.schedule(1, 5);
+    wheel.schedule(2, 5);
+    EXPECT_TRUE(wheel.cancel(1));
+    EXPECT_FALSE(wheel.cancel(1));
+    wheel.schedule(2, 8);  // Replaces the earlier expiry
+
+    std::vector<uint64_t> expired;
+    wheel.advance(7, expired);
+    EXPECT_TRUE(expired.empty());
+    wheel.advance(8, expired);
+    EXPECT_EQ(expired, (std::vector<uint64_t>{2}));
+}
+
+// Timers in the upper levels cascade down and still fire on their exact tick
+TEST(TimerWheelTest, CascadesAcrossLevels) {
+    TimerWheel wheel(100);
+    const std::vector<uint64_t> expiries = {355, 356, 70000, 16'800'000, 16'777'316};
+    for (size_t i = 0; i < expiries.size(); ++i) {
+        wheel.schedule(i, expiries[i]);
+    }
+
+    for (size_t i : {0, 1, 2, 4, 3}) {
+        std::vector<uint64_t> expired;
+        wheel.advance(expiries[i] - 1, expired);
+        EXPECT_TRUE(expired.empty()) << "timer " << i;
+        wheel.advance(expiries[i], expired);
+        EXPECT_EQ(expired, (std::vector<uint64_t>{i}));
+    }
+}
+
+// Past expiries fire on the next tick; timers beyond the wheel's range are parked
+TEST(TimerWheelTest, ClampsPastAndParksFarFuture) {
+    TimerWheel wheel(1000);
+    wheel.schedule(1, 3);
+    const uint64_t far = 1000 + (uint64_t{1} << 33);
+    wheel.schedule(2, far);
+
+    std::vector<uint64_t> expired;
+    wheel.advance(1001, expired);
+    EXPECT_EQ(expired, (std::vector<uint64_t>{1}));
+    ASSERT_TRUE(wheel.next_wakeup().has_value());
+
+    expired.clear();
+    wheel.advance(far - 1, expired);
+    EXPECT_TRUE(expired.empty());
+    wheel.advance(far, expired);
+    EXPECT_EQ(expired, (std::vector<uint64_t>{2}));
+}
+
+// With nothing live the wheel jumps instead of stepping
+TEST(TimerWheelTest, EmptyWheelJumps) {
+    TimerWheel wheel;
+    wheel.schedule(1, 50);
+    wheel.cancel(1);
+    std::vector<uint64_t> expired;
+    wheel.advance(uint64_t{1} << 40, expired);
+    EXPECT_EQ(wheel.now(), uint64_t{1} << 40);
+    EXPECT_TRUE(expired.empty());
+    EXPECT_FALSE(wheel.next_wakeup().has_value());
+}
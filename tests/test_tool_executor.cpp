@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "../src/tool_executor.hpp"
+#include "../src/utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(ExecLimitsTest, ReturnsOutputWithinLimits) {
+    ExecLimits limits{std::chrono::steady_clock::now() + 5s, nullptr};
+    EXPECT_EQ(exec("echo hello; echo world", limits), "hello\nworld\n");
+}
+
+TEST(ExecLimitsTest, DeadlineKillsCommand) {
+    auto start = std::chrono::steady_clock::now();
+    ExecLimits limits{start + 200ms, nullptr};
+    // The background sleep shares the pipe and the process group; both must go
+    EXPECT_THROW(exec("sleep 5 & sleep 5", limits), ExecAborted);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+}
+
+TEST(ExecLimitsTest, CancelKillsCommand) {
+    std::atomic<bool> cancelled{false};
+    ExecLimits limits{std::nullopt, &cancelled};
+    auto start = std::chrono::steady_clock::now();
+    auto result = std::async(std::launch::async, [&] { return exec("sleep 5", limits); });
+    std::this_thread::sleep_for(100ms);
+    cancelled = true;
+    EXPECT_THROW(result.get(), ExecAborted);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+}
+
+TEST(ToolExecutorTest, QueueIsBounded) {
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::atomic<int> ran{0};
+    {
+        ToolExecutor executor(1, 2);
+        std::promise<void> started;
+        ASSERT_TRUE(executor.submit([&] {
+            started.set_value();
+            gate.wait();
+            ++ran;
+        }));
+        started.get_future().wait();  // The only worker is busy
+        EXPECT_TRUE(executor.submit([&] { ++ran; }));
+        EXPECT_TRUE(executor.submit([&] { ++ran; }));
+        EXPECT_FALSE(executor.submit([&] { ++ran; }));
+        EXPECT_EQ(executor.queued(), 2u);
+        release.set_value();
+    }
+    // Destruction runs what was queued
+    EXPECT_EQ(ran.load(), 3);
+}
+
+TEST(ToolTaskTest, ProgressThenResponse) {
+    ToolTask task(10s, "\"tok-1\"");
+    task.progress(0, 1, "Probing");
+    task.finish(R"({"jsonrpc":"2.0","id":1,"result":{}})");
+
+    std::vector<std::string> events;
+    std::string response;
+    EXPECT_EQ(task.wait(events, response, ToolTask::Clock::now()), ToolTask::Wait::Done);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_NE(events[0].find(R"("method":"notifications/progress")"), std::string::npos);
+    EXPECT_NE(events[0].find(R"("progressToken":"tok-1")"), std::string::npos);
+    EXPECT_EQ(response, R"({"jsonrpc":"2.0","id":1,"result":{}})");
+}
+
+TEST(ToolTaskTest, NoTokenNoProgress) {
+    ToolTask task(std::nullopt);
+    task.progress(0, 1, "Probing");
+    std::vector<std::string> events;
+    std::string response;
+    EXPECT_EQ(task.wait(events, response, ToolTask::Clock::now() + 10ms), ToolTask::Wait::Idle);
+    EXPECT_TRUE(events.empty());
+    EXPECT_FALSE(task.deadline());
+}
+
+TEST(ToolTaskTest, CancelWakesWaiter) {
+    ToolTask task(10s);
+    auto waiter = std::async(std::launch::async, [&] {
+        std::vector<std::string> events;
+        std::string response;
+        return task.wait(events, response, ToolTask::Clock::now() + 10s);
+    });
+    std::this_thread::sleep_for(20ms);
+    task.cancel();
+    EXPECT_EQ(waiter.wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(waiter.get(), ToolTask::Wait::Done);
+    EXPECT_TRUE(task.cancelled());
+    ASSERT_TRUE(task.exec_limits().cancelled);
+    EXPECT_TRUE(task.exec_limits().cancelled->load());
+}
+
+namespace {
+std::string answer(const ToolTask& task, std::string response) {
+    if (response.empty()) {
+        return task.cancelled() ? "cancelled" : "timed out";
+    }
+    return response;
+}
+}
+
+TEST(PendingCallsTest, SlowCallIsFetchedOnceFinished) {
+    PendingCalls calls(8, 1min);
+    auto task = std::make_shared<ToolTask>(10s);
+    std::string id = calls.add(task, ToolTask::Clock::now() + 10s, answer);
+
+    // Polling never waits on the task
+    std::string response;
+    auto start = ToolTask::Clock::now();
+    EXPECT_EQ(calls.poll(id, response), PendingCalls::State::Running);
+    EXPECT_LT(ToolTask::Clock::now() - start, 100ms);
+
+    task->finish(R"({"jsonrpc":"2.0","id":1,"result":{}})");
+    EXPECT_EQ(calls.poll(id, response), PendingCalls::State::Finished);
+    EXPECT_EQ(response, R"({"jsonrpc":"2.0","id":1,"result":{}})");
+    // Still there for a client that lost the first answer
+    response.clear();
+    EXPECT_EQ(calls.poll(id, response), PendingCalls::State::Finished);
+    EXPECT_EQ(response, R"({"jsonrpc":"2.0","id":1,"result":{}})");
+
+    EXPECT_EQ(calls.poll("call-999", response), PendingCalls::State::Unknown);
+}
+
+TEST(PendingCallsTest, OverdueCallIsCancelledAndAnsweredAsTimedOut) {
+    PendingCalls calls(8, 1min);
+    auto task = std::make_shared<ToolTask>(10s);
+    std::string id = calls.add(task, ToolTask::Clock::now() - 1ms, answer);
+
+    std::string response;
+    EXPECT_EQ(calls.poll(id, response), PendingCalls::State::Finished);
+    EXPECT_EQ(response, "timed out");
+    EXPECT_TRUE(task->cancelled());
+}
+
+TEST(PendingCallsTest, BoundedAndExpiring) {
+    PendingCalls calls(2, 1min);
+    auto now = ToolTask::Clock::now();
+    std::string first = calls.add(std::make_shared<ToolTask>(10s), now + 10s, answer);
+    calls.add(std::make_shared<ToolTask>(10s), now + 20s, answer);
+    calls.add(std::make_shared<ToolTask>(10s), now + 30s, answer);
+    EXPECT_EQ(calls.size(), 2u);
+    std::string response;
+    EXPECT_EQ(calls.poll(first, response), PendingCalls::State::Unknown);
+
+    PendingCalls short_lived(8, 0ms);
+    auto task = std::make_shared<ToolTask>(10s);
+    std::string id = short_lived.add(task, ToolTask::Clock::now() + 10s, answer);
+    task->finish("{}");
+    EXPECT_EQ(short_lived.poll(id, response), PendingCalls::State::Finished);
+    EXPECT_EQ(short_lived.poll(id, response), PendingCalls::State::Unknown);
+}
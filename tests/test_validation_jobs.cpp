@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+#include "../src/validation_jobs.hpp"
+#include "../src/media_info.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+MediaProbe playable_probe() {
+    return {.duration = 60.0, .video_codec = "h264", .width = 1280, .height = 720, .audio_codec = "aac"};
+}
+
+// Waits for a job to leave Pending
+ValidationJob wait_finished(const ValidationJobs& jobs, const std::string& id) {
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    for (;;) {
+        auto job = jobs.find(id);
+        if (!job || job->state != ValidationState::Pending || std::chrono::steady_clock::now() > deadline) {
+            return job.value_or(ValidationJob{});
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+}  // namespace
+
+TEST(MediaProbeTest, ParsesFfprobeStreams) {
+    auto probe = parse_ffprobe_streams(
+        "codec_name=h264|codec_type=video|width=1920|height=1080\n"
+        "codec_name=aac|codec_type=audio\n"
+        "codec_name=mov_text|codec_type=subtitle\n"
+        "duration=125.400000\n");
+    EXPECT_EQ(probe.video_codec, "h264");
+    EXPECT_EQ(probe.width, 1920);
+    EXPECT_EQ(probe.height, 1080);
+    EXPECT_EQ(probe.audio_codec, "aac");
+    EXPECT_DOUBLE_EQ(probe.duration, 125.4);
+
+    auto audio_only = parse_ffprobe_streams("codec_name=mp3|codec_type=audio\nduration=N/A\n");
+    EXPECT_TRUE(audio_only.video_codec.empty());
+    EXPECT_EQ(audio_only.duration, 0.0);
+}
+
+TEST(MediaProbeTest, ParsesYtDlpFormat) {
+    auto probe = parse_ytdlp_format("212.0|avc1.64001F|1280|720|mp4a.40.2\n");
+    EXPECT_DOUBLE_EQ(probe.duration, 212.0);
+    EXPECT_EQ(probe.video_codec, "avc1.64001F");
+    EXPECT_EQ(probe.height, 720);
+    EXPECT_EQ(probe.audio_codec, "mp4a.40.2");
+
+    auto live = parse_ytdlp_format("NA|vp9|1920|1080|none");
+    EXPECT_EQ(live.duration, 0.0);
+    EXPECT_TRUE(live.audio_codec.empty());
+}
+
+TEST(MediaProbeTest, ChecksPlayability) {
+    EXPECT_EQ(check_playable(playable_probe()), "");
+
+    auto probe = playable_probe();
+    probe.video_codec.clear();
+    EXPECT_EQ(check_playable(probe), "No video stream");
+
+    probe = playable_probe();
+    probe.video_codec = "mjpeg";  // Album art
+    EXPECT_NE(check_playable(probe).find("still image"), std::string::npos);
+
+    probe = playable_probe();
+    probe.duration = 0.0;
+    EXPECT_NE(check_playable(probe).find("duration"), std::string::npos);
+
+    probe = playable_probe();
+    probe.height = 120;
+    EXPECT_NE(check_playable(probe).find("too low"), std::string::npos);
+
+    probe = playable_probe();
+    probe.width = 15360;
+    probe.height = 8640;
+    EXPECT_NE(check_playable(probe).find("8K"), std::string::npos);
+}
+
+TEST(ValidationJobsTest, PlayableItemIsQueuedAfterProbe) {
+    std::mutex mutex;
+    std::vector<std::string> queued;
+    std::vector<ValidationJob> events;
+    ValidationJobs jobs({.workers = 2}, [&](const QueueItem& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(item.source);
+        return std::string();
+    }, [](const std::string&, const ExecLimits&) { return playable_probe(); });
+    jobs.set_listener([&](const ValidationJob& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(job);
+    });
+
+    auto id = jobs.submit({"videos/a.mp4", PriorityClass::Normal, "alice"});
+    ASSERT_TRUE(id);
+    auto job = wait_finished(jobs, *id);
+    EXPECT_EQ(job.state, ValidationState::Playable);
+    ASSERT_TRUE(job.media);
+    EXPECT_EQ(job.media->height, 720);
+    EXPECT_TRUE(job.finished_at);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(queued, std::vector<std::string>{"videos/a.mp4"});
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].id, *id);
+    EXPECT_EQ(events[0].item.submitter, "alice");
+}
+
+TEST(ValidationJobsTest, RejectedItemsNeverReachTheQueue) {
+    std::atomic<int> queued{0};
+    ValidationJobs jobs({.workers = 1}, [&](const QueueItem&) {
+        ++queued;
+        return std::string();
+    }, [](const std::string& source, const ExecLimits&) {
+        if (source == "unreadable") {
+            throw std::runtime_error("Source could not be read");
+        }
+        auto probe = playable_probe();
+        probe.video_codec.clear();  // Audio only
+        return probe;
+    });
+
+    auto unreadable = jobs.submit({"unreadable"});
+    auto audio = jobs.submit({"song.mp3"});
+    ASSERT_TRUE(unreadable && audio);
+    auto job = wait_finished(jobs, *unreadable);
+    EXPECT_EQ(job.state, ValidationState::Rejected);
+    EXPECT_EQ(job.error, "Source could not be read");
+    EXPECT_FALSE(job.media);
+    job = wait_finished(jobs, *audio);
+    EXPECT_EQ(job.state, ValidationState::Rejected);
+    EXPECT_EQ(job.error, "No video stream");
+    EXPECT_EQ(queued.load(), 0);
+}
+
+TEST(ValidationJobsTest, QueueRefusalRejectsTheJob) {
+    ValidationJobs jobs({.workers = 1}, [](const QueueItem& item) { return "Queue quota exceeded for submitter " + item.submitter; },
+                        [](const std::string&, const ExecLimits&) { return playable_probe(); });
+    auto id = jobs.submit({"videos/a.mp4", PriorityClass::Normal, "bob"});
+    ASSERT_TRUE(id);
+    auto job = wait_finished(jobs, *id);
+    EXPECT_EQ(job.state, ValidationState::Rejected);
+    EXPECT_EQ(job.error, "Queue quota exceeded for submitter bob");
+}
+
+TEST(ValidationJobsTest, PlayableItemsAreQueuedInSubmissionOrder) {
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::mutex mutex;
+    std::vector<std::string> queued;
+    ValidationJobs jobs({.workers = 4}, [&](const QueueItem& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(item.source);
+        return std::string();
+    }, [gate](const std::string& source, const ExecLimits&) {
+        if (source == "slow") {
+            gate.wait();  // The first submission takes longest to probe
+        }
+        if (source == "broken") {
+            throw std::runtime_error("Source could not be read");
+        }
+        return playable_probe();
+    });
+
+    auto slow = jobs.submit({"slow"});
+    auto broken = jobs.submit({"broken"});
+    auto fast = jobs.submit({"fast"});
+    ASSERT_TRUE(slow && broken && fast);
+    EXPECT_EQ(wait_finished(jobs, *broken).state, ValidationState::Rejected);  // Rejections need not wait
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(jobs.find(*fast)->state, ValidationState::Pending);  // Probed, held behind "slow"
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_TRUE(queued.empty());
+    }
+
+    release.set_value();
+    EXPECT_EQ(wait_finished(jobs, *fast).state, ValidationState::Playable);
+    EXPECT_EQ(wait_finished(jobs, *slow).state, ValidationState::Playable);
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(queued, (std::vector<std::string>{"slow", "fast"}));
+}
+
+TEST(ValidationJobsTest, ProbesWithoutQueueing) {
+    std::atomic<int> queued{0};
+    ValidationJobs jobs({.workers = 1}, [&](const QueueItem&) {
+        ++queued;
+        return std::string();
+    }, [](const std::string& source, const ExecLimits&) {
+        if (source == "unreadable") {
+            throw std::runtime_error("Source could not be read");
+        }
+        return playable_probe();
+    });
+
+    std::promise<std::optional<MediaProbe>> film, unreadable;
+    ASSERT_TRUE(jobs.probe_async("videos/film.mp4", [&](std::optional<MediaProbe> media) { film.set_value(media); }));
+    ASSERT_TRUE(jobs.probe_async("unreadable", [&](std::optional<MediaProbe> media) { unreadable.set_value(media); }));
+    auto media = film.get_future().get();
+    ASSERT_TRUE(media);
+    EXPECT_DOUBLE_EQ(media->duration, 60.0);
+    EXPECT_FALSE(unreadable.get_future().get());
+    EXPECT_EQ(queued.load(), 0);
+    EXPECT_TRUE(jobs.recent(10).empty());
+}
+
+TEST(ValidationJobsTest, PendingJobsAreBounded) {
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    {
+        ValidationJobs jobs({.workers = 1, .max_pending = 2}, [](const QueueItem&) { return std::string(); },
+                            [gate](const std::string&, const ExecLimits&) {
+                                gate.wait();
+                                return playable_probe();
+                            });
+        auto first = jobs.submit({"a"});
+        auto second = jobs.submit({"b"});
+        ASSERT_TRUE(first && second);
+        EXPECT_NE(*first, *second);
+        EXPECT_FALSE(jobs.submit({"c"}));
+        EXPECT_EQ(jobs.pending(), 2u);
+
+        auto recent = jobs.recent(10);
+        ASSERT_EQ(recent.size(), 2u);
+        EXPECT_EQ(recent[0].item.source, "a");  // Pending in submission order
+        EXPECT_EQ(recent[0].state, ValidationState::Pending);
+
+        release.set_value();
+        EXPECT_EQ(wait_finished(jobs, *second).state, ValidationState::Playable);
+        EXPECT_EQ(jobs.pending(), 0u);
+        EXPECT_TRUE(jobs.submit({"c"}));
+    }
+}
+
+TEST(ValidationJobsTest, FinishedJobsAreRetainedNewestFirst) {
+    ValidationJobs jobs({.workers = 1, .retained = 2}, [](const QueueItem&) { return std::string(); },
+                        [](const std::string&, const ExecLimits&) { return playable_probe(); });
+    std::vector<std::string> ids;
+    for (const char* source : {"a", "b", "c"}) {
+        ids.push_back(jobs.submit({source}).value());
+        wait_finished(jobs, ids.back());
+    }
+    EXPECT_FALSE(jobs.find(ids[0]));  // Evicted
+    auto recent = jobs.recent(10);
+    ASSERT_EQ(recent.size(), 2u);
+    EXPECT_EQ(recent[0].item.source, "c");
+    EXPECT_EQ(recent[1].item.source, "b");
+    EXPECT_FALSE(jobs.find("no-such-job"));
+}
+
+TEST(ValidationJobsTest, DestructionCancelsRunningProbes) {
+    std::promise<void> started;
+    std::atomic<int> queued{0};
+    auto start = std::chrono::steady_clock::now();
+    {
+        ValidationJobs jobs({.workers = 1}, [&](const QueueItem&) {
+            ++queued;
+            return std::string();
+        }, [&](const std::string&, const ExecLimits& limits) -> MediaProbe {
+            started.set_value();
+            exec("sleep 5", limits);
+            return playable_probe();
+        });
+        ASSERT_TRUE(jobs.submit({"slow"}));
+        ASSERT_TRUE(jobs.submit({"waiting"}));
+        started.get_future().wait();
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+    EXPECT_EQ(queued.load(), 0);
+}
@@ -0,0 +1,481 @@
+// Load generator for a local mychannel instance: keep-alive connections sending a mix of
+// dashboard reads, queue writes and MCP tool calls, reporting throughput and latency
+// percentiles per request class.
+//
+//   mychannel_loadgen --port 8080 --connections 64 --duration 30 --mix read=80,write=15,mcp=5
+//
+// With --rate the load is open loop: requests are scheduled at fixed intervals and latency
+// is measured from the scheduled send time, so a stalled server shows up in the tail
+// instead of silently lowering the offered load.
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum RequestClass { Read, Write, Mcp, CLASS_COUNT };
+constexpr const char* CLASS_NAMES[CLASS_COUNT] = {"read", "write", "mcp"};
+
+struct Config {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8080;
+    size_t connections = 16;
+    double duration_s = 10.0;
+    double rate = 0.0;  // Requests per second over all connections; 0 sends as fast as answered
+    unsigned mix[CLASS_COUNT] = {80, 15, 5};
+    std::string token;
+    bool etag = false;  // Send If-None-Match on reads, like a polling dashboard
+    bool json = false;
+};
+
+struct Stats {
+    std::vector<double> latency_us[CLASS_COUNT];
+    uint64_t status_classes[6] = {};  // 1xx..5xx by hundreds; [0] counts transport errors
+    uint64_t reconnects = 0;
+};
+
+[[noreturn]] void usage(const char* message) {
+    std::cerr << "mychannel_loadgen: " << message << "\n"
+              << "usage: mychannel_loadgen [--host H] [--port P] [--connections N] [--duration S]\n"
+              << "                         [--rate RPS] [--mix read=80,write=15,mcp=5] [--token T]\n"
+              << "                         [--etag] [--json]\n";
+    std::exit(2);
+}
+
+template <typename T>
+bool to_number(std::string_view text, T& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc{} && result.ptr == text.data() + text.size();
+}
+
+template <typename T>
+T parse_number(std::string_view text, const char* flag) {
+    T value{};
+    if (!to_number(text, value)) {
+        usage((std::string("invalid value for ") + flag).c_str());
+    }
+    return value;
+}
+
+void parse_mix(std::string_view text, Config& config) {
+    std::fill(std::begin(config.mix), std::end(config.mix), 0u);
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view entry = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+        size_t equals = entry.find('=');
+        if (equals == std::string_view::npos) {
+            usage("--mix entries are class=weight");
+        }
+        std::string_view name = entry.substr(0, equals);
+        auto it = std::find(std::begin(CLASS_NAMES), std::end(CLASS_NAMES), name);
+        if (it == std::end(CLASS_NAMES)) {
+            usage("--mix classes are read, write and mcp");
+        }
+        config.mix[it - std::begin(CLASS_NAMES)] = parse_number<unsigned>(entry.substr(equals + 1), "--mix");
+    }
+    if (config.mix[Read] + config.mix[Write] + config.mix[Mcp] == 0) {
+        usage("--mix needs a non-zero weight");
+    }
+}
+
+Config parse_args(int argc, char** argv) {
+    Config config;
+    if (const char* token = std::getenv("MYCHANNEL_AUTH_TOKEN")) {
+        config.token = token;
+    }
+    for (int i = 1; i < argc; ++i) {
+        std::string_view flag = argv[i];
+        auto value = [&]() -> std::string_view {
+            if (i + 1 >= argc) {
+                usage((std::string(flag) + " needs a value").c_str());
+            }
+            return argv[++i];
+        };
+        if (flag == "--host") config.host = value();
+        else if (flag == "--port") config.port = parse_number<uint16_t>(value(), "--port");
+        else if (flag == "--connections") config.connections = parse_number<size_t>(value(), "--connections");
+        else if (flag == "--duration") config.duration_s = parse_number<double>(value(), "--duration");
+        else if (flag == "--rate") config.rate = parse_number<double>(value(), "--rate");
+        else if (flag == "--mix") parse_mix(value(), config);
+        else if (flag == "--token") config.token = value();
+        else if (flag == "--etag") config.etag = true;
+        else if (flag == "--json") config.json = true;
+        else usage(("unknown flag " + std::string(flag)).c_str());
+    }
+    if (config.connections == 0 || config.duration_s <= 0) {
+        usage("--connections and --duration must be positive");
+    }
+    return config;
+}
+
+// One keep-alive HTTP/1.1 connection. Reconnects when the server closes it (keep-alive
+// limit or timeout) and reports the status code, or 0 on a transport error.
+class Connection {
+public:
+    Connection(const sockaddr_in& address, Stats& stats) : address_(address), stats_(stats) {}
+    ~Connection() { close_socket(); }
+
+    int request(const std::string& raw, std::string* etag) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            if (fd_ < 0 && !connect_socket()) {
+                return 0;
+            }
+            bool fresh = requests_ == 0;
+            int status = exchange(raw, etag);
+            if (status > 0) {
+                return status;
+            }
+            close_socket();
+            if (fresh) {
+                return 0;  // A new connection failed; retrying would hide a real error
+            }
+            ++stats_.reconnects;  // The server dropped an idle connection under us
+        }
+        return 0;
+    }
+
+private:
+    bool connect_socket() {
+        fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) {
+            return false;
+        }
+        int one = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(fd_, reinterpret_cast<const sockaddr*>(&address_), sizeof(address_)) != 0) {
+            close_socket();
+            return false;
+        }
+        requests_ = 0;
+        buffer_.clear();
+        return true;
+    }
+
+    void close_socket() {
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int exchange(const std::string& raw, std::string* etag) {
+        for (size_t sent = 0; sent < raw.size();) {
+            ssize_t n = send(fd_, raw.data() + sent, raw.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return 0;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        ++requests_;
+
+        size_t header_end;
+        while ((header_end = buffer_.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill()) {
+                return 0;
+            }
+        }
+        std::string_view head(buffer_.data(), header_end);
+        int status = 0;
+        if (head.size() < 12 || !head.starts_with("HTTP/1.") || !to_number(head.substr(9, 3), status)) {
+            return 0;
+        }
+        size_t length = 0;
+        bool close_after = false;
+        for (size_t pos = head.find("\r\n"); pos != std::string_view::npos;) {
+            size_t next = head.find("\r\n", pos + 2);
+            std::string_view line = head.substr(pos + 2, next == std::string_view::npos ? next : next - pos - 2);
+            pos = next;
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos) {
+                continue;
+            }
+            std::string name(line.substr(0, colon));
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+            std::string_view field = line.substr(colon + 1);
+            while (!field.empty() && field.front() == ' ') field.remove_prefix(1);
+            if (name == "content-length") {
+                if (!to_number(field, length)) {
+                    return 0;
+                }
+            } else if (name == "connection") {
+                close_after = field.find("close") != std::string_view::npos;
+            } else if (name == "etag" && etag) {
+                *etag = field;
+            }
+        }
+        size_t total = header_end + 4 + length;
+        while (buffer_.size() < total) {
+            if (!fill()) {
+                return 0;
+            }
+        }
+        buffer_.erase(0, total);
+        if (close_after) {
+            close_socket();
+        }
+        return status;
+    }
+
+    bool fill() {
+        char chunk[16384];
+        ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    sockaddr_in address_;
+    Stats& stats_;
+    int fd_ = -1;
+    uint64_t requests_ = 0;
+    std::string buffer_;
+};
+
+std::string build_request(const Config& config, std::string_view method, std::string_view target,
+                          std::string_view body = {}, std::string_view etag = {}) {
+    std::string raw;
+    raw.reserve(256 + body.size());
+    raw.append(method).append(" ").append(target).append(" HTTP/1.1\r\n");
+    raw.append("Host: ").append(config.host).append("\r\n");
+    raw.append("X-Submitter: loadgen\r\n");
+    if (!config.token.empty()) {
+        raw.append("Authorization: Bearer ").append(config.token).append("\r\n");
+    }
+    if (!etag.empty()) {
+        raw.append("If-None-Match: ").append(etag).append("\r\n");
+    }
+    if (!body.empty()) {
+        raw.append("Content-Type: application/json\r\n");
+    }
+    raw.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n\r\n");
+    raw.append(body);
+    return raw;
+}
+
+// Cycles through what a dashboard, a submitting client and an MCP agent send
+class Workload {
+public:
+    Workload(const Config& config, uint64_t seed) : config_(config), random_(seed) {
+        for (unsigned weight : config.mix) {
+            total_weight_ += weight;
+        }
+    }
+
+    RequestClass next_class() {
+        unsigned pick = std::uniform_int_distribution<unsigned>(0, total_weight_ - 1)(random_);
+        for (int c = 0; c < CLASS_COUNT; ++c) {
+            if (pick < config_.mix[c]) {
+                return static_cast<RequestClass>(c);
+            }
+            pick -= config_.mix[c];
+        }
+        return Read;
+    }
+
+    std::string request(RequestClass cls) {
+        static constexpr const char* READS[] = {"/status", "/queue?limit=50", "/queue/position"};
+        static constexpr const char* TOOLS[] = {"get_stream_status", "get_streaming_queue"};
+        switch (cls) {
+            case Read: {
+                size_t i = reads_++ % std::size(READS);
+                return build_request(config_, "GET", READS[i], {}, config_.etag ? etags_[i] : std::string_view{});
+            }
+            case Write:
+                // Keep the queue short so reads measure the server, not a growing lineup
+                if (++writes_ % 50 == 0) {
+                    return build_request(config_, "POST", "/queue/clear");
+                }
+                return build_request(config_, "POST",
+                                     "/queue/add?url=https%3A%2F%2Fwww.youtube.com%2Fwatch%3Fv%3DdQw4w9WgXcQ");
+            case Mcp: {
+                uint64_t id = ++mcp_calls_;
+                std::string body = R"({"jsonrpc":"2.0","id":)" + std::to_string(id) +
+                                   R"(,"method":"tools/call","params":{"name":")" + TOOLS[id % std::size(TOOLS)] +
+                                   R"(","arguments":{}}})";
+                return build_request(config_, "POST", "/", body);
+            }
+            case CLASS_COUNT: break;
+        }
+        return {};
+    }
+
+    // Where a read's ETag goes, so the next poll of the same route can send it
+    std::string* etag_slot(RequestClass cls) {
+        return cls == Read && config_.etag ? &etags_[(reads_ - 1) % std::size(etags_)] : nullptr;
+    }
+
+private:
+    const Config& config_;
+    std::mt19937_64 random_;
+    unsigned total_weight_ = 0;
+    uint64_t reads_ = 0;
+    uint64_t writes_ = 0;
+    uint64_t mcp_calls_ = 0;
+    std::string etags_[3];
+};
+
+void run_connection(const Config& config, const sockaddr_in& address, size_t index, Clock::time_point start,
+                    Clock::time_point end, Stats& stats) {
+    Connection connection(address, stats);
+    Workload workload(config, index + 1);
+    // Open loop: this connection's share of the rate, staggered so connections do not fire together
+    Clock::duration interval{};
+    Clock::time_point scheduled = start;
+    if (config.rate > 0) {
+        interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(config.connections) / config.rate));
+        scheduled += interval * index / config.connections;
+    }
+    while (true) {
+        if (config.rate > 0) {
+            if (scheduled >= end) {
+                break;
+            }
+            std::this_thread::sleep_until(scheduled);
+        } else if (Clock::now() >= end) {
+            break;
+        }
+        RequestClass cls = workload.next_class();
+        std::string raw = workload.request(cls);
+        Clock::time_point sent = config.rate > 0 ? scheduled : Clock::now();
+        int status = connection.request(raw, workload.etag_slot(cls));
+        auto latency = std::chrono::duration<double, std::micro>(Clock::now() - sent).count();
+        stats.latency_us[cls].push_back(latency);
+        ++stats.status_classes[status >= 100 && status < 600 ? status / 100 : 0];
+        scheduled += interval;
+    }
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+sockaddr_in resolve(const Config& config) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(config.host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+        usage(("cannot resolve " + config.host).c_str());
+    }
+    sockaddr_in address = *reinterpret_cast<sockaddr_in*>(result->ai_addr);
+    freeaddrinfo(result);
+    address.sin_port = htons(config.port);
+    return address;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Config config = parse_args(argc, argv);
+    sockaddr_in address = resolve(config);
+
+    std::vector<Stats> stats(config.connections);
+    std::vector<std::thread> threads;
+    threads.reserve(config.connections);
+    auto start = Clock::now() + std::chrono::milliseconds(50);  // Let every thread reach the start line
+    auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.duration_s));
+    for (size_t i = 0; i < config.connections; ++i) {
+        threads.emplace_back(run_connection, std::cref(config), std::cref(address), i, start, end, std::ref(stats[i]));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Stats total;
+    for (auto& s : stats) {
+        for (int c = 0; c < CLASS_COUNT; ++c) {
+            total.latency_us[c].insert(total.latency_us[c].end(), s.latency_us[c].begin(), s.latency_us[c].end());
+        }
+        for (int i = 0; i < 6; ++i) {
+            total.status_classes[i] += s.status_classes[i];
+        }
+        total.reconnects += s.reconnects;
+    }
+    std::vector<double> all;
+    for (auto& latencies : total.latency_us) {
+        std::sort(latencies.begin(), latencies.end());
+        all.insert(all.end(), latencies.begin(), latencies.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    struct Row {
+        const char* name;
+        const std::vector<double>* latencies;
+    };
+    std::vector<Row> rows{{"all", &all}};
+    for (int c = 0; c < CLASS_COUNT; ++c) {
+        if (config.mix[c] > 0) {
+            rows.push_back({CLASS_NAMES[c], &total.latency_us[c]});
+        }
+    }
+
+    if (config.json) {
+        std::printf("{\"connections\":%zu,\"duration_s\":%.3f,\"rate\":%.1f,\"classes\":{", config.connections, elapsed,
+                    config.rate);
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const auto& l = *rows[i].latencies;
+            std::printf("%s\"%s\":{\"requests\":%zu,\"rps\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,"
+                        "\"max_us\":%.1f}",
+                        i ? "," : "", rows[i].name, l.size(), static_cast<double>(l.size()) / elapsed,
+                        percentile(l, 0.5), percentile(l, 0.99), percentile(l, 0.999), l.empty() ? 0.0 : l.back());
+        }
+        std::printf("},\"status\":{\"errors\":%llu,\"2xx\":%llu,\"3xx\":%llu,\"4xx\":%llu,\"5xx\":%llu},"
+                    "\"reconnects\":%llu}\n",
+                    static_cast<unsigned long long>(total.status_classes[0]),
+                    static_cast<unsigned long long>(total.status_classes[2]),
+                    static_cast<unsigned long long>(total.status_classes[3]),
+                    static_cast<unsigned long long>(total.status_classes[4]),
+                    static_cast<unsigned long long>(total.status_classes[5]),
+                    static_cast<unsigned long long>(total.reconnects));
+        return total.status_classes[0] > 0 ? 1 : 0;
+    }
+
+    std::printf("%zu connections, %.1f s, %s\n\n", config.connections, elapsed,
+                config.rate > 0 ? ("open loop at " + std::to_string(static_cast<long>(config.rate)) + " req/s").c_str()
+                                : "closed loop");
+    std::printf("%-6s %10s %10s %10s %10s %10s %10s\n", "class", "requests", "req/s", "p50 ms", "p99 ms", "p99.9 ms",
+                "max ms");
+    for (const auto& row : rows) {
+        const auto& l = *row.latencies;
+        std::printf("%-6s %10zu %10.1f %10.3f %10.3f %10.3f %10.3f\n", row.name, l.size(),
+                    static_cast<double>(l.size()) / elapsed, percentile(l, 0.5) / 1000, percentile(l, 0.99) / 1000,
+                    percentile(l, 0.999) / 1000, l.empty() ? 0.0 : l.back() / 1000);
+    }
+    std::printf("\nstatus: 2xx %llu, 3xx %llu, 4xx %llu, 5xx %llu, transport errors %llu, reconnects %llu\n",
+                static_cast<unsigned long long>(total.status_classes[2]),
+                static_cast<unsigned long long>(total.status_classes[3]),
+                static_cast<unsigned long long>(total.status_classes[4]),
+                static_cast<unsigned long long>(total.status_classes[5]),
+                static_cast<unsigned long long>(total.status_classes[0]),
+                static_cast<unsigned long long>(total.reconnects));
+    return total.status_classes[0] > 0 ? 1 : 0;
+}